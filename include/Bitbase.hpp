@@ -0,0 +1,180 @@
+#pragma once
+#include <MappedFile.hpp>
+
+#include <filesystem>
+#include <span>
+
+enum class PieceFlag : uint8_t;
+
+/// <summary>
+/// A win/draw/loss table of one endgame, two bits per position from the point of view of the side to move.
+/// The side with the stronger pieces plays white in the table, so a table covers both colors. Positions are
+/// indexed by the squares of the strong king, the weak king and then the other pieces, and positions that are
+/// mirror images of each other share an entry: without pawns the strong king is kept on the a1-d1-d4 triangle,
+/// with pawns on the queen side. A file is a little-endian header followed by the packed values and is probed
+/// in place through a memory mapping
+/// </summary>
+class Bitbase final {
+public:
+    static constexpr std::array<char, 4> Magic { 'C', 'W', 'D', 'L' };
+    static constexpr uint32_t Version = 1;
+    static constexpr size_t HeaderSize = 32;
+
+    /// <summary>
+    /// The most pieces a table can hold, kings included
+    /// </summary>
+    static constexpr int MaxPieces = 5;
+
+    /// <summary>
+    /// The extension of bitbase files, the file name is the name of the material
+    /// </summary>
+    static constexpr std::string_view Extension = ".cwdl";
+
+    /// <summary>
+    /// The value of a position for the side to move, as stored
+    /// </summary>
+    enum class Value : uint8_t {
+        Draw,
+        Win,
+        Loss,
+        Illegal // The position cannot occur, or is a mirror image of another entry
+    };
+
+    /// <summary>
+    /// The pieces of an endgame besides the kings, strongest first. Pawns may only be on one side, so that
+    /// no position of a table can have an en passant capture
+    /// </summary>
+    struct Material {
+        std::vector<PieceFlag> Strong;
+        std::vector<PieceFlag> Weak;
+
+        /// <summary>
+        /// Parses a name like <c>KQvKR</c> and puts the stronger side first
+        /// </summary>
+        /// <exception cref="std::invalid_argument">The name is malformed, has too many pieces or pawns on both sides</exception>
+        static auto Parse(std::string_view name) -> Material;
+
+        /// <summary>
+        /// Gets the material of the position on the board of the calling thread, in the order of <c>Parse</c>
+        /// </summary>
+        /// <param name="flipped"><c>bool</c> Set if black is the strong side</param>
+        static auto FromBoard(bool& flipped) -> Material;
+
+        [[nodiscard]] auto GetName() const -> std::string;
+
+        [[nodiscard]] auto GetPieceCount() const noexcept -> int;
+
+        [[nodiscard]] auto HasPawns() const noexcept -> bool;
+
+        /// <summary>
+        /// Gets the number of entries of the table, both sides to move
+        /// </summary>
+        [[nodiscard]] auto GetEntries() const noexcept -> uint64_t;
+
+        auto operator==(const Material&) const -> bool = default;
+    };
+
+    /// <summary>
+    /// A position of a table: the squares of the strong king, the weak king, the strong pieces and the weak
+    /// pieces in the order of the material, a1 = 0. The strong side is white
+    /// </summary>
+    struct Squares {
+        std::array<int, MaxPieces> Pieces {};
+        bool WhiteToMove = true;
+    };
+
+    /// <summary>
+    /// Gets the entry of a position, the same for every mirror image and every order of equal pieces
+    /// </summary>
+    static auto Index(const Material& material, const Squares& squares) -> uint64_t;
+
+    /// <summary>
+    /// Gets the position of an entry. Entries that are not the index of their own position are <c>Illegal</c>
+    /// </summary>
+    static auto Decode(const Material& material, uint64_t index) -> Squares;
+
+    /// <summary>
+    /// Memory-maps a table and validates its header
+    /// </summary>
+    /// <exception cref="std::runtime_error">The file cannot be mapped or is not a valid table</exception>
+    explicit Bitbase(const std::filesystem::path& path);
+
+    /// <summary>
+    /// Takes a table serialized in memory
+    /// </summary>
+    /// <exception cref="std::runtime_error">The bytes are not a valid table</exception>
+    explicit Bitbase(std::vector<uint8_t> bytes);
+
+    Bitbase(const Bitbase&) = delete;
+    auto operator=(const Bitbase&) -> Bitbase& = delete;
+
+    [[nodiscard]] auto GetMaterial() const noexcept -> const Material&;
+
+    /// <summary>
+    /// Gets the whole table as it is stored in a file, header included
+    /// </summary>
+    [[nodiscard]] auto GetBytes() const noexcept -> std::span<const uint8_t>;
+
+    [[nodiscard]] auto Get(uint64_t index) const noexcept -> Value {
+        return static_cast<Value>(m_Values[index / 4] >> (index % 4 * 2) & 3U);
+    }
+
+    /// <summary>
+    /// Probes the position on the board of the calling thread, which must have the material of the table
+    /// with either side strong
+    /// </summary>
+    [[nodiscard]] auto Probe() const -> Value;
+
+    /// <summary>
+    /// Lays out a table in memory
+    /// </summary>
+    /// <param name="values"><c>span</c> The value of every entry, <c>GetEntries</c> of them</param>
+    /// <exception cref="std::invalid_argument">The number of values does not match the material</exception>
+    static auto Serialize(const Material& material, std::span<const Value> values) -> std::vector<uint8_t>;
+
+    static auto GetName(Value value) -> std::string_view;
+
+private:
+    /// <summary>
+    /// Validates the header and points the values into the bytes
+    /// </summary>
+    auto Parse(std::span<const uint8_t> bytes) -> void;
+
+    MappedFile m_File;
+    std::vector<uint8_t> m_Bytes;
+    std::span<const uint8_t> m_Data;
+
+    Material m_Material;
+    const uint8_t* m_Values = nullptr;
+};
+
+/// <summary>
+/// The tables an engine or a tool probes, found by the material of the position
+/// </summary>
+class BitbaseSet final {
+public:
+    /// <summary>
+    /// Maps every table in a directory
+    /// </summary>
+    /// <returns><c>size_t</c> The number of tables loaded</returns>
+    /// <exception cref="std::runtime_error">A table cannot be mapped or is not valid</exception>
+    auto Load(const std::filesystem::path& directory) -> size_t;
+
+    auto Add(std::unique_ptr<Bitbase> table) -> const Bitbase&;
+
+    [[nodiscard]] auto Find(const Bitbase::Material& material) const -> const Bitbase*;
+
+    /// <summary>
+    /// Probes the position on the board of the calling thread. Two bare kings are a draw
+    /// </summary>
+    /// <returns><c>Value</c> The value for the side to move, or nothing if there is no table for the material
+    /// or the position has castling rights</returns>
+    [[nodiscard]] auto Probe() const -> std::optional<Bitbase::Value>;
+
+    [[nodiscard]] auto GetSize() const noexcept -> size_t {
+        return m_Tables.size();
+    }
+
+private:
+    std::unordered_map<std::string, std::unique_ptr<Bitbase>> m_Tables;
+};
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <Bitbase.hpp>
+
+#include <functional>
+
+/// <summary>
+/// Builds bitbases by retrograde analysis on the rules of the board. Every position is first classified by its
+/// moves: mates, stalemates and captures or promotions into smaller tables. The decided positions are then
+/// walked backwards with unmoves, level by level, on all threads: a predecessor of a loss is a win, and a
+/// predecessor whose every move leads to a win is a loss. What is left undecided is a draw
+/// </summary>
+class BitbaseGenerator final {
+public:
+    /// <summary>
+    /// The outcome of generating one table
+    /// </summary>
+    struct Report {
+        std::string Material;
+        uint64_t Entries;
+        uint64_t Wins;
+        uint64_t Draws;
+        uint64_t Losses;
+
+        /// <summary>
+        /// The number of backward passes until no position changed
+        /// </summary>
+        int Iterations;
+        int64_t Milliseconds;
+    };
+
+    using ReportCallback = std::function<void(const Report&)>;
+
+    /// <summary>
+    /// Generates into a set of tables, which also provides the smaller tables a generated one converts into
+    /// </summary>
+    /// <param name="threads"><c>int</c> The number of threads, zero for one per core</param>
+    /// <param name="report"><c>ReportCallback</c> Called after every generated table, the smaller tables first</param>
+    BitbaseGenerator(BitbaseSet& tables, int threads, ReportCallback report);
+
+    /// <summary>
+    /// Generates a table and every smaller table it depends on that the set does not have yet
+    /// </summary>
+    /// <exception cref="std::invalid_argument">The material cannot be generated</exception>
+    auto Generate(const Bitbase::Material& material) -> const Bitbase&;
+
+private:
+    class Table;
+
+    BitbaseSet& m_Tables;
+    int m_Threads;
+    ReportCallback m_Report;
+};
\ No newline at end of file
@@ -0,0 +1,197 @@
+#pragma once
+#include <Position.hpp>
+#include <array>
+#include <bit>
+
+/// <summary>
+/// A set of squares with one bit per square. Bit 0 is a1, bit 7 is h1 and bit 63 is h8
+/// </summary>
+using Bitboard = uint64_t;
+
+/// <summary>
+/// Converts a position on the board into a square index in range [0, 63]
+/// </summary>
+constexpr auto SquareIndex(const Position& pos) -> int {
+    return pos.y * 8 + pos.x;
+}
+
+/// <summary>
+/// Converts a square index in range [0, 63] into a position on the board
+/// </summary>
+constexpr auto SquarePosition(const int square) -> Position {
+    return { square & 7, square >> 3 };
+}
+
+/// <summary>
+/// Gets a bitboard with only the specified square set
+/// </summary>
+constexpr auto SquareBit(const Position& pos) -> Bitboard {
+    return Bitboard { 1 } << SquareIndex(pos);
+}
+
+/// <summary>
+/// Removes the lowest square from a bitboard and returns it
+/// </summary>
+/// <param name="squares"><c>Bitboard</c> A bitboard with at least one square set</param>
+constexpr auto PopSquare(Bitboard& squares) -> Position {
+    const int square = std::countr_zero(squares);
+    squares &= squares - 1;
+    return SquarePosition(square);
+}
+
+/// <summary>
+/// The eight ray directions. Each direction is followed by its opposite, and even
+/// directions point towards higher square indices
+/// </summary>
+inline constexpr std::array<Position, 8> RayDirections { {
+    { 1, 0 },
+    { -1, 0 },
+    { 0, 1 },
+    { 0, -1 },
+    { 1, 1 },
+    { -1, -1 },
+    { -1, 1 },
+    { 1, -1 }
+} };
+
+/// <summary>
+/// Gets the index into <c>RayDirections</c> that leads from one square to another
+/// </summary>
+/// <returns><c>int</c> The direction, or -1 if the squares do not share a line or a diagonal</returns>
+constexpr auto RayDirection(const Position& from, const Position& to) -> int {
+    const auto offset = to - from;
+
+    if (offset.x == 0 && offset.y == 0) {
+        return -1;
+    }
+
+    if (offset.y == 0) {
+        return offset.x > 0 ? 0 : 1;
+    }
+
+    if (offset.x == 0) {
+        return offset.y > 0 ? 2 : 3;
+    }
+
+    if (offset.x == offset.y) {
+        return offset.x > 0 ? 4 : 5;
+    }
+
+    if (offset.x == -offset.y) {
+        return offset.x < 0 ? 6 : 7;
+    }
+
+    return -1;
+}
+
+/// <summary>
+/// Gets the blocker on a ray that is closest to the origin of the ray
+/// </summary>
+/// <param name="direction"><c>int</c> The index of the ray direction</param>
+/// <param name="blockers"><c>Bitboard</c> The occupied squares on the ray, at least one</param>
+constexpr auto NearestSquare(const int direction, const Bitboard blockers) -> int {
+    return direction % 2 == 0 ? std::countr_zero(blockers) : 63 - std::countl_zero(blockers);
+}
+
+/// <summary>
+/// Builds an attack table for a piece that jumps by fixed offsets
+/// </summary>
+template<size_t N>
+constexpr auto CreateLeaperTable(const std::array<Position, N>& offsets) -> std::array<Bitboard, 64> {
+    std::array<Bitboard, 64> table {};
+
+    for (int square = 0; square < 64; square++) {
+        for (const auto& offset : offsets) {
+            if (auto pos = SquarePosition(square); pos.Advance(offset)) {
+                table[square] |= SquareBit(pos);
+            }
+        }
+    }
+
+    return table;
+}
+
+inline constexpr auto KnightAttacks = CreateLeaperTable(std::array<Position, 8> { {
+    { 1, 2 }, { -1, 2 }, { 1, -2 }, { -1, -2 }, { 2, 1 }, { 2, -1 }, { -2, 1 }, { -2, -1 }
+} });
+
+inline constexpr auto KingAttacks = CreateLeaperTable(RayDirections);
+
+/// <summary>
+/// Squares attacked by a pawn, indexed by color (white first) and square
+/// </summary>
+inline constexpr std::array<std::array<Bitboard, 64>, 2> PawnAttacks {
+    CreateLeaperTable(std::array<Position, 2> { { { -1, 1 }, { 1, 1 } } }),
+    CreateLeaperTable(std::array<Position, 2> { { { -1, -1 }, { 1, -1 } } })
+};
+
+/// <summary>
+/// Squares from a square to the edge of the board, excluding the square itself.
+/// Indexed by direction and square
+/// </summary>
+inline constexpr auto Rays = [] {
+    std::array<std::array<Bitboard, 64>, 8> table {};
+
+    for (size_t direction = 0; direction < RayDirections.size(); direction++) {
+        for (int square = 0; square < 64; square++) {
+            auto pos = SquarePosition(square);
+            while (pos.Advance(RayDirections[direction])) {
+                table[direction][square] |= SquareBit(pos);
+            }
+        }
+    }
+
+    return table;
+}();
+
+/// <summary>
+/// Squares strictly between two squares on a shared line or diagonal, empty otherwise
+/// </summary>
+inline constexpr auto SquaresBetween = [] {
+    std::array<std::array<Bitboard, 64>, 64> table {};
+
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) {
+            if (const int direction = RayDirection(SquarePosition(from), SquarePosition(to)); direction >= 0) {
+                table[from][to] = Rays[direction][from] & Rays[direction ^ 1][to];
+            }
+        }
+    }
+
+    return table;
+}();
+
+/// <summary>
+/// The full line or diagonal through two squares from edge to edge, empty if they do not share one
+/// </summary>
+inline constexpr auto LineThrough = [] {
+    std::array<std::array<Bitboard, 64>, 64> table {};
+
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) {
+            if (const int direction = RayDirection(SquarePosition(from), SquarePosition(to)); direction >= 0) {
+                table[from][to] = Rays[direction][from] | Rays[direction ^ 1][from] | SquareBit(SquarePosition(from));
+            }
+        }
+    }
+
+    return table;
+}();
+
+/// <summary>
+/// The number of king steps between two squares
+/// </summary>
+inline constexpr auto SquareDistance = [] {
+    std::array<std::array<uint8_t, 64>, 64> table {};
+
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) {
+            const auto offset = SquarePosition(to) - SquarePosition(from);
+            const int dx = offset.x < 0 ? -offset.x : offset.x;
+            const int dy = offset.y < 0 ? -offset.y : offset.y;
+            table[from][to] = static_cast<uint8_t>(dx > dy ? dx : dy);
+        }
+    }
+
+    return table;
+}();
\ No newline at end of file
@@ -1,109 +1,360 @@
 #pragma once
 
 class Move;
-class Piece;
+class PerftCache;
 
-#include <Position.hpp>
+#include <Bitboard.hpp>
+#include <Fen.hpp>
+#include <Piece.hpp>
 
 /// <summary>
-/// Describes the chess board
+/// Describes the chess board. Every thread has a board of its own
 /// </summary>
 class Board final {
 public:
+    /// <summary>
+    /// The side a generator is specialized for
+    /// </summary>
+    enum class Color : uint8_t {
+        White,
+        Black
+    };
+
+    /// <summary>
+    /// The subset of legal moves a generator emits
+    /// </summary>
+    enum class GenType : uint8_t {
+        Captures, // Captures, en passant and capturing promotions
+        Quiets,   // Non-captures, castling and quiet promotions
+        Evasions, // Every legal move, only emitted while in check
+        All       // Every legal move
+    };
+
     /// <summary>
     /// Sets the board state to the specified state using FEN notation.
     /// Wipes the board before the operation
     /// </summary>
     /// <param name="fen"><c>string</c> The FEN string to initialize the board with</param>
-    static auto SetState(std::string_view fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1") -> void;
+    /// <exception cref="std::invalid_argument">The FEN is malformed or describes an impossible position</exception>
+    static auto SetState(std::string_view fen = Fen::StartPosition) -> void;
 
     /// <summary>
-    /// Gets the underlying board data
+    /// Sets the board state to a parsed FEN record. Wipes the board and the move history before the operation
     /// </summary>
-    static auto GetBoard() -> std::unordered_map<Position, Piece>&;
+    static auto SetState(const Fen::State& state) -> void;
 
+    /// <summary>
+    /// Gets the current position as the fields of a FEN record
+    /// </summary>
+    static auto GetState() -> Fen::State;
+
+    /// <summary>
+    /// Gets the current position in FEN notation
+    /// </summary>
+    static auto GetFen() -> std::string;
+
+    /// <summary>
+    /// Gets the underlying board data, the pieces indexed by square from a1 to h8
+    /// </summary>
+    static auto GetBoard() -> const std::array<Piece, 64>&;
+
+    /// <summary>
+    /// Gets the piece on a square, an empty piece if there is none
+    /// </summary>
+    static auto GetPiece(const Position& square) -> Piece;
+
+    /// <summary>
+    /// Plays a move on the board and passes the turn to the other side
+    /// </summary>
+    /// <param name="move"><c>Move</c> A legal move for the side to move</param>
     static auto MakeMove(const Move& move) -> void;
 
+    /// <summary>
+    /// Takes back a move played with <c>MakeMove</c>. Moves must be taken back in reverse order
+    /// </summary>
+    /// <param name="move"><c>Move</c> The last move that was played</param>
+    static auto UnmakeMove(const Move& move) -> void;
+
+    /// <summary>
+    /// Passes the turn to the other side without moving. Only used by the search, the position
+    /// may not be in check
+    /// </summary>
+    static auto MakeNullMove() -> void;
+
+    /// <summary>
+    /// Takes back a null move played with <c>MakeNullMove</c>
+    /// </summary>
+    static auto UnmakeNullMove() -> void;
+
+    /// <summary>
+    /// Generates the legal moves of the side to move.
+    /// Dispatches once on the side to move to a generator specialized for that color
+    /// </summary>
+    /// <typeparam name="Type"><c>GenType</c> The subset of moves to generate</typeparam>
+    /// <param name="moves"><c>vector</c> Cleared and filled with the generated moves</param>
+    template<GenType Type>
+    static auto GenerateMoves(std::vector<Move>& moves) -> void;
+
+    /// <summary>
+    /// Finds the legal move of the side to move that matches the coordinate notation
+    /// </summary>
+    /// <param name="notation"><c>string</c> The move in coordinate notation, e.g. <c>e2e4</c> or <c>e7e8q</c></param>
+    /// <returns><c>Move</c> The matching move, or nothing if no legal move matches</returns>
+    static auto FindMove(std::string_view notation) -> std::optional<Move>;
+
+    /// <summary>
+    /// Counts the leaf nodes of the legal move tree to the specified depth
+    /// </summary>
+    /// <param name="depth"><c>int</c> The depth of the tree in plies</param>
+    static auto Perft(int depth) -> uint64_t;
+
+    /// <summary>
+    /// Counts the leaf nodes like <c>Perft</c>, but stores the counts of subtrees in a cache
+    /// so that transpositions are only counted once
+    /// </summary>
+    /// <param name="depth"><c>int</c> The depth of the tree in plies</param>
+    /// <param name="cache"><c>PerftCache</c> The cache of subtree counts, may hold counts of earlier runs</param>
+    static auto Perft(int depth, PerftCache& cache) -> uint64_t;
+
+    /// <summary>
+    /// Gets the squares occupied by one side
+    /// </summary>
+    static auto GetOccupancy(bool white) -> Bitboard;
+
+    /// <summary>
+    /// Gets the Zobrist hash of the current position
+    /// </summary>
+    static auto GetHash() -> uint64_t;
+
+    /// <summary>
+    /// Calculates the Zobrist hash of the current position from scratch
+    /// </summary>
+    static auto ComputeHash() -> uint64_t;
+
+    static auto IsWhiteToMove() -> bool;
+
+    /// <summary>
+    /// Checks if the king of the side to move is attacked
+    /// </summary>
+    static auto IsInCheck() -> bool;
+
+    /// <summary>
+    /// Gets the number of plies since the last capture or pawn move
+    /// </summary>
+    static auto GetHalfmoveClock() -> int;
+
+    /// <summary>
+    /// Gets the number of the full move, starting at 1 and incremented after every move of black
+    /// </summary>
+    static auto GetFullmoveNumber() -> int;
+
+    /// <summary>
+    /// Checks if the current position has occurred before. Only positions since the last capture,
+    /// pawn move or null move are scanned, as earlier positions can never repeat.
+    /// A single earlier occurrence within the last <c>plies</c> plies counts, since a search can repeat
+    /// it again; otherwise two earlier occurrences are required, as for the threefold repetition rule
+    /// </summary>
+    /// <param name="plies"><c>int</c> The number of plies played since the search root, zero for the game rule</param>
+    static auto IsRepetition(int plies = 0) -> bool;
+
     static auto CalculateLegalMoves(const Position& pos, const Piece& piece, std::vector<Move>& moves) -> void;
 
+    template<Color Us>
     static auto CalculatePawnAttacks(Position position, bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void;
+    template<Color Us, GenType Type>
     static auto CalculatePawnMoves(Position position, std::vector<Move>& moves) -> void;
 
+    template<Color Us>
     static auto CalculateRookAttacks(Position position, bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void;
+    template<Color Us, GenType Type>
     static auto CalculateRookMoves(Position position, std::vector<Move>& moves) -> void;
 
+    template<Color Us>
     static auto CalculateBishopAttacks(Position position, bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void;
+    template<Color Us, GenType Type>
     static auto CalculateBishopMoves(Position position, std::vector<Move>& moves) -> void;
 
+    template<Color Us>
     static auto CalculateKnightAttacks(Position position, bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void;
+    template<Color Us, GenType Type>
     static auto CalculateKnightMoves(Position position, std::vector<Move>& moves) -> void;
 
+    template<Color Us>
     static auto CalculateQueenAttacks(Position position, bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void;
+    template<Color Us, GenType Type>
     static auto CalculateQueenMoves(Position position, std::vector<Move>& moves) -> void;
 
+    template<Color Us>
 	static auto CalculateKingAttacks(Position position, bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void;
+    template<Color Us, GenType Type>
     static auto CalculateKingMoves(Position position, std::vector<Move>& moves) -> void;
 
+    template<Color Us>
     static auto UpdateCheckState() -> void;
 
+    /// <summary>
+    /// Gets the square of a king, kept up to date by the moves so that no square is searched
+    /// </summary>
+    /// <returns><c>Position</c> The square of the king, or -1, -1 if the side has none</returns>
     static auto GetKingPosition(bool white) -> Position;
 
-    static auto CheckForPins(const Position& ignorePos, std::vector<Position>& freeSquares) -> bool;
+    /// <summary>
+    /// Checks if a piece of <c>Us</c> is pinned to its king
+    /// </summary>
+    /// <param name="ignorePos"><c>Position</c> The square of the piece to check</param>
+    /// <param name="freeSquares"><c>Bitboard</c> The squares the piece may still move to if it was pinned</param>
+    template<Color Us>
+    static auto CheckForPins(const Position& ignorePos, Bitboard& freeSquares) -> bool;
 
     static auto GetSquaresBetween(const Position& start, const Position& end, std::vector<Position>& squares) -> void;
 
+    /// <summary>
+    /// Checks if the opponent of <c>Us</c> attacks the specified square
+    /// </summary>
+    /// <param name="square"><c>Position</c> The square to check</param>
+    /// <param name="ignorePos"><c>Position</c> A square that sliding attacks pass through as if it was empty</param>
+    template<Color Us>
+    static auto IsSquareAttacked(Position square, Position ignorePos) -> bool;
+
 private:
 
     struct CheckStateData {
 	    bool IsInCheck;
-		std::vector<Position> Threats;
-        std::vector<Position> BlockingSquares;
+		Bitboard Threats;
+        Bitboard BlockingSquares;
+    };
+
+    /// <summary>
+    /// The state <c>MakeMove</c> destroys and <c>UnmakeMove</c> restores
+    /// </summary>
+    struct UndoData {
+        PieceFlag Captured;
+        int HalfmoveClock;
+        int PliesSinceNullMove;
+        bool EnPassantAvailable;
+        Position EnPassantPosition;
+        bool WhiteCanCastleKingSide;
+        bool WhiteCanCastleQueenSide;
+        bool BlackCanCastleKingSide;
+        bool BlackCanCastleQueenSide;
     };
 
     /// <summary>
-    /// Checks if the specified char is empty space in FEN notation and initializes the amount
+    /// Generates the legal moves of <c>Us</c>, which must be the side to move
+    /// </summary>
+    template<Color Us, GenType Type>
+    static auto GenerateMoves(std::vector<Move>& moves) -> void;
+
+    /// <summary>
+    /// Generates the legal moves of a single piece. Expects an up to date check state
+    /// </summary>
+    template<Color Us, GenType Type>
+    static auto CalculatePieceMoves(const Position& pos, PieceFlag type, std::vector<Move>& moves) -> void;
+
+    /// <summary>
+    /// Gets the squares a piece of <c>Us</c> may move to without leaving its king in check: along its pin if it
+    /// is pinned, and onto the threat or its line while in check
+    /// </summary>
+    template<Color Us>
+    static auto AllowedSquares(Position position) -> Bitboard;
+
+    /// <summary>
+    /// Adds a move to every target square in square order, a capture where an enemy piece stands
+    /// </summary>
+    template<Color Us, GenType Type>
+    static auto AddMoves(Position position, Bitboard targets, std::vector<Move>& moves) -> void;
+
+    /// <summary>
+    /// Adds the moves along consecutive rays, ray by ray, filtered by pins and checks
+    /// </summary>
+    template<Color Us, GenType Type>
+    static auto AddSliderMoves(Position position, int firstDirection, int directions, std::vector<Move>& moves) -> void;
+
+    /// <summary>
+    /// Gets the squares of a leaper attack table entry that are empty or hold an enemy piece
+    /// </summary>
+    template<Color Us>
+    static auto LeaperTargets(Bitboard attacks, bool ignoreEmptySquares) -> Bitboard;
+
+    /// <summary>
+    /// Gets the squares along a ray up to and including the first blocker if it is an enemy piece
+    /// </summary>
+    template<Color Us>
+    static auto RayTargets(Position position, int direction, bool ignoreEmptySquares) -> Bitboard;
+
+    template<Color Us>
+    static auto AddCastlingMoves(Position position, std::vector<Move>& moves) -> void;
+
+    /// <summary>
+    /// Checks if capturing en passant with the pawn on the specified square leaves the king safe
+    /// </summary>
+    template<Color Us>
+    static auto IsEnPassantLegal(Position position) -> bool;
+
+    /// <summary>
+    /// Checks if a pawn of the side to move can legally capture on the en passant square
     /// </summary>
-    /// <param name="c"><c>char</c> The character to check</param>
-    /// <param name="space"><c>int</c> The amount of space if the character was space</param>
-    /// <returns><c>true</c> If the character was space</returns>
-    /// <example>
-    /// <code>
-    /// char c = '5';
-    /// if(int space = 0; IsEmptySpace(c, space)) {
-    ///     // char c was 5 space -> space == 5
-    /// }
-    /// </code>
-    /// </example>
-    static auto IsEmptySpace(const char& c, int& space) -> bool;
+    template<Color Us>
+    static auto CanCaptureEnPassant() -> bool;
 
     /// <summary>
-    /// Checks if the specified char is a piece in FEN notation and initializes the piece
+    /// Gets the hash keys of the castling rights and en passant square currently in effect. The en passant
+    /// square only counts when it can be captured on, otherwise the position is the same as without it
     /// </summary>
-    /// <param name="c"><c>char</c> The character to check</param>
-    /// <param name="piece"><c>Piece</c> The piece if the character was a piece</param>
-    /// <returns><c>true</c> If the character was a piece</returns>
-    /// <example>
-    /// <code>
-    /// char c = 'p';
-    /// if(Piece p(PieceFlags::Rook | PieceFlags::White); IsPiece(c, p)) {
-    ///     // char c was a black pawn piece -> p == Piece(PieceFlags::Pawn | PieceFlags::Black)
-    /// }
-    /// </code>
-    /// </example>
-    static auto IsPiece(const char& c, Piece& piece) -> bool;
+    static auto StateKey() -> uint64_t;
 
-    inline static CheckStateData s_CheckState;
+    static auto IsOccupied(const Position& square) -> bool;
+
+    /// <summary>
+    /// Revokes castling rights when a king or rook square is moved from or captured on
+    /// </summary>
+    static auto UpdateCastlingRights(const Position& square) -> void;
+
+    inline static thread_local CheckStateData s_CheckState;
+
+    inline static thread_local bool s_WhiteToMove;
+    inline static thread_local bool s_EnPassantAvailable;
+    inline static thread_local bool s_WhiteCanCastleKingSide;
+    inline static thread_local bool s_WhiteCanCastleQueenSide;
+    inline static thread_local bool s_BlackCanCastleKingSide;
+    inline static thread_local bool s_BlackCanCastleQueenSide;
+    inline static thread_local Position s_EnPassantPosition;
+
+    /// <summary>
+    /// The Zobrist hash of the current position, updated incrementally by <c>MakeMove</c>
+    /// </summary>
+    inline static thread_local uint64_t s_Hash;
 
-    inline static bool s_WhiteToMove;
-    inline static bool s_EnPassantAvailable;
-    inline static bool s_WhiteCanCastleKingSide;
-    inline static bool s_WhiteCanCastleQueenSide;
-    inline static bool s_BlackCanCastleKingSide;
-    inline static bool s_BlackCanCastleQueenSide;
-    inline static Position s_EnPassantPosition;
+    inline static thread_local int s_HalfmoveClock;
+    inline static thread_local int s_FullmoveNumber;
+
+    /// <summary>
+    /// The number of plies played since the last <c>SetState</c> or null move, how far back a position can repeat
+    /// </summary>
+    inline static thread_local int s_PliesSinceNullMove;
+
+    /// <summary>
+    /// The hashes of the positions before each move played since the last <c>SetState</c>
+    /// </summary>
+    inline static thread_local std::vector<uint64_t> s_KeyHistory;
+
+    /// <summary>
+    /// The squares occupied by each side, white first
+    /// </summary>
+    inline static thread_local std::array<Bitboard, 2> s_Occupancy;
+
+    /// <summary>
+    /// The square of each king, white first
+    /// </summary>
+    inline static thread_local std::array<Position, 2> s_KingPositions;
+
+    /// <summary>
+    /// Undo records of the moves played since the last <c>SetState</c>
+    /// </summary>
+    inline static thread_local std::vector<UndoData> s_History;
 
     /// <summary>
-    /// The board data containing pieces indexed by positions on the board
+    /// The board data containing pieces indexed by square, a single cache line
     /// </summary>
-    inline static std::unordered_map<Position, Piece> s_BoardData;
+    inline static thread_local std::array<Piece, 64> s_BoardData;
 };
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <sys/types.h>
+
+/// <summary>
+/// A child process with line based pipes connected to its standard input and output
+/// </summary>
+class ChildProcess final {
+public:
+    ChildProcess() noexcept = default;
+
+    /// <summary>
+    /// Starts a new process. Throws if the process could not be created
+    /// </summary>
+    /// <param name="args"><c>vector</c> The path to the executable followed by its arguments</param>
+    explicit ChildProcess(const std::vector<std::string>& args);
+
+    ChildProcess(const ChildProcess&) = delete;
+    auto operator=(const ChildProcess&) -> ChildProcess& = delete;
+
+    ChildProcess(ChildProcess&& other) noexcept;
+    auto operator=(ChildProcess&& other) noexcept -> ChildProcess&;
+
+    /// <summary>
+    /// Kills the process if it is still running
+    /// </summary>
+    ~ChildProcess();
+
+    /// <summary>
+    /// Writes a line to the standard input of the process
+    /// </summary>
+    /// <returns><c>true</c> if the whole line was written</returns>
+    auto WriteLine(std::string_view line) -> bool;
+
+    /// <summary>
+    /// Reads a line from the standard output of the process, waiting for at most the specified time
+    /// </summary>
+    /// <param name="line"><c>string</c> The line without its line break</param>
+    /// <param name="timeoutMs"><c>int</c> The time to wait in milliseconds, negative to wait forever</param>
+    /// <returns><c>true</c> if a line was read, <c>false</c> on timeout or when the output was closed</returns>
+    auto ReadLine(std::string& line, int timeoutMs) -> bool;
+
+    /// <summary>
+    /// Takes a complete line from the already received output without blocking
+    /// </summary>
+    auto TryReadLine(std::string& line) -> bool;
+
+    /// <summary>
+    /// Receives the output that is available without blocking.
+    /// Meant to be called when polling reports the output descriptor readable
+    /// </summary>
+    /// <returns><c>false</c> if the output was closed</returns>
+    auto Receive() -> bool;
+
+    /// <summary>
+    /// Gets the descriptor of the output pipe for polling
+    /// </summary>
+    [[nodiscard]] auto OutputDescriptor() const noexcept -> int;
+
+    /// <summary>
+    /// Checks if the process has been started and has not been reaped
+    /// </summary>
+    [[nodiscard]] auto IsRunning() const noexcept -> bool;
+
+    /// <summary>
+    /// Kills the process and waits for it to exit
+    /// </summary>
+    auto Kill() -> void;
+
+    /// <summary>
+    /// Closes the input of the process and waits for it to exit on its own
+    /// </summary>
+    /// <returns><c>int</c> The exit status of the process</returns>
+    auto Wait() -> int;
+
+private:
+    auto CloseDescriptors() noexcept -> void;
+
+    pid_t m_Pid = -1;
+    int m_Input = -1;
+    int m_Output = -1;
+    std::string m_Buffer;
+};
\ No newline at end of file
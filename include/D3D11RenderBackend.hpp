@@ -0,0 +1,105 @@
+#pragma once
+#include <RenderBackend.hpp>
+
+/// <summary>
+/// Draws the scene with Direct3D 11. Pieces and highlights are drawn with one instanced draw each,
+/// reading their positions and atlas sprites from a per-instance vertex buffer
+/// </summary>
+class D3D11RenderBackend final : public RenderBackend {
+public:
+    /// <summary>
+    /// Creates the buffers, states, shaders and piece atlas of the backend on a device
+    /// </summary>
+    D3D11RenderBackend(ComPtr<ID3D11Device5> device, ComPtr<ID3D11DeviceContext4> context);
+
+    auto BeginFrame(const FrameConstants& constants) -> void override;
+    auto DrawBoard() -> void override;
+    auto DrawHighlights(std::span<const QuadInstance> instances) -> void override;
+    auto DrawPieces(std::span<const QuadInstance> instances) -> void override;
+    auto EndFrame() -> void override;
+
+private:
+
+    /// <summary>
+    /// A Vertex struct that contains position and uv
+    /// </summary>
+    struct Vertex final {
+        Vector2 position;
+        Vector2 uv;
+    };
+
+    /// <summary>
+    /// Creates Vertex, Index, Instance and Constant buffers
+    /// </summary>
+    auto CreateBuffers() -> void;
+
+    /// <summary>
+    /// Compiles shaders to shader objects and creates the input layout from the piece shader
+    /// </summary>
+    auto CompileShaders() -> void;
+
+    /// <summary>
+    /// Creates DepthStencilStates, RasterizerStates, BlendStates and SamplerStates
+    /// </summary>
+    auto InitDrawingState() -> void;
+
+    /// <summary>
+    /// Maps the packed piece atlas and uploads its mip chain and sprite rectangles
+    /// </summary>
+    auto LoadPieceAtlas() -> void;
+
+    /// <summary>
+    /// Copies instances into the instance buffer with a single Map/Unmap
+    /// </summary>
+    auto UploadInstances(std::span<const QuadInstance> instances) -> void;
+
+    /// <summary>
+    /// Binds the geometry and pipeline state shared by every draw
+    /// </summary>
+    auto BindPipeline() -> void;
+
+    /// <summary>
+    /// Contains vertices for a quad with UV coordinates
+    /// </summary>
+    static constexpr std::array<Vertex, 4> quad {
+        {
+            { { 0.0F, 0.0F }, { 0.0F, 0.0F } },
+            { { 1.0F, 0.0F }, { 1.0F, 0.0F } },
+            { { 1.0F, 1.0F }, { 1.0F, 1.0F } },
+            { { 0.0F, 1.0F }, { 0.0F, 1.0F } },
+        }
+    };
+
+    /// <summary>
+    /// Contains indices for a quad
+    /// </summary>
+    static constexpr std::array<uint32_t, 6> indices {
+        0, 1, 2, 0, 2, 3
+    };
+
+    ComPtr<ID3D11Device5> m_Device;
+    ComPtr<ID3D11DeviceContext4> m_DeviceContext;
+
+    ComPtr<ID3D11Buffer> m_VertexBuffer;
+    ComPtr<ID3D11Buffer> m_InstanceBuffer;
+    ComPtr<ID3D11Buffer> m_IndexBuffer;
+    ComPtr<ID3D11Buffer> m_ConstantBuffer;
+    ComPtr<ID3D11Buffer> m_TileBuffer;
+    ComPtr<ID3D11InputLayout> m_InputLayout;
+    ComPtr<ID3D11DepthStencilState> m_DepthStencilStateBoard;
+    ComPtr<ID3D11DepthStencilState> m_DepthStencilStatePiece;
+    ComPtr<ID3D11RasterizerState2> m_RasterizerState;
+    ComPtr<ID3D11BlendState1> m_BlendState;
+    ComPtr<ID3D11SamplerState> m_SamplerState;
+    ComPtr<ID3D11ShaderResourceView> m_PieceTextures;
+
+    // Shaders
+    ComPtr<ID3D11VertexShader> m_BoardShaderVertex;
+    ComPtr<ID3D11PixelShader> m_BoardShaderPixel;
+
+    ComPtr<ID3D11VertexShader> m_PieceShaderVertex;
+    ComPtr<ID3D11PixelShader> m_PieceShaderPixel;
+
+    ComPtr<ID3D11VertexShader> m_HighlightShaderVertex;
+    ComPtr<ID3D11PixelShader> m_HighlightShaderPixel;
+};
\ No newline at end of file
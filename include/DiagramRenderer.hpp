@@ -0,0 +1,62 @@
+#pragma once
+#include <Fen.hpp>
+#include <PieceAtlas.hpp>
+#include <RenderBackend.hpp>
+
+/// <summary>
+/// Draws board diagrams on the CPU, with the square colors of <c>board.hlsl</c> and the sprites of the piece atlas.
+/// Sprites are resampled once on construction, after which rendering only copies rows and blends sprites,
+/// so a renderer can be shared by any number of threads
+/// </summary>
+class DiagramRenderer final {
+public:
+    /// <summary>
+    /// The squares of <c>board.hlsl</c> as 8-bit RGB, a1 is dark
+    /// </summary>
+    static constexpr std::array<uint8_t, 3> DarkSquare { 105, 36, 19 };
+    static constexpr std::array<uint8_t, 3> LightSquare { 241, 195, 142 };
+
+    /// <summary>
+    /// Prepares the board and the sprites for a square size
+    /// </summary>
+    /// <param name="atlas"><c>PieceAtlas</c> The piece sprites, only read during construction</param>
+    /// <param name="squareSize"><c>uint32_t</c> The width and height of a square in pixels</param>
+    /// <exception cref="std::invalid_argument">The square size is zero or the atlas lacks sprites</exception>
+    DiagramRenderer(const PieceAtlas& atlas, uint32_t squareSize);
+
+    /// <summary>
+    /// Gets the width and height of a diagram in pixels
+    /// </summary>
+    [[nodiscard]] auto GetImageSize() const noexcept -> uint32_t;
+
+    /// <summary>
+    /// Gets the number of bytes of a diagram, opaque 8-bit RGBA
+    /// </summary>
+    [[nodiscard]] auto GetImageBytes() const noexcept -> size_t;
+
+    /// <summary>
+    /// Draws a position, rows from the top
+    /// </summary>
+    /// <param name="state"><c>State</c> The position to draw</param>
+    /// <param name="image"><c>span</c> At least <c>GetImageBytes</c> bytes</param>
+    /// <param name="flipped"><c>bool</c> Draws the board from the side of black</param>
+    auto Render(const Fen::State& state, std::span<uint8_t> image, bool flipped = false) const -> void;
+
+private:
+    /// <summary>
+    /// Blends premultiplied sprite pixels over opaque image pixels, four pixels at a time where SSE2 is available
+    /// </summary>
+    static auto BlendRow(uint8_t* destination, const uint8_t* source, size_t pixels) noexcept -> void;
+
+    uint32_t m_SquareSize;
+
+    /// <summary>
+    /// The empty board, copied into every diagram before the pieces are drawn
+    /// </summary>
+    std::vector<uint8_t> m_Board;
+
+    /// <summary>
+    /// Premultiplied RGBA sprites of a square each, in the order of <c>RenderBackend::PieceTextureIndex</c>
+    /// </summary>
+    std::array<std::vector<uint8_t>, RenderBackend::PieceTextureCount> m_Sprites;
+};
\ No newline at end of file
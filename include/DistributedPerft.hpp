@@ -0,0 +1,113 @@
+#pragma once
+
+#include <ChildProcess.hpp>
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <map>
+
+/// <summary>
+/// Counts perft by splitting the move tree into subtree jobs that local worker processes count.
+/// Jobs of crashed, failing or stuck workers are retried, and finished jobs are checkpointed
+/// to disk so an interrupted run can be resumed
+/// </summary>
+class DistributedPerft final {
+public:
+    struct Options {
+        std::string Fen;
+        int Depth = 1;
+
+        /// <summary>
+        /// The number of plies played by the coordinator to create the jobs
+        /// </summary>
+        int SplitDepth = 1;
+        int Workers = 1;
+
+        /// <summary>
+        /// The number of times a job is started before the run is abandoned
+        /// </summary>
+        int MaxAttempts = 3;
+
+        /// <summary>
+        /// The time after which a worker is considered stuck, zero for no limit
+        /// </summary>
+        int JobTimeoutSeconds = 0;
+
+        /// <summary>
+        /// The file finished jobs are appended to, empty for no checkpoints
+        /// </summary>
+        std::string CheckpointPath;
+
+        /// <summary>
+        /// The executable started with <c>--worker</c> for each worker process
+        /// </summary>
+        std::string WorkerExecutable;
+    };
+
+    explicit DistributedPerft(Options options);
+
+    /// <summary>
+    /// Runs the coordinator until every job has been counted. Throws if a job keeps failing
+    /// </summary>
+    /// <returns><c>uint64_t</c> The number of leaf nodes</returns>
+    auto Run() -> uint64_t;
+
+    /// <summary>
+    /// Gets the leaf node counts of each root move after a run
+    /// </summary>
+    [[nodiscard]] auto GetDivide() const -> const std::map<std::string, uint64_t>&;
+
+    /// <summary>
+    /// Gets the number of jobs that had to be started again
+    /// </summary>
+    [[nodiscard]] auto GetRetries() const noexcept -> int;
+
+    /// <summary>
+    /// Serves jobs of a coordinator until told to quit or the input is closed
+    /// </summary>
+    /// <returns><c>int</c> Exit code</returns>
+    static auto RunWorker(std::istream& input, std::ostream& output) -> int;
+
+private:
+    struct Job {
+        std::string Moves;
+        int Attempts;
+        std::optional<uint64_t> Nodes;
+    };
+
+    struct Worker {
+        ChildProcess Process;
+        std::optional<size_t> Job;
+        std::chrono::steady_clock::time_point Started;
+    };
+
+    /// <summary>
+    /// Collects every line of play of split depth plies as a job
+    /// </summary>
+    auto CreateJobs(int depth, const std::string& moves) -> void;
+
+    /// <summary>
+    /// Restores finished jobs from the checkpoint and opens it for appending
+    /// </summary>
+    auto OpenCheckpoint() -> void;
+
+    auto StartWorker(Worker& worker) -> void;
+
+    auto AssignJob(Worker& worker) -> void;
+
+    auto HandleLine(Worker& worker, std::string_view line) -> void;
+
+    /// <summary>
+    /// Requeues the job of a worker and replaces the worker process
+    /// </summary>
+    auto FailJob(Worker& worker, std::string_view reason) -> void;
+
+    Options m_Options;
+    std::vector<Job> m_Jobs;
+    std::deque<size_t> m_Pending;
+    size_t m_Remaining = 0;
+    int m_Retries = 0;
+    std::ofstream m_Checkpoint;
+    std::map<std::string, uint64_t> m_Divide;
+};
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include <Bitboard.hpp>
+
+#include <span>
+
+class Move;
+enum class PieceFlag : uint8_t;
+
+/// <summary>
+/// Static evaluation of the position on the board of the calling thread
+/// </summary>
+class Evaluation final {
+public:
+    /// <summary>
+    /// Evaluates the position with material and piece-square tables, tapered between the middlegame and the endgame
+    /// </summary>
+    /// <returns><c>int</c> The score in centipawns from the point of view of the side to move</returns>
+    static auto Evaluate() -> int;
+
+    /// <summary>
+    /// Evaluates a position given as bitboards, with the same result as <c>Evaluate</c> on the board
+    /// </summary>
+    /// <param name="pieces"><c>span</c> A bitboard per piece kind in the order of <c>PositionBatch::Kind</c></param>
+    /// <returns><c>int</c> The score in centipawns from the point of view of the side to move</returns>
+    static auto Evaluate(std::span<const Bitboard, 12> pieces, bool whiteToMove) -> int;
+
+    /// <summary>
+    /// Gets the material value of a piece type in centipawns, ignoring its color
+    /// </summary>
+    static auto PieceValue(PieceFlag piece) -> int;
+
+    /// <summary>
+    /// Gets the middlegame piece-square value of a piece on a square in centipawns, without its material
+    /// </summary>
+    /// <param name="piece"><c>PieceFlag</c> The type and color of the piece</param>
+    static auto PieceSquare(PieceFlag piece, int square) -> int;
+
+    /// <summary>
+    /// Resolves the sequence of captures on the target square of a move, each side recapturing with its least
+    /// valuable attacker and standing pat whenever recapturing loses material. Pins are not taken into account
+    /// </summary>
+    /// <param name="move"><c>Move</c> A legal move of the side to move, usually a capture</param>
+    /// <returns><c>int</c> The material the side to move gains in centipawns, negative when the move loses material</returns>
+    static auto StaticExchange(const Move& move) -> int;
+};
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+
+enum class PieceFlag : uint8_t;
+
+/// <summary>
+/// Parses and writes positions in FEN and EPD notation without allocating
+/// </summary>
+class Fen final {
+public:
+    /// <summary>
+    /// The start position of a standard game
+    /// </summary>
+    static constexpr std::string_view StartPosition = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    /// <summary>
+    /// The longest FEN <c>Write</c> can produce, clocks included
+    /// </summary>
+    static constexpr size_t MaxLength = 128;
+
+    enum class Error : uint8_t {
+        None,
+        MissingField,
+        InvalidPiece,
+        RankTooLong,
+        RankTooShort,
+        WrongRankCount,
+        PawnOnBackRank,
+        WrongKingCount,
+        InvalidSideToMove,
+        OpponentInCheck,
+        InvalidCastlingRights,
+        CastlingWithoutKingOrRook,
+        InvalidEnPassantSquare,
+        InvalidHalfmoveClock,
+        InvalidFullmoveNumber,
+        TrailingCharacters
+    };
+
+    /// <summary>
+    /// The outcome of parsing. Converts to <c>true</c> on success
+    /// </summary>
+    struct Result {
+        Error Code = Error::None;
+
+        /// <summary>
+        /// The offset of the character where parsing failed
+        /// </summary>
+        size_t Offset = 0;
+
+        constexpr explicit operator bool() const noexcept {
+            return Code == Error::None;
+        }
+    };
+
+    /// <summary>
+    /// Every field of a FEN record. Squares are indexed from a1 to h8
+    /// </summary>
+    struct State {
+        std::array<PieceFlag, 64> Squares {};
+        bool WhiteToMove = true;
+        bool WhiteCanCastleKingSide = false;
+        bool WhiteCanCastleQueenSide = false;
+        bool BlackCanCastleKingSide = false;
+        bool BlackCanCastleQueenSide = false;
+
+        /// <summary>
+        /// The square a pawn may be captured on en passant, -1 if there is none
+        /// </summary>
+        int EnPassantSquare = -1;
+        int HalfmoveClock = 0;
+        int FullmoveNumber = 1;
+    };
+
+    /// <summary>
+    /// Parses and validates a FEN record. The clocks may be left out and default to <c>0 1</c>
+    /// </summary>
+    /// <param name="fen"><c>string_view</c> The FEN record</param>
+    /// <param name="state"><c>State</c> Reset and filled with the parsed fields</param>
+    static auto Parse(std::string_view fen, State& state) noexcept -> Result;
+
+    /// <summary>
+    /// Parses and validates an EPD record, four FEN fields followed by operations
+    /// </summary>
+    /// <param name="operations"><c>string_view</c> The operations after the fields, e.g. <c>bm e4; id "1";</c></param>
+    static auto ParseEpd(std::string_view epd, State& state, std::string_view& operations) noexcept -> Result;
+
+    /// <summary>
+    /// Writes a state as a FEN record
+    /// </summary>
+    /// <param name="buffer"><c>span</c> At least <c>MaxLength</c> characters</param>
+    /// <returns><c>size_t</c> The number of characters written, zero if the buffer was too small</returns>
+    static auto Write(const State& state, std::span<char> buffer) noexcept -> size_t;
+
+    static auto ToString(const State& state) -> std::string;
+
+    /// <summary>
+    /// Gets a description of a parse error for messages
+    /// </summary>
+    static auto Describe(Error error) noexcept -> std::string_view;
+};
\ No newline at end of file
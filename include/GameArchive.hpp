@@ -0,0 +1,106 @@
+#pragma once
+#include <GameCodec.hpp>
+#include <MappedFile.hpp>
+#include <PositionIndex.hpp>
+
+#include <filesystem>
+#include <functional>
+#include <span>
+
+/// <summary>
+/// A game collection stored as compactly as its moves allow. Every game is a record of its result, its starting
+/// position when it is not the standard one and its moves encoded with a <c>GameCodec</c> model trained on the
+/// whole collection, which the archive keeps in its header
+/// </summary>
+class GameArchive final {
+public:
+    static constexpr std::array<char, 4> Magic { 'C', 'G', 'M', 'A' };
+    static constexpr uint32_t Version = 1;
+    static constexpr size_t HeaderSize = 64;
+    static constexpr size_t ModelSize = 1024;
+    static constexpr std::string_view Extension = ".cgma";
+
+    /// <summary>
+    /// The archive records where every game with a multiple of this number starts, so decoding can begin there
+    /// </summary>
+    static constexpr uint64_t IndexInterval = 1024;
+
+    using Outcome = PositionIndex::Outcome;
+
+    /// <summary>
+    /// A game as it is stored, pointing into the mapped archive
+    /// </summary>
+    struct Record {
+        Outcome Result = Outcome::Unknown;
+
+        /// <summary>
+        /// The FEN of the starting position, empty for the standard one
+        /// </summary>
+        std::string_view Fen;
+
+        uint32_t Plies = 0;
+        std::span<const uint8_t> Moves;
+    };
+
+    /// <summary>
+    /// Maps an archive file
+    /// </summary>
+    /// <exception cref="std::runtime_error">The file cannot be mapped or is not a valid archive</exception>
+    explicit GameArchive(const std::filesystem::path& path);
+
+    [[nodiscard]] auto GetGameCount() const noexcept -> uint64_t {
+        return m_Games;
+    }
+
+    [[nodiscard]] auto GetMoveCount() const noexcept -> uint64_t {
+        return m_Moves;
+    }
+
+    /// <summary>
+    /// Gets the number of bytes the encoded moves take, without the rest of the records
+    /// </summary>
+    [[nodiscard]] auto GetMoveBytes() const noexcept -> uint64_t {
+        return m_MoveBytes;
+    }
+
+    [[nodiscard]] auto GetModel() const noexcept -> const GameCodec::Model& {
+        return m_Model;
+    }
+
+    /// <summary>
+    /// Finds the record of a game, reading on from the nearest indexed game before it
+    /// </summary>
+    /// <exception cref="std::out_of_range">There is no such game</exception>
+    [[nodiscard]] auto GetRecord(uint64_t game) const -> Record;
+
+    /// <summary>
+    /// Decodes every game, each on the board of one of the threads sharing them. The board is set to the
+    /// starting position of a game and is in its final position while the game is visited
+    /// </summary>
+    /// <param name="threads"><c>int</c> The number of threads decoding games, zero for one per core</param>
+    /// <param name="visit"><c>function</c> Called from the decoding threads with every game and its moves</param>
+    /// <exception cref="std::runtime_error">A game is not valid</exception>
+    auto Replay(int threads, const std::function<void(uint64_t game, const Record& record, std::span<const Move> moves)>& visit) const -> void;
+
+    /// <summary>
+    /// Writes the archive of the games in PGN files. Games whose moves do not replay are left out, the others
+    /// keep the order of the files and are numbered from zero
+    /// </summary>
+    /// <param name="threads"><c>int</c> The number of threads replaying games, zero for one per core</param>
+    /// <exception cref="std::runtime_error">A file cannot be read or the archive cannot be written</exception>
+    static auto Build(std::span<const std::filesystem::path> pgns, const std::filesystem::path& path, int threads = 0) -> PgnReader::ReplayReport;
+
+private:
+    /// <summary>
+    /// Reads the record at a cursor into the records and moves the cursor past it
+    /// </summary>
+    auto ReadRecord(size_t& cursor) const -> Record;
+
+    MappedFile m_File;
+    std::span<const uint8_t> m_Records;
+    std::span<const uint8_t> m_Index;
+    GameCodec::Model m_Model;
+    uint64_t m_Games = 0;
+    uint64_t m_Moves = 0;
+    uint64_t m_MoveBytes = 0;
+};
\ No newline at end of file
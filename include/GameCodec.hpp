@@ -0,0 +1,150 @@
+#pragma once
+#include <Move.hpp>
+
+#include <span>
+
+/// <summary>
+/// Encodes the moves of a game as their ranks in the legal moves of each position, ordered so that the moves
+/// players choose come first: recaptures, winning captures, promotions, then quiet moves by how much they improve
+/// the piece. The ranks are range coded with frequencies trained on a collection, one table per bucket of the
+/// number of legal moves, and a position with a single legal move costs nothing
+/// </summary>
+class GameCodec final {
+public:
+    /// <summary>
+    /// The buckets of legal move counts with a frequency table each: 2, 3-4, 5-8 and so on up to 129-256
+    /// </summary>
+    static constexpr int Contexts = 8;
+
+    /// <summary>
+    /// The frequencies of a table add up to one shifted left by this many bits
+    /// </summary>
+    static constexpr int ProbabilityBits = 15;
+
+    /// <summary>
+    /// The number of frequencies over all tables, a table has one per rank its bucket allows
+    /// </summary>
+    static constexpr size_t SymbolCount = (size_t { 2 } << Contexts) - 2;
+
+    /// <summary>
+    /// A move as the codec sees it: its rank in the ordered legal moves and how many legal moves there were
+    /// </summary>
+    struct Symbol {
+        uint8_t Rank;
+        uint8_t Moves;
+    };
+
+    /// <summary>
+    /// The frequency tables of the ranks
+    /// </summary>
+    class Model final {
+    public:
+        /// <summary>
+        /// Makes a model where every rank a bucket allows is as likely
+        /// </summary>
+        Model();
+
+        /// <summary>
+        /// Makes a model from the symbols of a collection, ranks that never occur keep a small frequency
+        /// </summary>
+        static auto Train(std::span<const Symbol> symbols) -> Model;
+
+        /// <summary>
+        /// Takes the frequencies of every table in order, as <c>GetFrequencies</c> gives them
+        /// </summary>
+        /// <exception cref="std::invalid_argument">The frequencies of a table do not add up</exception>
+        explicit Model(std::span<const uint16_t, SymbolCount> frequencies);
+
+        [[nodiscard]] auto GetFrequencies() const noexcept -> std::span<const uint16_t, SymbolCount> {
+            return m_Frequencies;
+        }
+
+        /// <summary>
+        /// Gets the bucket of a number of legal moves, which must be at least two
+        /// </summary>
+        static auto GetContext(int moves) -> int;
+
+        /// <summary>
+        /// Gets where the table of a bucket starts in the frequencies. Bucket <c>b</c> has two to the
+        /// <c>b + 1</c> ranks
+        /// </summary>
+        static constexpr auto GetOffset(const int context) -> size_t {
+            return (size_t { 2 } << context) - 2;
+        }
+
+        /// <summary>
+        /// Gets the cumulative frequency below a rank of a table, one past the last rank gives the total
+        /// </summary>
+        [[nodiscard]] auto GetCumulative(const int context, const int rank) const noexcept -> uint32_t {
+            return m_Cumulative[GetOffset(context) + static_cast<size_t>(context) + static_cast<size_t>(rank)];
+        }
+
+    private:
+        auto Accumulate() -> void;
+
+        std::array<uint16_t, SymbolCount> m_Frequencies {};
+
+        /// <summary>
+        /// The cumulative frequencies of every table, each with one more entry than the table has ranks
+        /// </summary>
+        std::array<uint32_t, SymbolCount + Contexts> m_Cumulative {};
+    };
+
+    /// <summary>
+    /// Replays an encoded game on the board of the calling thread, which must be in the position the game
+    /// was encoded from
+    /// </summary>
+    class Decoder final {
+    public:
+        /// <param name="bytes"><c>span</c> The encoded moves, which must outlive the decoder</param>
+        /// <param name="plies"><c>uint32_t</c> The number of moves encoded</param>
+        Decoder(const Model& model, std::span<const uint8_t> bytes, uint32_t plies);
+
+        /// <summary>
+        /// Decodes the next move and makes it on the board
+        /// </summary>
+        /// <returns><c>optional</c> The move, nothing after the last move</returns>
+        /// <exception cref="std::runtime_error">The encoded rank is not that of a legal move</exception>
+        auto Next() -> std::optional<Move>;
+
+        /// <summary>
+        /// Unmakes the moves decoded so far, back to the position the game starts from
+        /// </summary>
+        auto Rewind() -> void;
+
+        /// <summary>
+        /// Gets the moves decoded so far, in the order they were played
+        /// </summary>
+        [[nodiscard]] auto GetMoves() const noexcept -> std::span<const Move> {
+            return m_Played;
+        }
+
+    private:
+        auto ReadByte() noexcept -> uint8_t;
+
+        const Model& m_Model;
+        std::span<const uint8_t> m_Bytes;
+        size_t m_Position = 0;
+        uint32_t m_Plies;
+
+        uint32_t m_Range = 0xFFFFFFFFU;
+        uint32_t m_Code = 0;
+
+        std::vector<Move> m_Moves;
+        std::vector<uint32_t> m_Keys;
+        std::vector<Move> m_Played;
+    };
+
+    /// <summary>
+    /// Finds the symbol of a legal move of the position on the board. Moves the codec scores the same are ranked
+    /// in the order of the generator, so encoding and decoding agree
+    /// </summary>
+    /// <param name="previous"><c>Move</c> The move that led to the position, null at the start of a game</param>
+    static auto Rank(const Move& move, const Move* previous) -> Symbol;
+
+    /// <summary>
+    /// Range codes the symbols of a game and appends the bytes. Trailing zero bytes are left out, the decoder
+    /// reads zeros past the end
+    /// </summary>
+    static auto Encode(const Model& model, std::span<const Symbol> symbols, std::vector<uint8_t>& bytes) -> void;
+};
\ No newline at end of file
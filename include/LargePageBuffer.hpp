@@ -0,0 +1,102 @@
+#pragma once
+
+/// <summary>
+/// Zeroed memory for the large shared tables, backed by huge pages where the system offers them and optionally
+/// spread over the NUMA nodes. Every request degrades gracefully: what was actually granted is reported by <c>Describe</c>
+/// </summary>
+class LargePageBuffer final {
+public:
+    /// <summary>
+    /// How the pages of a buffer are placed on the NUMA nodes
+    /// </summary>
+    enum class NumaPolicy : uint8_t {
+        None,       // The pages land on the node of the thread that first writes them
+        Interleave, // The pages are spread round robin over every node
+        FirstTouch  // Each node writes its share of the buffer from a thread pinned to it
+    };
+
+    /// <summary>
+    /// The kind of pages that back a buffer
+    /// </summary>
+    enum class PageMode : uint8_t {
+        Normal,
+        Transparent, // Transparent huge pages requested with madvise
+        Large        // Locked large pages
+    };
+
+    struct Options {
+        bool LargePages = true;
+        NumaPolicy Numa = NumaPolicy::None;
+    };
+
+    /// <summary>
+    /// Sets the options of buffers allocated from now on
+    /// </summary>
+    static auto SetOptions(const Options& options) -> void;
+
+    static auto GetOptions() -> const Options&;
+
+    LargePageBuffer() noexcept = default;
+
+    /// <summary>
+    /// Allocates a zeroed buffer with the current options
+    /// </summary>
+    /// <param name="bytes"><c>size_t</c> The size of the buffer, rounded up to whole pages</param>
+    /// <exception cref="std::bad_alloc">The system is out of memory</exception>
+    explicit LargePageBuffer(size_t bytes);
+
+    LargePageBuffer(LargePageBuffer&& other) noexcept;
+    auto operator=(LargePageBuffer&& other) noexcept -> LargePageBuffer&;
+
+    LargePageBuffer(const LargePageBuffer&) = delete;
+    auto operator=(const LargePageBuffer&) -> LargePageBuffer& = delete;
+
+    ~LargePageBuffer();
+
+    [[nodiscard]] auto Get() const noexcept -> void* {
+        return m_Data;
+    }
+
+    [[nodiscard]] auto GetSize() const noexcept -> size_t {
+        return m_Size;
+    }
+
+    [[nodiscard]] auto GetPageMode() const noexcept -> PageMode {
+        return m_Pages;
+    }
+
+    [[nodiscard]] auto GetNumaPolicy() const noexcept -> NumaPolicy {
+        return m_Numa;
+    }
+
+    /// <summary>
+    /// Describes the size, the pages and the NUMA placement in effect, e.g.
+    /// <c>64 MB, transparent huge pages, interleaved over 2 NUMA nodes</c>
+    /// </summary>
+    [[nodiscard]] auto Describe() const -> std::string;
+
+    static auto GetName(NumaPolicy policy) -> std::string_view;
+
+    /// <summary>
+    /// Parses the name of a policy as given by <c>GetName</c>
+    /// </summary>
+    static auto ParseNumaPolicy(std::string_view name) -> std::optional<NumaPolicy>;
+
+private:
+    auto Release() noexcept -> void;
+
+    /// <summary>
+    /// Places the pages of the buffer on the NUMA nodes as the options ask, if there is more than one node
+    /// </summary>
+    auto PlacePages(NumaPolicy policy) -> void;
+
+    void* m_Data = nullptr;
+    size_t m_Size = 0;
+    size_t m_MappedSize = 0;
+    PageMode m_Pages = PageMode::Normal;
+    NumaPolicy m_Numa = NumaPolicy::None;
+    NumaPolicy m_RequestedNuma = NumaPolicy::None;
+    int m_Nodes = 1;
+
+    static Options s_Options;
+};
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include <filesystem>
+#include <span>
+
+/// <summary>
+/// A read-only memory mapping of a whole file. The mapping stays valid after the file is removed
+/// </summary>
+class MappedFile final {
+public:
+    MappedFile() noexcept = default;
+
+    /// <summary>
+    /// Maps a file that is not empty
+    /// </summary>
+    /// <exception cref="std::runtime_error">The file cannot be opened or mapped</exception>
+    explicit MappedFile(const std::filesystem::path& path);
+
+    MappedFile(MappedFile&& other) noexcept;
+    auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+
+    MappedFile(const MappedFile&) = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+    ~MappedFile();
+
+    [[nodiscard]] auto GetBytes() const noexcept -> std::span<const uint8_t> {
+        return { m_Data, m_Size };
+    }
+
+private:
+    auto Unmap() noexcept -> void;
+
+    const uint8_t* m_Data = nullptr;
+    size_t m_Size = 0;
+
+#ifdef _WIN32
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = nullptr;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+#include <MatchStatistics.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <mutex>
+
+/// <summary>
+/// Plays games between two UCI engines running as child processes, several games at a time.
+/// The rules are enforced on the board of each game thread
+/// </summary>
+class MatchRunner final {
+public:
+    enum class GameResult {
+        WhiteWins,
+        BlackWins,
+        Draw
+    };
+
+    struct EngineConfig {
+        std::string Name;
+
+        /// <summary>
+        /// The path to the executable followed by its arguments, separated by spaces
+        /// </summary>
+        std::string Command;
+
+        /// <summary>
+        /// UCI options sent to the engine after it has started
+        /// </summary>
+        std::vector<std::pair<std::string, std::string>> Options;
+    };
+
+    struct Options {
+        EngineConfig First;
+        EngineConfig Second;
+
+        /// <summary>
+        /// A file of FEN or EPD lines, each played twice with colors reversed. Empty to play from the start position
+        /// </summary>
+        std::string OpeningsPath;
+
+        int Games = 2;
+        int Concurrency = 1;
+
+        // Move limits, one of them is required
+        uint64_t Nodes = 0;
+        int Depth = 0;
+        int TimeMs = 0;
+        int IncrementMs = 0;
+
+        /// <summary>
+        /// The time an engine may exceed its clock by before it loses on time
+        /// </summary>
+        int TimeMarginMs = 100;
+
+        /// <summary>
+        /// Games reaching this many plies are adjudicated as draws, zero for no limit
+        /// </summary>
+        int MaxPlies = 600;
+
+        /// <summary>
+        /// The file finished games are appended to, empty for no PGN
+        /// </summary>
+        std::string PgnPath;
+
+        double Elo0 = 0.0;
+        double Elo1 = 5.0;
+        double Alpha = 0.05;
+        double Beta = 0.05;
+
+        /// <summary>
+        /// Stop starting new games once the SPRT has accepted a hypothesis
+        /// </summary>
+        bool StopOnVerdict = true;
+    };
+
+    struct Adjudication {
+        GameResult Result;
+        std::string Reason;
+    };
+
+    /// <summary>
+    /// Probes the position on the board of the calling thread and returns the game result if it is known
+    /// </summary>
+    using TablebaseProbe = std::function<std::optional<Adjudication>()>;
+
+    explicit MatchRunner(Options options);
+
+    /// <summary>
+    /// Sets the tablebase consulted after every move, adjudicating the game as soon as it returns a result
+    /// </summary>
+    auto SetTablebaseProbe(TablebaseProbe probe) -> void;
+
+    /// <summary>
+    /// Plays the match and prints the results after every game
+    /// </summary>
+    /// <returns><c>MatchStatistics</c> The results from the point of view of the first engine</returns>
+    auto Run() -> const MatchStatistics&;
+
+private:
+    class EngineProcess;
+
+    struct Game {
+        size_t Index;
+        std::string Fen;
+        bool FirstIsWhite;
+        std::vector<std::string> Moves;
+        std::vector<std::string> Comments;
+        GameResult Result;
+        std::string Termination;
+        std::string Reason;
+    };
+
+    /// <summary>
+    /// The body of a game thread, plays games until the match is over
+    /// </summary>
+    auto PlayGames() -> void;
+
+    auto PlayGame(Game& game, std::array<EngineProcess*, 2> engines) -> void;
+
+    /// <summary>
+    /// Ends the game if the rules, the tablebase or the ply limit decide it
+    /// </summary>
+    auto Adjudicate(Game& game, int plies) const -> bool;
+
+    /// <summary>
+    /// Adds a finished game to the statistics and the PGN file
+    /// </summary>
+    auto RecordGame(const Game& game) -> void;
+
+    auto WritePgn(const Game& game) -> void;
+
+    auto LoadOpenings() -> void;
+
+    Options m_Options;
+    TablebaseProbe m_TablebaseProbe;
+    std::vector<std::string> m_Openings;
+
+    std::atomic<size_t> m_NextGame = 0;
+    std::atomic<bool> m_Stop = false;
+
+    std::mutex m_ResultMutex;
+    MatchStatistics m_Statistics;
+    std::ofstream m_Pgn;
+};
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+/// <summary>
+/// Game results of one engine against another, with an Elo estimate and a sequential probability ratio test
+/// </summary>
+class MatchStatistics final {
+public:
+    enum class Verdict {
+        Continue, // Not enough games to decide
+        AcceptH0, // The difference is at most Elo0
+        AcceptH1  // The difference is at least Elo1
+    };
+
+    /// <summary>
+    /// Initializes the test of Elo0 against Elo1
+    /// </summary>
+    /// <param name="elo0"><c>double</c> The Elo difference of the null hypothesis</param>
+    /// <param name="elo1"><c>double</c> The Elo difference of the alternative hypothesis</param>
+    /// <param name="alpha"><c>double</c> The probability of accepting H1 when H0 is true</param>
+    /// <param name="beta"><c>double</c> The probability of accepting H0 when H1 is true</param>
+    MatchStatistics(double elo0, double elo1, double alpha, double beta);
+
+    /// <summary>
+    /// Adds the result of a game from the point of view of the first engine
+    /// </summary>
+    /// <param name="score"><c>double</c> 1 for a win, 0.5 for a draw and 0 for a loss</param>
+    auto AddResult(double score) -> void;
+
+    [[nodiscard]] auto GetWins() const noexcept -> int;
+    [[nodiscard]] auto GetDraws() const noexcept -> int;
+    [[nodiscard]] auto GetLosses() const noexcept -> int;
+    [[nodiscard]] auto GetGames() const noexcept -> int;
+
+    /// <summary>
+    /// Gets the mean score of the first engine in range [0, 1]
+    /// </summary>
+    [[nodiscard]] auto GetScore() const -> double;
+
+    /// <summary>
+    /// Gets the Elo difference implied by the score
+    /// </summary>
+    [[nodiscard]] auto GetElo() const -> double;
+
+    /// <summary>
+    /// Gets the half width of the 95% confidence interval of the Elo difference
+    /// </summary>
+    [[nodiscard]] auto GetEloError() const -> double;
+
+    /// <summary>
+    /// Gets the log-likelihood ratio of H1 against H0 using the normal approximation of the score
+    /// </summary>
+    [[nodiscard]] auto GetLlr() const -> double;
+
+    [[nodiscard]] auto GetLowerBound() const -> double;
+    [[nodiscard]] auto GetUpperBound() const -> double;
+
+    [[nodiscard]] auto GetVerdict() const -> Verdict;
+
+    /// <summary>
+    /// Formats the results on a single line, e.g. for printing after every game
+    /// </summary>
+    [[nodiscard]] auto ToString() const -> std::string;
+
+private:
+    [[nodiscard]] auto GetVariance() const -> double;
+
+    double m_Elo0;
+    double m_Elo1;
+    double m_Alpha;
+    double m_Beta;
+
+    int m_Wins = 0;
+    int m_Draws = 0;
+    int m_Losses = 0;
+};
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+#include <Board.hpp>
+#include <Move.hpp>
+
+#include <atomic>
+
+/// <summary>
+/// Proves or disproves forced mates with depth-first proof-number search (df-pn).
+/// Every thread searches its share of the root moves with a transposition table of its own,
+/// the memory cap is split between them
+/// </summary>
+class MateSolver final {
+public:
+    enum class Result : uint8_t {
+        Proven,    // The attacker mates within the depth
+        Disproven, // The defender avoids mate within the depth
+        Unknown    // The node budget ran out first
+    };
+
+    struct Options {
+        /// <summary>
+        /// The longest mate searched for, in moves of the attacker
+        /// </summary>
+        int Depth = 5;
+
+        /// <summary>
+        /// The node budget shared by all threads, zero for no limit
+        /// </summary>
+        uint64_t Nodes = 0;
+
+        int Threads = 1;
+
+        /// <summary>
+        /// Searches mates of every length up to the depth, so that a proof is always the shortest mate
+        /// </summary>
+        bool Shortest = true;
+    };
+
+    struct Solution {
+        Result Outcome = Result::Unknown;
+
+        /// <summary>
+        /// The length of the proven mate in moves of the attacker, zero when the defender is already mated or
+        /// there is no proof
+        /// </summary>
+        int MateIn = 0;
+
+        /// <summary>
+        /// A mating line from the position. It has been replayed on the board and ends in checkmate, it is empty
+        /// when the defender is already mated
+        /// </summary>
+        std::vector<Move> Line;
+
+        uint64_t Nodes = 0;
+        int64_t Milliseconds = 0;
+    };
+
+    /// <summary>
+    /// Allocates the transposition tables of the solver
+    /// </summary>
+    /// <param name="megabytes"><c>size_t</c> The memory cap of all tables together</param>
+    explicit MateSolver(size_t megabytes);
+
+    ~MateSolver();
+
+    /// <summary>
+    /// Searches for a forced mate by one side. The board of the calling thread is left at the position
+    /// </summary>
+    /// <param name="fen"><c>string</c> The position to solve</param>
+    /// <param name="attacker"><c>Color</c> The side that has to give mate, either side may be to move</param>
+    /// <param name="options"><c>Options</c> The depth, node budget and threads of the search</param>
+    /// <exception cref="std::invalid_argument">The FEN is malformed or the depth is less than one move</exception>
+    auto Solve(std::string_view fen, Board::Color attacker, const Options& options) -> Solution;
+
+    /// <summary>
+    /// Makes a running solve return as soon as possible. Safe to call from any thread
+    /// </summary>
+    auto Stop() -> void;
+
+    static auto GetName(Result result) -> std::string_view;
+
+private:
+    class Worker;
+
+    /// <summary>
+    /// Solves one mate length, every thread searching the root moves whose index matches its own
+    /// </summary>
+    auto SolveDepth(std::string_view fen, bool attackerWhite, int plies, int threads) -> Result;
+
+    /// <summary>
+    /// Follows the proof in the tables from the root, then replays the line on the board to verify the mate
+    /// </summary>
+    auto ExtractLine(std::string_view fen, bool attackerWhite, int plies) -> std::vector<Move>;
+
+    size_t m_Megabytes;
+    std::vector<std::unique_ptr<Worker>> m_Workers;
+
+    std::atomic<uint64_t> m_Nodes = 0;
+    uint64_t m_NodeLimit = 0;
+    std::atomic<bool> m_Stop = false;
+
+    /// <summary>
+    /// Raised when the share of one thread decides the root, the other threads can give up on theirs
+    /// </summary>
+    std::atomic<bool> m_Decided = false;
+};
\ No newline at end of file
@@ -0,0 +1,211 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <mutex>
+
+/// <summary>
+/// The counters of the metrics registry
+/// </summary>
+enum class Counter : uint8_t {
+    MovegenCalls,
+    MovesGenerated,
+    MakeMoves,
+    UnmakeMoves,
+    TTProbes,
+    TTHits,
+    EvalCalls,
+    BetaCutoffs,
+    FirstMoveCutoffs,
+    Count
+};
+
+/// <summary>
+/// The histograms of the metrics registry, recorded in powers of two
+/// </summary>
+enum class Histogram : uint8_t {
+    FrameTimeMicroseconds,
+    Count
+};
+
+/// <summary>
+/// The metrics of every thread merged together
+/// </summary>
+struct MetricsSnapshot {
+    /// <summary>
+    /// Bucket 0 counts zeros, bucket i the values in [2^(i-1), 2^i), the last bucket everything larger
+    /// </summary>
+    static constexpr size_t BucketCount = 32;
+
+    struct HistogramData {
+        uint64_t Count = 0;
+        uint64_t Sum = 0;
+        uint64_t Min = 0;
+        uint64_t Max = 0;
+        std::array<uint64_t, BucketCount> Buckets {};
+
+        /// <summary>
+        /// Estimates a percentile as the upper bound of the bucket it falls in
+        /// </summary>
+        /// <param name="fraction"><c>double</c> The percentile in range [0, 1]</param>
+        [[nodiscard]] auto Percentile(double fraction) const -> uint64_t;
+    };
+
+    bool Enabled = false;
+    std::array<uint64_t, static_cast<size_t>(Counter::Count)> Counters {};
+    std::array<HistogramData, static_cast<size_t>(Histogram::Count)> Histograms {};
+
+    [[nodiscard]] auto Get(Counter counter) const -> uint64_t;
+    [[nodiscard]] auto Get(Histogram histogram) const -> const HistogramData&;
+
+    /// <summary>
+    /// Formats the metrics as one <c>name value</c> line per counter and a summary line per histogram
+    /// </summary>
+    [[nodiscard]] auto ToText() const -> std::string;
+
+    [[nodiscard]] auto ToJson() const -> std::string;
+
+    static auto GetName(Counter counter) -> std::string_view;
+    static auto GetName(Histogram histogram) -> std::string_view;
+};
+
+/// <summary>
+/// Owns the metrics of every thread. Each thread only ever writes its own block, with relaxed loads and stores
+/// rather than read-modify-write instructions, and blocks are merged when they are read.
+/// The blocks of finished threads are folded into a retired total
+/// </summary>
+class MetricsRegistry final {
+public:
+    struct ThreadData {
+        std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::Count)> Counters {};
+
+        struct HistogramData {
+            std::atomic<uint64_t> Count;
+            std::atomic<uint64_t> Sum;
+            std::atomic<uint64_t> Min { UINT64_MAX };
+            std::atomic<uint64_t> Max;
+            std::array<std::atomic<uint64_t>, MetricsSnapshot::BucketCount> Buckets {};
+        };
+
+        std::array<HistogramData, static_cast<size_t>(Histogram::Count)> Histograms {};
+
+        ThreadData();
+        ThreadData(const ThreadData&) = delete;
+        auto operator=(const ThreadData&) -> ThreadData& = delete;
+        ~ThreadData();
+    };
+
+    /// <summary>
+    /// Gets the block of the calling thread, registered on first use
+    /// </summary>
+    static auto Local() -> ThreadData& {
+        return s_Local;
+    }
+
+    /// <summary>
+    /// Merges the blocks of every thread, live and finished
+    /// </summary>
+    static auto Snapshot() -> MetricsSnapshot;
+
+    /// <summary>
+    /// Zeroes every block. Values recorded concurrently may survive
+    /// </summary>
+    static auto Reset() -> void;
+
+private:
+    static auto Merge(const ThreadData& data, MetricsSnapshot& snapshot) -> void;
+
+    inline static std::mutex s_Mutex;
+    inline static std::vector<ThreadData*> s_Threads;
+    inline static MetricsSnapshot s_Retired;
+    inline static thread_local ThreadData s_Local;
+};
+
+struct MetricsEnabled {
+    static constexpr bool Enabled = true;
+};
+
+struct MetricsDisabled {
+    static constexpr bool Enabled = false;
+};
+
+/// <summary>
+/// The instrumentation interface. With <c>MetricsDisabled</c> every call compiles to nothing,
+/// so instrumented hot paths cost nothing in builds without metrics
+/// </summary>
+/// <typeparam name="Policy"><c>MetricsEnabled</c> or <c>MetricsDisabled</c></typeparam>
+template<typename Policy>
+class BasicMetrics final {
+public:
+    static constexpr bool Enabled = Policy::Enabled;
+
+    static auto Increment(const Counter counter, const uint64_t amount = 1) noexcept -> void {
+        if constexpr (Enabled) {
+            auto& value = MetricsRegistry::Local().Counters[static_cast<size_t>(counter)];
+            value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+    }
+
+    static auto Record(const Histogram histogram, const uint64_t value) noexcept -> void {
+        if constexpr (Enabled) {
+            auto& data = MetricsRegistry::Local().Histograms[static_cast<size_t>(histogram)];
+            const auto add = [](std::atomic<uint64_t>& target, const uint64_t amount) {
+                target.store(target.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+            };
+
+            add(data.Count, 1);
+            add(data.Sum, value);
+            add(data.Buckets[std::min<size_t>(std::bit_width(value), MetricsSnapshot::BucketCount - 1)], 1);
+
+            if (value < data.Min.load(std::memory_order_relaxed)) data.Min.store(value, std::memory_order_relaxed);
+            if (value > data.Max.load(std::memory_order_relaxed)) data.Max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    static auto Snapshot() -> MetricsSnapshot {
+        if constexpr (Enabled) {
+            return MetricsRegistry::Snapshot();
+        }
+        else {
+            return {};
+        }
+    }
+
+    static auto Reset() -> void {
+        if constexpr (Enabled) {
+            MetricsRegistry::Reset();
+        }
+    }
+
+    /// <summary>
+    /// Records the lifetime of a scope in microseconds
+    /// </summary>
+    class ScopedTimer final {
+    public:
+        explicit ScopedTimer(const Histogram histogram) noexcept : m_Histogram(histogram) {
+            if constexpr (Enabled) {
+                m_Start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        auto operator=(const ScopedTimer&) -> ScopedTimer& = delete;
+
+        ~ScopedTimer() {
+            if constexpr (Enabled) {
+                const auto elapsed = std::chrono::steady_clock::now() - m_Start;
+                Record(m_Histogram, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+            }
+        }
+
+    private:
+        Histogram m_Histogram;
+        std::chrono::steady_clock::time_point m_Start;
+    };
+};
+
+#ifdef CHESS_METRICS
+using Metrics = BasicMetrics<MetricsEnabled>;
+#else
+using Metrics = BasicMetrics<MetricsDisabled>;
+#endif
\ No newline at end of file
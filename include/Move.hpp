@@ -1,6 +1,8 @@
 #pragma once
 #include <Position.hpp>
 
+enum class PieceFlag : uint8_t;
+
 class Move final {
 
 public:
@@ -19,9 +21,21 @@ public:
 	/// <param name="from"><c>Vector2</c> The starting position of the move</param>
 	/// <param name="to"><c>Vector2</c> The ending position of the move</param>
 	/// <param name="type"><c>MoveType</c> The type of the move</param>
-	explicit Move(Position from, Position to, const MoveType& type) noexcept : From(from), To(to), Type(type) {}
+	/// <param name="promotion"><c>PieceFlag</c> The piece type a pawn promotes to, if any</param>
+	explicit Move(Position from, Position to, const MoveType& type, PieceFlag promotion = PieceFlag {}) noexcept :
+		From(from), To(to), Type(type), Promotion(promotion) {}
+
+	/// <summary>
+	/// Converts the move into coordinate notation, e.g. <c>e2e4</c> or <c>e7e8q</c>
+	/// </summary>
+	[[nodiscard]] auto ToString() const -> std::string;
+
+	auto operator==(const Move& rhs) const -> bool {
+		return From == rhs.From && To == rhs.To && Type == rhs.Type && Promotion == rhs.Promotion;
+	}
 
 	Position From;
 	Position To;
 	MoveType Type;
+	PieceFlag Promotion;
 };
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+#include <string_view>
+
+class Move;
+
+/// <summary>
+/// Conversions between moves and standard algebraic notation on the board of the calling thread
+/// </summary>
+class Notation final {
+public:
+    /// <summary>
+    /// Writes a legal move of the side to move in standard algebraic notation, e.g. <c>Nbd7</c>, <c>exd8=Q+</c> or <c>O-O#</c>
+    /// </summary>
+    static auto ToSan(const Move& move) -> std::string;
+
+    /// <summary>
+    /// Finds the legal move of the side to move written in standard algebraic notation. Check marks and annotations
+    /// are ignored, castling may be written with zeros and a promotion without the equals sign
+    /// </summary>
+    /// <returns><c>optional</c> The move, nothing if no legal move or more than one matches</returns>
+    static auto FromSan(std::string_view san) -> std::optional<Move>;
+};
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+#include <Bitboard.hpp>
+#include <MappedFile.hpp>
+#include <Pgn.hpp>
+#include <PositionBatch.hpp>
+
+#include <filesystem>
+#include <span>
+
+/// <summary>
+/// The positions of a game collection stored as bitboards for searching them by piece placement. Positions are
+/// kept in blocks laid out like a <c>PositionBatch</c>, one array per piece kind, and every block records the
+/// squares each kind occupies anywhere in it so a search skips the blocks that cannot match
+/// </summary>
+class PatternIndex final {
+public:
+    static constexpr std::array<char, 4> Magic { 'C', 'P', 'I', 'X' };
+    static constexpr uint32_t Version = 1;
+    static constexpr size_t HeaderSize = 64;
+    static constexpr std::string_view Extension = ".cpat";
+
+    /// <summary>
+    /// The positions a block holds
+    /// </summary>
+    static constexpr size_t BlockSize = 1024;
+
+    using Kind = PositionBatch::Kind;
+
+    /// <summary>
+    /// Piece-placement predicates compiled into mask tests of the bitboards of a position
+    /// </summary>
+    struct Query {
+        /// <summary>
+        /// The squares each piece kind must occupy
+        /// </summary>
+        std::array<Bitboard, Kind::KindCount> Required {};
+
+        /// <summary>
+        /// The squares each piece kind must not occupy
+        /// </summary>
+        std::array<Bitboard, Kind::KindCount> Forbidden {};
+
+        std::array<uint8_t, Kind::KindCount> MinCount {};
+        std::array<uint8_t, Kind::KindCount> MaxCount { 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64 };
+
+        /// <summary>
+        /// The flags of <c>PositionBatch::Flag</c> a position must have the values of
+        /// </summary>
+        uint8_t FlagMask = 0;
+        uint8_t FlagValues = 0;
+
+        /// <summary>
+        /// Compiles a query of terms separated by spaces or commas, pieces written as in FEN:
+        /// <c>Nd5</c> a white knight on d5, <c>pc6e6</c> black pawns on c6 and e6, <c>!Bg2</c> no white bishop
+        /// on g2, <c>.e4</c> an empty square, <c>Q=0</c>, <c>p&gt;=6</c> or <c>R&lt;=1</c> the number of pieces
+        /// of a kind, <c>!q</c> the same as <c>q=0</c>, and <c>w</c> or <c>b</c> the side to move
+        /// </summary>
+        /// <exception cref="std::invalid_argument">A term is not valid</exception>
+        static auto Compile(std::string_view text) -> Query;
+
+        /// <summary>
+        /// Checks the query against one position
+        /// </summary>
+        [[nodiscard]] auto Matches(std::span<const Bitboard, Kind::KindCount> pieces, uint8_t flags) const noexcept -> bool;
+    };
+
+    struct Match {
+        uint32_t Game;
+        uint16_t Ply;
+
+        auto operator<=>(const Match&) const = default;
+    };
+
+    struct SearchResult {
+        /// <summary>
+        /// The matching positions ordered by game and ply, at most the limit of the search
+        /// </summary>
+        std::vector<Match> Matches;
+
+        /// <summary>
+        /// The number of matching positions, including those over the limit
+        /// </summary>
+        uint64_t Total = 0;
+
+        uint64_t BlocksScanned = 0;
+        uint64_t BlocksSkipped = 0;
+    };
+
+    /// <summary>
+    /// Maps an index file
+    /// </summary>
+    /// <exception cref="std::runtime_error">The file cannot be mapped or is not a valid index</exception>
+    explicit PatternIndex(const std::filesystem::path& path);
+
+    /// <summary>
+    /// Finds the positions that match a query
+    /// </summary>
+    /// <param name="threads"><c>int</c> The number of threads sharing the blocks, zero for one per core</param>
+    /// <param name="limit"><c>size_t</c> The most matches to return, all are counted</param>
+    [[nodiscard]] auto Search(const Query& query, int threads = 0, size_t limit = 1000) const -> SearchResult;
+
+    [[nodiscard]] auto GetPositionCount() const noexcept -> uint64_t {
+        return m_Positions;
+    }
+
+    [[nodiscard]] auto GetGameCount() const noexcept -> uint64_t {
+        return m_Games;
+    }
+
+    /// <summary>
+    /// Writes the index of the games in PGN files. Games are numbered from zero in the order of the files
+    /// </summary>
+    /// <param name="threads"><c>int</c> The number of threads replaying games, zero for one per core</param>
+    /// <exception cref="std::runtime_error">A file cannot be read or the index cannot be written</exception>
+    static auto Build(std::span<const std::filesystem::path> pgns, const std::filesystem::path& path, int threads = 0) -> PgnReader::ReplayReport;
+
+    static auto GetInstructionSet() -> std::string_view;
+
+private:
+    class BlockWriter;
+
+    /// <summary>
+    /// Scans the blocks of a range, adding their matches to a result
+    /// </summary>
+    auto SearchBlocks(const Query& query, uint64_t begin, uint64_t end, SearchResult& result) const -> void;
+
+    MappedFile m_File;
+    const uint8_t* m_Blocks = nullptr;
+    uint64_t m_BlockCount = 0;
+    uint64_t m_Positions = 0;
+    uint64_t m_Games = 0;
+};
\ No newline at end of file
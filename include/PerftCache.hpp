@@ -0,0 +1,76 @@
+#pragma once
+#include <LargePageBuffer.hpp>
+
+/// <summary>
+/// A fixed size table of perft subtree counts keyed by position hash and remaining depth
+/// </summary>
+class PerftCache final {
+public:
+    /// <summary>
+    /// Allocates the table. Throws if the size is too small for a single bucket
+    /// </summary>
+    /// <param name="megabytes"><c>size_t</c> The upper bound of the table size, rounded down to a power of two</param>
+    explicit PerftCache(size_t megabytes);
+
+    /// <summary>
+    /// Looks up the leaf node count of a subtree
+    /// </summary>
+    /// <param name="hash"><c>uint64_t</c> The hash of the subtree root</param>
+    /// <param name="depth"><c>int</c> The remaining depth of the subtree</param>
+    /// <returns><c>uint64_t</c> The node count, or nothing if it is not stored</returns>
+    auto Probe(uint64_t hash, int depth) -> std::optional<uint64_t>;
+
+    /// <summary>
+    /// Stores the leaf node count of a subtree, possibly replacing another one
+    /// </summary>
+    auto Store(uint64_t hash, int depth, uint64_t nodes) -> void;
+
+    /// <summary>
+    /// Removes every stored count and resets the statistics
+    /// </summary>
+    auto Clear() -> void;
+
+    [[nodiscard]] auto GetProbes() const noexcept -> uint64_t;
+
+    [[nodiscard]] auto GetHits() const noexcept -> uint64_t;
+
+    /// <summary>
+    /// Gets the share of probes that found a count, in range [0, 1]
+    /// </summary>
+    [[nodiscard]] auto GetHitRate() const noexcept -> double;
+
+    /// <summary>
+    /// Gets the table size in bytes
+    /// </summary>
+    [[nodiscard]] auto GetSize() const noexcept -> size_t;
+
+    /// <summary>
+    /// Gets the memory of the table, which describes the pages and NUMA placement in effect
+    /// </summary>
+    [[nodiscard]] auto GetMemory() const noexcept -> const LargePageBuffer&;
+
+private:
+    /// <summary>
+    /// Both the full hash and the depth are compared, so a count is only ever reused for the same subtree
+    /// </summary>
+    struct Entry {
+        uint64_t Hash;
+        uint64_t Nodes : 56;
+        uint64_t Depth : 8;
+    };
+
+    /// <summary>
+    /// The first entry keeps the deepest subtree, the second one is always replaced
+    /// </summary>
+    struct Bucket {
+        std::array<Entry, 2> Entries;
+    };
+
+    auto GetBucket(uint64_t hash, int depth) -> Bucket&;
+
+    LargePageBuffer m_Memory;
+    Bucket* m_Buckets = nullptr;
+    size_t m_BucketCount = 0;
+    uint64_t m_Probes = 0;
+    uint64_t m_Hits = 0;
+};
\ No newline at end of file
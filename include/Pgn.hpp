@@ -0,0 +1,99 @@
+#pragma once
+#include <functional>
+#include <istream>
+#include <string_view>
+
+class Move;
+
+/// <summary>
+/// Reads the games of a PGN file one at a time. Comments, variations and annotation glyphs are skipped, only the
+/// tags and the moves of the main line are kept
+/// </summary>
+class PgnReader final {
+public:
+    struct Game {
+        std::vector<std::pair<std::string, std::string>> Tags;
+
+        /// <summary>
+        /// The moves of the main line in standard algebraic notation, as written
+        /// </summary>
+        std::vector<std::string> Moves;
+
+        /// <summary>
+        /// The result from the tags, or the game termination marker if there is no tag: <c>1-0</c>, <c>0-1</c>,
+        /// <c>1/2-1/2</c> or <c>*</c>
+        /// </summary>
+        std::string Result = "*";
+
+        /// <summary>
+        /// Gets the value of a tag, empty if the game does not have it
+        /// </summary>
+        [[nodiscard]] auto GetTag(std::string_view name) const -> std::string_view;
+    };
+
+    /// <summary>
+    /// Receives the positions of the games one worker of <c>Replay</c> replays
+    /// </summary>
+    class Visitor {
+    public:
+        virtual ~Visitor() = default;
+
+        /// <summary>
+        /// Called with the board of the worker thread set to a position of a game
+        /// </summary>
+        /// <param name="game"><c>uint64_t</c> The number of the game in the stream, from zero</param>
+        /// <param name="next"><c>Move</c> The move played from the position, null after the last move</param>
+        virtual auto Visit(uint64_t game, int ply, const Game& record, const Move* next) -> void = 0;
+
+        /// <summary>
+        /// Called on the worker thread after its last game
+        /// </summary>
+        virtual auto Finish() -> void {}
+    };
+
+    struct ReplayReport {
+        uint64_t Games = 0;
+        uint64_t Positions = 0;
+
+        /// <summary>
+        /// Games with an invalid start position or a move that is not legal, their positions up to the error are visited
+        /// </summary>
+        uint64_t Errors = 0;
+    };
+
+    explicit PgnReader(std::istream& stream) : m_Stream(stream) {}
+
+    /// <summary>
+    /// Reads and parses the next game
+    /// </summary>
+    /// <returns><c>bool</c> False at the end of the stream</returns>
+    auto Next(Game& game) -> bool;
+
+    /// <summary>
+    /// Reads the text of the next game without parsing it, for parsing the games on other threads
+    /// </summary>
+    /// <returns><c>bool</c> False at the end of the stream</returns>
+    auto NextText(std::string& text) -> bool;
+
+    /// <summary>
+    /// Parses the text of a single game
+    /// </summary>
+    static auto Parse(std::string_view text, Game& game) -> void;
+
+    /// <summary>
+    /// Replays every game of a stream. The calling thread reads the games and hands them to workers in batches,
+    /// every worker parses and replays them on its own board and passes the positions to a visitor of its own
+    /// </summary>
+    /// <param name="threads"><c>int</c> The number of workers, zero for one per core</param>
+    /// <param name="makeVisitor"><c>function</c> Makes the visitor of a worker, called on the worker thread</param>
+    /// <exception>Rethrows the first exception of a visitor after the workers have stopped</exception>
+    static auto Replay(std::istream& stream, int threads, const std::function<std::unique_ptr<Visitor>()>& makeVisitor) -> ReplayReport;
+
+private:
+    std::istream& m_Stream;
+
+    /// <summary>
+    /// The tag line that ended the previous game and starts the next one
+    /// </summary>
+    std::string m_Pending;
+};
\ No newline at end of file
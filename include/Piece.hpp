@@ -50,69 +50,16 @@ constexpr auto operator ^=(PieceFlag& a, const PieceFlag& b) -> PieceFlag& {
 }
 
 /// <summary>
-/// A Chess Piece object
+/// A Chess Piece object, only the compact piece code the rules need.
+/// Where a piece is drawn is kept by the application
 /// </summary>
 class Piece final {
 public:
     //Ctors
 
-    Piece() noexcept :
-        m_Transform(Matrix::CreateTranslation(Vector3(0.0F, 0.0F, 0.01F))),
-		m_Type(PieceFlag::None)
-	{}
+    constexpr Piece() noexcept : m_Type(PieceFlag::None) {}
 
-    explicit Piece(const PieceFlag& type) noexcept :
-		m_Transform(Matrix::CreateTranslation(Vector3(0.0F, 0.0F, 0.01F))),
-		m_Type(type)
-    {}
-
-    Piece(const PieceFlag& type, const Vector2& pos) noexcept :
-        m_Transform(Matrix::CreateTranslation(Vector3(pos.x, pos.y, 0.01F))),
-		m_Type(type)
-	{}
-
-    /// <summary>
-    /// Sets the position of the piece in world space
-    /// </summary>
-    /// <param name="pos"><c>Vector2</c> The position to set the piece to</param>
-    auto SetPosition(const Vector2& pos) noexcept -> void {
-        const auto currentPos = m_Transform.Translation();
-        m_Transform.Translation(Vector3(pos.x, pos.y, currentPos.z));
-    }
-
-    /// <summary>
-    /// Gets the position of the piece in world space
-    /// </summary>
-    [[nodiscard]] auto GetPosition() const noexcept -> Vector2 {
-        const auto currentPos = m_Transform.Translation();
-        return { currentPos.x, currentPos.y };
-    }
-
-    /// <summary>
-    /// Sets the Z index of the piece
-    /// </summary>
-    /// <param name="index"><c>float</c> The index to set the piece to</param>
-    auto SetZIndex(float index) noexcept -> void {
-        const auto pos = m_Transform.Translation();
-        m_Transform.Translation(Vector3(pos.x, pos.y, index));
-    }
-
-    /// <summary>
-    /// Checks if the given point is inside the square that the piece occupies
-    /// </summary>
-    /// <param name="point"><c>Vector2</c> The point to check</param>
-    /// <returns><c>true</c> if the point was inside the square</returns>
-    [[nodiscard]] auto PointInside(const Vector2& point) const noexcept -> bool {
-        const auto pos = m_Transform.Translation();
-        return point.x > pos.x && point.x < pos.x + 1 && point.y > pos.y && point.y < pos.y + 1;
-    }
-
-    /// <summary>
-    /// Gets the transformation matrix of the piece
-    /// </summary>
-    [[nodiscard]] auto GetModelMatrix() const noexcept -> Matrix {
-        return m_Transform;
-    }
+    constexpr explicit Piece(const PieceFlag& type) noexcept : m_Type(type) {}
 
     /// <summary>
     /// Gets the <c>PieceFlag</c> property of the piece
@@ -136,7 +83,17 @@ public:
 		return Is(PieceFlag::White) ? PieceFlag::White : PieceFlag::Black;
 	}
 
+    /// <summary>
+    /// Checks if the piece is the empty piece standing on unoccupied squares
+    /// </summary>
+    [[nodiscard]] constexpr auto IsEmpty() const noexcept -> bool {
+        return m_Type == PieceFlag::None;
+    }
+
+    constexpr auto operator==(const Piece& rhs) const noexcept -> bool = default;
+
 private:
-    Matrix m_Transform;
     PieceFlag m_Type;
-};
\ No newline at end of file
+};
+
+static_assert(sizeof(Piece) == 1, "The board keeps 64 pieces in a single cache line");
\ No newline at end of file
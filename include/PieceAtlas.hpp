@@ -0,0 +1,103 @@
+#pragma once
+#include <filesystem>
+#include <span>
+
+/// <summary>
+/// The packed piece asset bundle: every piece sprite in one RGBA texture with a full mip chain,
+/// followed by the UV rectangle of each sprite. The file is memory-mapped and its levels are
+/// handed to the graphics API as they are, so loading does no decoding and no copies.
+/// Every field is little-endian, each level is tightly packed and starts 16-byte aligned
+/// </summary>
+class PieceAtlas final {
+public:
+    static constexpr std::array<char, 4> Magic { 'C', 'P', 'A', 'T' };
+    static constexpr uint32_t Version = 1;
+
+    /// <summary>
+    /// Pixels are 8-bit RGBA with straight alpha, rows from the top
+    /// </summary>
+    static constexpr uint32_t FormatRgba8 = 1;
+    static constexpr uint32_t BytesPerPixel = 4;
+
+    /// <summary>
+    /// The location of the bundle relative to the executable's working directory
+    /// </summary>
+    static constexpr std::string_view DefaultPath = "textures/pieces.atlas";
+
+    /// <summary>
+    /// The rectangle of a sprite in texture coordinates, (0, 0) is the top left of the texture
+    /// </summary>
+    struct TileRect {
+        float U0, V0, U1, V1;
+    };
+
+    struct Level {
+        uint32_t Width;
+        uint32_t Height;
+        std::span<const uint8_t> Pixels;
+    };
+
+    /// <summary>
+    /// A mip level to write, <c>Width * Height * BytesPerPixel</c> bytes
+    /// </summary>
+    struct Image {
+        uint32_t Width;
+        uint32_t Height;
+        std::vector<uint8_t> Pixels;
+    };
+
+    /// <summary>
+    /// Memory-maps a bundle and validates its header and tables
+    /// </summary>
+    /// <param name="path"><c>path</c> The bundle written by the atlas packer</param>
+    /// <exception cref="std::runtime_error">The file cannot be mapped or is not a valid bundle</exception>
+    explicit PieceAtlas(const std::filesystem::path& path);
+
+    PieceAtlas(const PieceAtlas&) = delete;
+    auto operator=(const PieceAtlas&) -> PieceAtlas& = delete;
+    ~PieceAtlas();
+
+    /// <summary>
+    /// Gets the mip levels, largest first
+    /// </summary>
+    [[nodiscard]] auto GetLevels() const noexcept -> std::span<const Level>;
+
+    /// <summary>
+    /// Gets the UV rectangles of the sprites, in the order of <c>RenderBackend::PieceTextureIndex</c>
+    /// </summary>
+    [[nodiscard]] auto GetTiles() const noexcept -> std::span<const TileRect>;
+
+    /// <summary>
+    /// Gets the width and height of a sprite in the largest level, in pixels
+    /// </summary>
+    [[nodiscard]] auto GetTileSize() const noexcept -> uint32_t;
+
+    /// <summary>
+    /// Lays out a bundle in memory. The same input always gives the same bytes
+    /// </summary>
+    /// <param name="tileSize"><c>uint32_t</c> The size of a sprite in the largest level</param>
+    /// <param name="tiles"><c>span</c> The UV rectangles of the sprites</param>
+    /// <param name="levels"><c>span</c> The mip levels, largest first, each half the size of the previous one</param>
+    /// <exception cref="std::invalid_argument">A level has the wrong number of bytes</exception>
+    static auto Serialize(uint32_t tileSize, std::span<const TileRect> tiles, std::span<const Image> levels) -> std::vector<uint8_t>;
+
+private:
+    /// <summary>
+    /// Validates the mapped bytes and fills the level and tile tables from them
+    /// </summary>
+    auto Parse(std::span<const uint8_t> bytes) -> void;
+
+    auto Unmap() noexcept -> void;
+
+    const uint8_t* m_Data = nullptr;
+    size_t m_Size = 0;
+
+#ifdef _WIN32
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = nullptr;
+#endif
+
+    uint32_t m_TileSize = 0;
+    std::vector<Level> m_Levels;
+    std::vector<TileRect> m_Tiles;
+};
\ No newline at end of file
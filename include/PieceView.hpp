@@ -0,0 +1,76 @@
+#pragma once
+#include <Piece.hpp>
+
+/// <summary>
+/// The render state of a piece on the board, owned by the application.
+/// The rules only know the piece code, the transform is how the piece is drawn
+/// </summary>
+class PieceView final {
+public:
+    //Ctors
+
+    PieceView(const PieceFlag& type, const Position& square) noexcept :
+        m_Transform(Matrix::CreateTranslation(Vector3(static_cast<float>(square.x), static_cast<float>(square.y), 0.01F))),
+        m_Type(type),
+        m_Square(square)
+    {}
+
+    /// <summary>
+    /// Sets the position of the piece in world space
+    /// </summary>
+    /// <param name="pos"><c>Vector2</c> The position to set the piece to</param>
+    auto SetPosition(const Vector2& pos) noexcept -> void {
+        const auto currentPos = m_Transform.Translation();
+        m_Transform.Translation(Vector3(pos.x, pos.y, currentPos.z));
+    }
+
+    /// <summary>
+    /// Gets the position of the piece in world space
+    /// </summary>
+    [[nodiscard]] auto GetPosition() const noexcept -> Vector2 {
+        const auto currentPos = m_Transform.Translation();
+        return { currentPos.x, currentPos.y };
+    }
+
+    /// <summary>
+    /// Sets the Z index of the piece
+    /// </summary>
+    /// <param name="index"><c>float</c> The index to set the piece to</param>
+    auto SetZIndex(float index) noexcept -> void {
+        const auto pos = m_Transform.Translation();
+        m_Transform.Translation(Vector3(pos.x, pos.y, index));
+    }
+
+    /// <summary>
+    /// Checks if the given point is inside the square that the piece occupies
+    /// </summary>
+    /// <param name="point"><c>Vector2</c> The point to check</param>
+    /// <returns><c>true</c> if the point was inside the square</returns>
+    [[nodiscard]] auto PointInside(const Vector2& point) const noexcept -> bool {
+        const auto pos = m_Transform.Translation();
+        return point.x > pos.x && point.x < pos.x + 1 && point.y > pos.y && point.y < pos.y + 1;
+    }
+
+    /// <summary>
+    /// Gets the transformation matrix of the piece
+    /// </summary>
+    [[nodiscard]] auto GetModelMatrix() const noexcept -> Matrix {
+        return m_Transform;
+    }
+
+    [[nodiscard]] auto GetType() const noexcept -> PieceFlag {
+        return m_Type;
+    }
+
+    /// <summary>
+    /// Gets the square of the piece on the board, where it returns to when a drag is cancelled
+    /// </summary>
+    [[nodiscard]] auto GetSquare() const noexcept -> Position {
+        return m_Square;
+    }
+
+private:
+    Matrix m_Transform;
+    PieceFlag m_Type;
+    Position m_Square;
+};
\ No newline at end of file
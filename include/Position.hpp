@@ -4,49 +4,45 @@
 struct Position {
 	int x, y;
 
-	auto Advance(const Position pos) -> bool {
+	constexpr auto Advance(const Position pos) -> bool {
 		*this += pos;
 		return x <= 7 && y <= 7 && x >= 0 && y >= 0;
 	}
 
-	auto Clamp() -> void {
+	constexpr auto Clamp() -> void {
 		if (x < -1) x = -1;
 		if (y < -1) y = -1;
 		if (x > 1) x = 1;
 		if (y > 1) y = 1;
 	}
 
-	auto operator+(const Position& rhs) const -> Position {
+	constexpr auto operator+(const Position& rhs) const -> Position {
 		return { x + rhs.x, y + rhs.y };
 	}
 
-	auto operator-(const Position& rhs) const -> Position {
+	constexpr auto operator-(const Position& rhs) const -> Position {
 		return { x - rhs.x, y - rhs.y };
 	}
 
-	auto operator+=(const Position& rhs) -> Position& {
+	constexpr auto operator+=(const Position& rhs) -> Position& {
 		x += rhs.x;
 		y += rhs.y;
 		return *this;
 	}
 
-	auto operator-=(const Position& rhs) -> Position& {
+	constexpr auto operator-=(const Position& rhs) -> Position& {
 		x -= rhs.x;
 		y -= rhs.y;
 		return *this;
 	}
 
-	auto operator==(const Position& rhs) const -> bool {
+	constexpr auto operator==(const Position& rhs) const -> bool {
 		return x == rhs.x && y == rhs.y;
 	}
 
-	auto operator!=(const Position& rhs) const -> bool {
+	constexpr auto operator!=(const Position& rhs) const -> bool {
 		return x != rhs.x || y != rhs.y;
 	}
-
-	operator Vector2() const {
-		return { static_cast<float>(x), static_cast<float>(y) };
-	}
 };
 
 /// <summary>
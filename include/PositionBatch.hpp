@@ -0,0 +1,103 @@
+#pragma once
+#include <Bitboard.hpp>
+#include <Fen.hpp>
+
+#include <span>
+
+/// <summary>
+/// Many positions stored as arrays of bitboards, one array per piece kind, for scoring them in bulk without the
+/// board. The attack maps of several positions are computed at once in the lanes of SIMD registers, two with SSE2
+/// and four with AVX2 when built with the CHESS_AVX2 option, and the legal moves are counted from the maps without
+/// generating them
+/// </summary>
+class PositionBatch final {
+public:
+    /// <summary>
+    /// The piece kinds in the order of the bitboard arrays
+    /// </summary>
+    enum Kind : uint8_t {
+        WhitePawn, WhiteKnight, WhiteBishop, WhiteRook, WhiteQueen, WhiteKing,
+        BlackPawn, BlackKnight, BlackBishop, BlackRook, BlackQueen, BlackKing,
+        KindCount
+    };
+
+    /// <summary>
+    /// The flags of a position besides its pieces
+    /// </summary>
+    enum Flag : uint8_t {
+        WhiteToMove = 1U << 0U,
+        WhiteKingSide = 1U << 1U,
+        WhiteQueenSide = 1U << 2U,
+        BlackKingSide = 1U << 3U,
+        BlackQueenSide = 1U << 4U
+    };
+
+    /// <summary>
+    /// The results of <c>Analyze</c>, one entry per position in the order they were added
+    /// </summary>
+    struct Results {
+        std::vector<uint8_t> MoveCounts;
+        std::vector<uint8_t> InCheck;
+
+        /// <summary>
+        /// The static evaluation in centipawns from the point of view of the side to move, as <c>Evaluation::Evaluate</c>
+        /// </summary>
+        std::vector<int16_t> Scores;
+    };
+
+    /// <summary>
+    /// Adds a position, which must be legal
+    /// </summary>
+    auto Add(const Fen::State& state) -> void;
+
+    /// <summary>
+    /// Parses and adds a position
+    /// </summary>
+    /// <returns><c>Result</c> The outcome of parsing, nothing is added on failure</returns>
+    auto Add(std::string_view fen) -> Fen::Result;
+
+    auto Clear() -> void;
+
+    auto Reserve(size_t positions) -> void;
+
+    [[nodiscard]] auto GetSize() const noexcept -> size_t {
+        return m_Size;
+    }
+
+    [[nodiscard]] auto GetPieces(Kind kind) const noexcept -> std::span<const Bitboard> {
+        return { m_Pieces[kind].data(), m_Size };
+    }
+
+    [[nodiscard]] auto GetFlags() const noexcept -> std::span<const uint8_t> {
+        return { m_Flags.data(), m_Size };
+    }
+
+    /// <summary>
+    /// Counts the legal moves, detects checks and evaluates every position
+    /// </summary>
+    /// <param name="threads"><c>int</c> The number of threads sharing the positions</param>
+    auto Analyze(Results& results, int threads = 1) const -> void;
+
+    /// <summary>
+    /// Gets the name of the instruction set the attack maps are computed with
+    /// </summary>
+    static auto GetInstructionSet() -> std::string_view;
+
+private:
+    /// <summary>
+    /// Analyzes the positions in a range, which starts on a lane boundary
+    /// </summary>
+    auto AnalyzeRange(size_t begin, size_t end, Results& results) const -> void;
+
+    /// <summary>
+    /// The arrays are padded with empty positions to a whole number of lane groups
+    /// </summary>
+    std::array<std::vector<Bitboard>, KindCount> m_Pieces;
+    std::vector<uint8_t> m_Flags;
+
+    /// <summary>
+    /// The square a pawn may be captured on en passant, -1 if there is none
+    /// </summary>
+    std::vector<int8_t> m_EnPassant;
+    size_t m_Size = 0;
+};
\ No newline at end of file
@@ -0,0 +1,186 @@
+#pragma once
+#include <Pgn.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <span>
+
+class Move;
+
+/// <summary>
+/// An on-disk index of the positions of a game collection, keyed by the Zobrist key of the position. Every key
+/// holds how often the position occurred, the results of the games it occurred in and the moves played from it.
+/// Writers buffer the positions they add in memory and flush them as immutable runs sorted by key. Runs of the
+/// same level are merged into one run of the next level, so a lookup searches only a few memory-mapped runs.
+/// A manifest names the runs in effect and is replaced whole, so a merge interrupted at any point leaves either
+/// its inputs or its output in the index, never both
+/// </summary>
+class PositionIndex final {
+public:
+    static constexpr std::array<char, 4> Magic { 'C', 'P', 'D', 'X' };
+    static constexpr uint32_t Version = 1;
+    static constexpr size_t HeaderSize = 32;
+    static constexpr std::string_view Extension = ".pdx";
+    static constexpr std::string_view ManifestName = "MANIFEST";
+
+    enum class Outcome : uint8_t {
+        WhiteWins,
+        Draw,
+        BlackWins,
+        Unknown
+    };
+
+    /// <summary>
+    /// A move packed into 16 bits: the from square, the to square and the promotion. Zero stands for no move
+    /// </summary>
+    using MoveCode = uint16_t;
+
+    struct MoveCount {
+        MoveCode Move;
+        uint64_t Count;
+    };
+
+    struct Stats {
+        uint64_t Count = 0;
+        uint64_t WhiteWins = 0;
+        uint64_t Draws = 0;
+        uint64_t BlackWins = 0;
+
+        /// <summary>
+        /// The moves played from the position, the most frequent first
+        /// </summary>
+        std::vector<MoveCount> Moves;
+    };
+
+    struct Options {
+        /// <summary>
+        /// The positions a writer buffers before flushing them as a run, 16 bytes each
+        /// </summary>
+        size_t BufferPositions = size_t { 1 } << 22U;
+
+        /// <summary>
+        /// The number of runs of a level that are merged into one run of the next level
+        /// </summary>
+        size_t MergeFanIn = 4;
+    };
+
+    /// <summary>
+    /// Buffers positions for one thread and flushes them to the index. Adding is not synchronized, every thread
+    /// needs a writer of its own
+    /// </summary>
+    class Writer final {
+    public:
+        explicit Writer(PositionIndex& index) : m_Index(index) {}
+
+        Writer(const Writer&) = delete;
+        auto operator=(const Writer&) -> Writer& = delete;
+
+        /// <summary>
+        /// Adds an occurrence of a position, flushing the buffer when it is full
+        /// </summary>
+        /// <param name="move"><c>MoveCode</c> The move played from the position, zero after the last move</param>
+        auto Add(uint64_t key, Outcome outcome, MoveCode move) -> void;
+
+        /// <summary>
+        /// Writes the buffered positions as a run. Positions are not found until they are flushed
+        /// </summary>
+        auto Flush() -> void;
+
+    private:
+        struct Occurrence {
+            uint64_t Key;
+            MoveCode Move;
+            Outcome Result;
+        };
+
+        PositionIndex& m_Index;
+        std::vector<Occurrence> m_Buffer;
+    };
+
+    /// <summary>
+    /// Opens the index in a directory, creating the directory if it does not exist. Runs the manifest does not
+    /// name are left over from an interrupted flush or merge and are deleted
+    /// </summary>
+    /// <exception cref="std::runtime_error">A run in the directory is not valid or one the manifest names is missing</exception>
+    PositionIndex(std::filesystem::path directory, Options options);
+
+    explicit PositionIndex(std::filesystem::path directory) : PositionIndex(std::move(directory), Options {}) {}
+
+    PositionIndex(const PositionIndex&) = delete;
+    auto operator=(const PositionIndex&) -> PositionIndex& = delete;
+    ~PositionIndex();
+
+    /// <summary>
+    /// Looks up a position
+    /// </summary>
+    /// <returns><c>optional</c> The statistics of the position, nothing if it never occurred</returns>
+    [[nodiscard]] auto Find(uint64_t key) const -> std::optional<Stats>;
+
+    /// <summary>
+    /// Adds every position of the games in a PGN stream, each writer flushing when its worker is done
+    /// </summary>
+    /// <param name="threads"><c>int</c> The number of threads replaying games, zero for one per core</param>
+    auto Ingest(std::istream& pgn, int threads = 0) -> PgnReader::ReplayReport;
+
+    /// <summary>
+    /// Merges all runs into one, after which a lookup searches a single run
+    /// </summary>
+    auto Compact() -> void;
+
+    [[nodiscard]] auto GetRunCount() const -> size_t;
+
+    /// <summary>
+    /// Gets the number of entries over all runs. A position is counted once for every run it is in
+    /// </summary>
+    [[nodiscard]] auto GetEntryCount() const -> uint64_t;
+
+    /// <summary>
+    /// Gets the keys of a run in order, for sampling lookups
+    /// </summary>
+    [[nodiscard]] auto GetKeys(size_t run) const -> std::vector<uint64_t>;
+
+    static auto EncodeMove(const Move& move) -> MoveCode;
+
+    /// <summary>
+    /// Writes a packed move in coordinate notation, e.g. <c>e2e4</c> or <c>e7e8q</c>
+    /// </summary>
+    static auto MoveName(MoveCode move) -> std::string;
+
+    static auto GetOutcome(std::string_view result) -> Outcome;
+
+private:
+    class Run;
+    class RunWriter;
+
+    /// <summary>
+    /// Takes a flushed run into the index and merges the level it joins if it is full
+    /// </summary>
+    auto AddRun(const std::filesystem::path& path) -> void;
+
+    /// <summary>
+    /// Merges the runs of a level that are not already being merged, until the level has fewer than the fan-in
+    /// </summary>
+    auto MergeLevel(uint32_t level) -> void;
+
+    /// <summary>
+    /// Merges runs into a new run of a level and swaps them for it
+    /// </summary>
+    auto Merge(const std::vector<std::shared_ptr<Run>>& runs, uint32_t level) -> void;
+
+    auto NextPath(uint32_t level) -> std::filesystem::path;
+
+    /// <summary>
+    /// Replaces the manifest with one naming the runs, the caller holds the mutex
+    /// </summary>
+    auto WriteManifest(const std::vector<std::shared_ptr<Run>>& runs) const -> void;
+
+    [[nodiscard]] auto Snapshot() const -> std::vector<std::shared_ptr<Run>>;
+
+    std::filesystem::path m_Directory;
+    Options m_Options;
+
+    mutable std::mutex m_Mutex;
+    std::vector<std::shared_ptr<Run>> m_Runs;
+    std::atomic<uint64_t> m_Sequence = 0;
+};
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+#include <RenderBackend.hpp>
+
+/// <summary>
+/// A backend that draws nothing and records what it was asked to draw,
+/// for checking draw call counts and upload sizes without a graphics device
+/// </summary>
+class RecordingRenderBackend final : public RenderBackend {
+public:
+    enum class CommandType : uint8_t {
+        BeginFrame,
+        DrawBoard,
+        DrawHighlights,
+        DrawPieces,
+        EndFrame
+    };
+
+    struct Command {
+        CommandType Type;
+
+        /// <summary>
+        /// The number of instances drawn, one for a non-instanced draw and zero for the frame commands
+        /// </summary>
+        size_t Instances;
+
+        /// <summary>
+        /// The number of bytes the command uploads to the GPU
+        /// </summary>
+        size_t UploadBytes;
+    };
+
+    auto BeginFrame(const FrameConstants& constants) -> void override;
+    auto DrawBoard() -> void override;
+    auto DrawHighlights(std::span<const QuadInstance> instances) -> void override;
+    auto DrawPieces(std::span<const QuadInstance> instances) -> void override;
+    auto EndFrame() -> void override;
+
+    [[nodiscard]] auto GetCommands() const noexcept -> const std::vector<Command>&;
+
+    /// <summary>
+    /// Gets the instances of the last piece batch, in the order they were submitted
+    /// </summary>
+    [[nodiscard]] auto GetPieces() const noexcept -> const std::vector<QuadInstance>&;
+
+    [[nodiscard]] auto GetFrames() const noexcept -> size_t;
+    [[nodiscard]] auto GetDrawCalls() const noexcept -> size_t;
+    [[nodiscard]] auto GetUploadBytes() const noexcept -> size_t;
+
+    /// <summary>
+    /// Forgets every recorded command and counter
+    /// </summary>
+    auto Reset() -> void;
+
+private:
+    auto Record(CommandType type, size_t instances, size_t uploadBytes) -> void;
+
+    std::vector<Command> m_Commands;
+    std::vector<QuadInstance> m_Pieces;
+    size_t m_Frames = 0;
+    size_t m_DrawCalls = 0;
+    size_t m_UploadBytes = 0;
+    bool m_InFrame = false;
+};
\ No newline at end of file
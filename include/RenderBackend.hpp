@@ -0,0 +1,96 @@
+#pragma once
+#include <Move.hpp>
+#include <Piece.hpp>
+
+#include <bit>
+#include <span>
+
+/// <summary>
+/// The per-instance data of a quad drawn on the board, uploaded once per batch
+/// </summary>
+struct QuadInstance {
+    float X, Y, Z;
+
+    /// <summary>
+    /// The sprite of the piece atlas, unused by highlights
+    /// </summary>
+    uint32_t Texture;
+};
+
+static_assert(sizeof(QuadInstance) == 16, "Instances are uploaded as they are laid out");
+
+/// <summary>
+/// A piece as a frame draws it, at its place in world space. A dragged piece is off its square and in front
+/// </summary>
+struct PieceSprite {
+    PieceFlag Type;
+    float X, Y, Z;
+};
+
+/// <summary>
+/// The constants shared by every draw of a frame, in the layout of the shader constant buffer
+/// </summary>
+struct FrameConstants {
+    std::array<float, 16> ViewMatrix;
+    std::array<float, 16> ProjectionMatrix;
+};
+
+/// <summary>
+/// Draws the scene of a frame. The application only decides what is drawn, a backend decides how,
+/// so the submission of a frame can be checked without a graphics device
+/// </summary>
+class RenderBackend {
+public:
+    /// <summary>
+    /// The most instances a batch can hold, a board has at most 64 pieces or highlights
+    /// </summary>
+    static constexpr size_t MaxInstances = 64;
+
+    /// <summary>
+    /// The number of textures a piece can be drawn with, one per type and color
+    /// </summary>
+    static constexpr uint32_t PieceTextureCount = 12;
+
+    /// <summary>
+    /// Gets the sprite of the piece atlas for a piece, white pieces first in the order of the type flags
+    /// </summary>
+    static constexpr auto PieceTextureIndex(const PieceFlag type) -> uint32_t {
+        const auto bits = static_cast<uint32_t>(type);
+        const auto typeIndex = static_cast<uint32_t>(std::countr_zero(bits & 0x3FU));
+        return (bits & static_cast<uint32_t>(PieceFlag::Black)) != 0 ? typeIndex + 6 : typeIndex;
+    }
+
+    RenderBackend() = default;
+    RenderBackend(const RenderBackend&) = delete;
+    auto operator=(const RenderBackend&) -> RenderBackend& = delete;
+    virtual ~RenderBackend() = default;
+
+    /// <summary>
+    /// Starts a frame and uploads its constants, once for every draw that follows
+    /// </summary>
+    virtual auto BeginFrame(const FrameConstants& constants) -> void = 0;
+
+    virtual auto DrawBoard() -> void = 0;
+
+    /// <summary>
+    /// Draws every highlight of the frame in a single instanced draw
+    /// </summary>
+    /// <param name="instances"><c>span</c> At most <c>MaxInstances</c> highlights</param>
+    virtual auto DrawHighlights(std::span<const QuadInstance> instances) -> void = 0;
+
+    /// <summary>
+    /// Draws every piece of the frame in a single instanced draw
+    /// </summary>
+    /// <param name="instances"><c>span</c> At most <c>MaxInstances</c> pieces</param>
+    virtual auto DrawPieces(std::span<const QuadInstance> instances) -> void = 0;
+
+    virtual auto EndFrame() -> void = 0;
+
+    /// <summary>
+    /// Submits a whole frame: the board, a highlight on the target square of every move and the pieces, the
+    /// highlights and the pieces in one instanced draw each. Highlights past <c>MaxInstances</c> are left out
+    /// </summary>
+    /// <param name="moves"><c>span</c> The moves to highlight, those of the selected piece</param>
+    /// <exception cref="std::length_error">There are more pieces than a batch holds</exception>
+    auto DrawFrame(const FrameConstants& constants, std::span<const Move> moves, std::span<const PieceSprite> pieces) -> void;
+};
\ No newline at end of file
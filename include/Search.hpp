@@ -0,0 +1,157 @@
+#pragma once
+#include <Move.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+class TranspositionTable;
+
+/// <summary>
+/// Iterative deepening alpha-beta search. Helper threads search the same position on boards
+/// of their own and share their results through the transposition table (Lazy SMP)
+/// </summary>
+class Search final {
+public:
+    static constexpr int Infinity = 32001;
+    static constexpr int MateScore = 32000;
+    static constexpr int MaxPly = 128;
+
+    /// <summary>
+    /// Scores beyond this bound are mate scores
+    /// </summary>
+    static constexpr int MateBound = MateScore - MaxPly;
+
+    /// <summary>
+    /// Limits of a search. Zero means no limit
+    /// </summary>
+    struct Limits {
+        int Depth = 0;
+        uint64_t Nodes = 0;
+        int MoveTime = 0;
+        int WhiteTime = 0;
+        int BlackTime = 0;
+        int WhiteIncrement = 0;
+        int BlackIncrement = 0;
+        int MovesToGo = 0;
+        bool Infinite = false;
+    };
+
+    /// <summary>
+    /// A line of a finished iteration. With several PV lines there is one report per line, best line first
+    /// </summary>
+    struct Report {
+        int Depth;
+        int SelectiveDepth;
+        int Score;
+        uint64_t Nodes;
+        int64_t Milliseconds;
+        int Hashfull;
+        std::vector<Move> Pv;
+        int MultiPv = 1;
+    };
+
+    /// <summary>
+    /// Tunable parameters of the selective search. Depths and reductions are in plies, margins in centipawns
+    /// </summary>
+    struct Parameters {
+        bool NullMovePruning = true;
+        int NullMoveDepth = 3;         // The smallest depth a null move is tried at
+        int NullMoveReduction = 3;
+        int NullMoveDivisor = 4;       // The reduction grows by a ply every this many plies of depth
+        int NullMoveVerifyDepth = 10;  // From this depth on a null move cutoff is confirmed by a reduced search
+        int ReductionBase = 75;        // Late move reductions in hundredths of a ply,
+        int ReductionDivisor = 225;    // base + ln(depth) * ln(move number) / divisor
+        int ReverseFutilityDepth = 6;
+        int ReverseFutilityMargin = 80;
+        int FutilityDepth = 6;
+        int FutilityBase = 80;
+        int FutilityMargin = 90;
+        int LateMovePruningDepth = 4;
+        int LateMovePruningBase = 3;   // Quiet moves past base + depth * depth are skipped
+        bool CheckExtensions = true;
+    };
+
+    using ReportCallback = std::function<void(const Report&)>;
+
+    explicit Search(TranspositionTable& table) noexcept;
+
+    ~Search();
+
+    /// <summary>
+    /// Sets the number of threads used by the following searches, at least one
+    /// </summary>
+    auto SetThreads(int threads) -> void;
+
+    /// <summary>
+    /// Sets the number of best lines the following searches find, at least one. Each iteration searches the root
+    /// once per line, leaving out the first moves of the lines found before
+    /// </summary>
+    auto SetMultiPv(int lines) -> void;
+
+    /// <summary>
+    /// Sets the parameters of the selective search used by the following searches
+    /// </summary>
+    auto SetParameters(const Parameters& parameters) -> void;
+
+    [[nodiscard]] auto GetParameters() const -> const Parameters&;
+
+    /// <summary>
+    /// Searches a position on the board of the calling thread until a limit is reached or <c>Stop</c> is called.
+    /// A stop requested before the search starts is kept, so call <c>Reset</c> before every search
+    /// </summary>
+    /// <param name="fen"><c>string</c> The position the game started from</param>
+    /// <param name="moves"><c>vector</c> The moves played since in coordinate notation</param>
+    /// <param name="limits"><c>Limits</c> When to stop the search</param>
+    /// <param name="report"><c>ReportCallback</c> Called after every finished iteration</param>
+    /// <returns><c>Move</c> The best move, or nothing if the side to move has no legal moves</returns>
+    auto Run(std::string_view fen, const std::vector<std::string>& moves, const Limits& limits, const ReportCallback& report) -> std::optional<Move>;
+
+    /// <summary>
+    /// Makes a running search return as soon as possible. Safe to call from any thread
+    /// </summary>
+    auto Stop() -> void;
+
+    /// <summary>
+    /// Clears the stop flag for the next search. Call it before starting the thread that runs the search, so that a
+    /// <c>Stop</c> sent right after the start is not lost
+    /// </summary>
+    auto Reset() -> void;
+
+private:
+    class Worker;
+
+    /// <summary>
+    /// Sets the board of the calling thread to the searched position
+    /// </summary>
+    auto SetupBoard() const -> bool;
+
+    /// <summary>
+    /// Calculates the soft and hard time limits from the clock of the side to move
+    /// </summary>
+    auto AllocateTime(bool whiteToMove) -> void;
+
+    /// <summary>
+    /// Checks the node and hard time limits and raises the stop flag when one is reached
+    /// </summary>
+    auto CheckLimits() -> bool;
+
+    [[nodiscard]] auto GetNodes() const -> uint64_t;
+
+    [[nodiscard]] auto GetElapsed() const -> int64_t;
+
+    TranspositionTable& m_Table;
+    int m_Threads = 1;
+    int m_MultiPv = 1;
+    Parameters m_Parameters;
+
+    std::string m_Fen;
+    std::vector<std::string> m_Moves;
+    Limits m_Limits;
+    std::chrono::steady_clock::time_point m_Start;
+    int64_t m_SoftTime = 0;
+    int64_t m_HardTime = 0;
+
+    std::atomic<bool> m_Stop = false;
+    std::vector<std::unique_ptr<Worker>> m_Workers;
+};
\ No newline at end of file
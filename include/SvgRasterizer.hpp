@@ -0,0 +1,106 @@
+#pragma once
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Rasterizes the subset of SVG used by the piece artwork: paths, circles, groups, CSS classes,
+/// translate and matrix transforms, both fill rules and round or butt strokes.
+/// Rendering is deterministic, the same document and size always give the same pixels
+/// </summary>
+class SvgRasterizer final {
+public:
+    /// <summary>
+    /// Parses an SVG document
+    /// </summary>
+    /// <param name="document"><c>string_view</c> The text of the document</param>
+    /// <exception cref="std::runtime_error">The document uses syntax the rasterizer does not support</exception>
+    explicit SvgRasterizer(std::string_view document);
+
+    /// <summary>
+    /// Renders the document scaled to fit a square image
+    /// </summary>
+    /// <param name="size"><c>uint32_t</c> The width and height of the image in pixels</param>
+    /// <param name="rgba"><c>vector</c> Filled with premultiplied RGBA, rows from the top</param>
+    auto Render(uint32_t size, std::vector<float>& rgba) const -> void;
+
+private:
+    struct Point {
+        double X, Y;
+    };
+
+    /// <summary>
+    /// An affine transform mapping (x, y) to (A x + C y + E, B x + D y + F)
+    /// </summary>
+    struct Transform {
+        double A = 1.0, B = 0.0, C = 0.0, D = 1.0, E = 0.0, F = 0.0;
+
+        [[nodiscard]] auto Apply(const Point& p) const -> Point;
+        [[nodiscard]] auto Multiply(const Transform& rhs) const -> Transform;
+    };
+
+    struct Paint {
+        bool None = true;
+        float R = 0.0F, G = 0.0F, B = 0.0F;
+    };
+
+    enum class LineCap : uint8_t {
+        Butt,
+        Round,
+        Square
+    };
+
+    struct Style {
+        Paint Fill { false };
+        Paint Stroke;
+        double StrokeWidth = 1.0;
+        LineCap Cap = LineCap::Butt;
+        bool EvenOdd = false;
+        float Opacity = 1.0F;
+        float FillOpacity = 1.0F;
+        float StrokeOpacity = 1.0F;
+        Transform Matrix;
+    };
+
+    struct Subpath {
+        std::vector<Point> Points;
+        bool Closed = false;
+    };
+
+    /// <summary>
+    /// A flattened outline in document units with the style it is painted with
+    /// </summary>
+    struct Shape {
+        std::vector<Subpath> Subpaths;
+        Style Paint;
+    };
+
+    using Declarations = std::vector<std::pair<std::string_view, std::string_view>>;
+
+    auto ParseStyleSheet(std::string_view css) -> void;
+    auto ApplyProperty(Style& style, std::string_view name, std::string_view value) const -> void;
+    auto ApplyDeclarations(Style& style, std::string_view declarations) const -> void;
+    auto AddPath(std::string_view data, const Style& style) -> void;
+    auto AddCircle(double cx, double cy, double r, const Style& style) -> void;
+
+    static auto ParsePaint(std::string_view value) -> Paint;
+    static auto ParseTransform(std::string_view value) -> Transform;
+
+    /// <summary>
+    /// Appends a cubic Bezier curve, subdivided until it is flat within the tolerance
+    /// </summary>
+    static auto FlattenCubic(std::vector<Point>& points, Point p0, Point p1, Point p2, Point p3, int depth) -> void;
+
+    /// <summary>
+    /// Appends an elliptical arc given in the endpoint parameterization of SVG
+    /// </summary>
+    static auto FlattenArc(std::vector<Point>& points, Point from, double rx, double ry, double rotation,
+        bool largeArc, bool sweep, Point to) -> void;
+
+    std::vector<Shape> m_Shapes;
+    std::unordered_map<std::string_view, std::string_view> m_Classes;
+    double m_ViewWidth = 0.0;
+    double m_ViewHeight = 0.0;
+    double m_ViewX = 0.0;
+    double m_ViewY = 0.0;
+};
\ No newline at end of file
@@ -0,0 +1,161 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+/// <summary>
+/// Records scoped spans into a ring buffer per thread and exports them as Chrome trace events,
+/// which load in Perfetto and chrome://tracing. Tracing is compiled in everywhere and switched at runtime;
+/// while it is off a span costs a single relaxed load and branch
+/// </summary>
+class Trace final {
+public:
+    /// <summary>
+    /// The number of spans each thread keeps, older spans are overwritten
+    /// </summary>
+    static constexpr size_t BufferSize = 1 << 16;
+
+    /// <summary>
+    /// Marks a span that carries no value
+    /// </summary>
+    static constexpr int64_t NoValue = INT64_MIN;
+
+    static auto IsEnabled() noexcept -> bool {
+        return s_Enabled.load(std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// Starts or stops recording. Spans open while tracing is switched on are not recorded
+    /// </summary>
+    static auto SetEnabled(bool enabled) -> void;
+
+    /// <summary>
+    /// Names the calling thread in the exported trace
+    /// </summary>
+    static auto SetThreadName(std::string_view name) -> void;
+
+    /// <summary>
+    /// Gets the time in nanoseconds since the process started tracing
+    /// </summary>
+    static auto Now() noexcept -> int64_t {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_Epoch).count();
+    }
+
+    /// <summary>
+    /// Appends a finished span to the ring buffer of the calling thread
+    /// </summary>
+    /// <param name="name"><c>char*</c> The name of the span, must outlive the trace, e.g. a string literal</param>
+    /// <param name="start"><c>int64_t</c> The start of the span from <c>Now</c></param>
+    /// <param name="end"><c>int64_t</c> The end of the span from <c>Now</c></param>
+    /// <param name="value"><c>int64_t</c> A value shown with the span, <c>NoValue</c> for none</param>
+    static auto Record(const char* name, int64_t start, int64_t end, int64_t value = NoValue) noexcept -> void;
+
+    /// <summary>
+    /// Writes the recorded spans of every thread, live and finished, as a Chrome trace-event JSON object
+    /// </summary>
+    static auto Export(std::ostream& stream) -> void;
+
+    /// <summary>
+    /// Discards every recorded span. Spans recorded concurrently may survive
+    /// </summary>
+    static auto Clear() -> void;
+
+    /// <summary>
+    /// Records the lifetime of a scope as a span if tracing was enabled when it was entered
+    /// </summary>
+    class Scope final {
+    public:
+        explicit Scope(const char* name, const int64_t value = NoValue) noexcept {
+            if (IsEnabled()) [[unlikely]] {
+                m_Name = name;
+                m_Value = value;
+                m_Start = Now();
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        auto operator=(const Scope&) -> Scope& = delete;
+
+        ~Scope() {
+            if (m_Name) [[unlikely]] {
+                Record(m_Name, m_Start, Now(), m_Value);
+            }
+        }
+
+    private:
+        const char* m_Name = nullptr;
+        int64_t m_Value = NoValue;
+        int64_t m_Start = 0;
+    };
+
+private:
+    /// <summary>
+    /// A slot of the ring buffer. The fields are atomics so that the exporter may read a slot while it is rewritten,
+    /// torn slots are detected from the write index and dropped
+    /// </summary>
+    struct Slot {
+        std::atomic<const char*> Name;
+        std::atomic<int64_t> Start;
+        std::atomic<int64_t> Duration;
+        std::atomic<int64_t> Value;
+    };
+
+    struct Span {
+        const char* Name;
+        int64_t Start;
+        int64_t Duration;
+        int64_t Value;
+    };
+
+    /// <summary>
+    /// The ring buffer of a single thread. Only the owning thread writes, so advancing the write index
+    /// is a plain store; the exporter reads concurrently without locking the owner out
+    /// </summary>
+    struct ThreadBuffer {
+        std::unique_ptr<Slot[]> Slots;
+        std::atomic<uint64_t> Head;
+        std::atomic<uint64_t> Tail;
+        uint32_t Id;
+        std::string Name;
+
+        ThreadBuffer();
+        ThreadBuffer(const ThreadBuffer&) = delete;
+        auto operator=(const ThreadBuffer&) -> ThreadBuffer& = delete;
+        ~ThreadBuffer();
+    };
+
+    /// <summary>
+    /// Copies the spans of a buffer that were not overwritten while they were read
+    /// </summary>
+    static auto Collect(const ThreadBuffer& buffer, std::vector<Span>& spans) -> void;
+
+    static auto WriteEvents(std::ostream& stream, uint32_t thread, std::string_view name, const std::vector<Span>& spans, bool& first) -> void;
+
+    inline static std::atomic<bool> s_Enabled;
+    inline static const std::chrono::steady_clock::time_point s_Epoch = std::chrono::steady_clock::now();
+
+    inline static std::mutex s_Mutex;
+    inline static std::vector<ThreadBuffer*> s_Threads;
+    inline static uint32_t s_NextId;
+
+    /// <summary>
+    /// The spans of finished threads, kept by thread id and name
+    /// </summary>
+    inline static std::vector<std::tuple<uint32_t, std::string, std::vector<Span>>> s_Retired;
+
+    inline static thread_local ThreadBuffer s_Local;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/// <summary>
+/// Traces the enclosing scope under a name that must outlive the trace
+/// </summary>
+#define TRACE_SCOPE(name) const Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+/// <summary>
+/// Traces the enclosing scope with a value, e.g. the depth of an iteration
+/// </summary>
+#define TRACE_SCOPE_VALUE(name, value) const Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name, static_cast<int64_t>(value))
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+#include <LargePageBuffer.hpp>
+#include <atomic>
+
+class Move;
+
+/// <summary>
+/// A table of search results shared by every search thread without locks.
+/// Each entry stores its key xor its data, so an entry torn by concurrent writes fails verification
+/// </summary>
+class TranspositionTable final {
+public:
+    enum class Bound : uint8_t {
+        None,
+        Upper, // The score is at most the stored score
+        Lower, // The score is at least the stored score
+        Exact
+    };
+
+    struct Entry {
+        /// <summary>
+        /// The best move in compact form, see <c>PackMove</c>
+        /// </summary>
+        uint16_t Move;
+        int16_t Score;
+        uint8_t Depth;
+        Bound Type;
+    };
+
+    /// <summary>
+    /// Allocates the table. Throws if the size is too small for a single cluster
+    /// </summary>
+    /// <param name="megabytes"><c>size_t</c> The upper bound of the table size, rounded down to a power of two</param>
+    explicit TranspositionTable(size_t megabytes);
+
+    /// <summary>
+    /// Reallocates the table with the current <c>LargePageBuffer</c> options, dropping every entry
+    /// </summary>
+    auto Resize(size_t megabytes) -> void;
+
+    /// <summary>
+    /// Gets the memory of the table, which describes the pages and NUMA placement in effect
+    /// </summary>
+    [[nodiscard]] auto GetMemory() const noexcept -> const LargePageBuffer&;
+
+    auto Clear() -> void;
+
+    /// <summary>
+    /// Starts a new search so that entries of older searches are replaced first
+    /// </summary>
+    auto NewSearch() -> void;
+
+    /// <summary>
+    /// Looks up the entry of a position
+    /// </summary>
+    [[nodiscard]] auto Probe(uint64_t hash) const -> std::optional<Entry>;
+
+    /// <summary>
+    /// Stores an entry, replacing the entry of the same position or the least valuable entry of the cluster
+    /// </summary>
+    auto Store(uint64_t hash, const Entry& entry) -> void;
+
+    /// <summary>
+    /// Estimates how full the table is in permille from a sample of clusters
+    /// </summary>
+    [[nodiscard]] auto GetHashfull() const -> int;
+
+    /// <summary>
+    /// Packs the squares and promotion of a move into 15 bits. Zero means no move
+    /// </summary>
+    static auto PackMove(const Move& move) -> uint16_t;
+
+    /// <summary>
+    /// Checks if a move matches a packed move
+    /// </summary>
+    static auto IsSameMove(uint16_t packed, const Move& move) -> bool;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> Key;
+        std::atomic<uint64_t> Data;
+    };
+
+    /// <summary>
+    /// Four slots fill a cache line
+    /// </summary>
+    struct alignas(64) Cluster {
+        std::array<Slot, 4> Slots;
+    };
+
+    static auto Pack(const Entry& entry, uint8_t generation) -> uint64_t;
+
+    static auto Unpack(uint64_t data) -> Entry;
+
+    static auto GetGeneration(uint64_t data) -> uint8_t;
+
+    [[nodiscard]] auto GetCluster(uint64_t hash) const -> Cluster&;
+
+    LargePageBuffer m_Memory;
+    Cluster* m_Clusters = nullptr;
+    size_t m_ClusterCount = 0;
+    uint8_t m_Generation = 0;
+};
\ No newline at end of file
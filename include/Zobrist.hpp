@@ -0,0 +1,69 @@
+#pragma once
+#include <Piece.hpp>
+#include <array>
+#include <bit>
+
+/// <summary>
+/// Random keys that are combined with xor into a hash of a position
+/// </summary>
+namespace Zobrist {
+    /// <summary>
+    /// The splitmix64 generator, used to fill the key tables at compile time
+    /// </summary>
+    constexpr auto NextKey(uint64_t& state) -> uint64_t {
+        uint64_t z = state += 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    struct KeyTable {
+        std::array<std::array<uint64_t, 64>, 12> Pieces;
+        std::array<uint64_t, 4> Castling;
+        std::array<uint64_t, 8> EnPassantFile;
+        uint64_t BlackToMove;
+    };
+
+    inline constexpr KeyTable Keys = [] {
+        KeyTable table {};
+        uint64_t state = 0x43686573734B6579ULL;
+
+        for (auto& piece : table.Pieces) {
+            for (auto& key : piece) {
+                key = NextKey(state);
+            }
+        }
+
+        for (auto& key : table.Castling) {
+            key = NextKey(state);
+        }
+
+        for (auto& key : table.EnPassantFile) {
+            key = NextKey(state);
+        }
+
+        table.BlackToMove = NextKey(state);
+        return table;
+    }();
+
+    /// <summary>
+    /// Gets the key of a piece standing on a square
+    /// </summary>
+    /// <param name="piece"><c>PieceFlag</c> The type and color of the piece</param>
+    constexpr auto PieceKey(const PieceFlag piece, const Position& square) -> uint64_t {
+        // Type flags are single bits from pawn to queen, so their bit index is the type index
+        const int type = std::countr_zero(static_cast<uint8_t>(piece & ~(PieceFlag::White | PieceFlag::Black)));
+        const int color = (piece & PieceFlag::Black) == PieceFlag::Black ? 6 : 0;
+        return Keys.Pieces[color + type][square.y * 8 + square.x];
+    }
+
+    /// <summary>
+    /// Gets the combined key of the castling rights in order K, Q, k, q
+    /// </summary>
+    constexpr auto CastlingKey(const bool whiteKingSide, const bool whiteQueenSide, const bool blackKingSide, const bool blackQueenSide) -> uint64_t {
+        return (whiteKingSide ? Keys.Castling[0] : 0)
+            ^ (whiteQueenSide ? Keys.Castling[1] : 0)
+            ^ (blackKingSide ? Keys.Castling[2] : 0)
+            ^ (blackQueenSide ? Keys.Castling[3] : 0);
+    }
+}
\ No newline at end of file
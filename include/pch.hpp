@@ -1,4 +1,5 @@
 #pragma once
+#ifdef _WIN32
 #ifndef UNICODE
 #define UNICODE
 #endif
@@ -13,6 +14,7 @@
 #include <d3d11_4.h>
 #include <wrl/client.h>
 #include <d3dcompiler.h>
+#endif
 
 // std
 #include <string>
@@ -24,10 +26,11 @@
 #include <ranges>
 #include <array>
 #include <algorithm>
+#include <optional>
 
+#ifdef _WIN32
 // DXTK
 #include <PlatformHelpers.h> // Not really public, but has ThrowIfFailed
-#include <WICTextureLoader.h>
 #include <SimpleMath.h>
 #include <Mouse.h>
 
@@ -36,4 +39,5 @@ using DirectX::SimpleMath::Matrix;
 using DirectX::SimpleMath::Vector2;
 using DirectX::SimpleMath::Vector3;
 using DirectX::Mouse;
-using ButtonState = Mouse::ButtonStateTracker::ButtonState;
\ No newline at end of file
+using ButtonState = Mouse::ButtonStateTracker::ButtonState;
+#endif
\ No newline at end of file
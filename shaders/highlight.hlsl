@@ -1,6 +1,5 @@
 cbuffer cb : register(b0)
 {
-    float4x4 modelMatrix;
     float4x4 viewMatrix;
     float4x4 projectionMartix;
 }
@@ -9,6 +8,7 @@ struct VertexInput
 {
     float2 positionOS : POSITION;
     float2 uv : TEXCOORD0;
+    float3 instancePosition : INSTANCEPOSITION;
 };
 
 struct VertexOutput
@@ -20,7 +20,7 @@ struct VertexOutput
 VertexOutput vert(VertexInput input)
 {
     VertexOutput output;
-    output.positionHCS = mul(projectionMartix, mul(viewMatrix, mul(modelMatrix, float4(input.positionOS, 0.0, 1.0))));
+    output.positionHCS = mul(projectionMartix, mul(viewMatrix, float4(input.positionOS + input.instancePosition.xy, input.instancePosition.z, 1.0)));
     output.uv = input.uv;
     return output;
 }
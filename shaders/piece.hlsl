@@ -1,14 +1,21 @@
 cbuffer cb : register(b0)
 {
-    float4x4 modelMatrix;
     float4x4 viewMatrix;
     float4x4 projectionMartix;
 }
 
+// The rectangle of every sprite in the piece atlas, in the order of the texture indices
+cbuffer atlas : register(b1)
+{
+    float4 tileRects[12];
+}
+
 struct VertexInput
 {
     float2 positionOS : POSITION;
     float2 uv : TEXCOORD0;
+    float3 instancePosition : INSTANCEPOSITION;
+    uint textureIndex : TEXTUREINDEX;
 };
 
 struct VertexOutput
@@ -20,23 +27,19 @@ struct VertexOutput
 VertexOutput vert(VertexInput input)
 {
     VertexOutput output;
-    output.positionHCS = mul(projectionMartix, mul(viewMatrix, mul(modelMatrix, float4(input.positionOS, 0.0, 1.0))));
-    output.uv = input.uv;
+    output.positionHCS = mul(projectionMartix, mul(viewMatrix, float4(input.positionOS + input.instancePosition.xy, input.instancePosition.z, 1.0)));
+    // The atlas stores rows from the top, the quad has its uv origin at the bottom
+    float4 rect = tileRects[input.textureIndex];
+    output.uv = float2(lerp(rect.x, rect.z, input.uv.x), lerp(rect.w, rect.y, input.uv.y));
     return output;
 }
 
 Texture2D mainTex : register(t0);
-//SamplerState mainTexSampler : register(s0);
-SamplerState MeshTextureSampler
-{
-    Filter = MIN_MAG_MIP_LINEAR;
-    AddressU = Wrap;
-    AddressV = Wrap;
-};
+SamplerState mainTexSampler : register(s0);
 
 float4 frag(VertexOutput input) : SV_TARGET
 {
-    float4 fragColor = mainTex.Sample(MeshTextureSampler, input.uv * float2(1, -1));
+    float4 fragColor = mainTex.Sample(mainTexSampler, input.uv);
     clip(fragColor.a - 0.00001);
     return fragColor;
 }
\ No newline at end of file
@@ -2,10 +2,21 @@
 #include <Application.hpp>
 #include <Piece.hpp>
 #include <Board.hpp>
+#include <D3D11RenderBackend.hpp>
+#include <Metrics.hpp>
+#include <Trace.hpp>
+
+#include <fstream>
 
 constexpr uint32_t Width = 1920U;
 constexpr uint32_t Height = 1080U;
 
+namespace {
+    auto ToVector(const Position& square) -> Vector2 {
+        return { static_cast<float>(square.x), static_cast<float>(square.y) };
+    }
+}
+
 auto Application::Run(HINSTANCE hInstance) -> int {
     // Initilaize COM Library
     DirectX::ThrowIfFailed(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
@@ -20,13 +31,11 @@ auto Application::Run(HINSTANCE hInstance) -> int {
     // Iniltialize renderer
     InitGraphicsDevice(s_Window);
     CreateFrameResources(Width, Height);
-    CreateBuffers();
-    InitDrawingState();
-    CompileShaders();
-    LoadPieceTextures();
+    s_Renderer = std::make_unique<D3D11RenderBackend>(s_Device, s_DeviceContext);
 
     // Set board state to starting position
     Board::SetState("1n2q3/1PBPpbK1/1N1pR1N1/2p3pP/rpPP2Bn/p6P/4pQPb/1k6 w - - 0 1");
+    SyncPieceViews();
 
     ShowWindow(s_Window, SW_SHOW);
 
@@ -43,29 +52,6 @@ auto Application::Run(HINSTANCE hInstance) -> int {
     return 0;
 }
 
-void Application::LoadPieceTextures() {
-    s_PieceTextures.insert({ PieceFlag::Pawn   | PieceFlag::Black, CreateTexture(L"textures/bPawn.png") });
-    s_PieceTextures.insert({ PieceFlag::Rook   | PieceFlag::Black, CreateTexture(L"textures/bRook.png") });
-    s_PieceTextures.insert({ PieceFlag::Knight | PieceFlag::Black, CreateTexture(L"textures/bKnight.png") });
-    s_PieceTextures.insert({ PieceFlag::Bishop | PieceFlag::Black, CreateTexture(L"textures/bBishop.png") });
-    s_PieceTextures.insert({ PieceFlag::King   | PieceFlag::Black, CreateTexture(L"textures/bKing.png") });
-    s_PieceTextures.insert({ PieceFlag::Queen  | PieceFlag::Black, CreateTexture(L"textures/bQueen.png") });
-    s_PieceTextures.insert({ PieceFlag::Pawn   | PieceFlag::White, CreateTexture(L"textures/wPawn.png") });
-    s_PieceTextures.insert({ PieceFlag::Rook   | PieceFlag::White, CreateTexture(L"textures/wRook.png") });
-    s_PieceTextures.insert({ PieceFlag::Knight | PieceFlag::White, CreateTexture(L"textures/wKnight.png") });
-    s_PieceTextures.insert({ PieceFlag::Bishop | PieceFlag::White, CreateTexture(L"textures/wBishop.png") });
-    s_PieceTextures.insert({ PieceFlag::King   | PieceFlag::White, CreateTexture(L"textures/wKing.png") });
-    s_PieceTextures.insert({ PieceFlag::Queen  | PieceFlag::White, CreateTexture(L"textures/wQueen.png") });
-}
-
-auto Application::CreateTexture(const std::wstring_view filename) -> Texture2D {
-    Texture2D tex;
-    // DirectXTK WICLoader
-    DirectX::ThrowIfFailed(DirectX::CreateWICTextureFromFile(s_Device.Get(), s_DeviceContext.Get(),
-        filename.data(), &tex.Resource(), &tex.ResourceView()));
-    return tex;
-}
-
 auto Application::InitGraphicsDevice(const HWND hWnd) -> void {
 
     uint32_t factoryFlag = 0;
@@ -112,16 +98,6 @@ auto Application::InitGraphicsDevice(const HWND hWnd) -> void {
     DirectX::ThrowIfFailed(t_Device.As(&s_Device));
     DirectX::ThrowIfFailed(t_DeviceContext.As(&s_DeviceContext));
     DirectX::ThrowIfFailed(t_SwapChain.As(&s_SwapChain));
-
-    // Create linear sampler for piece texture sampling
-    constexpr D3D11_SAMPLER_DESC samplerDesc {
-        D3D11_FILTER_MIN_MAG_MIP_LINEAR, D3D11_TEXTURE_ADDRESS_WRAP, D3D11_TEXTURE_ADDRESS_WRAP,
-        D3D11_TEXTURE_ADDRESS_WRAP, 0, 1, D3D11_COMPARISON_ALWAYS,
-        1, 1, 1, 1, 0, 0
-    };
-
-    DirectX::ThrowIfFailed(s_Device->CreateSamplerState(&samplerDesc, &s_SamplerState));
-    s_DeviceContext->PSSetSamplers(0, 1, s_SamplerState.GetAddressOf());
 }
 
 auto Application::CreateFrameResources(const uint32_t width, const uint32_t height) -> void {
@@ -154,171 +130,33 @@ auto Application::CreateFrameResources(const uint32_t width, const uint32_t heig
     s_DeviceContext->OMSetRenderTargets(1, s_RTV.GetAddressOf(), s_DSV.Get());
 }
 
-auto Application::CreateBuffers() -> void {
-    // Primitive topology triangles
-    s_DeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-    // Create and bind vertex buffer
-    constexpr D3D11_BUFFER_DESC vertexBufferDesc {
-        sizeof(quad), D3D11_USAGE_DEFAULT, D3D11_BIND_VERTEX_BUFFER,
-        0, 0, 0
-    };
-
-    constexpr D3D11_SUBRESOURCE_DATA vertexData { quad.data(), 0, 0 };
-    DirectX::ThrowIfFailed(s_Device->CreateBuffer(&vertexBufferDesc, &vertexData, &s_VertexBuffer));
-    constexpr unsigned stride = sizeof(Vertex);
-    constexpr unsigned offset = 0;
-    s_DeviceContext->IASetVertexBuffers(0, 1, s_VertexBuffer.GetAddressOf(), &stride, &offset);
+auto Application::SyncPieceViews() -> void {
+    TRACE_SCOPE("SyncPieceViews");
 
-    // Create and bind index buffer
-    constexpr D3D11_BUFFER_DESC indexBufferDesc {
-        sizeof(indices), D3D11_USAGE_DEFAULT, D3D11_BIND_INDEX_BUFFER,
-        0, 0, 0
-    };
-    constexpr D3D11_SUBRESOURCE_DATA indexData { indices.data(), 0, 0 };
-    DirectX::ThrowIfFailed(s_Device->CreateBuffer(&indexBufferDesc, &indexData, &s_IndexBuffer));
-    s_DeviceContext->IASetIndexBuffer(s_IndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
-
-    // Create constant buffer
-    constexpr D3D11_BUFFER_DESC constantBufferDesc = {
-        sizeof(ConstantBufferData), D3D11_USAGE_DYNAMIC, D3D11_BIND_CONSTANT_BUFFER,
-        D3D11_CPU_ACCESS_WRITE, 0, 0
-    };
-    DirectX::ThrowIfFailed(s_Device->CreateBuffer(&constantBufferDesc, nullptr, &s_ConstantBuffer));
-}
+    s_PieceViews.clear();
 
-auto Application::InitDrawingState() -> void {
-    // Create and set input layout
-    ComPtr<ID3D11InputLayout> InputLayout;
-    constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 2> polygonLayout {
-        {
-            {
-                "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0,
-                0, D3D11_INPUT_PER_VERTEX_DATA, 0
-            }, {
-                "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0,
-                D3D11_APPEND_ALIGNED_ELEMENT,D3D11_INPUT_PER_VERTEX_DATA, 0
-            }
-        }
-    };
+    const auto& board = Board::GetBoard();
 
-    ComPtr<ID3DBlob> inputShaderBlob;
-    DirectX::ThrowIfFailed(D3DCompileFromFile(L"board.hlsl", nullptr, nullptr, "vert",
-        "vs_5_0", 0, 0, &inputShaderBlob, nullptr));
-    DirectX::ThrowIfFailed(s_Device->CreateInputLayout(polygonLayout.data(), 2,
-        inputShaderBlob->GetBufferPointer(), inputShaderBlob->GetBufferSize(), &InputLayout));
-    s_DeviceContext->IASetInputLayout(InputLayout.Get());
-
-    // Create depth stencil states
-    D3D11_DEPTH_STENCIL_DESC depthStencilDesc {
-        TRUE, D3D11_DEPTH_WRITE_MASK_ALL, D3D11_COMPARISON_LESS,
-        FALSE, D3D11_DEFAULT_STENCIL_READ_MASK, D3D11_DEFAULT_STENCIL_WRITE_MASK,
-        { D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_INCR,
-            D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS
-        }, { D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_INCR,
-            D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS
-        }
-    };
-    DirectX::ThrowIfFailed(s_Device->CreateDepthStencilState(&depthStencilDesc, &s_DepthStencilStateBoard));
-    depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
-    DirectX::ThrowIfFailed(s_Device->CreateDepthStencilState(&depthStencilDesc, &s_DepthStencilStatePiece));
-
-    // Create and set rasterizer state
-    constexpr D3D11_RASTERIZER_DESC2 rasterDesc {
-        D3D11_FILL_SOLID, D3D11_CULL_BACK, TRUE, 0, 0.0F,
-        0.0F, TRUE, FALSE, FALSE, FALSE,
-        0, D3D11_CONSERVATIVE_RASTERIZATION_MODE_OFF
-    };
-    DirectX::ThrowIfFailed(s_Device->CreateRasterizerState2(&rasterDesc, &s_RasterizerState));
-    s_DeviceContext->RSSetState(s_RasterizerState.Get());
-
-    // Create and set blend state
-    constexpr D3D11_BLEND_DESC1 blendDesc {
-        FALSE, FALSE,
-        { {
-                TRUE, FALSE, D3D11_BLEND_SRC_ALPHA, D3D11_BLEND_INV_SRC_ALPHA,
-                D3D11_BLEND_OP_ADD, D3D11_BLEND_SRC_ALPHA, D3D11_BLEND_INV_SRC_ALPHA,
-                D3D11_BLEND_OP_ADD, D3D11_LOGIC_OP_NOOP, D3D11_COLOR_WRITE_ENABLE_ALL
-            }
+    for (int square = 0; square < 64; square++) {
+        if (!board[square].IsEmpty()) {
+            s_PieceViews.emplace_back(board[square].GetType(), Position { square % 8, square / 8 });
         }
-    };
-    DirectX::ThrowIfFailed(s_Device->CreateBlendState1(&blendDesc, &s_BlendState));
-    s_DeviceContext->OMSetBlendState(s_BlendState.Get(), nullptr, D3D11_DEFAULT_SAMPLE_MASK);
-}
-
-auto Application::CompileShaders() -> void {
-    // Compile shaders from file into blobs
-    ComPtr<ID3DBlob> vertexShaderBlob;
-    ComPtr<ID3DBlob> pixelShaderBlob;
-
-    // TODO: Refactor this into a function
-
-    // Board
-    DirectX::ThrowIfFailed(D3DCompileFromFile(L"board.hlsl", nullptr, nullptr, "vert",
-        "vs_5_0", 0, 0, &vertexShaderBlob, nullptr));
-    DirectX::ThrowIfFailed(D3DCompileFromFile(L"board.hlsl", nullptr, nullptr, "frag",
-        "ps_5_0", 0, 0, &pixelShaderBlob, nullptr));
-    DirectX::ThrowIfFailed(s_Device->CreateVertexShader(vertexShaderBlob->GetBufferPointer(),
-        vertexShaderBlob->GetBufferSize(), nullptr, &s_BoardShaderVertex));
-    DirectX::ThrowIfFailed(s_Device->CreatePixelShader(pixelShaderBlob->GetBufferPointer(),
-        pixelShaderBlob->GetBufferSize(), nullptr, &s_BoardShaderPixel));
-
-    // Piece
-    DirectX::ThrowIfFailed(D3DCompileFromFile(L"piece.hlsl", nullptr, nullptr, "vert",
-        "vs_5_0", 0, 0, &vertexShaderBlob, nullptr));
-    DirectX::ThrowIfFailed(D3DCompileFromFile(L"piece.hlsl", nullptr, nullptr, "frag",
-        "ps_5_0", 0, 0, &pixelShaderBlob, nullptr));
-    DirectX::ThrowIfFailed(s_Device->CreateVertexShader(vertexShaderBlob->GetBufferPointer(),
-            vertexShaderBlob->GetBufferSize(), nullptr, &s_PieceShaderVertex));
-    DirectX::ThrowIfFailed(s_Device->CreatePixelShader(pixelShaderBlob->GetBufferPointer(),
-        pixelShaderBlob->GetBufferSize(), nullptr, &s_PieceShaderPixel));
-
-    // Highlight
-    DirectX::ThrowIfFailed(D3DCompileFromFile(L"highlight.hlsl", nullptr, nullptr, "vert",
-        "vs_5_0", 0, 0, &vertexShaderBlob, nullptr));
-    DirectX::ThrowIfFailed(D3DCompileFromFile(L"highlight.hlsl", nullptr, nullptr, "frag",
-        "ps_5_0", 0, 0, &pixelShaderBlob, nullptr));
-    DirectX::ThrowIfFailed(s_Device->CreateVertexShader(vertexShaderBlob->GetBufferPointer(),
-        vertexShaderBlob->GetBufferSize(), nullptr, &s_HighlightShaderVertex));
-    DirectX::ThrowIfFailed(s_Device->CreatePixelShader(pixelShaderBlob->GetBufferPointer(),
-        pixelShaderBlob->GetBufferSize(), nullptr, &s_HighlightShaderPixel));
-}
-
-auto Application::DrawChessPiece(const Piece &piece, ConstantBufferData &cbuffer) -> void {
-    // Update transform, set texture, and draw
-    cbuffer.ModelMatrix = piece.GetModelMatrix();
-    UpdateConstantBuffer(cbuffer);
-    s_DeviceContext->PSSetShaderResources(0, 1, s_PieceTextures[piece.GetType()].ResourceView().GetAddressOf());
-    s_DeviceContext->DrawIndexed(6, 0, 0);
-}
-
-auto Application::DrawHighlight(const Vector2& pos, ConstantBufferData& cbuffer) -> void {
-    cbuffer.ModelMatrix = Matrix::CreateTranslation(pos.x, pos.y, 0.005F);
-    UpdateConstantBuffer(cbuffer);
-    s_DeviceContext->DrawIndexed(6, 0, 0);
-}
-
-auto Application::UpdateConstantBuffer(const ConstantBufferData &cbuffer) -> void {
-    // Map and unmap constant buffer to set data, and then upload
-    D3D11_MAPPED_SUBRESOURCE mappedResource;
-    DirectX::ThrowIfFailed(s_DeviceContext->Map(s_ConstantBuffer.Get(), 0,
-        D3D11_MAP_WRITE_DISCARD, 0, &mappedResource));
-    std::memcpy(mappedResource.pData, &cbuffer, sizeof(ConstantBufferData));
-    s_DeviceContext->Unmap(s_ConstantBuffer.Get(), 0);
-    s_DeviceContext->VSSetConstantBuffers(0, 1, s_ConstantBuffer.GetAddressOf());
+    }
 }
 
-auto Application::ScreenToWorldPoint(const Vector2 &screen, const Vector2& screenMetrics, const ConstantBufferData &cbuffer) -> Vector2 {
+auto Application::ScreenToWorldPoint(const Vector2 &screen, const Vector2& screenMetrics, const CameraData &camera) -> Vector2 {
     // Transform into ndc, then into view space, and then into world space
     const auto ndc = (Vector2(screen.x / screenMetrics.x, (screenMetrics.y - screen.y) / screenMetrics.y) - Vector2(0.5F, 0.5F)) * 2.0F;
-    return Vector2::Transform(Vector2::Transform(ndc, cbuffer.ProjectionMatrix.Invert()), cbuffer.ViewMatrix.Invert());
+    return Vector2::Transform(Vector2::Transform(ndc, camera.ProjectionMatrix.Invert()), camera.ViewMatrix.Invert());
 }
 
-auto Application::ScreenToWorldPoint(const int sx, const int sy, const int smx, const int smy, const ConstantBufferData &cbuffer) -> Vector2 {
-    return ScreenToWorldPoint(Vector2(static_cast<float>(sx), static_cast<float>(sy)), Vector2(static_cast<float>(smx), static_cast<float>(smy)), cbuffer);
+auto Application::ScreenToWorldPoint(const int sx, const int sy, const int smx, const int smy, const CameraData &camera) -> Vector2 {
+    return ScreenToWorldPoint(Vector2(static_cast<float>(sx), static_cast<float>(sy)), Vector2(static_cast<float>(smx), static_cast<float>(smy)), camera);
 }
 
 auto Application::Render() -> void {
+    const Metrics::ScopedTimer frameTimer(Histogram::FrameTimeMicroseconds);
+    TRACE_SCOPE("Frame");
 
     // Get window metrics
     RECT clientRect;
@@ -326,61 +164,56 @@ auto Application::Render() -> void {
     const auto windowWidth = static_cast<float>(clientRect.right);
     const auto windowHeight = static_cast<float>(clientRect.bottom);
 
-    // Initialize cbuffer for current config
-    ConstantBufferData cbuffer {
-        Matrix::CreateScale(8, 8, 1),
+    // Initialize camera for current config
+    const CameraData camera {
         Matrix::CreateTranslation(4, 4, 0).Invert(),
         Matrix::CreateOrthographic(9.0F * windowWidth / windowHeight, 9.0F, -1, 1)
     };
 
-    UpdateConstantBuffer(cbuffer);
-
     // Update mouse state
     const auto mouseState = Mouse::Get().GetState();
     s_MouseState.Update(mouseState);
 
     // Handle basic piece dragging
     if(s_MouseState.leftButton == ButtonState::PRESSED) {
-        for(auto& piece : Board::GetBoard() | std::views::values) {
-            if(piece.PointInside(ScreenToWorldPoint(mouseState.x, mouseState.y, clientRect.right, clientRect.bottom, cbuffer))) {
-                s_SelectedPiece = &piece;
-                s_PickupPos = piece.GetPosition();
-                s_SelectedPiece->SetZIndex(1.0F);
-                auto pos = ScreenToWorldPoint(mouseState.x, mouseState.y, clientRect.right, clientRect.bottom, cbuffer);
-                pos.x = floor(pos.x);
-                pos.y = floor(pos.y);
-                Board::CalculateLegalMoves({ static_cast<int>(pos.x), static_cast<int>(pos.y) }, *s_SelectedPiece, s_Moves);
+        for(size_t i = 0; i < s_PieceViews.size(); i++) {
+            if(auto& piece = s_PieceViews[i]; piece.PointInside(ScreenToWorldPoint(mouseState.x, mouseState.y, clientRect.right, clientRect.bottom, camera))) {
+                s_SelectedPiece = i;
+                piece.SetZIndex(1.0F);
+                Board::CalculateLegalMoves(piece.GetSquare(), Board::GetPiece(piece.GetSquare()), s_Moves);
             }
         }
     }
 
     if(s_MouseState.leftButton == ButtonState::RELEASED) {
-        auto pos = ScreenToWorldPoint(mouseState.x, mouseState.y, clientRect.right, clientRect.bottom, cbuffer);
+        auto pos = ScreenToWorldPoint(mouseState.x, mouseState.y, clientRect.right, clientRect.bottom, camera);
         pos.x = floor(pos.x);
         pos.y = floor(pos.y);
-        if(s_SelectedPiece != nullptr) {
-            s_SelectedPiece->SetPosition(pos);
-            s_SelectedPiece->SetZIndex(0.01F);
+        if(s_SelectedPiece.has_value()) {
+            auto& piece = s_PieceViews[*s_SelectedPiece];
+            piece.SetPosition(pos);
+            piece.SetZIndex(0.01F);
+            s_SelectedPiece.reset();
 
-            if (pos != s_PickupPos) {
+            if (pos != ToVector(piece.GetSquare())) {
                 const auto move = std::ranges::find_if(s_Moves, [&pos](const Move& m) -> bool {
-	                return static_cast<Vector2>(m.To) == pos;
+	                return ToVector(m.To) == pos;
                 });
 
                 if (move != s_Moves.end()) {
 	                Board::MakeMove(*move);
+                    // Captures, castling and promotions change other pieces too
+                    SyncPieceViews();
 				}
                 else {
-					s_SelectedPiece->SetPosition(s_PickupPos);
+					piece.SetPosition(ToVector(piece.GetSquare()));
                 }
 			}
-
-            s_SelectedPiece = nullptr;
         }
     }
 
-    if(s_SelectedPiece != nullptr) {
-        s_SelectedPiece->SetPosition(ScreenToWorldPoint(mouseState.x, mouseState.y, clientRect.right, clientRect.bottom, cbuffer) - Vector2(0.5F, 0.5F));
+    if(s_SelectedPiece.has_value()) {
+        s_PieceViews[*s_SelectedPiece].SetPosition(ScreenToWorldPoint(mouseState.x, mouseState.y, clientRect.right, clientRect.bottom, camera) - Vector2(0.5F, 0.5F));
     }
 
     // Clear RT
@@ -397,29 +230,19 @@ auto Application::Render() -> void {
     };
     s_DeviceContext->RSSetViewports(1, &viewport);
 
-    // Draw board
-    s_DeviceContext->OMSetDepthStencilState(s_DepthStencilStateBoard.Get(), 1);
-    s_DeviceContext->VSSetShader(s_BoardShaderVertex.Get(), nullptr, 0);
-    s_DeviceContext->PSSetShader(s_BoardShaderPixel.Get(), nullptr, 0);
-
-    s_DeviceContext->DrawIndexed(6, 0, 0);
+    std::array<PieceSprite, RenderBackend::MaxInstances> pieces;
+    size_t pieceCount = 0;
 
-    // Draw highlights
-    s_DeviceContext->OMSetDepthStencilState(s_DepthStencilStatePiece.Get(), 1);
-    s_DeviceContext->VSSetShader(s_HighlightShaderVertex.Get(), nullptr, 0);
-    s_DeviceContext->PSSetShader(s_HighlightShaderPixel.Get(), nullptr, 0);
-
-    for (auto& move : s_Moves) {
-        DrawHighlight(move.To, cbuffer);
+    for (const auto& piece : s_PieceViews) {
+        const auto translation = piece.GetModelMatrix().Translation();
+        pieces[pieceCount++] = { piece.GetType(), translation.x, translation.y, translation.z };
     }
 
-    // Draw pieces
-    s_DeviceContext->VSSetShader(s_PieceShaderVertex.Get(), nullptr, 0);
-    s_DeviceContext->PSSetShader(s_PieceShaderPixel.Get(), nullptr, 0);
+    FrameConstants constants;
+    std::memcpy(constants.ViewMatrix.data(), &camera.ViewMatrix, sizeof(constants.ViewMatrix));
+    std::memcpy(constants.ProjectionMatrix.data(), &camera.ProjectionMatrix, sizeof(constants.ProjectionMatrix));
 
-    for(auto& piece : Board::GetBoard() | std::views::values) {
-        DrawChessPiece(piece, cbuffer);
-    }
+    s_Renderer->DrawFrame(constants, s_Moves, { pieces.data(), pieceCount });
 
     s_SwapChain->Present(1, 0);
 }
@@ -542,6 +365,31 @@ auto Application::WindowProcedure(const HWND hWnd, const UINT uMsg, const WPARAM
             Mouse::ProcessMessage(uMsg, wParam, lParam);
             return 0;
 
+        case WM_KEYDOWN:
+            // F2 dumps the metrics next to the executable and to the debugger
+            if (wParam == VK_F2) {
+                const auto snapshot = Metrics::Snapshot();
+                std::ofstream("metrics.json") << snapshot.ToJson() << '\n';
+                OutputDebugStringA(snapshot.ToText().c_str());
+                return 0;
+            }
+            // F3 starts tracing, pressing it again writes the trace next to the executable
+            if (wParam == VK_F3) {
+                if (Trace::IsEnabled()) {
+                    Trace::SetEnabled(false);
+                    std::ofstream stream("trace.json");
+                    Trace::Export(stream);
+                    OutputDebugStringA("Trace written to trace.json\n");
+                }
+                else {
+                    Trace::Clear();
+                    Trace::SetThreadName("UI");
+                    Trace::SetEnabled(true);
+                }
+                return 0;
+            }
+            return DefWindowProc(hWnd, uMsg, wParam, lParam);
+
         default: {
             return DefWindowProc(hWnd, uMsg, wParam, lParam);
         }
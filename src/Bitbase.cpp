@@ -0,0 +1,411 @@
+#include <pch.hpp>
+#include <Bitbase.hpp>
+#include <Bitboard.hpp>
+#include <Board.hpp>
+#include <Piece.hpp>
+
+#include <bit>
+#include <cstring>
+
+static_assert(std::endian::native == std::endian::little, "The table is read in place as little-endian");
+
+namespace {
+    constexpr size_t NameSize = 16;
+
+    /// <summary>
+    /// The pieces in the order of a material, strongest first, with their letters and values
+    /// </summary>
+    constexpr std::array<PieceFlag, 5> PieceOrder { PieceFlag::Queen, PieceFlag::Rook, PieceFlag::Bishop, PieceFlag::Knight, PieceFlag::Pawn };
+    constexpr std::string_view PieceLetters = "QRBNP";
+    constexpr std::array PieceValues { 9, 5, 3, 3, 1 };
+
+    auto Rank(const PieceFlag type) -> int {
+        return static_cast<int>(std::ranges::find(PieceOrder, type) - PieceOrder.begin());
+    }
+
+    auto IsStronger(const std::vector<PieceFlag>& a, const std::vector<PieceFlag>& b) -> bool {
+        const auto value = [](const std::vector<PieceFlag>& pieces) {
+            int sum = 0;
+            for (const auto type : pieces) sum += PieceValues[Rank(type)];
+            return sum;
+        };
+
+        if (value(a) != value(b)) {
+            return value(a) > value(b);
+        }
+
+        // Stronger pieces first, then more of them
+        return std::ranges::lexicographical_compare(b, a, [](const PieceFlag x, const PieceFlag y) { return Rank(x) > Rank(y); });
+    }
+
+    auto HasPawn(const std::vector<PieceFlag>& pieces) -> bool {
+        return std::ranges::find(pieces, PieceFlag::Pawn) != pieces.end();
+    }
+
+    auto SortPieces(std::vector<PieceFlag>& pieces) -> void {
+        std::ranges::sort(pieces, {}, Rank);
+    }
+
+    /// <summary>
+    /// The squares of the a1-d1-d4 triangle and the queen side, the strong king is always on one of them
+    /// </summary>
+    constexpr std::array<int, 10> TriangleSquares { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 };
+
+    constexpr auto KingIndices = [] {
+        std::array<std::array<int, 64>, 2> indices {};
+
+        for (int square = 0; square < 64; square++) {
+            indices[0][square] = -1;
+            indices[1][square] = square % 8 < 4 ? square / 8 * 4 + square % 8 : -1;
+        }
+
+        for (int i = 0; i < static_cast<int>(TriangleSquares.size()); i++) {
+            indices[0][TriangleSquares[i]] = i;
+        }
+
+        return indices;
+    }();
+
+    /// <summary>
+    /// Mirrors a square: bit 0 flips the file, bit 1 the rank and bit 2 swaps them
+    /// </summary>
+    constexpr auto Transform(const int square, const int symmetry) -> int {
+        auto x = square % 8;
+        auto y = square / 8;
+
+        if (symmetry & 1) x = 7 - x;
+        if (symmetry & 2) y = 7 - y;
+        if (symmetry & 4) std::swap(x, y);
+
+        return y * 8 + x;
+    }
+
+    template<typename T>
+    auto Write(std::vector<uint8_t>& bytes, const size_t offset, const T value) -> void {
+        std::memcpy(bytes.data() + offset, &value, sizeof(T));
+    }
+
+    template<typename T>
+    auto Read(const std::span<const uint8_t> bytes, const size_t offset) -> T {
+        T value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+        return value;
+    }
+}
+
+auto Bitbase::Material::Parse(const std::string_view name) -> Material {
+    const auto versus = name.find('v');
+
+    if (versus == std::string_view::npos || !name.starts_with('K') || name.size() <= versus + 1 || name[versus + 1] != 'K') {
+        throw std::invalid_argument("A material is named like KQvKR, not " + std::string(name));
+    }
+
+    const auto parseSide = [&](const std::string_view letters) {
+        std::vector<PieceFlag> pieces;
+
+        for (const auto letter : letters) {
+            const auto rank = PieceLetters.find(letter);
+
+            if (rank == std::string_view::npos) {
+                throw std::invalid_argument("Unknown piece " + std::string(1, letter) + " in " + std::string(name));
+            }
+
+            pieces.push_back(PieceOrder[rank]);
+        }
+
+        SortPieces(pieces);
+        return pieces;
+    };
+
+    Material material { parseSide(name.substr(1, versus - 1)), parseSide(name.substr(versus + 2)) };
+
+    if (IsStronger(material.Weak, material.Strong)) {
+        std::swap(material.Strong, material.Weak);
+    }
+
+    if (material.GetPieceCount() > MaxPieces) {
+        throw std::invalid_argument(std::string(name) + " has more than " + std::to_string(MaxPieces) + " pieces");
+    }
+
+    if (HasPawn(material.Weak) && HasPawn(material.Strong)) {
+        throw std::invalid_argument(std::string(name) + " has pawns on both sides");
+    }
+
+    return material;
+}
+
+auto Bitbase::Material::FromBoard(bool& flipped) -> Material {
+    Material material;
+
+    for (const bool white : { true, false }) {
+        auto& pieces = white ? material.Strong : material.Weak;
+
+        for (auto squares = Board::GetOccupancy(white); squares;) {
+            const auto type = Board::GetPiece(PopSquare(squares)).GetType() & ~(PieceFlag::White | PieceFlag::Black);
+
+            if (type != PieceFlag::King) {
+                pieces.push_back(type);
+            }
+        }
+
+        SortPieces(pieces);
+    }
+
+    flipped = IsStronger(material.Weak, material.Strong);
+
+    if (flipped) {
+        std::swap(material.Strong, material.Weak);
+    }
+
+    return material;
+}
+
+auto Bitbase::Material::GetName() const -> std::string {
+    std::string name = "K";
+
+    for (const auto type : Strong) name += PieceLetters[Rank(type)];
+    name += "vK";
+    for (const auto type : Weak) name += PieceLetters[Rank(type)];
+
+    return name;
+}
+
+auto Bitbase::Material::GetPieceCount() const noexcept -> int {
+    return static_cast<int>(2 + Strong.size() + Weak.size());
+}
+
+auto Bitbase::Material::HasPawns() const noexcept -> bool {
+    return HasPawn(Strong) || HasPawn(Weak);
+}
+
+auto Bitbase::Material::GetEntries() const noexcept -> uint64_t {
+    const uint64_t kingSquares = HasPawns() ? 32 : TriangleSquares.size();
+    return kingSquares << (6 * (GetPieceCount() - 1)) << 1;
+}
+
+auto Bitbase::Index(const Material& material, const Squares& squares) -> uint64_t {
+    const bool pawns = material.HasPawns();
+    const auto count = material.GetPieceCount();
+    const auto& kings = KingIndices[pawns ? 1 : 0];
+    const auto strongEnd = 2 + static_cast<int>(material.Strong.size());
+
+    auto best = std::numeric_limits<uint64_t>::max();
+
+    // Pawns only allow the left-right mirror. Without them every image with the strong king on the triangle is
+    // a candidate, which is more than one when the king is on the diagonal, and the smallest index is taken
+    for (int symmetry = 0; symmetry < (pawns ? 2 : 8); symmetry++) {
+        const auto king = Transform(squares.Pieces[0], symmetry);
+
+        if (kings[king] < 0) {
+            continue;
+        }
+
+        std::array<int, MaxPieces> pieces {};
+        for (int i = 0; i < count; i++) {
+            pieces[i] = Transform(squares.Pieces[i], symmetry);
+        }
+
+        // Equal pieces of a side are interchangeable, so they are kept in ascending order
+        for (int i = 2; i < count;) {
+            const auto& types = i < strongEnd ? material.Strong : material.Weak;
+            const auto base = i < strongEnd ? 2 : strongEnd;
+            auto end = i + 1;
+
+            while (end < (i < strongEnd ? strongEnd : count) && types[end - base] == types[i - base]) {
+                end++;
+            }
+
+            // A run holds a few pieces at most, an insertion sort over it is all that is needed
+            for (int j = i + 1; j < end; j++) {
+                for (int k = j; k > i && pieces[k - 1] > pieces[k]; k--) {
+                    std::swap(pieces[k - 1], pieces[k]);
+                }
+            }
+
+            i = end;
+        }
+
+        uint64_t index = kings[king];
+        for (int i = 1; i < count; i++) {
+            index = index * 64 + pieces[i];
+        }
+
+        best = std::min(best, index * 2 + (squares.WhiteToMove ? 0 : 1));
+    }
+
+    return best;
+}
+
+auto Bitbase::Decode(const Material& material, uint64_t index) -> Squares {
+    Squares squares;
+    squares.WhiteToMove = index % 2 == 0;
+    index /= 2;
+
+    for (int i = material.GetPieceCount() - 1; i > 0; i--) {
+        squares.Pieces[i] = static_cast<int>(index % 64);
+        index /= 64;
+    }
+
+    squares.Pieces[0] = material.HasPawns()
+        ? static_cast<int>(index / 4 * 8 + index % 4)
+        : TriangleSquares[index];
+
+    return squares;
+}
+
+Bitbase::Bitbase(const std::filesystem::path& path) : m_File(path), m_Data(m_File.GetBytes()) {
+    try {
+        Parse(m_Data);
+    }
+    catch (const std::exception& e) {
+        throw std::runtime_error(path.string() + ": " + e.what());
+    }
+}
+
+Bitbase::Bitbase(std::vector<uint8_t> bytes) : m_Bytes(std::move(bytes)), m_Data(m_Bytes) {
+    Parse(m_Data);
+}
+
+auto Bitbase::GetMaterial() const noexcept -> const Material& {
+    return m_Material;
+}
+
+auto Bitbase::GetBytes() const noexcept -> std::span<const uint8_t> {
+    return m_Data;
+}
+
+auto Bitbase::Probe() const -> Value {
+    bool flipped;
+    Material::FromBoard(flipped);
+
+    Squares squares;
+    squares.WhiteToMove = Board::IsWhiteToMove() != flipped;
+
+    // The pieces of each side sorted like the material, a flipped position is mirrored from top to bottom
+    std::array<std::vector<std::pair<int, int>>, 2> sides;
+
+    for (const bool white : { true, false }) {
+        auto& side = sides[white != flipped ? 0 : 1];
+
+        for (auto occupancy = Board::GetOccupancy(white); occupancy;) {
+            const auto position = PopSquare(occupancy);
+            const auto type = Board::GetPiece(position).GetType() & ~(PieceFlag::White | PieceFlag::Black);
+            const auto square = SquareIndex(position) ^ (flipped ? 56 : 0);
+
+            side.emplace_back(type == PieceFlag::King ? -1 : Rank(type), square);
+        }
+
+        std::ranges::sort(side);
+    }
+
+    squares.Pieces[0] = sides[0][0].second;
+    squares.Pieces[1] = sides[1][0].second;
+
+    int slot = 2;
+    for (const auto& side : sides) {
+        for (size_t i = 1; i < side.size(); i++) {
+            squares.Pieces[slot++] = side[i].second;
+        }
+    }
+
+    return Get(Index(m_Material, squares));
+}
+
+auto Bitbase::Serialize(const Material& material, const std::span<const Value> values) -> std::vector<uint8_t> {
+    if (values.size() != material.GetEntries()) {
+        throw std::invalid_argument("A table of " + material.GetName() + " has " + std::to_string(material.GetEntries()) + " entries");
+    }
+
+    // Padding stays zero so the output only depends on the input
+    std::vector<uint8_t> bytes(HeaderSize + (values.size() + 3) / 4, 0);
+
+    const auto name = material.GetName();
+    std::memcpy(bytes.data(), Magic.data(), Magic.size());
+    Write(bytes, 4, Version);
+    std::memcpy(bytes.data() + 8, name.data(), std::min(name.size(), NameSize));
+    Write(bytes, 24, static_cast<uint64_t>(values.size()));
+
+    for (size_t i = 0; i < values.size(); i++) {
+        bytes[HeaderSize + i / 4] |= static_cast<uint8_t>(static_cast<uint8_t>(values[i]) << (i % 4 * 2));
+    }
+
+    return bytes;
+}
+
+auto Bitbase::GetName(const Value value) -> std::string_view {
+    switch (value) {
+        case Value::Draw: return "draw";
+        case Value::Win: return "win";
+        case Value::Loss: return "loss";
+        case Value::Illegal: return "illegal";
+    }
+
+    return "unknown";
+}
+
+auto Bitbase::Parse(const std::span<const uint8_t> bytes) -> void {
+    if (bytes.size() < HeaderSize || std::memcmp(bytes.data(), Magic.data(), Magic.size()) != 0) {
+        throw std::runtime_error("Not a bitbase");
+    }
+
+    if (Read<uint32_t>(bytes, 4) != Version) {
+        throw std::runtime_error("Unsupported bitbase version");
+    }
+
+    const auto name = reinterpret_cast<const char*>(bytes.data() + 8);
+    m_Material = Material::Parse({ name, strnlen(name, NameSize) });
+
+    const auto entries = Read<uint64_t>(bytes, 24);
+    if (entries != m_Material.GetEntries() || bytes.size() < HeaderSize + (entries + 3) / 4) {
+        throw std::runtime_error("Truncated " + m_Material.GetName() + " table");
+    }
+
+    m_Values = bytes.data() + HeaderSize;
+}
+
+auto BitbaseSet::Load(const std::filesystem::path& directory) -> size_t {
+    size_t loaded = 0;
+
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.is_regular_file() && entry.path().extension() == Bitbase::Extension) {
+            Add(std::make_unique<Bitbase>(entry.path()));
+            loaded++;
+        }
+    }
+
+    return loaded;
+}
+
+auto BitbaseSet::Add(std::unique_ptr<Bitbase> table) -> const Bitbase& {
+    auto& slot = m_Tables[table->GetMaterial().GetName()];
+    slot = std::move(table);
+    return *slot;
+}
+
+auto BitbaseSet::Find(const Bitbase::Material& material) const -> const Bitbase* {
+    const auto table = m_Tables.find(material.GetName());
+    return table != m_Tables.end() ? table->second.get() : nullptr;
+}
+
+auto BitbaseSet::Probe() const -> std::optional<Bitbase::Value> {
+    if (std::popcount(Board::GetOccupancy(true) | Board::GetOccupancy(false)) > Bitbase::MaxPieces) {
+        return std::nullopt;
+    }
+
+    // An en passant square needs no check, no table has pawns of both colors
+    const auto state = Board::GetState();
+    if (state.WhiteCanCastleKingSide || state.WhiteCanCastleQueenSide
+        || state.BlackCanCastleKingSide || state.BlackCanCastleQueenSide) {
+        return std::nullopt;
+    }
+
+    bool flipped;
+    const auto material = Bitbase::Material::FromBoard(flipped);
+
+    if (material.Strong.empty() && material.Weak.empty()) {
+        return Bitbase::Value::Draw;
+    }
+
+    const auto table = Find(material);
+    return table != nullptr ? std::optional(table->Probe()) : std::nullopt;
+}
\ No newline at end of file
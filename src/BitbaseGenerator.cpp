@@ -0,0 +1,419 @@
+#include <pch.hpp>
+#include <BitbaseGenerator.hpp>
+#include <Bitboard.hpp>
+#include <Board.hpp>
+#include <Move.hpp>
+#include <Piece.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+    /// <summary>
+    /// The work a thread takes from a pass at a time
+    /// </summary>
+    constexpr uint64_t ChunkSize = 4096;
+
+    /// <summary>
+    /// The count of a position that has a drawing capture or promotion. Counting down from it never
+    /// reaches zero, so the position can never be lost
+    /// </summary>
+    constexpr uint8_t CannotLose = 0xFF;
+
+    enum State : uint8_t {
+        Unknown,
+        Win,
+        Loss,
+        Illegal
+    };
+
+    /// <summary>
+    /// Gets the material left after a piece is taken off or a pawn is promoted, nothing for two bare kings
+    /// </summary>
+    auto Convert(const Bitbase::Material& material, const bool strong, const size_t piece, const PieceFlag promotion) -> std::optional<Bitbase::Material> {
+        auto result = material;
+        auto& pieces = strong ? result.Strong : result.Weak;
+
+        if (promotion == PieceFlag::None) {
+            pieces.erase(pieces.begin() + static_cast<std::ptrdiff_t>(piece));
+        }
+        else {
+            pieces[piece] = promotion;
+        }
+
+        if (result.Strong.empty() && result.Weak.empty()) {
+            return std::nullopt;
+        }
+
+        return Bitbase::Material::Parse(result.GetName());
+    }
+}
+
+/// <summary>
+/// The state of one table while it is generated. A position has an atomic state and the number of its distinct
+/// successors in the table that are not known to be wins for the opponent yet
+/// </summary>
+class BitbaseGenerator::Table final {
+public:
+    Table(const Bitbase::Material& material, const BitbaseSet& tables, const int threads) :
+        m_Material(material),
+        m_Tables(tables),
+        m_Threads(threads),
+        m_Entries(material.GetEntries()),
+        m_StrongEnd(2 + static_cast<int>(material.Strong.size())),
+        m_States(std::make_unique<std::atomic<uint8_t>[]>(m_Entries)),
+        m_Counts(std::make_unique<std::atomic<uint8_t>[]>(m_Entries)) {}
+
+    auto Generate(Report& report) -> std::vector<uint8_t> {
+        std::vector<std::vector<uint64_t>> found(m_Threads);
+
+        Parallel(m_Entries, [&](const uint64_t begin, const uint64_t end, const int thread) {
+            std::vector<Move> moves;
+            std::vector<uint64_t> successors;
+
+            for (auto index = begin; index < end; index++) {
+                if (Classify(index, moves, successors)) {
+                    found[thread].push_back(index);
+                }
+            }
+        });
+
+        report.Iterations = 0;
+
+        for (auto frontier = Gather(found); !frontier.empty(); frontier = Gather(found)) {
+            Parallel(frontier.size(), [&](const uint64_t begin, const uint64_t end, const int thread) {
+                std::vector<uint64_t> predecessors;
+
+                for (auto i = begin; i < end; i++) {
+                    Propagate(frontier[i], predecessors, found[thread]);
+                }
+            });
+
+            report.Iterations++;
+        }
+
+        std::vector<Bitbase::Value> values(m_Entries);
+        report.Wins = report.Draws = report.Losses = 0;
+
+        for (uint64_t index = 0; index < m_Entries; index++) {
+            switch (m_States[index].load(std::memory_order_relaxed)) {
+                case Win:
+                    values[index] = Bitbase::Value::Win;
+                    report.Wins++;
+                    break;
+                case Loss:
+                    values[index] = Bitbase::Value::Loss;
+                    report.Losses++;
+                    break;
+                case Illegal:
+                    values[index] = Bitbase::Value::Illegal;
+                    break;
+                default:
+                    values[index] = Bitbase::Value::Draw;
+                    report.Draws++;
+                    break;
+            }
+        }
+
+        return Bitbase::Serialize(m_Material, values);
+    }
+
+private:
+    /// <summary>
+    /// Runs a pass over a range of work on every thread, a chunk at a time
+    /// </summary>
+    template<typename Body>
+    auto Parallel(const uint64_t count, const Body& body) const -> void {
+        std::atomic<uint64_t> next = 0;
+        std::vector<std::jthread> threads;
+
+        for (int thread = 0; thread < m_Threads; thread++) {
+            threads.emplace_back([&, thread] {
+                for (auto begin = next.fetch_add(ChunkSize); begin < count; begin = next.fetch_add(ChunkSize)) {
+                    body(begin, std::min(begin + ChunkSize, count), thread);
+                }
+            });
+        }
+    }
+
+    static auto Gather(std::vector<std::vector<uint64_t>>& found) -> std::vector<uint64_t> {
+        std::vector<uint64_t> frontier;
+
+        for (auto& positions : found) {
+            frontier.insert(frontier.end(), positions.begin(), positions.end());
+            positions.clear();
+        }
+
+        return frontier;
+    }
+
+    [[nodiscard]] auto GetType(const int piece) const -> PieceFlag {
+        if (piece < 2) {
+            return PieceFlag::King;
+        }
+
+        return piece < m_StrongEnd ? m_Material.Strong[piece - 2] : m_Material.Weak[piece - m_StrongEnd];
+    }
+
+    [[nodiscard]] auto IsWhite(const int piece) const -> bool {
+        return piece == 0 || (piece >= 2 && piece < m_StrongEnd);
+    }
+
+    /// <summary>
+    /// Decides a position by its own moves and counts its successors in the table
+    /// </summary>
+    /// <returns><c>bool</c> True if the position was decided</returns>
+    auto Classify(const uint64_t index, std::vector<Move>& moves, std::vector<uint64_t>& successors) -> bool {
+        const auto squares = Bitbase::Decode(m_Material, index);
+        const auto count = m_Material.GetPieceCount();
+
+        Bitboard occupied = 0;
+        Fen::State state;
+        state.WhiteToMove = squares.WhiteToMove;
+
+        for (int piece = 0; piece < count; piece++) {
+            const auto square = squares.Pieces[piece];
+            const auto type = GetType(piece);
+
+            if (type == PieceFlag::Pawn && (square < 8 || square >= 56)) {
+                return SetState(index, Illegal);
+            }
+
+            occupied |= 1ULL << square;
+            state.Squares[square] = type | (IsWhite(piece) ? PieceFlag::White : PieceFlag::Black);
+        }
+
+        if (std::popcount(occupied) != count || Bitbase::Index(m_Material, squares) != index) {
+            return SetState(index, Illegal);
+        }
+
+        Board::SetState(state);
+
+        // The side that just moved cannot have left its king in check
+        if (squares.WhiteToMove
+            ? Board::IsSquareAttacked<Board::Color::Black>(Board::GetKingPosition(false), { -1, -1 })
+            : Board::IsSquareAttacked<Board::Color::White>(Board::GetKingPosition(true), { -1, -1 })) {
+            return SetState(index, Illegal);
+        }
+
+        moves.clear();
+        Board::GenerateMoves<Board::GenType::All>(moves);
+
+        if (moves.empty()) {
+            if (Board::IsInCheck()) {
+                return SetState(index, Loss);
+            }
+
+            m_Counts[index].store(CannotLose, std::memory_order_relaxed);
+            return false;
+        }
+
+        bool cannotLose = false;
+        successors.clear();
+
+        for (const auto& move : moves) {
+            if (move.Type == Move::MoveType::Normal) {
+                auto successor = squares;
+                successor.WhiteToMove = !squares.WhiteToMove;
+
+                for (int piece = 0; piece < count; piece++) {
+                    if (successor.Pieces[piece] == SquareIndex(move.From)) {
+                        successor.Pieces[piece] = SquareIndex(move.To);
+                        break;
+                    }
+                }
+
+                successors.push_back(Bitbase::Index(m_Material, successor));
+                continue;
+            }
+
+            // Captures and promotions leave the table and are looked up in the smaller ones
+            Board::MakeMove(move);
+            const auto value = m_Tables.Probe();
+            Board::UnmakeMove(move);
+
+            if (!value) {
+                throw std::logic_error(m_Material.GetName() + " converts into a table that was not generated");
+            }
+
+            if (*value == Bitbase::Value::Loss) {
+                return SetState(index, Win);
+            }
+
+            cannotLose |= *value == Bitbase::Value::Draw;
+        }
+
+        std::ranges::sort(successors);
+        const auto distinct = std::ranges::unique(successors).begin() - successors.begin();
+
+        if (cannotLose) {
+            m_Counts[index].store(CannotLose, std::memory_order_relaxed);
+            return false;
+        }
+
+        // Every move converts into a lost ending
+        if (distinct == 0) {
+            return SetState(index, Loss);
+        }
+
+        m_Counts[index].store(static_cast<uint8_t>(distinct), std::memory_order_relaxed);
+        return false;
+    }
+
+    auto SetState(const uint64_t index, const State state) -> bool {
+        m_States[index].store(state, std::memory_order_relaxed);
+        return state != Illegal;
+    }
+
+    /// <summary>
+    /// Walks back from a decided position to the positions one move before it
+    /// </summary>
+    auto Propagate(const uint64_t index, std::vector<uint64_t>& predecessors, std::vector<uint64_t>& found) -> void {
+        const auto squares = Bitbase::Decode(m_Material, index);
+        const auto count = m_Material.GetPieceCount();
+        const bool moverWhite = !squares.WhiteToMove;
+
+        Bitboard occupied = 0;
+        for (int piece = 0; piece < count; piece++) {
+            occupied |= 1ULL << squares.Pieces[piece];
+        }
+
+        predecessors.clear();
+
+        for (int piece = 0; piece < count; piece++) {
+            if (IsWhite(piece) != moverWhite) {
+                continue;
+            }
+
+            const auto to = squares.Pieces[piece];
+            Bitboard origins = 0;
+
+            switch (const auto type = GetType(piece)) {
+                case PieceFlag::King:
+                    origins = KingAttacks[to];
+                    break;
+                case PieceFlag::Knight:
+                    origins = KnightAttacks[to];
+                    break;
+                case PieceFlag::Pawn: {
+                    // Pawns step back without capturing, two squares only onto their start rank
+                    const auto back = moverWhite ? -8 : 8;
+                    const auto rank = to / 8;
+
+                    if (moverWhite ? rank >= 2 : rank <= 5) {
+                        origins |= 1ULL << (to + back);
+
+                        if (rank == (moverWhite ? 3 : 4) && !(occupied & 1ULL << (to + back))) {
+                            origins |= 1ULL << (to + 2 * back);
+                        }
+                    }
+                    break;
+                }
+                default:
+                    for (int direction = 0; direction < static_cast<int>(RayDirections.size()); direction++) {
+                        const bool straight = direction < 4;
+
+                        if (type != PieceFlag::Queen && straight != (type == PieceFlag::Rook)) {
+                            continue;
+                        }
+
+                        auto ray = Rays[direction][to];
+                        if (const auto blockers = ray & occupied) {
+                            ray &= ~Rays[direction][NearestSquare(direction, blockers)];
+                        }
+
+                        origins |= ray;
+                    }
+                    break;
+            }
+
+            for (origins &= ~occupied; origins;) {
+                auto predecessor = squares;
+                predecessor.WhiteToMove = moverWhite;
+                predecessor.Pieces[piece] = std::countr_zero(origins);
+                origins &= origins - 1;
+
+                predecessors.push_back(Bitbase::Index(m_Material, predecessor));
+            }
+        }
+
+        // A mirror image can be reached by several unmoves, but it is one successor of its predecessor
+        std::ranges::sort(predecessors);
+        const auto end = std::ranges::unique(predecessors).begin();
+        const auto state = m_States[index].load(std::memory_order_relaxed);
+
+        for (auto i = predecessors.begin(); i != end; ++i) {
+            auto& predecessor = m_States[*i];
+            auto expected = static_cast<uint8_t>(Unknown);
+
+            if (predecessor.load(std::memory_order_relaxed) != Unknown) {
+                continue;
+            }
+
+            if (state == Loss) {
+                if (predecessor.compare_exchange_strong(expected, Win, std::memory_order_relaxed)) {
+                    found.push_back(*i);
+                }
+            }
+            else if (m_Counts[*i].fetch_sub(1, std::memory_order_relaxed) == 1
+                && predecessor.compare_exchange_strong(expected, Loss, std::memory_order_relaxed)) {
+                found.push_back(*i);
+            }
+        }
+    }
+
+    const Bitbase::Material& m_Material;
+    const BitbaseSet& m_Tables;
+    int m_Threads;
+    uint64_t m_Entries;
+    int m_StrongEnd;
+
+    std::unique_ptr<std::atomic<uint8_t>[]> m_States;
+    std::unique_ptr<std::atomic<uint8_t>[]> m_Counts;
+};
+
+BitbaseGenerator::BitbaseGenerator(BitbaseSet& tables, const int threads, ReportCallback report) :
+    m_Tables(tables),
+    m_Threads(threads > 0 ? threads : static_cast<int>(std::max(std::thread::hardware_concurrency(), 1U))),
+    m_Report(std::move(report)) {}
+
+auto BitbaseGenerator::Generate(const Bitbase::Material& material) -> const Bitbase& {
+    if (const auto table = m_Tables.Find(material)) {
+        return *table;
+    }
+
+    // Every capture and promotion leads into a smaller table, which has to be complete first
+    for (const bool strong : { true, false }) {
+        const auto& pieces = strong ? material.Strong : material.Weak;
+
+        for (size_t piece = 0; piece < pieces.size(); piece++) {
+            if (const auto smaller = Convert(material, strong, piece, PieceFlag::None)) {
+                Generate(*smaller);
+            }
+
+            if (pieces[piece] == PieceFlag::Pawn) {
+                for (const auto promotion : { PieceFlag::Queen, PieceFlag::Rook, PieceFlag::Bishop, PieceFlag::Knight }) {
+                    Generate(*Convert(material, strong, piece, promotion));
+                }
+            }
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    Report report {};
+    report.Material = material.GetName();
+    report.Entries = material.GetEntries();
+
+    auto bytes = Table(material, m_Tables, m_Threads).Generate(report);
+    report.Milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    const auto& table = m_Tables.Add(std::make_unique<Bitbase>(std::move(bytes)));
+
+    if (m_Report) {
+        m_Report(report);
+    }
+
+    return table;
+}
\ No newline at end of file
@@ -1,682 +1,966 @@
 #include <pch.hpp>
 #include <Board.hpp>
 #include <Piece.hpp>
+#include <Metrics.hpp>
 #include <Move.hpp>
+#include <PerftCache.hpp>
+#include <Trace.hpp>
+#include <Zobrist.hpp>
+
+#include <utility>
 
 using MoveType = Move::MoveType;
+using Color = Board::Color;
+using GenType = Board::GenType;
+
+namespace {
+    /// <summary>
+    /// Compile-time constants that differ between the two sides
+    /// </summary>
+    template<Color Us>
+    struct ColorTraits final {
+        static constexpr bool IsWhite = Us == Color::White;
+        static constexpr Color Them = IsWhite ? Color::Black : Color::White;
+        static constexpr PieceFlag Friendly = IsWhite ? PieceFlag::White : PieceFlag::Black;
+        static constexpr PieceFlag Enemy = IsWhite ? PieceFlag::Black : PieceFlag::White;
+        static constexpr int Forward = IsWhite ? 1 : -1;
+        static constexpr int BackRank = IsWhite ? 0 : 7;
+        static constexpr int PawnStartRank = IsWhite ? 1 : 6;
+        static constexpr int EnPassantRank = IsWhite ? 4 : 3;
+        static constexpr int PromotionRank = IsWhite ? 7 : 0;
+        static constexpr size_t Index = IsWhite ? 0 : 1;
+        static constexpr size_t ThemIndex = IsWhite ? 1 : 0;
+    };
+
+    template<GenType Type>
+    constexpr bool EmitCaptures = Type != GenType::Quiets;
+
+    template<GenType Type>
+    constexpr bool EmitQuiets = Type != GenType::Captures;
+
+    // Queen first so that picking the first move to a square promotes to a queen
+    constexpr std::array PromotionPieces { PieceFlag::Queen, PieceFlag::Knight, PieceFlag::Rook, PieceFlag::Bishop };
+
+    // First entries of the orthogonal and diagonal directions in RayDirections
+    constexpr int RookRays = 0;
+    constexpr int BishopRays = 4;
+
+    constexpr auto Has(const PieceFlag type, const PieceFlag flag) -> bool {
+        return (type & flag) == flag;
+    }
 
-void Board::SetState(const std::string_view fen) {
-    s_BoardData.clear();
+    auto AppendSquares(Bitboard squares, std::vector<Position>& positions) -> void {
+        while (squares) {
+            positions.emplace_back(PopSquare(squares));
+        }
+    }
+}
 
-    Position currentSquare = { 0, 7 }; // Start from the top left square as per FEN specification
-    bool piecesPlaced = false;
+void Board::SetState(const std::string_view fen) {
+    Fen::State state;
 
-    // Iterate the characters
-    for (int i = 0, n = fen.size(); i < n; i++) {
+    if (const auto result = Fen::Parse(fen, state); !result) {
+        throw std::invalid_argument("Invalid FEN at column " + std::to_string(result.Offset + 1) + ": "
+            + std::string(Fen::Describe(result.Code)) + ": " + std::string(fen));
+    }
 
-        const auto& c = fen[i];
+    SetState(state);
+}
 
-        if (!piecesPlaced) {
-            if (int space = 0; IsEmptySpace(c, space)) { // Process empty space
-                currentSquare += { space, 0 };
-            }
-            else if (Piece p; IsPiece(c, p)) { // Process pieces
-                p.SetPosition(currentSquare);
-                s_BoardData.emplace(currentSquare, p);
-                currentSquare += { 1, 0 };
-            }
-            else if (c == '/') { // New rank
-                currentSquare = { 0, currentSquare.y - 1 };
-            }
-            else if (c == ' ') {
-                piecesPlaced = true; // end of piece placement
-            }
-        }
-        else {
-	        switch (c)
-	        {
-				case 'w': {
-                    s_WhiteToMove = true;
-                    break;
-                }
-				case 'b': {
-                    s_WhiteToMove = false;
-                    break;
-                }
-				case 'K': {
-                    s_WhiteCanCastleKingSide = true;
-                    break;
-                }
-                case 'Q': {
-                    s_WhiteCanCastleQueenSide = true;
-                    break;
-                }
-                case 'k': {
-                    s_BlackCanCastleKingSide = true;
-                    break;
-                }
-				case 'q': {
-                    s_BlackCanCastleQueenSide = true;
-                    break;
-                }
-                case '-': {
-                    s_EnPassantAvailable = false;
-                    break;
-                }
-                default: {
-                    break;
-				}
-	        }
-
-            if (c >= 'a' && c <= 'h') {
-                s_EnPassantAvailable = true;
-                s_EnPassantPosition = { c - 'a',  fen[++i] - '1' };
+auto Board::SetState(const Fen::State& state) -> void {
+    s_BoardData = {};
+    s_History.clear();
+    s_KeyHistory.clear();
+    s_Occupancy = {};
+    s_KingPositions = { Position { -1, -1 }, Position { -1, -1 } };
+
+    for (int square = 0; square < 64; square++) {
+        if (const Piece piece(state.Squares[square]); !piece.IsEmpty()) {
+            const auto side = piece.Is(PieceFlag::White) ? 0 : 1;
+            s_BoardData[square] = piece;
+            s_Occupancy[side] |= SquareBit(SquarePosition(square));
+
+            if (piece.Is(PieceFlag::King) && s_KingPositions[side].x < 0) {
+                s_KingPositions[side] = SquarePosition(square);
             }
         }
     }
-}
 
-auto Board::IsEmptySpace(const char &c, int &space) -> bool {
-    space = c - '0'; // Convert char to int
-    return c > '0' && c < '9'; // Space can be in range [1, 8];
+    s_WhiteToMove = state.WhiteToMove;
+    s_WhiteCanCastleKingSide = state.WhiteCanCastleKingSide;
+    s_WhiteCanCastleQueenSide = state.WhiteCanCastleQueenSide;
+    s_BlackCanCastleKingSide = state.BlackCanCastleKingSide;
+    s_BlackCanCastleQueenSide = state.BlackCanCastleQueenSide;
+    s_EnPassantAvailable = state.EnPassantSquare >= 0;
+    s_EnPassantPosition = s_EnPassantAvailable ? Position { state.EnPassantSquare % 8, state.EnPassantSquare / 8 } : Position {};
+    s_HalfmoveClock = state.HalfmoveClock;
+    s_FullmoveNumber = state.FullmoveNumber;
+    s_PliesSinceNullMove = 0;
+    s_Hash = ComputeHash();
 }
 
-auto Board::IsPiece(const char &c, Piece& piece) -> bool {
-    // Convert character into a piece
-    switch(c) {
-        case 'r':
-            piece = Piece(PieceFlag::Rook | PieceFlag::Black);
-            return true;
+auto Board::GetState() -> Fen::State {
+    Fen::State state;
 
-        case 'n':
-            piece = Piece(PieceFlag::Knight | PieceFlag::Black);
-            return true;
+    for (int square = 0; square < 64; square++) {
+        state.Squares[square] = s_BoardData[square].GetType();
+    }
 
-        case 'b':
-            piece = Piece(PieceFlag::Bishop | PieceFlag::Black);
-            return true;
+    state.WhiteToMove = s_WhiteToMove;
+    state.WhiteCanCastleKingSide = s_WhiteCanCastleKingSide;
+    state.WhiteCanCastleQueenSide = s_WhiteCanCastleQueenSide;
+    state.BlackCanCastleKingSide = s_BlackCanCastleKingSide;
+    state.BlackCanCastleQueenSide = s_BlackCanCastleQueenSide;
+    state.EnPassantSquare = s_EnPassantAvailable ? s_EnPassantPosition.y * 8 + s_EnPassantPosition.x : -1;
+    state.HalfmoveClock = s_HalfmoveClock;
+    state.FullmoveNumber = s_FullmoveNumber;
 
-        case 'q':
-            piece = Piece(PieceFlag::Queen | PieceFlag::Black);
-            return true;
+    return state;
+}
 
-        case 'k':
-            piece = Piece(PieceFlag::King | PieceFlag::Black);
-            return true;
+auto Board::GetFen() -> std::string {
+    return Fen::ToString(GetState());
+}
 
-        case 'p':
-            piece = Piece(PieceFlag::Pawn | PieceFlag::Black);
-            return true;
+auto Board::GetBoard() -> const std::array<Piece, 64>& {
+    return s_BoardData;
+}
 
-        case 'R':
-            piece = Piece(PieceFlag::Rook | PieceFlag::White);
-            return true;
+auto Board::GetPiece(const Position& square) -> Piece {
+    return s_BoardData[SquareIndex(square)];
+}
 
-        case 'N':
-            piece = Piece(PieceFlag::Knight | PieceFlag::White);
-            return true;
+auto Board::MakeMove(const Move& move) -> void {
+    auto piece = s_BoardData[SquareIndex(move.From)];
 
-        case 'B':
-            piece = Piece(PieceFlag::Bishop | PieceFlag::White);
-            return true;
+    if (piece.IsEmpty()) {
+        return;
+    }
 
-        case 'Q':
-            piece = Piece(PieceFlag::Queen | PieceFlag::White);
-            return true;
+    Metrics::Increment(Counter::MakeMoves);
 
-        case 'K':
-            piece = Piece(PieceFlag::King | PieceFlag::White);
-            return true;
+    s_KeyHistory.emplace_back(s_Hash);
 
-        case 'P':
-            piece = Piece(PieceFlag::Pawn | PieceFlag::White);
-            return true;
+    auto& undo = s_History.emplace_back(UndoData {
+        PieceFlag::None, s_HalfmoveClock, s_PliesSinceNullMove, s_EnPassantAvailable, s_EnPassantPosition,
+        s_WhiteCanCastleKingSide, s_WhiteCanCastleQueenSide,
+        s_BlackCanCastleKingSide, s_BlackCanCastleQueenSide
+    });
 
-        default:
-            return false;
-    }
-}
+    auto& friendly = s_Occupancy[s_WhiteToMove ? 0 : 1];
+    auto& enemy = s_Occupancy[s_WhiteToMove ? 1 : 0];
 
-auto Board::GetBoard() -> std::unordered_map<Position, Piece>& {
-    return s_BoardData;
-}
+    // The old castling rights and en passant square are replaced by the new ones at the end
+    s_Hash ^= StateKey();
 
-auto Board::MakeMove(const Move& move) -> void {
 	switch (move.Type) {
-		case MoveType::Normal: {
-			auto piece = s_BoardData.find(move.From);
-			if (piece != s_BoardData.end()) {
-				s_BoardData.insert({ move.To, Piece(piece->second) });
-				s_BoardData.erase(piece);
-			}
-            break;
-		}
-
-        case MoveType::Capture: {
-			auto piece = s_BoardData.find(move.From);
-			auto target = s_BoardData.find(move.To);
-
-			if (piece != s_BoardData.end() && target != s_BoardData.end()) {
-				s_BoardData.erase(target);
-				s_BoardData.insert({ move.To, Piece(piece->second) });
-				s_BoardData.erase(piece);
-			}
+        case MoveType::Capture:
+        case MoveType::PromotionCapture: {
+            undo.Captured = s_BoardData[SquareIndex(move.To)].GetType();
+            enemy ^= SquareBit(move.To);
+            s_Hash ^= Zobrist::PieceKey(undo.Captured, move.To);
 			break;
 		}
 
-        // TODO: Implement EnPassant
 		case MoveType::EnPassant: {
-			auto piece = s_BoardData.find(move.From);
-			auto target = s_BoardData.find(move.To);
-
-			if (piece != s_BoardData.end() && target != s_BoardData.end()) {
-				s_BoardData.erase(target);
-				s_BoardData.insert({ move.To, Piece(piece->second) });
-				s_BoardData.erase(piece);
-			}
+            // The captured pawn stands next to the capturing pawn, not on the target square
+            const Position captured = { move.To.x, move.From.y };
+            undo.Captured = std::exchange(s_BoardData[SquareIndex(captured)], Piece()).GetType();
+            enemy ^= SquareBit(captured);
+            s_Hash ^= Zobrist::PieceKey(undo.Captured, captured);
 			break;
 		}
 
-        // TODO: Implement Castle
 		case MoveType::Castle: {
-			auto piece = s_BoardData.find(move.From);
-			if (piece != s_BoardData.end()) {
-				s_BoardData.insert({ move.To, Piece(piece->second) });
-				s_BoardData.erase(piece);
-			}
+            const bool kingSide = move.To.x > move.From.x;
+            const Position from = { kingSide ? 7 : 0, move.From.y };
+            const Position to = { kingSide ? 5 : 3, move.From.y };
+            const auto rook = std::exchange(s_BoardData[SquareIndex(from)], Piece());
+            s_BoardData[SquareIndex(to)] = rook;
+            friendly ^= SquareBit(from) | SquareBit(to);
+            s_Hash ^= Zobrist::PieceKey(rook.GetType(), from) ^ Zobrist::PieceKey(rook.GetType(), to);
 			break;
 		}
 
-		case MoveType::Promotion: {
-			auto piece = s_BoardData.find(move.From);
-			if (piece != s_BoardData.end()) {
-				s_BoardData.insert({ move.To, Piece(PieceFlag::Queen | piece->second.GetColorFlag(), move.To) });
-				s_BoardData.erase(piece);
-			}
-			break;
-		}
+        default: {
+            break;
+        }
+	}
+
+    s_Hash ^= Zobrist::PieceKey(piece.GetType(), move.From);
+
+    // Captures and pawn moves are irreversible, they restart the fifty moves count
+    const bool irreversible = piece.Is(PieceFlag::Pawn) || undo.Captured != PieceFlag::None;
+
+    if (move.Type == MoveType::Promotion || move.Type == MoveType::PromotionCapture) {
+        const auto promotion = move.Promotion != PieceFlag::None ? move.Promotion : PieceFlag::Queen;
+        piece = Piece(promotion | piece.GetColorFlag());
+    }
+
+    const bool doublePush = piece.Is(PieceFlag::Pawn)
+        && SquareDistance[SquareIndex(move.From)][SquareIndex(move.To)] == 2;
+
+    friendly ^= SquareBit(move.From) | SquareBit(move.To);
+
+    s_Hash ^= Zobrist::PieceKey(piece.GetType(), move.To);
+
+    s_BoardData[SquareIndex(move.From)] = Piece();
+    s_BoardData[SquareIndex(move.To)] = piece;
+
+    if (piece.Is(PieceFlag::King)) {
+        s_KingPositions[s_WhiteToMove ? 0 : 1] = move.To;
+    }
+
+    UpdateCastlingRights(move.From);
+    UpdateCastlingRights(move.To);
+
+    s_EnPassantAvailable = doublePush;
+    if (doublePush) {
+        s_EnPassantPosition = { move.From.x, (move.From.y + move.To.y) / 2 };
+    }
+
+    s_HalfmoveClock = irreversible ? 0 : s_HalfmoveClock + 1;
+    s_PliesSinceNullMove++;
+    if (!s_WhiteToMove) {
+        s_FullmoveNumber++;
+    }
 
+    s_WhiteToMove = !s_WhiteToMove;
+    s_Hash ^= StateKey() ^ Zobrist::Keys.BlackToMove;
+}
+
+auto Board::UnmakeMove(const Move& move) -> void {
+    if (s_History.empty()) {
+        return;
+    }
+
+    Metrics::Increment(Counter::UnmakeMoves);
+
+    const auto undo = s_History.back();
+    s_History.pop_back();
+
+    s_WhiteToMove = !s_WhiteToMove;
+
+    auto& friendly = s_Occupancy[s_WhiteToMove ? 0 : 1];
+    auto& enemy = s_Occupancy[s_WhiteToMove ? 1 : 0];
+
+    friendly ^= SquareBit(move.From) | SquareBit(move.To);
+
+    auto piece = std::exchange(s_BoardData[SquareIndex(move.To)], Piece());
+
+    if (move.Type == MoveType::Promotion || move.Type == MoveType::PromotionCapture) {
+        piece = Piece(PieceFlag::Pawn | piece.GetColorFlag());
+    }
+
+    s_BoardData[SquareIndex(move.From)] = piece;
+
+    if (piece.Is(PieceFlag::King)) {
+        s_KingPositions[s_WhiteToMove ? 0 : 1] = move.From;
+    }
+
+    switch (move.Type) {
+        case MoveType::Capture:
         case MoveType::PromotionCapture: {
-            auto piece = s_BoardData.find(move.From);
-            auto target = s_BoardData.find(move.To);
+            s_BoardData[SquareIndex(move.To)] = Piece(undo.Captured);
+            enemy ^= SquareBit(move.To);
+            break;
+        }
 
-            if (piece != s_BoardData.end() && target != s_BoardData.end()) {
-                s_BoardData.erase(target);
-                s_BoardData.insert({ move.To, Piece(PieceFlag::Queen | piece->second.GetColorFlag(), move.To) });
-                s_BoardData.erase(piece);
-            }
+        case MoveType::EnPassant: {
+            const Position captured = { move.To.x, move.From.y };
+            s_BoardData[SquareIndex(captured)] = Piece(undo.Captured);
+            enemy ^= SquareBit(captured);
             break;
         }
-	}
-}
 
-auto Board::CalculatePawnAttacks(Position position, const bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void {
-    const auto directions = std::array<Position, 2> { {
-        { -1, s_WhiteToMove ? 1 : -1 },
-        { 1, s_WhiteToMove ? 1 : -1 }
-	} };
-
-	const auto enemyFlag = s_WhiteToMove ? PieceFlag::Black : PieceFlag::White;
-
-	for (const auto& direction : directions) {
-        auto positionCopy = position;
-        if (positionCopy.Advance(direction)) {
-            if (const auto piece = s_BoardData.find(positionCopy); piece != s_BoardData.end()) {
-                if (piece->second.Is(enemyFlag)) {
-                    attackedSquares.emplace_back(positionCopy);
-                }
-            }
-            else if (!ignoreEmptySquares) {
-                attackedSquares.emplace_back(positionCopy);
-			}
+        case MoveType::Castle: {
+            const bool kingSide = move.To.x > move.From.x;
+            const Position from = { kingSide ? 5 : 3, move.From.y };
+            const Position to = { kingSide ? 7 : 0, move.From.y };
+            s_BoardData[SquareIndex(to)] = std::exchange(s_BoardData[SquareIndex(from)], Piece());
+            friendly ^= SquareBit(from) | SquareBit(to);
+            break;
         }
-	}
+
+        default: {
+            break;
+        }
+    }
+
+    s_EnPassantAvailable = undo.EnPassantAvailable;
+    s_EnPassantPosition = undo.EnPassantPosition;
+    s_WhiteCanCastleKingSide = undo.WhiteCanCastleKingSide;
+    s_WhiteCanCastleQueenSide = undo.WhiteCanCastleQueenSide;
+    s_BlackCanCastleKingSide = undo.BlackCanCastleKingSide;
+    s_BlackCanCastleQueenSide = undo.BlackCanCastleQueenSide;
+    s_HalfmoveClock = undo.HalfmoveClock;
+    s_PliesSinceNullMove = undo.PliesSinceNullMove;
+    if (!s_WhiteToMove) {
+        s_FullmoveNumber--;
+    }
+
+    s_Hash = s_KeyHistory.back();
+    s_KeyHistory.pop_back();
 }
 
-auto Board::CalculatePawnMoves(const Position position, std::vector<Move>& moves) -> void
-{
+auto Board::MakeNullMove() -> void {
+    s_KeyHistory.emplace_back(s_Hash);
+    s_History.emplace_back(UndoData {
+        PieceFlag::None, s_HalfmoveClock, s_PliesSinceNullMove, s_EnPassantAvailable, s_EnPassantPosition,
+        s_WhiteCanCastleKingSide, s_WhiteCanCastleQueenSide,
+        s_BlackCanCastleKingSide, s_BlackCanCastleQueenSide
+    });
+
+    s_Hash ^= StateKey();
+
+    s_EnPassantAvailable = false;
 
+    // Positions before a null move cannot come back in a real game, so the repetition scan stops here. The
+    // fifty moves count goes on, passing is neither a capture nor a pawn move
+    s_HalfmoveClock++;
+    s_PliesSinceNullMove = 0;
+
+    s_WhiteToMove = !s_WhiteToMove;
+    s_Hash ^= StateKey() ^ Zobrist::Keys.BlackToMove;
 }
 
-auto Board::CalculateRookAttacks(Position position, const bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void {
-    constexpr auto directions = std::array<Position, 4> { {
-        { 1, 0 },
-        { -1, 0 },
-        { 0, 1 },
-        { 0, -1 }
-    } };
-
-    const auto enemyFlag = s_WhiteToMove ? PieceFlag::Black : PieceFlag::White;
-
-    for (const auto& direction : directions) {
-        auto positionCopy = position;
-		while (positionCopy.Advance(direction) && !s_BoardData.contains(positionCopy)) {
-            if (!ignoreEmptySquares) {
-                attackedSquares.emplace_back(positionCopy);
-            }
-		}
+auto Board::UnmakeNullMove() -> void {
+    if (s_History.empty()) {
+        return;
+    }
 
-        if (const auto piece = s_BoardData.find(positionCopy); piece != s_BoardData.end() &&  piece->second.Is(enemyFlag)) {
-			attackedSquares.emplace_back(positionCopy);
-		}
-	}
+    const auto undo = s_History.back();
+    s_History.pop_back();
+
+    s_WhiteToMove = !s_WhiteToMove;
+    s_EnPassantAvailable = undo.EnPassantAvailable;
+    s_EnPassantPosition = undo.EnPassantPosition;
+    s_HalfmoveClock = undo.HalfmoveClock;
+    s_PliesSinceNullMove = undo.PliesSinceNullMove;
+
+    s_Hash = s_KeyHistory.back();
+    s_KeyHistory.pop_back();
 }
 
-auto Board::CalculateRookMoves(const Position position, std::vector<Move>& moves) -> void {
-    if (s_CheckState.IsInCheck) {
-        if (s_CheckState.Threats.size() > 1) {
-            return;
+auto Board::GetOccupancy(const bool white) -> Bitboard {
+    return s_Occupancy[white ? 0 : 1];
+}
+
+auto Board::GetHash() -> uint64_t {
+    return s_Hash;
+}
+
+auto Board::GetHalfmoveClock() -> int {
+    return s_HalfmoveClock;
+}
+
+auto Board::GetFullmoveNumber() -> int {
+    return s_FullmoveNumber;
+}
+
+auto Board::IsRepetition(const int plies) -> bool {
+    const auto size = static_cast<int>(s_KeyHistory.size());
+    const auto reach = std::min(s_HalfmoveClock, s_PliesSinceNullMove);
+    int occurrences = 0;
+
+    // Only positions with the same side to move can match, so every other key is skipped
+    for (int distance = 4; distance <= reach; distance += 2) {
+        if (s_KeyHistory[size - distance] != s_Hash) {
+            continue;
         }
 
-        std::vector<Position> attacks;
-        CalculateRookAttacks(position, false, attacks);
-        
-        if (std::vector<Position> freeSquares; CheckForPins(position, freeSquares)) {
-            for (const auto& attack : attacks) {
-				if (!std::ranges::contains(freeSquares, attack)) {
-                    continue;
-				}
-
-                if (std::ranges::contains(s_CheckState.Threats, attack)) {
-                    moves.emplace_back(position, attack, MoveType::Capture);
-                }
-
-                const auto square = std::ranges::find(s_CheckState.BlockingSquares, attack);
-
-                if (square != s_CheckState.BlockingSquares.end()) {
-                    moves.emplace_back(position, attack, MoveType::Normal);
-                }
-			}
+        if (distance <= plies || ++occurrences == 2) {
+            return true;
         }
-        else {
-            for (const auto& attack : attacks) {
-                if (std::ranges::contains(s_CheckState.Threats, attack)) {
-                    moves.emplace_back(position, attack, MoveType::Capture);
-                }
+    }
+
+    return false;
+}
 
-                const auto square = std::ranges::find(s_CheckState.BlockingSquares, attack);
+auto Board::IsWhiteToMove() -> bool {
+    return s_WhiteToMove;
+}
 
-                if (square != s_CheckState.BlockingSquares.end()) {
-                    moves.emplace_back(position, attack, MoveType::Normal);
-                }
-            }
-        }
+auto Board::IsInCheck() -> bool {
+    return s_WhiteToMove
+        ? IsSquareAttacked<Color::White>(GetKingPosition(true), { -1, -1 })
+        : IsSquareAttacked<Color::Black>(GetKingPosition(false), { -1, -1 });
+}
+
+auto Board::ComputeHash() -> uint64_t {
+    uint64_t hash = StateKey();
+
+    for (auto occupied = s_Occupancy[0] | s_Occupancy[1]; occupied;) {
+        const auto pos = PopSquare(occupied);
+        hash ^= Zobrist::PieceKey(s_BoardData[SquareIndex(pos)].GetType(), pos);
     }
-    else {
-        std::vector<Position> attacks;
-        CalculateRookAttacks(position, false, attacks);
-
-        if (std::vector<Position> freeSquares; CheckForPins(position, freeSquares)) {
-            for (const auto& attack : attacks) {
-                if (!std::ranges::contains(freeSquares, attack)) {
-                    continue;
-                }
-
-                if (s_BoardData.contains(attack)) {
-                    moves.emplace_back(position, attack, MoveType::Capture);
-                }
-                else {
-                    moves.emplace_back(position, attack, MoveType::Normal);
-                }
-            }
-        }
-        else {
-            for (const auto& attack : attacks) {
-                if (s_BoardData.contains(attack)) {
-                    moves.emplace_back(position, attack, MoveType::Capture);
-                }
-                else {
-                    moves.emplace_back(position, attack, MoveType::Normal);
-                }
-            }
-        }
+
+    return s_WhiteToMove ? hash : hash ^ Zobrist::Keys.BlackToMove;
+}
+
+auto Board::StateKey() -> uint64_t {
+    const auto castling = Zobrist::CastlingKey(
+        s_WhiteCanCastleKingSide, s_WhiteCanCastleQueenSide,
+        s_BlackCanCastleKingSide, s_BlackCanCastleQueenSide
+    );
+
+    const bool enPassant = s_EnPassantAvailable
+        && (s_WhiteToMove ? CanCaptureEnPassant<Color::White>() : CanCaptureEnPassant<Color::Black>());
+
+    return enPassant ? castling ^ Zobrist::Keys.EnPassantFile[s_EnPassantPosition.x] : castling;
+}
+
+auto Board::IsOccupied(const Position& square) -> bool {
+    return ((s_Occupancy[0] | s_Occupancy[1]) & SquareBit(square)) != 0;
+}
+
+auto Board::UpdateCastlingRights(const Position& square) -> void {
+    if (square == Position { 4, 0 }) {
+        s_WhiteCanCastleKingSide = false;
+        s_WhiteCanCastleQueenSide = false;
+    }
+    else if (square == Position { 7, 0 }) {
+        s_WhiteCanCastleKingSide = false;
+    }
+    else if (square == Position { 0, 0 }) {
+        s_WhiteCanCastleQueenSide = false;
+    }
+    else if (square == Position { 4, 7 }) {
+        s_BlackCanCastleKingSide = false;
+        s_BlackCanCastleQueenSide = false;
+    }
+    else if (square == Position { 7, 7 }) {
+        s_BlackCanCastleKingSide = false;
+    }
+    else if (square == Position { 0, 7 }) {
+        s_BlackCanCastleQueenSide = false;
     }
 }
 
-auto Board::CalculateBishopAttacks(Position position, const bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void {
-    constexpr auto directions = std::array<Position, 4> { {
-        { 1, 1 },
-        { -1, 1 },
-        { 1, -1 },
-        { -1, -1 }
-    } };
-
-    const auto enemyFlag = s_WhiteToMove ? PieceFlag::Black : PieceFlag::White;
-
-    for (const auto& direction : directions) {
-        auto positionCopy = position;
-        while (positionCopy.Advance(direction) && !s_BoardData.contains(positionCopy)) {
-            if (!ignoreEmptySquares) {
-                attackedSquares.emplace_back(positionCopy);
-            }
-        }
+template<GenType Type>
+auto Board::GenerateMoves(std::vector<Move>& moves) -> void {
+    moves.clear();
 
-        if (const auto piece = s_BoardData.find(positionCopy); piece != s_BoardData.end() && piece->second.Is(enemyFlag)) {
-            attackedSquares.emplace_back(positionCopy);
-        }
+    // The only runtime branch on the side to move, everything below is specialized per color
+    if (s_WhiteToMove) {
+        GenerateMoves<Color::White, Type>(moves);
+    }
+    else {
+        GenerateMoves<Color::Black, Type>(moves);
     }
+
+    Metrics::Increment(Counter::MovegenCalls);
+    Metrics::Increment(Counter::MovesGenerated, moves.size());
 }
 
-auto Board::CalculateBishopMoves(const Position position, std::vector<Move>& moves) -> void {
-    if (s_CheckState.IsInCheck) {
-        if (s_CheckState.Threats.size() > 1) {
+template<Color Us, GenType Type>
+auto Board::GenerateMoves(std::vector<Move>& moves) -> void {
+    using Traits = ColorTraits<Us>;
+
+    UpdateCheckState<Us>();
+
+    if constexpr (Type == GenType::Evasions) {
+        if (!s_CheckState.IsInCheck) {
             return;
         }
+    }
 
-        std::vector<Position> attacks;
-        CalculateBishopAttacks(position, false, attacks);
+    // Iterate a copy of our pieces, en passant legality checks temporarily modify the board
+    for (auto pieces = s_Occupancy[Traits::Index]; pieces;) {
+        const auto pos = PopSquare(pieces);
+        CalculatePieceMoves<Us, Type>(pos, s_BoardData[SquareIndex(pos)].GetType(), moves);
+    }
+}
 
-        if (std::vector<Position> freeSquares; CheckForPins(position, freeSquares)) {
-            for (const auto& attack : attacks) {
-                if (!std::ranges::contains(freeSquares, attack)) {
-                    continue;
-                }
+auto Board::FindMove(const std::string_view notation) -> std::optional<Move> {
+    std::vector<Move> moves;
+    GenerateMoves<GenType::All>(moves);
 
-                if (std::ranges::contains(s_CheckState.Threats, attack)) {
-                    moves.emplace_back(position, attack, MoveType::Capture);
-                }
+    const auto move = std::ranges::find_if(moves, [&](const Move& m) -> bool {
+        return m.ToString() == notation;
+    });
 
-                const auto square = std::ranges::find(s_CheckState.BlockingSquares, attack);
+    return move != moves.end() ? std::optional(*move) : std::nullopt;
+}
 
-                if (square != s_CheckState.BlockingSquares.end()) {
-                    moves.emplace_back(position, attack, MoveType::Normal);
-                }
-            }
-        }
-        else {
-            for (const auto& attack : attacks) {
-                if (std::ranges::contains(s_CheckState.Threats, attack)) {
-                    moves.emplace_back(position, attack, MoveType::Capture);
-                }
+auto Board::Perft(const int depth) -> uint64_t {
+    if (depth <= 0) {
+        return 1;
+    }
 
-                const auto square = std::ranges::find(s_CheckState.BlockingSquares, attack);
+    std::vector<Move> moves;
+    moves.reserve(64);
+    GenerateMoves<GenType::All>(moves);
 
-                if (square != s_CheckState.BlockingSquares.end()) {
-                    moves.emplace_back(position, attack, MoveType::Normal);
-                }
-            }
-        }
+    // Legal moves at the last ply are leaves, no need to play them
+    if (depth == 1) {
+        return moves.size();
     }
-    else {
-        std::vector<Position> attacks;
-        CalculateBishopAttacks(position, false, attacks);
-
-        if (std::vector<Position> freeSquares; CheckForPins(position, freeSquares)) {
-            for (const auto& attack : attacks) {
-                if (!std::ranges::contains(freeSquares, attack)) {
-                    continue;
-                }
-
-                if (s_BoardData.contains(attack)) {
-                    moves.emplace_back(position, attack, MoveType::Capture);
-                }
-                else {
-                    moves.emplace_back(position, attack, MoveType::Normal);
-                }
-            }
-        }
-        else {
-            for (const auto& attack : attacks) {
-                if (s_BoardData.contains(attack)) {
-                    moves.emplace_back(position, attack, MoveType::Capture);
-                }
-                else {
-                    moves.emplace_back(position, attack, MoveType::Normal);
-                }
-            }
-        }
+
+    uint64_t nodes = 0;
+
+    for (const auto& move : moves) {
+        MakeMove(move);
+        nodes += Perft(depth - 1);
+        UnmakeMove(move);
     }
+
+    return nodes;
 }
 
-auto Board::CalculateKnightAttacks(Position position, const bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void {
-    constexpr auto directions = std::array<Position, 8> { {
-        { 1, 2 },
-        { -1, 2 },
-        { 1, -2 },
-        { -1, -2 },
-        { 2, 1 },
-        { 2, -1 },
-        { -2, 1 },
-        { -2, -1 }
-    } };
-
-    const auto enemyFlag = s_WhiteToMove ? PieceFlag::Black : PieceFlag::White;
-
-    for (const auto& direction : directions) {
-        auto positionCopy = position;
-        if (positionCopy.Advance(direction)) {
-            if (const auto piece = s_BoardData.find(positionCopy); piece != s_BoardData.end()) {
-                if (piece->second.Is(enemyFlag)) {
-                    attackedSquares.emplace_back(positionCopy);
-                }
-            }
-            else if (!ignoreEmptySquares) {
-                attackedSquares.emplace_back(positionCopy);
-            }
-        }
+auto Board::Perft(const int depth, PerftCache& cache) -> uint64_t {
+    // Bulk counting the last ply is cheaper than a cache lookup, so those nodes bypass the cache
+    if (depth <= 1) {
+        return Perft(depth);
     }
+
+    if (const auto cached = cache.Probe(s_Hash, depth)) {
+        return *cached;
+    }
+
+    std::vector<Move> moves;
+    moves.reserve(64);
+    GenerateMoves<GenType::All>(moves);
+
+    uint64_t nodes = 0;
+
+    for (const auto& move : moves) {
+        MakeMove(move);
+        nodes += Perft(depth - 1, cache);
+        UnmakeMove(move);
+    }
+
+    cache.Store(s_Hash, depth, nodes);
+    return nodes;
 }
 
-auto Board::CalculateKnightMoves(const Position position, std::vector<Move>& moves) -> void {
-    if (s_CheckState.IsInCheck) {
-	    if (s_CheckState.Threats.size() > 1) {
-		    return;
-	    }
+template<Color Us>
+auto Board::CalculatePawnAttacks(Position position, const bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void {
+    AppendSquares(LeaperTargets<Us>(PawnAttacks[ColorTraits<Us>::Index][SquareIndex(position)], ignoreEmptySquares), attackedSquares);
+}
+template<Color Us, GenType Type>
+auto Board::CalculatePawnMoves(const Position position, std::vector<Move>& moves) -> void {
+    using Traits = ColorTraits<Us>;
 
-        if (std::vector<Position> freeSquares; CheckForPins(position, freeSquares)) {
-			return;
-		}
+    const auto allowed = AllowedSquares<Us>(position);
 
-        std::vector<Position> attacks;
-        CalculateKnightAttacks(position, false, attacks);
+    const auto addMove = [&](const Position& target, const bool capture) -> void {
+        if (target.y != Traits::PromotionRank) {
+            moves.emplace_back(position, target, capture ? MoveType::Capture : MoveType::Normal);
+            return;
+        }
 
-        for (const auto& attack : attacks) {
-            if (std::ranges::contains(s_CheckState.Threats, attack)) {
-				moves.emplace_back(position, attack, MoveType::Capture);
-			}
+        for (const auto& promotion : PromotionPieces) {
+            moves.emplace_back(position, target, capture ? MoveType::PromotionCapture : MoveType::Promotion, promotion);
+        }
+    };
 
-            const auto square = std::ranges::find(s_CheckState.BlockingSquares, attack);
+    if constexpr (EmitCaptures<Type>) {
+        for (auto attacks = LeaperTargets<Us>(PawnAttacks[Traits::Index][SquareIndex(position)], true) & allowed; attacks;) {
+            addMove(PopSquare(attacks), true);
+        }
 
-            if (square != s_CheckState.BlockingSquares.end()) {
-                moves.emplace_back(position, attack, MoveType::Normal);
+        if (s_EnPassantAvailable && position.y == Traits::EnPassantRank && std::abs(s_EnPassantPosition.x - position.x) == 1) {
+            // Pins and checks are resolved by trying the capture, two pawns leave the rank at once
+            if (IsEnPassantLegal<Us>(position)) {
+                moves.emplace_back(position, s_EnPassantPosition, MoveType::EnPassant);
             }
-		}
-    }
-    else {
-        if (std::vector<Position> freeSquares; CheckForPins(position, freeSquares)) {
-            return;
         }
+    }
 
-        std::vector<Position> attacks;
-        CalculateKnightAttacks(position, false, attacks);
+    if constexpr (EmitQuiets<Type>) {
+        auto target = position + Position { 0, Traits::Forward };
 
-        for (const auto& attack : attacks) {
-            if (s_BoardData.contains(attack)) {
-				moves.emplace_back(position, attack, MoveType::Capture);
+        if (!IsOccupied(target)) {
+            if (allowed & SquareBit(target)) {
+                addMove(target, false);
             }
-            else {
-                moves.emplace_back(position, attack, MoveType::Normal);
+
+            target += { 0, Traits::Forward };
+
+            if (position.y == Traits::PawnStartRank && !IsOccupied(target) && allowed & SquareBit(target)) {
+                moves.emplace_back(position, target, MoveType::Normal);
             }
         }
     }
 }
 
+template<Color Us>
+auto Board::CalculateRookAttacks(Position position, const bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void {
+    for (int direction = RookRays; direction < RookRays + 4; direction++) {
+        AppendSquares(RayTargets<Us>(position, direction, ignoreEmptySquares), attackedSquares);
+    }
+}
+template<Color Us, GenType Type>
+auto Board::CalculateRookMoves(const Position position, std::vector<Move>& moves) -> void {
+    AddSliderMoves<Us, Type>(position, RookRays, 4, moves);
+}
+
+template<Color Us>
+auto Board::CalculateBishopAttacks(Position position, const bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void {
+    for (int direction = BishopRays; direction < BishopRays + 4; direction++) {
+        AppendSquares(RayTargets<Us>(position, direction, ignoreEmptySquares), attackedSquares);
+    }
+}
+template<Color Us, GenType Type>
+auto Board::CalculateBishopMoves(const Position position, std::vector<Move>& moves) -> void {
+    AddSliderMoves<Us, Type>(position, BishopRays, 4, moves);
+}
+
+template<Color Us>
+auto Board::CalculateKnightAttacks(Position position, const bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void {
+    AppendSquares(LeaperTargets<Us>(KnightAttacks[SquareIndex(position)], ignoreEmptySquares), attackedSquares);
+}
+template<Color Us, GenType Type>
+auto Board::CalculateKnightMoves(const Position position, std::vector<Move>& moves) -> void {
+    // A pinned knight can never stay on the line of the pin, none of its targets are allowed
+    const auto targets = LeaperTargets<Us>(KnightAttacks[SquareIndex(position)], !EmitQuiets<Type>);
+    AddMoves<Us, Type>(position, targets & AllowedSquares<Us>(position), moves);
+}
+
+template<Color Us>
 auto Board::CalculateQueenAttacks(Position position, const bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void
 {
-    CalculateRookAttacks(position, ignoreEmptySquares, attackedSquares);
-	CalculateBishopAttacks(position, ignoreEmptySquares, attackedSquares);
+    CalculateRookAttacks<Us>(position, ignoreEmptySquares, attackedSquares);
+	CalculateBishopAttacks<Us>(position, ignoreEmptySquares, attackedSquares);
 }
 
+template<Color Us, GenType Type>
 auto Board::CalculateQueenMoves(const Position position, std::vector<Move>& moves) -> void
 {
-	CalculateRookMoves(position, moves);
-	CalculateBishopMoves(position, moves);
+    // The rook rays are followed by the bishop rays, so one pin check covers all eight
+	AddSliderMoves<Us, Type>(position, RookRays, 8, moves);
 }
 
-auto Board::CalculateKingAttacks(Position position, bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void {
-	
+template<Color Us>
+auto Board::CalculateKingAttacks(Position position, const bool ignoreEmptySquares, std::vector<Position>& attackedSquares) -> void {
+    AppendSquares(LeaperTargets<Us>(KingAttacks[SquareIndex(position)], ignoreEmptySquares), attackedSquares);
 }
 
-auto Board::CalculateKingMoves(Position position, std::vector<Move>& moves) -> void {
-
+template<Color Us>
+auto Board::LeaperTargets(const Bitboard attacks, const bool ignoreEmptySquares) -> Bitboard {
+    return attacks & (ignoreEmptySquares ? s_Occupancy[ColorTraits<Us>::ThemIndex] : ~s_Occupancy[ColorTraits<Us>::Index]);
 }
 
-auto Board::UpdateCheckState() -> void {
-    s_CheckState.IsInCheck = false;
-	s_CheckState.Threats.clear();
-    s_CheckState.BlockingSquares.clear();
-
-	const auto enemyFlag = s_WhiteToMove ? PieceFlag::Black : PieceFlag::White;
-    const auto king = GetKingPosition(s_WhiteToMove);
-
-    // Pawn threats
-	{
-		std::vector<Position> threats;
-    	CalculatePawnAttacks(king, true, threats);
-
-    	for (const auto& pos : threats) {
-    		if (auto piece = s_BoardData.find(pos); piece != s_BoardData.end() && piece->second.Is(PieceFlag::Pawn | enemyFlag)) {
-    			s_CheckState.IsInCheck = true;
-    			s_CheckState.Threats.emplace_back(pos);
-    		}
-    	}
-	}
+template<Color Us>
+auto Board::RayTargets(const Position position, const int direction, const bool ignoreEmptySquares) -> Bitboard {
+    using Traits = ColorTraits<Us>;
+
+    auto attacks = Rays[direction][SquareIndex(position)];
 
-    // Rook & Queen threats
-    {
-	    std::vector<Position> threats;
-        CalculateRookAttacks(king, true, threats);
+    // Cut the ray off behind the first blocker
+    if (const auto blockers = attacks & (s_Occupancy[0] | s_Occupancy[1])) {
+        attacks ^= Rays[direction][NearestSquare(direction, blockers)];
+    }
 
-		for (const auto& pos : threats) {
-            auto piece = s_BoardData.find(pos);
+    return attacks & (ignoreEmptySquares ? s_Occupancy[Traits::ThemIndex] : ~s_Occupancy[Traits::Index]);
+}
+template<Color Us, GenType Type>
+auto Board::CalculateKingMoves(const Position position, std::vector<Move>& moves) -> void {
+    const auto enemies = s_Occupancy[ColorTraits<Us>::ThemIndex];
 
-            if (piece != s_BoardData.end()) {
-                if (piece->second.Is(PieceFlag::Rook | enemyFlag)) {
-                    s_CheckState.IsInCheck = true;
-                    s_CheckState.Threats.emplace_back(pos);
+    for (auto attacks = LeaperTargets<Us>(KingAttacks[SquareIndex(position)], !EmitQuiets<Type>); attacks;) {
+        const auto attack = PopSquare(attacks);
 
-                    GetSquaresBetween(king, pos, s_CheckState.BlockingSquares);
-                }
-                else if (piece->second.Is(PieceFlag::Queen | enemyFlag)) {
-                    s_CheckState.IsInCheck = true;
-                    s_CheckState.Threats.emplace_back(pos);
+        // The king itself must not shield the square it steps back to from a slider
+        if (IsSquareAttacked<Us>(attack, position)) {
+            continue;
+        }
 
-                    GetSquaresBetween(king, pos, s_CheckState.BlockingSquares);
-                }
+        if (enemies & SquareBit(attack)) {
+            if constexpr (EmitCaptures<Type>) {
+                moves.emplace_back(position, attack, MoveType::Capture);
             }
-		}
-	}
+        }
+        else if constexpr (EmitQuiets<Type>) {
+            moves.emplace_back(position, attack, MoveType::Normal);
+        }
+    }
 
-    // Bishop & Queen threats
-	{
-		std::vector<Position> threats;
-		CalculateBishopAttacks(king, true, threats);
+    if constexpr (EmitQuiets<Type>) {
+        if (!s_CheckState.IsInCheck) {
+            AddCastlingMoves<Us>(position, moves);
+        }
+    }
+}
 
-		for (const auto& pos : threats) {
-            auto piece = s_BoardData.find(pos);
+template<Color Us>
+auto Board::AddCastlingMoves(const Position position, std::vector<Move>& moves) -> void {
+    using Traits = ColorTraits<Us>;
+    constexpr int rank = Traits::BackRank;
 
-			if (piece != s_BoardData.end()) {
-                if (piece->second.Is(PieceFlag::Bishop | enemyFlag)) {
-                    s_CheckState.IsInCheck = true;
-                    s_CheckState.Threats.emplace_back(pos);
+    if (position != Position { 4, rank }) {
+        return;
+    }
 
-                    GetSquaresBetween(king, pos, s_CheckState.BlockingSquares);
-                }
-                else if (piece->second.Is(PieceFlag::Queen | enemyFlag)) {
-                    s_CheckState.IsInCheck = true;
-                    s_CheckState.Threats.emplace_back(pos);
+    const auto hasRook = [](const Position& pos) -> bool {
+        return s_BoardData[SquareIndex(pos)].Is(PieceFlag::Rook | Traits::Friendly);
+    };
 
-                    GetSquaresBetween(king, pos, s_CheckState.BlockingSquares);
-                }
-			}
-		}
-	}
+    const bool kingSide = Traits::IsWhite ? s_WhiteCanCastleKingSide : s_BlackCanCastleKingSide;
+    const bool queenSide = Traits::IsWhite ? s_WhiteCanCastleQueenSide : s_BlackCanCastleQueenSide;
 
-    // Knight threats
-    {
-        std::vector<Position> threats;
-        CalculateKnightAttacks(king, true, threats);
+    if (kingSide && hasRook({ 7, rank })
+        && !IsOccupied({ 5, rank }) && !IsOccupied({ 6, rank })
+        && !IsSquareAttacked<Us>({ 5, rank }, position) && !IsSquareAttacked<Us>({ 6, rank }, position)) {
+        moves.emplace_back(position, Position { 6, rank }, MoveType::Castle);
+    }
 
-        for (const auto& pos : threats) {
-            if (auto piece = s_BoardData.find(pos); piece != s_BoardData.end() && piece->second.Is(PieceFlag::Knight | enemyFlag)) {
-                s_CheckState.IsInCheck = true;
-                s_CheckState.Threats.emplace_back(pos);
-            }
-        }
+    if (queenSide && hasRook({ 0, rank })
+        && !IsOccupied({ 3, rank }) && !IsOccupied({ 2, rank }) && !IsOccupied({ 1, rank })
+        && !IsSquareAttacked<Us>({ 3, rank }, position) && !IsSquareAttacked<Us>({ 2, rank }, position)) {
+        moves.emplace_back(position, Position { 2, rank }, MoveType::Castle);
     }
 }
 
-auto Board::GetKingPosition(bool white) -> Position {
-    const auto flag = white ? PieceFlag::White : PieceFlag::Black;
-    const auto king = std::ranges::find_if(s_BoardData, [&](const auto& piece) -> bool {
-        return piece.second.Is(PieceFlag::King | flag);
-    });
-    return king != s_BoardData.end() ? king->first : Position { -1, -1 };
+template<Color Us>
+auto Board::AllowedSquares(const Position position) -> Bitboard {
+    // In check only capturing the threat or blocking its line is allowed
+    const auto evasions = s_CheckState.IsInCheck ? s_CheckState.Threats | s_CheckState.BlockingSquares : ~Bitboard { 0 };
+
+    Bitboard freeSquares = 0;
+    return CheckForPins<Us>(position, freeSquares) ? freeSquares & evasions : evasions;
 }
 
-auto Board::CheckForPins(const Position& ignorePos, std::vector<Position>& freeSquares) -> bool {
-    const auto enemyFlag = s_WhiteToMove ? PieceFlag::Black : PieceFlag::White;
-    auto king = GetKingPosition(s_WhiteToMove);
+template<Color Us, GenType Type>
+auto Board::AddMoves(const Position position, Bitboard targets, std::vector<Move>& moves) -> void {
+    const auto enemies = s_Occupancy[ColorTraits<Us>::ThemIndex];
 
-    auto direction = ignorePos - king;
-    direction.Clamp();
+    while (targets) {
+        const auto target = PopSquare(targets);
 
-    auto pos = king;
-    while (pos.Advance(direction)) {
-        if (pos != ignorePos && s_BoardData.contains(pos)) {
-            return false;
+        if (enemies & SquareBit(target)) {
+            if constexpr (EmitCaptures<Type>) {
+                moves.emplace_back(position, target, MoveType::Capture);
+            }
         }
+        else if constexpr (EmitQuiets<Type>) {
+            moves.emplace_back(position, target, MoveType::Normal);
+        }
+    }
+}
 
-        if (pos == ignorePos) {
-			break;
-		}
+template<Color Us, GenType Type>
+auto Board::AddSliderMoves(const Position position, const int firstDirection, const int directions, std::vector<Move>& moves) -> void {
+    const auto allowed = AllowedSquares<Us>(position);
+
+    for (int direction = firstDirection; direction < firstDirection + directions; direction++) {
+        AddMoves<Us, Type>(position, RayTargets<Us>(position, direction, !EmitQuiets<Type>) & allowed, moves);
     }
+}
 
-    if (!s_BoardData.contains(pos)) {
-        return false;
-	}
+template<Color Us>
+auto Board::CanCaptureEnPassant() -> bool {
+    const Piece pawn(PieceFlag::Pawn | ColorTraits<Us>::Friendly);
 
-    const auto isDiagonal = direction.x != 0 && direction.y != 0;
+    for (const int file : { s_EnPassantPosition.x - 1, s_EnPassantPosition.x + 1 }) {
+        const Position position { file, ColorTraits<Us>::EnPassantRank };
 
-    while(king.Advance(direction)) {
-        if (king != ignorePos && !s_BoardData.contains(king)) {
-			freeSquares.emplace_back(king);
-		}
-        else if (king != ignorePos && s_BoardData.contains(king)) {
-            break;
+        if (file >= 0 && file < 8 && s_BoardData[SquareIndex(position)] == pawn && IsEnPassantLegal<Us>(position)) {
+            return true;
         }
     }
 
-    const auto piece = s_BoardData.find(king);
+    return false;
+}
 
-    if (piece != s_BoardData.end()) {
-		if (piece->second.Is(enemyFlag)) {
-			if (isDiagonal && (piece->second.Is(PieceFlag::Bishop) || piece->second.Is(PieceFlag::Queen))) {
-                return true;
-			}
+template<Color Us>
+auto Board::IsEnPassantLegal(const Position position) -> bool {
+    const Position captured = { s_EnPassantPosition.x, position.y };
+    const auto occupancy = s_Occupancy;
+
+    const auto board = s_BoardData;
+
+    s_BoardData[SquareIndex(s_EnPassantPosition)] = std::exchange(s_BoardData[SquareIndex(position)], Piece());
+    s_BoardData[SquareIndex(captured)] = Piece();
+
+    s_Occupancy[ColorTraits<Us>::Index] ^= SquareBit(position) | SquareBit(s_EnPassantPosition);
+    s_Occupancy[ColorTraits<Us>::ThemIndex] ^= SquareBit(captured);
+
+    const bool legal = !IsSquareAttacked<Us>(GetKingPosition(ColorTraits<Us>::IsWhite), { -1, -1 });
+
+    s_Occupancy = occupancy;
+    s_BoardData = board;
+
+    return legal;
+}
+template<Color Us>
+auto Board::IsSquareAttacked(const Position square, const Position ignorePos) -> bool {
+    using Traits = ColorTraits<Us>;
+
+    const auto index = SquareIndex(square);
+    const auto enemies = s_Occupancy[Traits::ThemIndex];
 
-			if (!isDiagonal && (piece->second.Is(PieceFlag::Rook) || piece->second.Is(PieceFlag::Queen))) {
+    const auto anyEnemy = [](Bitboard candidates, const PieceFlag type) -> bool {
+        while (candidates) {
+            if (s_BoardData[SquareIndex(PopSquare(candidates))].Is(type | Traits::Enemy)) {
                 return true;
-			}
-		}
+            }
+        }
+
+        return false;
+    };
+
+    // Enemy pawns attack the square from where our pawns would capture to
+    if (anyEnemy(PawnAttacks[Traits::Index][index] & enemies, PieceFlag::Pawn)
+        || anyEnemy(KnightAttacks[index] & enemies, PieceFlag::Knight)
+        || anyEnemy(KingAttacks[index] & enemies, PieceFlag::King)) {
+        return true;
+    }
+
+    auto occupied = s_Occupancy[0] | s_Occupancy[1];
+    if (ignorePos.x >= 0) {
+        occupied &= ~SquareBit(ignorePos);
+    }
+
+    for (int direction = 0; direction < static_cast<int>(RayDirections.size()); direction++) {
+        const auto blockers = Rays[direction][index] & occupied;
+
+        if (!blockers) {
+            continue;
+        }
+
+        const auto blocker = NearestSquare(direction, blockers);
+        const auto slider = direction < BishopRays ? PieceFlag::Rook : PieceFlag::Bishop;
+
+        if (const auto piece = s_BoardData[blocker]; piece.Is(Traits::Enemy)
+            && (piece.Is(slider) || piece.Is(PieceFlag::Queen))) {
+            return true;
+        }
     }
 
     return false;
 }
+template<Color Us>
+auto Board::UpdateCheckState() -> void {
+    using Traits = ColorTraits<Us>;
+
+    s_CheckState = { false, 0, 0 };
+
+    const auto king = GetKingPosition(Traits::IsWhite);
+
+    if (king.x < 0) {
+        return;
+    }
+
+    const auto index = SquareIndex(king);
+    const auto enemies = s_Occupancy[Traits::ThemIndex];
+    const auto occupied = s_Occupancy[0] | s_Occupancy[1];
+
+    const auto addThreats = [](Bitboard candidates, const PieceFlag type) -> void {
+        while (candidates) {
+            const auto pos = PopSquare(candidates);
+            if (s_BoardData[SquareIndex(pos)].Is(type | Traits::Enemy)) {
+                s_CheckState.Threats |= SquareBit(pos);
+            }
+        }
+    };
+
+    // Pawn & Knight threats
+    addThreats(PawnAttacks[Traits::Index][index] & enemies, PieceFlag::Pawn);
+    addThreats(KnightAttacks[index] & enemies, PieceFlag::Knight);
+
+    // Rook, Bishop & Queen threats, the line to a slider can be blocked
+    for (int direction = 0; direction < static_cast<int>(RayDirections.size()); direction++) {
+        const auto blockers = Rays[direction][index] & occupied;
+
+        if (!(blockers & enemies)) {
+            continue;
+        }
+
+        const auto square = NearestSquare(direction, blockers);
+        const auto slider = direction < BishopRays ? PieceFlag::Rook : PieceFlag::Bishop;
+
+        if (const auto piece = s_BoardData[square]; piece.Is(Traits::Enemy)
+            && (piece.Is(slider) || piece.Is(PieceFlag::Queen))) {
+            s_CheckState.Threats |= SquareBit(SquarePosition(square));
+            s_CheckState.BlockingSquares |= SquaresBetween[index][square];
+        }
+    }
+
+    s_CheckState.IsInCheck = s_CheckState.Threats != 0;
+}
+auto Board::GetKingPosition(const bool white) -> Position {
+    return s_KingPositions[white ? 0 : 1];
+}
+
+template<Color Us>
+auto Board::CheckForPins(const Position& ignorePos, Bitboard& freeSquares) -> bool {
+    const auto king = GetKingPosition(ColorTraits<Us>::IsWhite);
+
+    if (king.x < 0) {
+        return false;
+    }
+
+    const auto kingIndex = SquareIndex(king);
+    const auto index = SquareIndex(ignorePos);
+    const auto direction = RayDirection(king, ignorePos);
+
+    // Only pieces on a line or a diagonal from the king can be pinned
+    if (direction < 0) {
+        return false;
+    }
+
+    const auto occupied = s_Occupancy[0] | s_Occupancy[1];
+
+    if (SquaresBetween[kingIndex][index] & occupied) {
+        return false;
+    }
+
+    const auto blockers = Rays[direction][index] & occupied;
 
+    if (!blockers) {
+        return false;
+    }
+
+    const auto pinner = NearestSquare(direction, blockers);
+    const auto piece = s_BoardData[pinner];
+    const auto slider = direction < BishopRays ? PieceFlag::Rook : PieceFlag::Bishop;
+
+    if (!piece.Is(ColorTraits<Us>::Enemy) || (!piece.Is(slider) && !piece.Is(PieceFlag::Queen))) {
+        return false;
+    }
+
+    // The pinned piece may only move along the pin, its attacks end at the king and the pinner
+    freeSquares = LineThrough[kingIndex][pinner];
+    return true;
+}
 auto Board::GetSquaresBetween(const Position& start, const Position& end, std::vector<Position>& squares) -> void {
-	auto direction = end - start;
-	direction.Clamp();
+    auto between = SquaresBetween[SquareIndex(start)][SquareIndex(end)];
 
-	auto currentPos = start + direction;
+    while (between) {
+        squares.emplace_back(PopSquare(between));
+    }
+}
+template<Color Us, GenType Type>
+auto Board::CalculatePieceMoves(const Position& pos, const PieceFlag type, std::vector<Move>& moves) -> void {
+    // Only the king can escape a double check
+    if (std::popcount(s_CheckState.Threats) > 1 && !Has(type, PieceFlag::King)) {
+        return;
+    }
 
-	while (currentPos != end) {
-		squares.emplace_back(currentPos);
-		currentPos += direction;
+    if (Has(type, PieceFlag::Pawn)) {
+	    CalculatePawnMoves<Us, Type>(pos, moves);
+    }
+	else if (Has(type, PieceFlag::Rook)) {
+		CalculateRookMoves<Us, Type>(pos, moves);
+	}
+	else if (Has(type, PieceFlag::Bishop)) {
+		CalculateBishopMoves<Us, Type>(pos, moves);
+	}
+	else if (Has(type, PieceFlag::Knight)) {
+		CalculateKnightMoves<Us, Type>(pos, moves);
+	}
+	else if (Has(type, PieceFlag::Queen)) {
+		CalculateQueenMoves<Us, Type>(pos, moves);
+	}
+	else if (Has(type, PieceFlag::King)) {
+		CalculateKingMoves<Us, Type>(pos, moves);
 	}
 }
 
 auto Board::CalculateLegalMoves(const Position& pos, const Piece& piece, std::vector<Move>& moves) -> void {
+    TRACE_SCOPE("CalculateLegalMoves");
 
     moves.clear();
 
@@ -684,22 +968,55 @@ auto Board::CalculateLegalMoves(const Position& pos, const Piece& piece, std::ve
     	return;
 	}
 
-    if (piece.Is(PieceFlag::Pawn)) {
-	    //CalculatePawnMoves(pos, moves);
+    if (s_WhiteToMove) {
+        UpdateCheckState<Color::White>();
+        CalculatePieceMoves<Color::White, GenType::All>(pos, piece.GetType(), moves);
     }
-	else if (piece.Is(PieceFlag::Rook)) {
-		CalculateRookMoves(pos, moves);
-	}
-	else if (piece.Is(PieceFlag::Bishop)) {
-		CalculateBishopMoves(pos, moves);
-	}
-	else if (piece.Is(PieceFlag::Knight)) {
-		CalculateKnightMoves(pos, moves);
-	}
-	else if (piece.Is(PieceFlag::Queen)) {
-		CalculateQueenMoves(pos, moves);
-	}
-	else if (piece.Is(PieceFlag::King)) {
-		//CalculateKingMoves(pos, moves);
-	}
-}
\ No newline at end of file
+    else {
+        UpdateCheckState<Color::Black>();
+        CalculatePieceMoves<Color::Black, GenType::All>(pos, piece.GetType(), moves);
+    }
+
+    Metrics::Increment(Counter::MovegenCalls);
+    Metrics::Increment(Counter::MovesGenerated, moves.size());
+}
+
+template auto Board::GenerateMoves<GenType::Captures>(std::vector<Move>& moves) -> void;
+template auto Board::GenerateMoves<GenType::Quiets>(std::vector<Move>& moves) -> void;
+template auto Board::GenerateMoves<GenType::Evasions>(std::vector<Move>& moves) -> void;
+template auto Board::GenerateMoves<GenType::All>(std::vector<Move>& moves) -> void;
+
+// The public building blocks of the generators, instantiated so that tools outside this file can call them
+
+template auto Board::CalculatePawnAttacks<Color::White>(Position, bool, std::vector<Position>&) -> void;
+template auto Board::CalculatePawnAttacks<Color::Black>(Position, bool, std::vector<Position>&) -> void;
+template auto Board::CalculateRookAttacks<Color::White>(Position, bool, std::vector<Position>&) -> void;
+template auto Board::CalculateRookAttacks<Color::Black>(Position, bool, std::vector<Position>&) -> void;
+template auto Board::CalculateBishopAttacks<Color::White>(Position, bool, std::vector<Position>&) -> void;
+template auto Board::CalculateBishopAttacks<Color::Black>(Position, bool, std::vector<Position>&) -> void;
+template auto Board::CalculateKnightAttacks<Color::White>(Position, bool, std::vector<Position>&) -> void;
+template auto Board::CalculateKnightAttacks<Color::Black>(Position, bool, std::vector<Position>&) -> void;
+template auto Board::CalculateQueenAttacks<Color::White>(Position, bool, std::vector<Position>&) -> void;
+template auto Board::CalculateQueenAttacks<Color::Black>(Position, bool, std::vector<Position>&) -> void;
+template auto Board::CalculateKingAttacks<Color::White>(Position, bool, std::vector<Position>&) -> void;
+template auto Board::CalculateKingAttacks<Color::Black>(Position, bool, std::vector<Position>&) -> void;
+
+template auto Board::CalculatePawnMoves<Color::White, GenType::All>(Position, std::vector<Move>&) -> void;
+template auto Board::CalculatePawnMoves<Color::Black, GenType::All>(Position, std::vector<Move>&) -> void;
+template auto Board::CalculateRookMoves<Color::White, GenType::All>(Position, std::vector<Move>&) -> void;
+template auto Board::CalculateRookMoves<Color::Black, GenType::All>(Position, std::vector<Move>&) -> void;
+template auto Board::CalculateBishopMoves<Color::White, GenType::All>(Position, std::vector<Move>&) -> void;
+template auto Board::CalculateBishopMoves<Color::Black, GenType::All>(Position, std::vector<Move>&) -> void;
+template auto Board::CalculateKnightMoves<Color::White, GenType::All>(Position, std::vector<Move>&) -> void;
+template auto Board::CalculateKnightMoves<Color::Black, GenType::All>(Position, std::vector<Move>&) -> void;
+template auto Board::CalculateQueenMoves<Color::White, GenType::All>(Position, std::vector<Move>&) -> void;
+template auto Board::CalculateQueenMoves<Color::Black, GenType::All>(Position, std::vector<Move>&) -> void;
+template auto Board::CalculateKingMoves<Color::White, GenType::All>(Position, std::vector<Move>&) -> void;
+template auto Board::CalculateKingMoves<Color::Black, GenType::All>(Position, std::vector<Move>&) -> void;
+
+template auto Board::UpdateCheckState<Color::White>() -> void;
+template auto Board::UpdateCheckState<Color::Black>() -> void;
+template auto Board::CheckForPins<Color::White>(const Position&, Bitboard&) -> bool;
+template auto Board::CheckForPins<Color::Black>(const Position&, Bitboard&) -> bool;
+template auto Board::IsSquareAttacked<Color::White>(Position, Position) -> bool;
+template auto Board::IsSquareAttacked<Color::Black>(Position, Position) -> bool;
\ No newline at end of file
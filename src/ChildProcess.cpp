@@ -0,0 +1,207 @@
+#include <pch.hpp>
+#include <ChildProcess.hpp>
+
+#include <cerrno>
+#include <utility>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+ChildProcess::ChildProcess(const std::vector<std::string>& args) {
+    if (args.empty()) {
+        throw std::invalid_argument("ChildProcess needs an executable");
+    }
+
+    // A dead child must surface as a failed write, not terminate the parent
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::array<int, 2> input {};
+    std::array<int, 2> output {};
+
+    if (pipe2(input.data(), O_CLOEXEC) != 0) {
+        throw std::runtime_error("Failed to create a pipe");
+    }
+
+    if (pipe2(output.data(), O_CLOEXEC) != 0) {
+        close(input[0]);
+        close(input[1]);
+        throw std::runtime_error("Failed to create a pipe");
+    }
+
+    std::vector<char*> argv;
+    argv.reserve(args.size() + 1);
+    for (const auto& arg : args) {
+        argv.emplace_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.emplace_back(nullptr);
+
+    m_Pid = fork();
+
+    if (m_Pid == 0) {
+        dup2(input[0], STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    close(input[0]);
+    close(output[1]);
+    m_Input = input[1];
+    m_Output = output[0];
+
+    if (m_Pid < 0) {
+        CloseDescriptors();
+        throw std::runtime_error("Failed to start " + args.front());
+    }
+}
+
+ChildProcess::ChildProcess(ChildProcess&& other) noexcept :
+    m_Pid(std::exchange(other.m_Pid, -1)),
+    m_Input(std::exchange(other.m_Input, -1)),
+    m_Output(std::exchange(other.m_Output, -1)),
+    m_Buffer(std::move(other.m_Buffer))
+{}
+
+auto ChildProcess::operator=(ChildProcess&& other) noexcept -> ChildProcess& {
+    if (this != &other) {
+        Kill();
+        m_Pid = std::exchange(other.m_Pid, -1);
+        m_Input = std::exchange(other.m_Input, -1);
+        m_Output = std::exchange(other.m_Output, -1);
+        m_Buffer = std::move(other.m_Buffer);
+    }
+    return *this;
+}
+
+ChildProcess::~ChildProcess() {
+    Kill();
+}
+
+auto ChildProcess::WriteLine(const std::string_view line) -> bool {
+    if (m_Input < 0) {
+        return false;
+    }
+
+    std::string data { line };
+    data += '\n';
+
+    for (size_t written = 0; written < data.size();) {
+        const auto result = write(m_Input, data.data() + written, data.size() - written);
+
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (result <= 0) {
+            return false;
+        }
+
+        written += static_cast<size_t>(result);
+    }
+
+    return true;
+}
+
+auto ChildProcess::ReadLine(std::string& line, const int timeoutMs) -> bool {
+    while (!TryReadLine(line)) {
+        pollfd fd { m_Output, POLLIN, 0 };
+        const auto ready = poll(&fd, 1, timeoutMs);
+
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (ready <= 0 || !Receive()) {
+            return TryReadLine(line);
+        }
+    }
+
+    return true;
+}
+
+auto ChildProcess::TryReadLine(std::string& line) -> bool {
+    const auto end = m_Buffer.find('\n');
+
+    if (end == std::string::npos) {
+        return false;
+    }
+
+    line.assign(m_Buffer, 0, end);
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+
+    m_Buffer.erase(0, end + 1);
+    return true;
+}
+
+auto ChildProcess::Receive() -> bool {
+    if (m_Output < 0) {
+        return false;
+    }
+
+    std::array<char, 4096> chunk {};
+    ssize_t result;
+
+    do {
+        result = read(m_Output, chunk.data(), chunk.size());
+    } while (result < 0 && errno == EINTR);
+
+    if (result <= 0) {
+        return false;
+    }
+
+    m_Buffer.append(chunk.data(), static_cast<size_t>(result));
+    return true;
+}
+
+auto ChildProcess::OutputDescriptor() const noexcept -> int {
+    return m_Output;
+}
+
+auto ChildProcess::IsRunning() const noexcept -> bool {
+    return m_Pid > 0;
+}
+
+auto ChildProcess::Kill() -> void {
+    if (m_Pid > 0) {
+        kill(m_Pid, SIGKILL);
+        waitpid(m_Pid, nullptr, 0);
+        m_Pid = -1;
+    }
+
+    CloseDescriptors();
+}
+
+auto ChildProcess::Wait() -> int {
+    if (m_Input >= 0) {
+        close(m_Input);
+        m_Input = -1;
+    }
+
+    int status = 0;
+
+    if (m_Pid > 0) {
+        while (waitpid(m_Pid, &status, 0) < 0 && errno == EINTR) {}
+        m_Pid = -1;
+    }
+
+    CloseDescriptors();
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+auto ChildProcess::CloseDescriptors() noexcept -> void {
+    if (m_Input >= 0) {
+        close(m_Input);
+        m_Input = -1;
+    }
+
+    if (m_Output >= 0) {
+        close(m_Output);
+        m_Output = -1;
+    }
+
+    m_Buffer.clear();
+}
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include <pch.hpp>
+#include <D3D11RenderBackend.hpp>
+#include <PieceAtlas.hpp>
+
+namespace {
+    auto CompileShader(const wchar_t* filename, const char* entryPoint, const char* target) -> ComPtr<ID3DBlob> {
+        ComPtr<ID3DBlob> blob;
+        DirectX::ThrowIfFailed(D3DCompileFromFile(filename, nullptr, nullptr, entryPoint, target, 0, 0, &blob, nullptr));
+        return blob;
+    }
+}
+
+D3D11RenderBackend::D3D11RenderBackend(ComPtr<ID3D11Device5> device, ComPtr<ID3D11DeviceContext4> context) :
+    m_Device(std::move(device)),
+    m_DeviceContext(std::move(context))
+{
+    CreateBuffers();
+    CompileShaders();
+    InitDrawingState();
+    LoadPieceAtlas();
+    BindPipeline();
+}
+
+auto D3D11RenderBackend::BeginFrame(const FrameConstants& constants) -> void {
+    // The view and projection are the only constants, uploaded once per frame
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    DirectX::ThrowIfFailed(m_DeviceContext->Map(m_ConstantBuffer.Get(), 0,
+        D3D11_MAP_WRITE_DISCARD, 0, &mappedResource));
+    std::memcpy(mappedResource.pData, &constants, sizeof(FrameConstants));
+    m_DeviceContext->Unmap(m_ConstantBuffer.Get(), 0);
+}
+
+auto D3D11RenderBackend::DrawBoard() -> void {
+    m_DeviceContext->OMSetDepthStencilState(m_DepthStencilStateBoard.Get(), 1);
+    m_DeviceContext->VSSetShader(m_BoardShaderVertex.Get(), nullptr, 0);
+    m_DeviceContext->PSSetShader(m_BoardShaderPixel.Get(), nullptr, 0);
+    m_DeviceContext->DrawIndexed(6, 0, 0);
+}
+
+auto D3D11RenderBackend::DrawHighlights(const std::span<const QuadInstance> instances) -> void {
+    if (instances.empty()) {
+        return;
+    }
+
+    UploadInstances(instances);
+    m_DeviceContext->OMSetDepthStencilState(m_DepthStencilStatePiece.Get(), 1);
+    m_DeviceContext->VSSetShader(m_HighlightShaderVertex.Get(), nullptr, 0);
+    m_DeviceContext->PSSetShader(m_HighlightShaderPixel.Get(), nullptr, 0);
+    m_DeviceContext->DrawIndexedInstanced(6, static_cast<UINT>(instances.size()), 0, 0, 0);
+}
+
+auto D3D11RenderBackend::DrawPieces(const std::span<const QuadInstance> instances) -> void {
+    if (instances.empty()) {
+        return;
+    }
+
+    UploadInstances(instances);
+    m_DeviceContext->OMSetDepthStencilState(m_DepthStencilStatePiece.Get(), 1);
+    m_DeviceContext->VSSetShader(m_PieceShaderVertex.Get(), nullptr, 0);
+    m_DeviceContext->PSSetShader(m_PieceShaderPixel.Get(), nullptr, 0);
+    m_DeviceContext->DrawIndexedInstanced(6, static_cast<UINT>(instances.size()), 0, 0, 0);
+}
+
+auto D3D11RenderBackend::EndFrame() -> void {}
+
+auto D3D11RenderBackend::CreateBuffers() -> void {
+    // Create vertex buffer
+    constexpr D3D11_BUFFER_DESC vertexBufferDesc {
+        sizeof(quad), D3D11_USAGE_DEFAULT, D3D11_BIND_VERTEX_BUFFER,
+        0, 0, 0
+    };
+
+    constexpr D3D11_SUBRESOURCE_DATA vertexData { quad.data(), 0, 0 };
+    DirectX::ThrowIfFailed(m_Device->CreateBuffer(&vertexBufferDesc, &vertexData, &m_VertexBuffer));
+
+    // Create instance buffer, rewritten by every instanced draw
+    constexpr D3D11_BUFFER_DESC instanceBufferDesc {
+        sizeof(QuadInstance) * MaxInstances, D3D11_USAGE_DYNAMIC, D3D11_BIND_VERTEX_BUFFER,
+        D3D11_CPU_ACCESS_WRITE, 0, 0
+    };
+
+    DirectX::ThrowIfFailed(m_Device->CreateBuffer(&instanceBufferDesc, nullptr, &m_InstanceBuffer));
+
+    // Create index buffer
+    constexpr D3D11_BUFFER_DESC indexBufferDesc {
+        sizeof(indices), D3D11_USAGE_DEFAULT, D3D11_BIND_INDEX_BUFFER,
+        0, 0, 0
+    };
+    constexpr D3D11_SUBRESOURCE_DATA indexData { indices.data(), 0, 0 };
+    DirectX::ThrowIfFailed(m_Device->CreateBuffer(&indexBufferDesc, &indexData, &m_IndexBuffer));
+
+    // Create constant buffer
+    constexpr D3D11_BUFFER_DESC constantBufferDesc = {
+        sizeof(FrameConstants), D3D11_USAGE_DYNAMIC, D3D11_BIND_CONSTANT_BUFFER,
+        D3D11_CPU_ACCESS_WRITE, 0, 0
+    };
+    DirectX::ThrowIfFailed(m_Device->CreateBuffer(&constantBufferDesc, nullptr, &m_ConstantBuffer));
+}
+
+auto D3D11RenderBackend::CompileShaders() -> void {
+    const auto createShaders = [this](const wchar_t* filename, ComPtr<ID3D11VertexShader>& vertex, ComPtr<ID3D11PixelShader>& pixel) {
+        const auto vertexShaderBlob = CompileShader(filename, "vert", "vs_5_0");
+        const auto pixelShaderBlob = CompileShader(filename, "frag", "ps_5_0");
+        DirectX::ThrowIfFailed(m_Device->CreateVertexShader(vertexShaderBlob->GetBufferPointer(),
+            vertexShaderBlob->GetBufferSize(), nullptr, &vertex));
+        DirectX::ThrowIfFailed(m_Device->CreatePixelShader(pixelShaderBlob->GetBufferPointer(),
+            pixelShaderBlob->GetBufferSize(), nullptr, &pixel));
+        return vertexShaderBlob;
+    };
+
+    createShaders(L"board.hlsl", m_BoardShaderVertex, m_BoardShaderPixel);
+    createShaders(L"highlight.hlsl", m_HighlightShaderVertex, m_HighlightShaderPixel);
+    const auto pieceShaderBlob = createShaders(L"piece.hlsl", m_PieceShaderVertex, m_PieceShaderPixel);
+
+    // The piece shader reads every element, the other shaders a subset of them
+    constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 4> polygonLayout {
+        {
+            {
+                "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0,
+                0, D3D11_INPUT_PER_VERTEX_DATA, 0
+            }, {
+                "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0,
+                D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0
+            }, {
+                "INSTANCEPOSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1,
+                offsetof(QuadInstance, X), D3D11_INPUT_PER_INSTANCE_DATA, 1
+            }, {
+                "TEXTUREINDEX", 0, DXGI_FORMAT_R32_UINT, 1,
+                offsetof(QuadInstance, Texture), D3D11_INPUT_PER_INSTANCE_DATA, 1
+            }
+        }
+    };
+
+    DirectX::ThrowIfFailed(m_Device->CreateInputLayout(polygonLayout.data(), static_cast<UINT>(polygonLayout.size()),
+        pieceShaderBlob->GetBufferPointer(), pieceShaderBlob->GetBufferSize(), &m_InputLayout));
+}
+
+auto D3D11RenderBackend::InitDrawingState() -> void {
+    // Create depth stencil states
+    D3D11_DEPTH_STENCIL_DESC depthStencilDesc {
+        TRUE, D3D11_DEPTH_WRITE_MASK_ALL, D3D11_COMPARISON_LESS,
+        FALSE, D3D11_DEFAULT_STENCIL_READ_MASK, D3D11_DEFAULT_STENCIL_WRITE_MASK,
+        { D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_INCR,
+            D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS
+        }, { D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_INCR,
+            D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS
+        }
+    };
+    DirectX::ThrowIfFailed(m_Device->CreateDepthStencilState(&depthStencilDesc, &m_DepthStencilStateBoard));
+    depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+    DirectX::ThrowIfFailed(m_Device->CreateDepthStencilState(&depthStencilDesc, &m_DepthStencilStatePiece));
+
+    // Create rasterizer state
+    constexpr D3D11_RASTERIZER_DESC2 rasterDesc {
+        D3D11_FILL_SOLID, D3D11_CULL_BACK, TRUE, 0, 0.0F,
+        0.0F, TRUE, FALSE, FALSE, FALSE,
+        0, D3D11_CONSERVATIVE_RASTERIZATION_MODE_OFF
+    };
+    DirectX::ThrowIfFailed(m_Device->CreateRasterizerState2(&rasterDesc, &m_RasterizerState));
+
+    // Create blend state
+    constexpr D3D11_BLEND_DESC1 blendDesc {
+        FALSE, FALSE,
+        { {
+                TRUE, FALSE, D3D11_BLEND_SRC_ALPHA, D3D11_BLEND_INV_SRC_ALPHA,
+                D3D11_BLEND_OP_ADD, D3D11_BLEND_SRC_ALPHA, D3D11_BLEND_INV_SRC_ALPHA,
+                D3D11_BLEND_OP_ADD, D3D11_LOGIC_OP_NOOP, D3D11_COLOR_WRITE_ENABLE_ALL
+            }
+        }
+    };
+    DirectX::ThrowIfFailed(m_Device->CreateBlendState1(&blendDesc, &m_BlendState));
+
+    // Create linear sampler for piece atlas sampling, clamped so the edge sprites never wrap around
+    constexpr D3D11_SAMPLER_DESC samplerDesc {
+        D3D11_FILTER_MIN_MAG_MIP_LINEAR, D3D11_TEXTURE_ADDRESS_CLAMP, D3D11_TEXTURE_ADDRESS_CLAMP,
+        D3D11_TEXTURE_ADDRESS_CLAMP, 0, 1, D3D11_COMPARISON_ALWAYS,
+        1, 1, 1, 1, 0, 0
+    };
+
+    DirectX::ThrowIfFailed(m_Device->CreateSamplerState(&samplerDesc, &m_SamplerState));
+}
+
+auto D3D11RenderBackend::LoadPieceAtlas() -> void {
+    const PieceAtlas atlas(PieceAtlas::DefaultPath);
+    const auto levels = atlas.GetLevels();
+    const auto tiles = atlas.GetTiles();
+
+    if (tiles.size() != PieceTextureCount) {
+        throw std::runtime_error("The piece atlas has the wrong number of sprites");
+    }
+
+    // Every level points into the mapped file, so the whole mip chain is uploaded by a single call
+    std::vector<D3D11_SUBRESOURCE_DATA> levelData;
+    for (const auto& level : levels) {
+        levelData.push_back({ level.Pixels.data(), level.Width * PieceAtlas::BytesPerPixel, 0 });
+    }
+
+    const D3D11_TEXTURE2D_DESC textureDesc {
+        levels.front().Width, levels.front().Height, static_cast<UINT>(levels.size()), 1,
+        DXGI_FORMAT_R8G8B8A8_UNORM, { 1, 0 }, D3D11_USAGE_IMMUTABLE, D3D11_BIND_SHADER_RESOURCE, 0, 0
+    };
+
+    ComPtr<ID3D11Texture2D> texture;
+    DirectX::ThrowIfFailed(m_Device->CreateTexture2D(&textureDesc, levelData.data(), &texture));
+    DirectX::ThrowIfFailed(m_Device->CreateShaderResourceView(texture.Get(), nullptr, &m_PieceTextures));
+
+    // The piece shader looks up the rectangle of a sprite by its texture index
+    constexpr D3D11_BUFFER_DESC tileBufferDesc {
+        sizeof(PieceAtlas::TileRect) * PieceTextureCount, D3D11_USAGE_IMMUTABLE, D3D11_BIND_CONSTANT_BUFFER,
+        0, 0, 0
+    };
+
+    const D3D11_SUBRESOURCE_DATA tileData { tiles.data(), 0, 0 };
+    DirectX::ThrowIfFailed(m_Device->CreateBuffer(&tileBufferDesc, &tileData, &m_TileBuffer));
+}
+
+auto D3D11RenderBackend::UploadInstances(const std::span<const QuadInstance> instances) -> void {
+    if (instances.size() > MaxInstances) {
+        throw std::length_error("Too many instances in a batch");
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    DirectX::ThrowIfFailed(m_DeviceContext->Map(m_InstanceBuffer.Get(), 0,
+        D3D11_MAP_WRITE_DISCARD, 0, &mappedResource));
+    std::memcpy(mappedResource.pData, instances.data(), instances.size_bytes());
+    m_DeviceContext->Unmap(m_InstanceBuffer.Get(), 0);
+}
+
+auto D3D11RenderBackend::BindPipeline() -> void {
+    // Primitive topology triangles
+    m_DeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    m_DeviceContext->IASetInputLayout(m_InputLayout.Get());
+
+    const std::array buffers { m_VertexBuffer.Get(), m_InstanceBuffer.Get() };
+    constexpr std::array<UINT, 2> strides { sizeof(Vertex), sizeof(QuadInstance) };
+    constexpr std::array<UINT, 2> offsets { 0, 0 };
+    m_DeviceContext->IASetVertexBuffers(0, 2, buffers.data(), strides.data(), offsets.data());
+    m_DeviceContext->IASetIndexBuffer(m_IndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+
+    m_DeviceContext->RSSetState(m_RasterizerState.Get());
+    m_DeviceContext->OMSetBlendState(m_BlendState.Get(), nullptr, D3D11_DEFAULT_SAMPLE_MASK);
+    m_DeviceContext->VSSetConstantBuffers(0, 1, m_ConstantBuffer.GetAddressOf());
+    m_DeviceContext->VSSetConstantBuffers(1, 1, m_TileBuffer.GetAddressOf());
+
+    // The piece atlas never changes, a single bind serves every frame
+    m_DeviceContext->PSSetSamplers(0, 1, m_SamplerState.GetAddressOf());
+    m_DeviceContext->PSSetShaderResources(0, 1, m_PieceTextures.GetAddressOf());
+}
\ No newline at end of file
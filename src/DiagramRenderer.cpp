@@ -0,0 +1,176 @@
+#include <pch.hpp>
+#include <DiagramRenderer.hpp>
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CHESS_DIAGRAM_SSE2
+#endif
+
+namespace {
+    /// <summary>
+    /// Divides a product of two bytes by 255, rounded, without a division
+    /// </summary>
+    constexpr auto DivideBy255(const uint32_t value) -> uint32_t {
+        return (value + 128 + ((value + 128) >> 8)) >> 8;
+    }
+}
+
+DiagramRenderer::DiagramRenderer(const PieceAtlas& atlas, const uint32_t squareSize) : m_SquareSize(squareSize) {
+    if (squareSize == 0) {
+        throw std::invalid_argument("The square size must be positive");
+    }
+
+    const auto tiles = atlas.GetTiles();
+    const auto levels = atlas.GetLevels();
+
+    if (tiles.size() < RenderBackend::PieceTextureCount) {
+        throw std::invalid_argument("The piece atlas lacks sprites");
+    }
+
+    // The board is opaque, so only the sprites ever need blending
+    const auto size = GetImageSize();
+    m_Board.resize(GetImageBytes());
+
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            // Row 0 is rank 8, which starts with a light square as seen from either side
+            const bool light = (x / squareSize + y / squareSize) % 2 == 0;
+            const auto& color = light ? LightSquare : DarkSquare;
+            auto* pixel = &m_Board[(static_cast<size_t>(y) * size + x) * 4];
+            std::memcpy(pixel, color.data(), 3);
+            pixel[3] = 255;
+        }
+    }
+
+    // Sprites are sampled from the smallest level that is still at least as large as a square
+    size_t levelIndex = 0;
+    while (levelIndex + 1 < levels.size() && (atlas.GetTileSize() >> (levelIndex + 1)) >= squareSize) {
+        levelIndex++;
+    }
+
+    const auto& level = levels[levelIndex];
+    const auto tileSize = static_cast<double>(atlas.GetTileSize() >> levelIndex);
+
+    const auto texel = [&](const int x, const int y, const int channel) -> double {
+        const auto cx = std::clamp(x, 0, static_cast<int>(level.Width) - 1);
+        const auto cy = std::clamp(y, 0, static_cast<int>(level.Height) - 1);
+        const auto* pixel = &level.Pixels[(static_cast<size_t>(cy) * level.Width + cx) * PieceAtlas::BytesPerPixel];
+
+        // Filtering happens on premultiplied colors so transparent texels do not darken the edges
+        return channel == 3 ? pixel[3] : pixel[channel] * pixel[3] / 255.0;
+    };
+
+    for (uint32_t index = 0; index < RenderBackend::PieceTextureCount; index++) {
+        const auto left = std::round(static_cast<double>(tiles[index].U0) * level.Width);
+        const auto top = std::round(static_cast<double>(tiles[index].V0) * level.Height);
+        const auto scale = tileSize / squareSize;
+
+        auto& sprite = m_Sprites[index];
+        sprite.resize(static_cast<size_t>(squareSize) * squareSize * 4);
+
+        for (uint32_t y = 0; y < squareSize; y++) {
+            // Bilinear filtering, the level is less than twice the size of a square
+            const auto sy = std::clamp(top + (y + 0.5) * scale - 0.5, top, top + tileSize - 1.0);
+            const auto y0 = static_cast<int>(std::floor(sy));
+            const auto fy = sy - y0;
+
+            for (uint32_t x = 0; x < squareSize; x++) {
+                const auto sx = std::clamp(left + (x + 0.5) * scale - 0.5, left, left + tileSize - 1.0);
+                const auto x0 = static_cast<int>(std::floor(sx));
+                const auto fx = sx - x0;
+
+                for (int c = 0; c < 4; c++) {
+                    const auto value =
+                        (texel(x0, y0, c) * (1.0 - fx) + texel(x0 + 1, y0, c) * fx) * (1.0 - fy) +
+                        (texel(x0, y0 + 1, c) * (1.0 - fx) + texel(x0 + 1, y0 + 1, c) * fx) * fy;
+                    sprite[(static_cast<size_t>(y) * squareSize + x) * 4 + c] = static_cast<uint8_t>(std::lround(value));
+                }
+            }
+        }
+    }
+}
+
+auto DiagramRenderer::GetImageSize() const noexcept -> uint32_t {
+    return m_SquareSize * 8;
+}
+
+auto DiagramRenderer::GetImageBytes() const noexcept -> size_t {
+    return static_cast<size_t>(GetImageSize()) * GetImageSize() * 4;
+}
+
+auto DiagramRenderer::Render(const Fen::State& state, const std::span<uint8_t> image, const bool flipped) const -> void {
+    if (image.size() < GetImageBytes()) {
+        throw std::invalid_argument("The image buffer is too small for a diagram");
+    }
+
+    std::memcpy(image.data(), m_Board.data(), m_Board.size());
+
+    const auto stride = static_cast<size_t>(GetImageSize()) * 4;
+
+    for (int square = 0; square < 64; square++) {
+        const auto piece = state.Squares[square];
+        if (piece == PieceFlag::None) {
+            continue;
+        }
+
+        const auto file = square % 8;
+        const auto rank = square / 8;
+        const auto column = static_cast<size_t>(flipped ? 7 - file : file);
+        const auto row = static_cast<size_t>(flipped ? rank : 7 - rank);
+
+        const auto& sprite = m_Sprites[RenderBackend::PieceTextureIndex(piece)];
+        auto* destination = image.data() + row * m_SquareSize * stride + column * m_SquareSize * 4;
+
+        for (uint32_t y = 0; y < m_SquareSize; y++) {
+            BlendRow(destination + y * stride, sprite.data() + static_cast<size_t>(y) * m_SquareSize * 4, m_SquareSize);
+        }
+    }
+}
+
+auto DiagramRenderer::BlendRow(uint8_t* destination, const uint8_t* source, const size_t pixels) noexcept -> void {
+    // destination = source + destination * (255 - source alpha) / 255
+    size_t i = 0;
+
+#ifdef CHESS_DIAGRAM_SSE2
+    const auto zero = _mm_setzero_si128();
+    const auto full = _mm_set1_epi16(255);
+    const auto half = _mm_set1_epi16(128);
+
+    for (; i + 4 <= pixels; i += 4) {
+        const auto src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+
+        // Fully transparent runs are common around the pieces
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(src, zero)) == 0xFFFF) {
+            continue;
+        }
+
+        const auto dst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + i * 4));
+
+        const auto blend = [&](const __m128i s, const __m128i d) {
+            // Broadcasts the alpha of each pixel to its four channels
+            auto alpha = _mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3));
+            alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+
+            auto product = _mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(full, alpha)), half);
+            product = _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+            return _mm_add_epi16(s, product);
+        };
+
+        const auto low = blend(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero));
+        const auto high = blend(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), _mm_packus_epi16(low, high));
+    }
+#endif
+
+    for (; i < pixels; i++) {
+        const auto* src = source + i * 4;
+        auto* dst = destination + i * 4;
+        const auto inverse = 255U - src[3];
+
+        for (int c = 0; c < 4; c++) {
+            dst[c] = static_cast<uint8_t>(src[c] + DivideBy255(dst[c] * inverse));
+        }
+    }
+}
\ No newline at end of file
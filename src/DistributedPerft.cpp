@@ -0,0 +1,304 @@
+#include <pch.hpp>
+#include <DistributedPerft.hpp>
+#include <Board.hpp>
+#include <Piece.hpp>
+#include <Move.hpp>
+
+#include <cerrno>
+#include <iostream>
+#include <sstream>
+#include <poll.h>
+
+DistributedPerft::DistributedPerft(Options options) : m_Options(std::move(options)) {
+    if (m_Options.Depth < 1) {
+        throw std::invalid_argument("Perft depth must be at least 1");
+    }
+
+    // Every job needs at least one ply of its own
+    m_Options.SplitDepth = std::clamp(m_Options.SplitDepth, 0, m_Options.Depth - 1);
+    m_Options.Workers = std::max(m_Options.Workers, 1);
+    m_Options.MaxAttempts = std::max(m_Options.MaxAttempts, 1);
+}
+
+auto DistributedPerft::Run() -> uint64_t {
+    m_Jobs.clear();
+    m_Pending.clear();
+    m_Divide.clear();
+    m_Retries = 0;
+
+    Board::SetState(m_Options.Fen);
+    CreateJobs(m_Options.SplitDepth, "");
+    OpenCheckpoint();
+
+    for (size_t i = 0; i < m_Jobs.size(); i++) {
+        if (!m_Jobs[i].Nodes) {
+            m_Pending.emplace_back(i);
+        }
+    }
+
+    m_Remaining = m_Pending.size();
+
+    std::vector<Worker> workers(std::min<size_t>(m_Options.Workers, m_Pending.size()));
+
+    for (auto& worker : workers) {
+        StartWorker(worker);
+        AssignJob(worker);
+    }
+
+    std::vector<pollfd> descriptors;
+
+    while (m_Remaining > 0) {
+        descriptors.clear();
+        for (const auto& worker : workers) {
+            descriptors.push_back({ worker.Process.OutputDescriptor(), POLLIN, 0 });
+        }
+
+        // Wake up regularly to notice stuck workers
+        if (poll(descriptors.data(), descriptors.size(), 1000) < 0 && errno != EINTR) {
+            throw std::runtime_error("Failed to poll the workers");
+        }
+
+        for (size_t i = 0; i < workers.size(); i++) {
+            auto& worker = workers[i];
+
+            if (descriptors[i].revents != 0) {
+                if (worker.Process.Receive()) {
+                    for (std::string line; worker.Process.TryReadLine(line);) {
+                        HandleLine(worker, line);
+                    }
+                }
+                else {
+                    FailJob(worker, "worker exited");
+                }
+            }
+
+            if (worker.Job && m_Options.JobTimeoutSeconds > 0
+                && std::chrono::steady_clock::now() - worker.Started > std::chrono::seconds(m_Options.JobTimeoutSeconds)) {
+                FailJob(worker, "timed out");
+            }
+
+            if (!worker.Job) {
+                AssignJob(worker);
+            }
+        }
+    }
+
+    for (auto& worker : workers) {
+        worker.Process.WriteLine("quit");
+        worker.Process.Wait();
+    }
+
+    uint64_t nodes = 0;
+
+    for (const auto& job : m_Jobs) {
+        nodes += *job.Nodes;
+        m_Divide[job.Moves.substr(0, job.Moves.find(' '))] += *job.Nodes;
+    }
+
+    return nodes;
+}
+
+auto DistributedPerft::GetDivide() const -> const std::map<std::string, uint64_t>& {
+    return m_Divide;
+}
+
+auto DistributedPerft::GetRetries() const noexcept -> int {
+    return m_Retries;
+}
+
+auto DistributedPerft::RunWorker(std::istream& input, std::ostream& output) -> int {
+    std::string fen;
+
+    for (std::string line; std::getline(input, line);) {
+        std::istringstream stream(line);
+        std::string command;
+        stream >> command;
+
+        if (command == "quit") {
+            break;
+        }
+
+        if (command == "fen") {
+            std::getline(stream >> std::ws, fen);
+            continue;
+        }
+
+        if (command != "perft") {
+            output << "error unknown command " << command << std::endl;
+            continue;
+        }
+
+        // perft <id> <depth> [moves...]
+        size_t id = 0;
+        int depth = 0;
+        stream >> id >> depth;
+
+        Board::SetState(fen);
+
+        bool legal = true;
+
+        for (std::string notation; legal && stream >> notation;) {
+            if (const auto move = Board::FindMove(notation)) {
+                Board::MakeMove(*move);
+            }
+            else {
+                output << "error " << id << " illegal move " << notation << std::endl;
+                legal = false;
+            }
+        }
+
+        if (legal) {
+            output << "nodes " << id << ' ' << Board::Perft(depth) << std::endl;
+        }
+    }
+
+    return 0;
+}
+
+auto DistributedPerft::CreateJobs(const int depth, const std::string& moves) -> void {
+    if (depth == 0) {
+        m_Jobs.push_back({ moves, 0, std::nullopt });
+        return;
+    }
+
+    std::vector<Move> legalMoves;
+    Board::GenerateMoves<Board::GenType::All>(legalMoves);
+
+    for (const auto& move : legalMoves) {
+        Board::MakeMove(move);
+        CreateJobs(depth - 1, moves.empty() ? move.ToString() : moves + ' ' + move.ToString());
+        Board::UnmakeMove(move);
+    }
+}
+
+auto DistributedPerft::OpenCheckpoint() -> void {
+    if (m_Options.CheckpointPath.empty()) {
+        return;
+    }
+
+    // The header identifies the run, results of another run must never be mixed in
+    std::ostringstream header;
+    header << "root " << m_Options.Depth << ' ' << m_Options.SplitDepth << ' ' << m_Options.Fen;
+
+    if (std::ifstream file(m_Options.CheckpointPath); file) {
+        std::string line;
+
+        if (std::getline(file, line) && line != header.str()) {
+            throw std::runtime_error("Checkpoint " + m_Options.CheckpointPath + " belongs to a different run");
+        }
+
+        std::unordered_map<std::string, uint64_t> finished;
+
+        // done <nodes> [moves...]
+        while (std::getline(file, line)) {
+            std::istringstream stream(line);
+            std::string command;
+            uint64_t nodes = 0;
+
+            if (stream >> command >> nodes && command == "done") {
+                std::string moves;
+                std::getline(stream >> std::ws, moves);
+                finished[moves] = nodes;
+            }
+        }
+
+        for (auto& job : m_Jobs) {
+            if (const auto result = finished.find(job.Moves); result != finished.end()) {
+                job.Nodes = result->second;
+            }
+        }
+
+        m_Checkpoint.open(m_Options.CheckpointPath, std::ios::app);
+    }
+    else {
+        m_Checkpoint.open(m_Options.CheckpointPath);
+        m_Checkpoint << header.str() << std::endl;
+    }
+
+    if (!m_Checkpoint) {
+        throw std::runtime_error("Failed to open checkpoint " + m_Options.CheckpointPath);
+    }
+}
+
+auto DistributedPerft::StartWorker(Worker& worker) -> void {
+    worker.Process = ChildProcess({ m_Options.WorkerExecutable, "--worker" });
+    worker.Job.reset();
+
+    if (!worker.Process.WriteLine("fen " + m_Options.Fen)) {
+        throw std::runtime_error("Failed to start a worker from " + m_Options.WorkerExecutable);
+    }
+}
+
+auto DistributedPerft::AssignJob(Worker& worker) -> void {
+    if (m_Pending.empty()) {
+        return;
+    }
+
+    const auto index = m_Pending.front();
+    auto& job = m_Jobs[index];
+
+    if (++job.Attempts > m_Options.MaxAttempts) {
+        throw std::runtime_error("Giving up on job '" + job.Moves + "' after " + std::to_string(m_Options.MaxAttempts) + " attempts");
+    }
+
+    m_Pending.pop_front();
+    worker.Job = index;
+    worker.Started = std::chrono::steady_clock::now();
+
+    std::ostringstream command;
+    command << "perft " << index << ' ' << m_Options.Depth - m_Options.SplitDepth << ' ' << job.Moves;
+
+    if (!worker.Process.WriteLine(command.str())) {
+        FailJob(worker, "worker closed its input");
+    }
+}
+
+auto DistributedPerft::HandleLine(Worker& worker, const std::string_view line) -> void {
+    std::istringstream stream { std::string(line) };
+    std::string command;
+    size_t id = 0;
+    stream >> command >> id;
+
+    if (!worker.Job || id != *worker.Job) {
+        return;
+    }
+
+    if (command == "error") {
+        std::string reason;
+        std::getline(stream >> std::ws, reason);
+        FailJob(worker, reason);
+        return;
+    }
+
+    uint64_t nodes = 0;
+
+    if (command != "nodes" || !(stream >> nodes)) {
+        FailJob(worker, "malformed reply");
+        return;
+    }
+
+    auto& job = m_Jobs[id];
+    job.Nodes = nodes;
+    worker.Job.reset();
+    m_Remaining--;
+
+    if (m_Checkpoint.is_open()) {
+        m_Checkpoint << "done " << nodes << ' ' << job.Moves << std::endl;
+    }
+
+    std::cerr << "[" << m_Jobs.size() - m_Remaining << "/" << m_Jobs.size() << "] "
+        << (job.Moves.empty() ? "root" : job.Moves) << ": " << nodes << std::endl;
+}
+
+auto DistributedPerft::FailJob(Worker& worker, const std::string_view reason) -> void {
+    if (worker.Job) {
+        const auto& job = m_Jobs[*worker.Job];
+        std::cerr << "Job '" << job.Moves << "' failed (" << reason << "), retrying" << std::endl;
+        m_Pending.push_front(*worker.Job);
+        m_Retries++;
+    }
+
+    // The worker may be stuck or half dead, always replace it
+    worker.Process.Kill();
+    StartWorker(worker);
+}
\ No newline at end of file
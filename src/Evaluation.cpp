@@ -0,0 +1,313 @@
+#include <pch.hpp>
+#include <Evaluation.hpp>
+#include <Board.hpp>
+#include <Metrics.hpp>
+#include <Move.hpp>
+#include <Piece.hpp>
+
+#include <bit>
+
+namespace {
+    using Table = std::array<int, 64>;
+
+    // The tables are laid out as seen from white, rank 8 first
+
+    constexpr Table PawnTable {
+         0,   0,   0,   0,   0,   0,   0,   0,
+        50,  50,  50,  50,  50,  50,  50,  50,
+        10,  10,  20,  30,  30,  20,  10,  10,
+         5,   5,  10,  25,  25,  10,   5,   5,
+         0,   0,   0,  20,  20,   0,   0,   0,
+         5,  -5, -10,   0,   0, -10,  -5,   5,
+         5,  10,  10, -20, -20,  10,  10,   5,
+         0,   0,   0,   0,   0,   0,   0,   0
+    };
+
+    constexpr Table KnightTable {
+        -50, -40, -30, -30, -30, -30, -40, -50,
+        -40, -20,   0,   0,   0,   0, -20, -40,
+        -30,   0,  10,  15,  15,  10,   0, -30,
+        -30,   5,  15,  20,  20,  15,   5, -30,
+        -30,   0,  15,  20,  20,  15,   0, -30,
+        -30,   5,  10,  15,  15,  10,   5, -30,
+        -40, -20,   0,   5,   5,   0, -20, -40,
+        -50, -40, -30, -30, -30, -30, -40, -50
+    };
+
+    constexpr Table BishopTable {
+        -20, -10, -10, -10, -10, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,  10,  10,   5,   0, -10,
+        -10,   5,   5,  10,  10,   5,   5, -10,
+        -10,   0,  10,  10,  10,  10,   0, -10,
+        -10,  10,  10,  10,  10,  10,  10, -10,
+        -10,   5,   0,   0,   0,   0,   5, -10,
+        -20, -10, -10, -10, -10, -10, -10, -20
+    };
+
+    constexpr Table RookTable {
+         0,   0,   0,   0,   0,   0,   0,   0,
+         5,  10,  10,  10,  10,  10,  10,   5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+         0,   0,   0,   5,   5,   0,   0,   0
+    };
+
+    constexpr Table QueenTable {
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,   5,   5,   5,   0, -10,
+         -5,   0,   5,   5,   5,   5,   0,  -5,
+          0,   0,   5,   5,   5,   5,   0,  -5,
+        -10,   5,   5,   5,   5,   5,   0, -10,
+        -10,   0,   5,   0,   0,   0,   0, -10,
+        -20, -10, -10,  -5,  -5, -10, -10, -20
+    };
+
+    constexpr Table KingMiddlegameTable {
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -30, -40, -40, -50, -50, -40, -40, -30,
+        -20, -30, -30, -40, -40, -30, -30, -20,
+        -10, -20, -20, -20, -20, -20, -20, -10,
+         20,  20,   0,   0,   0,   0,  20,  20,
+         20,  30,  10,   0,   0,  10,  30,  20
+    };
+
+    constexpr Table KingEndgameTable {
+        -50, -40, -30, -20, -20, -30, -40, -50,
+        -30, -20, -10,   0,   0, -10, -20, -30,
+        -30, -10,  20,  30,  30,  20, -10, -30,
+        -30, -10,  30,  40,  40,  30, -10, -30,
+        -30, -10,  30,  40,  40,  30, -10, -30,
+        -30, -10,  20,  30,  30,  20, -10, -30,
+        -30, -30,   0,   0,   0,   0, -30, -30,
+        -50, -30, -30, -30, -30, -30, -30, -50
+    };
+
+    // Indexed by the bit index of the type flag: pawn, rook, knight, bishop, king, queen
+    constexpr std::array<int, 6> Values { 100, 500, 320, 330, 0, 900 };
+    constexpr std::array<int, 6> Phases { 0, 2, 1, 1, 0, 4 };
+    constexpr std::array<const Table*, 6> Tables { &PawnTable, &RookTable, &KnightTable, &BishopTable, nullptr, &QueenTable };
+
+    constexpr int TotalPhase = 24;
+    constexpr int KingType = 4;
+
+    // The type index of each piece kind of a batch: pawn, knight, bishop, rook, queen, king
+    constexpr std::array<int, 6> KindTypes { 0, 2, 3, 1, 5, 4 };
+
+    constexpr auto TypeIndex(const PieceFlag piece) -> int {
+        return std::countr_zero(static_cast<uint8_t>(piece & ~(PieceFlag::White | PieceFlag::Black)));
+    }
+
+    constexpr int RookRays = 0;
+    constexpr int BishopRays = 4;
+
+    /// <summary>
+    /// Finds the least valuable piece of a side that attacks a square through the occupied squares.
+    /// Removing a piece from the occupancy uncovers the sliders behind it
+    /// </summary>
+    /// <returns><c>int</c> The square of the attacker, -1 if there is none</returns>
+    auto LeastValuableAttacker(const std::array<Piece, 64>& board, const int square, const Bitboard occupied, const bool white) -> int {
+        const auto color = white ? PieceFlag::White : PieceFlag::Black;
+
+        const auto find = [&](Bitboard candidates, const PieceFlag type) -> int {
+            for (candidates &= occupied; candidates;) {
+                const int from = std::countr_zero(candidates);
+                candidates &= candidates - 1;
+
+                if (board[from].Is(type | color)) {
+                    return from;
+                }
+            }
+
+            return -1;
+        };
+
+        // A pawn attacks the square from where a pawn of the other color on the square would capture to
+        if (const int from = find(PawnAttacks[white ? 1 : 0][square], PieceFlag::Pawn); from >= 0) {
+            return from;
+        }
+
+        if (const int from = find(KnightAttacks[square], PieceFlag::Knight); from >= 0) {
+            return from;
+        }
+
+        // The nearest blockers on each ray, bishops and rooks first and queens after them
+        std::array<int, 8> blockers {};
+
+        for (int direction = 0; direction < static_cast<int>(RayDirections.size()); direction++) {
+            const auto ray = Rays[direction][square] & occupied;
+            blockers[direction] = ray ? NearestSquare(direction, ray) : -1;
+        }
+
+        const auto findSlider = [&](const int firstDirection, const PieceFlag type) -> int {
+            for (int direction = firstDirection; direction < firstDirection + 4; direction++) {
+                if (blockers[direction] >= 0 && board[blockers[direction]].Is(type | color)) {
+                    return blockers[direction];
+                }
+            }
+
+            return -1;
+        };
+
+        if (const int from = findSlider(BishopRays, PieceFlag::Bishop); from >= 0) {
+            return from;
+        }
+
+        if (const int from = findSlider(RookRays, PieceFlag::Rook); from >= 0) {
+            return from;
+        }
+
+        if (const int from = findSlider(BishopRays, PieceFlag::Queen); from >= 0) {
+            return from;
+        }
+
+        if (const int from = findSlider(RookRays, PieceFlag::Queen); from >= 0) {
+            return from;
+        }
+
+        return find(KingAttacks[square], PieceFlag::King);
+    }
+}
+
+auto Evaluation::Evaluate() -> int {
+    Metrics::Increment(Counter::EvalCalls);
+
+    std::array<int, 2> middlegame {};
+    std::array<int, 2> endgame {};
+    int phase = 0;
+
+    const auto& board = Board::GetBoard();
+
+    for (int index = 0; index < 64; index++) {
+        const auto piece = board[index];
+
+        if (piece.IsEmpty()) {
+            continue;
+        }
+
+        const bool white = piece.Is(PieceFlag::White);
+        const int side = white ? 0 : 1;
+        const int type = TypeIndex(piece.GetType());
+
+        // Black reads the tables mirrored vertically
+        const int square = white ? index ^ 56 : index;
+
+        if (type == KingType) {
+            middlegame[side] += KingMiddlegameTable[square];
+            endgame[side] += KingEndgameTable[square];
+            continue;
+        }
+
+        const int score = Values[type] + (*Tables[type])[square];
+        middlegame[side] += score;
+        endgame[side] += score;
+        phase += Phases[type];
+    }
+
+    phase = std::min(phase, TotalPhase);
+
+    const int score = ((middlegame[0] - middlegame[1]) * phase + (endgame[0] - endgame[1]) * (TotalPhase - phase)) / TotalPhase;
+    return Board::IsWhiteToMove() ? score : -score;
+}
+
+auto Evaluation::Evaluate(const std::span<const Bitboard, 12> pieces, const bool whiteToMove) -> int {
+    std::array<int, 2> middlegame {};
+    std::array<int, 2> endgame {};
+    int phase = 0;
+
+    for (size_t kind = 0; kind < pieces.size(); kind++) {
+        const int side = kind < 6 ? 0 : 1;
+        const int type = KindTypes[kind % 6];
+
+        for (auto squares = pieces[kind]; squares; squares &= squares - 1) {
+            const int index = std::countr_zero(squares);
+            const int square = side == 0 ? index ^ 56 : index;
+
+            if (type == KingType) {
+                middlegame[side] += KingMiddlegameTable[square];
+                endgame[side] += KingEndgameTable[square];
+                continue;
+            }
+
+            const int score = Values[type] + (*Tables[type])[square];
+            middlegame[side] += score;
+            endgame[side] += score;
+            phase += Phases[type];
+        }
+    }
+
+    phase = std::min(phase, TotalPhase);
+
+    const int score = ((middlegame[0] - middlegame[1]) * phase + (endgame[0] - endgame[1]) * (TotalPhase - phase)) / TotalPhase;
+    return whiteToMove ? score : -score;
+}
+
+auto Evaluation::PieceValue(const PieceFlag piece) -> int {
+    return Values[TypeIndex(piece)];
+}
+
+auto Evaluation::PieceSquare(const PieceFlag piece, const int square) -> int {
+    const int type = TypeIndex(piece);
+    const int mirrored = (piece & PieceFlag::White) == PieceFlag::White ? square ^ 56 : square;
+
+    return type == KingType ? KingMiddlegameTable[mirrored] : (*Tables[type])[mirrored];
+}
+
+auto Evaluation::StaticExchange(const Move& move) -> int {
+    const auto& board = Board::GetBoard();
+    const int from = SquareIndex(move.From);
+    const int to = SquareIndex(move.To);
+
+    auto occupied = (Board::GetOccupancy(true) | Board::GetOccupancy(false)) & ~SquareBit(move.From);
+    bool white = !board[from].Is(PieceFlag::White);
+
+    // The gains of each capture in the sequence, seen from the side making it
+    std::array<int, 32> gains {};
+
+    // The piece standing on the target square once the move is played
+    auto onSquare = board[from].GetType();
+
+    if (move.Type == Move::MoveType::EnPassant) {
+        gains[0] = Values[0];
+        occupied &= ~SquareBit({ move.To.x, move.From.y });
+    }
+    else if (!board[to].IsEmpty()) {
+        gains[0] = PieceValue(board[to].GetType());
+    }
+
+    if (move.Type == Move::MoveType::Promotion || move.Type == Move::MoveType::PromotionCapture) {
+        gains[0] += PieceValue(move.Promotion) - Values[0];
+        onSquare = move.Promotion;
+    }
+
+    size_t depth = 0;
+
+    for (int attacker; depth + 1 < gains.size() && (attacker = LeastValuableAttacker(board, to, occupied, white)) >= 0;) {
+        const auto type = board[attacker].GetType();
+
+        // The king may only recapture when the other side has nothing left to take it with
+        if (TypeIndex(type) == KingType && LeastValuableAttacker(board, to, occupied & ~(Bitboard { 1 } << attacker), !white) >= 0) {
+            break;
+        }
+
+        depth++;
+        gains[depth] = PieceValue(onSquare) - gains[depth - 1];
+
+        onSquare = type;
+        occupied &= ~(Bitboard { 1 } << attacker);
+        white = !white;
+    }
+
+    // Either side may stand pat instead of capturing, going back from the last capture
+    for (; depth > 0; depth--) {
+        gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+    }
+
+    return gains[0];
+}
\ No newline at end of file
@@ -0,0 +1,503 @@
+#include <pch.hpp>
+#include <Bitboard.hpp>
+#include <Fen.hpp>
+#include <Piece.hpp>
+
+#include <charconv>
+
+using Error = Fen::Error;
+using Result = Fen::Result;
+using State = Fen::State;
+
+namespace {
+    /// <summary>
+    /// The largest clock value accepted, keeps the written record within <c>MaxLength</c>
+    /// </summary>
+    constexpr int MaxClock = 99999;
+
+    constexpr auto PieceFromChar(const char c) -> PieceFlag {
+        switch (c) {
+            case 'P': return PieceFlag::Pawn | PieceFlag::White;
+            case 'R': return PieceFlag::Rook | PieceFlag::White;
+            case 'N': return PieceFlag::Knight | PieceFlag::White;
+            case 'B': return PieceFlag::Bishop | PieceFlag::White;
+            case 'Q': return PieceFlag::Queen | PieceFlag::White;
+            case 'K': return PieceFlag::King | PieceFlag::White;
+            case 'p': return PieceFlag::Pawn | PieceFlag::Black;
+            case 'r': return PieceFlag::Rook | PieceFlag::Black;
+            case 'n': return PieceFlag::Knight | PieceFlag::Black;
+            case 'b': return PieceFlag::Bishop | PieceFlag::Black;
+            case 'q': return PieceFlag::Queen | PieceFlag::Black;
+            case 'k': return PieceFlag::King | PieceFlag::Black;
+            default: return PieceFlag::None;
+        }
+    }
+
+    constexpr auto CharFromPiece(const PieceFlag piece) -> char {
+        const bool white = (piece & PieceFlag::White) == PieceFlag::White;
+        char c = '?';
+
+        switch (piece & ~(PieceFlag::White | PieceFlag::Black)) {
+            case PieceFlag::Pawn: c = 'p'; break;
+            case PieceFlag::Rook: c = 'r'; break;
+            case PieceFlag::Knight: c = 'n'; break;
+            case PieceFlag::Bishop: c = 'b'; break;
+            case PieceFlag::Queen: c = 'q'; break;
+            case PieceFlag::King: c = 'k'; break;
+            default: break;
+        }
+
+        return white ? static_cast<char>(c - 'a' + 'A') : c;
+    }
+
+    constexpr auto IsSpace(const char c) -> bool {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    /// <summary>
+    /// Walks the fields of a record, tracking the offset for error reports
+    /// </summary>
+    class Reader final {
+    public:
+        explicit Reader(const std::string_view text) noexcept : m_Text(text) {
+            SkipSpace();
+        }
+
+        auto SkipSpace() noexcept -> void {
+            while (m_Offset < m_Text.size() && IsSpace(m_Text[m_Offset])) {
+                m_Offset++;
+            }
+        }
+
+        /// <summary>
+        /// Gets the next field separated by whitespace, empty at the end of the text
+        /// </summary>
+        auto NextField() noexcept -> std::string_view {
+            SkipSpace();
+            const size_t start = m_Offset;
+
+            while (m_Offset < m_Text.size() && !IsSpace(m_Text[m_Offset])) {
+                m_Offset++;
+            }
+
+            m_FieldStart = start;
+            return m_Text.substr(start, m_Offset - start);
+        }
+
+        auto Rest() noexcept -> std::string_view {
+            SkipSpace();
+            auto rest = m_Text.substr(m_Offset);
+
+            while (!rest.empty() && IsSpace(rest.back())) {
+                rest.remove_suffix(1);
+            }
+
+            return rest;
+        }
+
+        [[nodiscard]] auto Fail(const Error error, const size_t index = 0) const noexcept -> Result {
+            return { error, m_FieldStart + index };
+        }
+
+        [[nodiscard]] auto AtEnd() noexcept -> bool {
+            SkipSpace();
+            return m_Offset == m_Text.size();
+        }
+
+    private:
+        std::string_view m_Text;
+        size_t m_Offset = 0;
+        size_t m_FieldStart = 0;
+    };
+
+    auto ParsePlacement(Reader& reader, State& state) noexcept -> Result {
+        const auto field = reader.NextField();
+
+        if (field.empty()) {
+            return reader.Fail(Error::MissingField);
+        }
+
+        int rank = 7;
+        int file = 0;
+        int whiteKings = 0;
+        int blackKings = 0;
+
+        for (size_t i = 0; i < field.size(); i++) {
+            const char c = field[i];
+
+            if (c == '/') {
+                if (file < 8) {
+                    return reader.Fail(Error::RankTooShort, i);
+                }
+                if (rank == 0) {
+                    return reader.Fail(Error::WrongRankCount, i);
+                }
+
+                rank--;
+                file = 0;
+            }
+            else if (c >= '1' && c <= '8') {
+                file += c - '0';
+
+                if (file > 8) {
+                    return reader.Fail(Error::RankTooLong, i);
+                }
+            }
+            else {
+                const auto piece = PieceFromChar(c);
+
+                if (piece == PieceFlag::None) {
+                    return reader.Fail(Error::InvalidPiece, i);
+                }
+                if (file == 8) {
+                    return reader.Fail(Error::RankTooLong, i);
+                }
+                if ((piece & PieceFlag::Pawn) == PieceFlag::Pawn && (rank == 0 || rank == 7)) {
+                    return reader.Fail(Error::PawnOnBackRank, i);
+                }
+                if (piece == (PieceFlag::King | PieceFlag::White)) {
+                    whiteKings++;
+                }
+                else if (piece == (PieceFlag::King | PieceFlag::Black)) {
+                    blackKings++;
+                }
+
+                state.Squares[rank * 8 + file++] = piece;
+            }
+        }
+
+        if (file < 8) {
+            return reader.Fail(Error::RankTooShort, field.size());
+        }
+        if (rank != 0) {
+            return reader.Fail(Error::WrongRankCount, field.size());
+        }
+        if (whiteKings != 1 || blackKings != 1) {
+            return reader.Fail(Error::WrongKingCount);
+        }
+
+        return {};
+    }
+
+    auto ParseSideToMove(Reader& reader, State& state) noexcept -> Result {
+        const auto field = reader.NextField();
+
+        if (field.empty()) {
+            return reader.Fail(Error::MissingField);
+        }
+        if (field != "w" && field != "b") {
+            return reader.Fail(Error::InvalidSideToMove);
+        }
+
+        state.WhiteToMove = field[0] == 'w';
+        return {};
+    }
+
+    /// <summary>
+    /// Checks if the king of a side is attacked, which for the side not to move would let its king be captured
+    /// </summary>
+    auto IsKingAttacked(const State& state, const bool white) noexcept -> bool {
+        const auto enemy = white ? PieceFlag::Black : PieceFlag::White;
+        const auto king = std::ranges::find(state.Squares, PieceFlag::King | (white ? PieceFlag::White : PieceFlag::Black));
+        const auto index = static_cast<int>(king - state.Squares.begin());
+        Bitboard occupied = 0;
+
+        for (int square = 0; square < 64; square++) {
+            if (state.Squares[square] != PieceFlag::None) {
+                occupied |= Bitboard { 1 } << square;
+            }
+        }
+
+        const auto anyEnemy = [&](Bitboard candidates, const PieceFlag type) -> bool {
+            while (candidates) {
+                if (state.Squares[SquareIndex(PopSquare(candidates))] == (type | enemy)) {
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+        // Enemy pawns attack the king from where its own pawns would capture to
+        if (anyEnemy(PawnAttacks[white ? 0 : 1][index], PieceFlag::Pawn) || anyEnemy(KnightAttacks[index], PieceFlag::Knight)
+            || anyEnemy(KingAttacks[index], PieceFlag::King)) {
+            return true;
+        }
+
+        for (int direction = 0; direction < static_cast<int>(RayDirections.size()); direction++) {
+            const auto blockers = Rays[direction][index] & occupied;
+
+            if (!blockers) {
+                continue;
+            }
+
+            // The first four rays are the orthogonal ones
+            const auto piece = state.Squares[NearestSquare(direction, blockers)];
+            const auto slider = direction < 4 ? PieceFlag::Rook : PieceFlag::Bishop;
+
+            if (piece == (slider | enemy) || piece == (PieceFlag::Queen | enemy)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    auto ParseCastling(Reader& reader, State& state) noexcept -> Result {
+        const auto field = reader.NextField();
+
+        if (field.empty()) {
+            return reader.Fail(Error::MissingField);
+        }
+        if (field == "-") {
+            return {};
+        }
+
+        constexpr std::string_view order = "KQkq";
+        const auto whiteKing = PieceFlag::King | PieceFlag::White;
+        const auto blackKing = PieceFlag::King | PieceFlag::Black;
+        const auto whiteRook = PieceFlag::Rook | PieceFlag::White;
+        const auto blackRook = PieceFlag::Rook | PieceFlag::Black;
+        size_t next = 0;
+
+        for (size_t i = 0; i < field.size(); i++) {
+            const auto index = order.find(field[i], next);
+
+            // Rights are listed once each and in KQkq order
+            if (index == std::string_view::npos) {
+                return reader.Fail(Error::InvalidCastlingRights, i);
+            }
+
+            next = index + 1;
+            bool valid = false;
+
+            switch (field[i]) {
+                case 'K':
+                    valid = state.Squares[4] == whiteKing && state.Squares[7] == whiteRook;
+                    state.WhiteCanCastleKingSide = true;
+                    break;
+                case 'Q':
+                    valid = state.Squares[4] == whiteKing && state.Squares[0] == whiteRook;
+                    state.WhiteCanCastleQueenSide = true;
+                    break;
+                case 'k':
+                    valid = state.Squares[60] == blackKing && state.Squares[63] == blackRook;
+                    state.BlackCanCastleKingSide = true;
+                    break;
+                default:
+                    valid = state.Squares[60] == blackKing && state.Squares[56] == blackRook;
+                    state.BlackCanCastleQueenSide = true;
+                    break;
+            }
+
+            if (!valid) {
+                return reader.Fail(Error::CastlingWithoutKingOrRook, i);
+            }
+        }
+
+        return {};
+    }
+
+    auto ParseEnPassant(Reader& reader, State& state) noexcept -> Result {
+        const auto field = reader.NextField();
+
+        if (field.empty()) {
+            return reader.Fail(Error::MissingField);
+        }
+        if (field == "-") {
+            return {};
+        }
+
+        // The square behind a pawn of the side that just moved, which must have come from two squares further
+        const char expectedRank = state.WhiteToMove ? '6' : '3';
+
+        if (field.size() != 2 || field[0] < 'a' || field[0] > 'h' || field[1] != expectedRank) {
+            return reader.Fail(Error::InvalidEnPassantSquare);
+        }
+
+        const int square = (field[1] - '1') * 8 + (field[0] - 'a');
+        const int forward = state.WhiteToMove ? 8 : -8;
+        const auto pawn = PieceFlag::Pawn | (state.WhiteToMove ? PieceFlag::Black : PieceFlag::White);
+
+        if (state.Squares[square] != PieceFlag::None || state.Squares[square + forward] != PieceFlag::None
+            || state.Squares[square - forward] != pawn) {
+            return reader.Fail(Error::InvalidEnPassantSquare);
+        }
+
+        state.EnPassantSquare = square;
+        return {};
+    }
+
+    auto ParseClock(const std::string_view field, int& value) noexcept -> bool {
+        const auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+        return error == std::errc() && end == field.data() + field.size() && value >= 0 && value <= MaxClock;
+    }
+
+    auto ParseFields(Reader& reader, State& state) noexcept -> Result {
+        state = State();
+
+        if (const auto result = ParsePlacement(reader, state); !result) {
+            return result;
+        }
+        if (const auto result = ParseSideToMove(reader, state); !result) {
+            return result;
+        }
+        if (IsKingAttacked(state, !state.WhiteToMove)) {
+            return reader.Fail(Error::OpponentInCheck);
+        }
+        if (const auto result = ParseCastling(reader, state); !result) {
+            return result;
+        }
+
+        return ParseEnPassant(reader, state);
+    }
+}
+
+auto Fen::Parse(const std::string_view fen, State& state) noexcept -> Result {
+    Reader reader(fen);
+
+    if (const auto result = ParseFields(reader, state); !result) {
+        return result;
+    }
+
+    // The clocks are optional, positions taken from EPD records often lack them
+    if (reader.AtEnd()) {
+        return {};
+    }
+
+    if (!ParseClock(reader.NextField(), state.HalfmoveClock)) {
+        return reader.Fail(Error::InvalidHalfmoveClock);
+    }
+
+    const auto fullmove = reader.NextField();
+
+    if (fullmove.empty()) {
+        return reader.Fail(Error::MissingField);
+    }
+    if (!ParseClock(fullmove, state.FullmoveNumber) || state.FullmoveNumber == 0) {
+        return reader.Fail(Error::InvalidFullmoveNumber);
+    }
+
+    if (!reader.AtEnd()) {
+        reader.NextField();
+        return reader.Fail(Error::TrailingCharacters);
+    }
+
+    return {};
+}
+
+auto Fen::ParseEpd(const std::string_view epd, State& state, std::string_view& operations) noexcept -> Result {
+    Reader reader(epd);
+
+    if (const auto result = ParseFields(reader, state); !result) {
+        return result;
+    }
+
+    operations = reader.Rest();
+    return {};
+}
+
+auto Fen::Write(const State& state, const std::span<char> buffer) noexcept -> size_t {
+    if (buffer.size() < MaxLength) {
+        return 0;
+    }
+
+    char* out = buffer.data();
+
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+
+        for (int file = 0; file < 8; file++) {
+            const auto piece = state.Squares[rank * 8 + file];
+
+            if (piece == PieceFlag::None) {
+                empty++;
+                continue;
+            }
+
+            if (empty > 0) {
+                *out++ = static_cast<char>('0' + empty);
+                empty = 0;
+            }
+
+            *out++ = CharFromPiece(piece);
+        }
+
+        if (empty > 0) {
+            *out++ = static_cast<char>('0' + empty);
+        }
+
+        if (rank > 0) {
+            *out++ = '/';
+        }
+    }
+
+    *out++ = ' ';
+    *out++ = state.WhiteToMove ? 'w' : 'b';
+    *out++ = ' ';
+
+    const char* castling = out;
+
+    if (state.WhiteCanCastleKingSide) {
+        *out++ = 'K';
+    }
+    if (state.WhiteCanCastleQueenSide) {
+        *out++ = 'Q';
+    }
+    if (state.BlackCanCastleKingSide) {
+        *out++ = 'k';
+    }
+    if (state.BlackCanCastleQueenSide) {
+        *out++ = 'q';
+    }
+    if (out == castling) {
+        *out++ = '-';
+    }
+
+    *out++ = ' ';
+
+    if (state.EnPassantSquare >= 0) {
+        *out++ = static_cast<char>('a' + state.EnPassantSquare % 8);
+        *out++ = static_cast<char>('1' + state.EnPassantSquare / 8);
+    }
+    else {
+        *out++ = '-';
+    }
+
+    char* const end = buffer.data() + buffer.size();
+
+    *out++ = ' ';
+    out = std::to_chars(out, end, state.HalfmoveClock).ptr;
+    *out++ = ' ';
+    out = std::to_chars(out, end, state.FullmoveNumber).ptr;
+
+    return static_cast<size_t>(out - buffer.data());
+}
+
+auto Fen::ToString(const State& state) -> std::string {
+    std::array<char, MaxLength> buffer;
+    return { buffer.data(), Write(state, buffer) };
+}
+
+auto Fen::Describe(const Error error) noexcept -> std::string_view {
+    switch (error) {
+        case Error::None: return "no error";
+        case Error::MissingField: return "a field is missing";
+        case Error::InvalidPiece: return "invalid piece character";
+        case Error::RankTooLong: return "rank has more than 8 squares";
+        case Error::RankTooShort: return "rank has fewer than 8 squares";
+        case Error::WrongRankCount: return "placement does not have 8 ranks";
+        case Error::PawnOnBackRank: return "pawn on the first or last rank";
+        case Error::WrongKingCount: return "each side needs exactly one king";
+        case Error::InvalidSideToMove: return "side to move is not w or b";
+        case Error::OpponentInCheck: return "side not to move is in check";
+        case Error::InvalidCastlingRights: return "castling rights are not a subset of KQkq in order";
+        case Error::CastlingWithoutKingOrRook: return "castling right without king and rook on their squares";
+        case Error::InvalidEnPassantSquare: return "invalid en passant square";
+        case Error::InvalidHalfmoveClock: return "invalid halfmove clock";
+        case Error::InvalidFullmoveNumber: return "invalid fullmove number";
+        case Error::TrailingCharacters: return "unexpected characters after the record";
+    }
+
+    return "unknown error";
+}
\ No newline at end of file
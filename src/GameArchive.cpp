@@ -0,0 +1,355 @@
+#include <pch.hpp>
+#include <GameArchive.hpp>
+#include <Board.hpp>
+
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+static_assert(std::endian::native == std::endian::little, "The archive is read in place as little-endian");
+static_assert(GameCodec::SymbolCount * sizeof(uint16_t) <= GameArchive::ModelSize);
+
+namespace {
+    /// <summary>
+    /// A record is the varint of its plies, result and whether it has a FEN, the FEN with its length if it has
+    /// one, and the encoded moves with their length
+    /// </summary>
+    constexpr uint64_t HasFen = 1;
+    constexpr int OutcomeShift = 1;
+    constexpr int PliesShift = 3;
+
+    auto WriteVarint(std::vector<uint8_t>& bytes, uint64_t value) -> void {
+        for (; value >= 0x80; value >>= 7U) {
+            bytes.push_back(static_cast<uint8_t>(value | 0x80U));
+        }
+
+        bytes.push_back(static_cast<uint8_t>(value));
+    }
+
+    auto ReadVarint(const std::span<const uint8_t> bytes, size_t& cursor) -> uint64_t {
+        uint64_t value = 0;
+
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (cursor >= bytes.size()) {
+                break;
+            }
+
+            const auto byte = bytes[cursor++];
+            value |= static_cast<uint64_t>(byte & 0x7FU) << shift;
+
+            if ((byte & 0x80U) == 0) {
+                return value;
+            }
+        }
+
+        throw std::runtime_error("Corrupt game record");
+    }
+
+    auto Read64(const uint8_t* bytes) -> uint64_t {
+        uint64_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+}
+
+GameArchive::GameArchive(const std::filesystem::path& path) : m_File(path) {
+    const auto bytes = m_File.GetBytes();
+
+    if (bytes.size() < HeaderSize + ModelSize || !std::equal(Magic.begin(), Magic.end(), bytes.begin())) {
+        throw std::runtime_error(path.string() + " is not a game archive");
+    }
+
+    uint32_t version;
+    std::memcpy(&version, bytes.data() + 4, sizeof(version));
+
+    if (version != Version) {
+        throw std::runtime_error(path.string() + ": unsupported game archive version");
+    }
+
+    m_Games = Read64(bytes.data() + 8);
+    m_Moves = Read64(bytes.data() + 16);
+    m_MoveBytes = Read64(bytes.data() + 24);
+    const auto recordBytes = Read64(bytes.data() + 32);
+    const auto indexBytes = (m_Games + IndexInterval - 1) / IndexInterval * sizeof(uint64_t);
+
+    if (bytes.size() != HeaderSize + ModelSize + recordBytes + indexBytes) {
+        throw std::runtime_error(path.string() + ": truncated game archive");
+    }
+
+    std::array<uint16_t, GameCodec::SymbolCount> frequencies {};
+    std::memcpy(frequencies.data(), bytes.data() + HeaderSize, sizeof(frequencies));
+
+    try {
+        m_Model = GameCodec::Model(frequencies);
+    }
+    catch (const std::invalid_argument& e) {
+        throw std::runtime_error(path.string() + ": " + e.what());
+    }
+
+    m_Records = bytes.subspan(HeaderSize + ModelSize, recordBytes);
+    m_Index = bytes.subspan(HeaderSize + ModelSize + recordBytes, indexBytes);
+}
+
+auto GameArchive::GetRecord(const uint64_t game) const -> Record {
+    if (game >= m_Games) {
+        throw std::out_of_range("There is no game " + std::to_string(game));
+    }
+
+    auto cursor = static_cast<size_t>(Read64(m_Index.data() + game / IndexInterval * sizeof(uint64_t)));
+
+    for (auto skipped = game / IndexInterval * IndexInterval; skipped < game; skipped++) {
+        ReadRecord(cursor);
+    }
+
+    return ReadRecord(cursor);
+}
+
+auto GameArchive::ReadRecord(size_t& cursor) const -> Record {
+    Record record;
+    const auto head = ReadVarint(m_Records, cursor);
+
+    if ((head & HasFen) != 0) {
+        const auto length = ReadVarint(m_Records, cursor);
+
+        if (length > m_Records.size() - cursor) {
+            throw std::runtime_error("Corrupt game record");
+        }
+
+        record.Fen = { reinterpret_cast<const char*>(m_Records.data() + cursor), length };
+        cursor += length;
+    }
+
+    const auto length = ReadVarint(m_Records, cursor);
+
+    if (length > m_Records.size() - cursor) {
+        throw std::runtime_error("Corrupt game record");
+    }
+
+    record.Result = static_cast<Outcome>((head >> OutcomeShift) & 3U);
+    record.Plies = static_cast<uint32_t>(head >> PliesShift);
+    record.Moves = m_Records.subspan(cursor, length);
+    cursor += length;
+    return record;
+}
+
+auto GameArchive::Replay(int threads, const std::function<void(uint64_t, const Record&, std::span<const Move>)>& visit) const -> void {
+    const auto chunks = (m_Games + IndexInterval - 1) / IndexInterval;
+    threads = threads > 0 ? threads : static_cast<int>(std::max(std::thread::hardware_concurrency(), 1U));
+    threads = static_cast<int>(std::max<uint64_t>(std::min<uint64_t>(static_cast<uint64_t>(threads), chunks), 1));
+
+    std::atomic<uint64_t> next = 0;
+    std::atomic<bool> failed = false;
+    std::mutex mutex;
+    std::exception_ptr failure;
+
+    const auto work = [&] {
+        try {
+            // Most games start from the standard position, so a game is unmade back to it rather than the
+            // board being set up again for the next one
+            bool atStart = false;
+
+            for (auto chunk = next++; chunk < chunks && !failed; chunk = next++) {
+                auto cursor = static_cast<size_t>(Read64(m_Index.data() + chunk * sizeof(uint64_t)));
+                const auto end = std::min((chunk + 1) * IndexInterval, m_Games);
+
+                for (auto game = chunk * IndexInterval; game < end; game++) {
+                    const auto record = ReadRecord(cursor);
+
+                    if (!record.Fen.empty()) {
+                        Board::SetState(record.Fen);
+                    }
+                    else if (!atStart) {
+                        Board::SetState();
+                    }
+
+                    GameCodec::Decoder decoder(m_Model, record.Moves, record.Plies);
+
+                    while (decoder.Next()) {}
+
+                    if (visit) {
+                        visit(game, record, decoder.GetMoves());
+                    }
+
+                    atStart = record.Fen.empty();
+
+                    if (atStart) {
+                        decoder.Rewind();
+                    }
+                }
+            }
+        }
+        catch (...) {
+            std::lock_guard lock(mutex);
+            failure = failure ? failure : std::current_exception();
+            failed = true;
+        }
+    };
+
+    if (threads == 1) {
+        work();
+    }
+    else {
+        std::vector<std::jthread> workers;
+
+        for (int thread = 0; thread < threads; thread++) {
+            workers.emplace_back(work);
+        }
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+auto GameArchive::Build(const std::span<const std::filesystem::path> pgns, const std::filesystem::path& path, const int threads) -> PgnReader::ReplayReport {
+    struct Game {
+        uint64_t Index;
+        Outcome Result;
+        std::string Fen;
+        size_t First;
+        uint32_t Plies;
+    };
+
+    struct Collection {
+        std::mutex Mutex;
+        std::vector<Game> Games;
+        std::vector<GameCodec::Symbol> Symbols;
+    };
+
+    /// <summary>
+    /// Ranks the moves of the games a replaying thread is given, keeping the games that replay to the end
+    /// </summary>
+    class Collector final : public PgnReader::Visitor {
+    public:
+        Collector(Collection& collection, const uint64_t firstGame) : m_Collection(collection), m_FirstGame(firstGame) {}
+
+        auto Visit(const uint64_t game, const int ply, const PgnReader::Game& record, const Move* next) -> void override {
+            if (ply == 0) {
+                // The moves of a game that failed to replay are dropped along with it
+                m_Symbols.resize(m_Games.empty() ? 0 : m_Games.back().First + m_Games.back().Plies);
+                m_Pending = { m_FirstGame + game, PositionIndex::GetOutcome(record.Result), std::string(record.GetTag("FEN")), m_Symbols.size(), 0 };
+                m_Previous.reset();
+            }
+
+            if (next == nullptr) {
+                m_Pending.Plies = static_cast<uint32_t>(ply);
+                m_Games.push_back(m_Pending);
+                return;
+            }
+
+            m_Symbols.push_back(GameCodec::Rank(*next, m_Previous ? &*m_Previous : nullptr));
+            m_Previous = *next;
+        }
+
+        auto Finish() -> void override {
+            m_Symbols.resize(m_Games.empty() ? 0 : m_Games.back().First + m_Games.back().Plies);
+
+            std::lock_guard lock(m_Collection.Mutex);
+            const auto offset = m_Collection.Symbols.size();
+
+            for (auto& game : m_Games) {
+                game.First += offset;
+                m_Collection.Games.push_back(std::move(game));
+            }
+
+            m_Collection.Symbols.insert(m_Collection.Symbols.end(), m_Symbols.begin(), m_Symbols.end());
+            m_Games.clear();
+            m_Symbols.clear();
+        }
+
+    private:
+        Collection& m_Collection;
+        uint64_t m_FirstGame;
+        std::vector<Game> m_Games;
+        std::vector<GameCodec::Symbol> m_Symbols;
+        Game m_Pending {};
+        std::optional<Move> m_Previous;
+    };
+
+    Collection collection;
+    PgnReader::ReplayReport total;
+
+    for (const auto& pgn : pgns) {
+        std::ifstream stream(pgn);
+
+        if (!stream) {
+            throw std::runtime_error("Failed to open " + pgn.string());
+        }
+
+        const auto firstGame = total.Games;
+        const auto report = PgnReader::Replay(stream, threads, [&] { return std::make_unique<Collector>(collection, firstGame); });
+
+        total.Games += report.Games;
+        total.Positions += report.Positions;
+        total.Errors += report.Errors;
+    }
+
+    auto& games = collection.Games;
+    std::ranges::sort(games, {}, &Game::Index);
+
+    const auto model = GameCodec::Model::Train(collection.Symbols);
+
+    std::vector<uint8_t> records;
+    std::vector<uint64_t> index;
+    std::vector<uint8_t> moves;
+    uint64_t moveCount = 0, moveBytes = 0;
+
+    for (size_t i = 0; i < games.size(); i++) {
+        const auto& game = games[i];
+
+        if (i % IndexInterval == 0) {
+            index.push_back(records.size());
+        }
+
+        moves.clear();
+        GameCodec::Encode(model, std::span(collection.Symbols).subspan(game.First, game.Plies), moves);
+
+        WriteVarint(records, (static_cast<uint64_t>(game.Plies) << PliesShift) | (static_cast<uint64_t>(game.Result) << OutcomeShift)
+            | (game.Fen.empty() ? 0 : HasFen));
+
+        if (!game.Fen.empty()) {
+            WriteVarint(records, game.Fen.size());
+            records.insert(records.end(), game.Fen.begin(), game.Fen.end());
+        }
+
+        WriteVarint(records, moves.size());
+        records.insert(records.end(), moves.begin(), moves.end());
+
+        moveCount += game.Plies;
+        moveBytes += moves.size();
+    }
+
+    std::array<char, HeaderSize + ModelSize> header {};
+    const uint64_t gameCount = games.size(), recordBytes = records.size();
+
+    std::memcpy(header.data(), Magic.data(), Magic.size());
+    std::memcpy(header.data() + 4, &Version, sizeof(Version));
+    std::memcpy(header.data() + 8, &gameCount, sizeof(gameCount));
+    std::memcpy(header.data() + 16, &moveCount, sizeof(moveCount));
+    std::memcpy(header.data() + 24, &moveBytes, sizeof(moveBytes));
+    std::memcpy(header.data() + 32, &recordBytes, sizeof(recordBytes));
+    std::memcpy(header.data() + HeaderSize, model.GetFrequencies().data(), model.GetFrequencies().size_bytes());
+
+    const std::filesystem::path temporary = path.string() + ".tmp";
+
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+
+        stream.write(header.data(), header.size());
+        stream.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size()));
+        stream.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(uint64_t)));
+        stream.close();
+
+        if (!stream) {
+            std::error_code error;
+            std::filesystem::remove(temporary, error);
+            throw std::runtime_error("Failed to write " + temporary.string());
+        }
+    }
+
+    std::filesystem::rename(temporary, path);
+    return total;
+}
\ No newline at end of file
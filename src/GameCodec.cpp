@@ -0,0 +1,328 @@
+#include <pch.hpp>
+#include <GameCodec.hpp>
+#include <Board.hpp>
+#include <Evaluation.hpp>
+#include <Piece.hpp>
+
+#include <bit>
+#include <functional>
+
+using MoveType = Move::MoveType;
+
+namespace {
+    constexpr uint32_t Total = uint32_t { 1 } << GameCodec::ProbabilityBits;
+
+    /// <summary>
+    /// The range is renormalized a byte at a time whenever it falls below this
+    /// </summary>
+    constexpr uint32_t TopValue = uint32_t { 1 } << 24U;
+
+    constexpr auto TableSize(const int context) -> size_t {
+        return size_t { 2 } << context;
+    }
+
+    auto IsCapture(const MoveType type) -> bool {
+        return type == MoveType::Capture || type == MoveType::PromotionCapture || type == MoveType::EnPassant;
+    }
+
+    auto Score(const std::array<Piece, 64>& board, const Move& move, const Move* previous) -> int {
+        const auto piece = board[SquareIndex(move.From)].GetType();
+        const int attacker = Evaluation::PieceValue(piece);
+
+        if (IsCapture(move.Type)) {
+            // Taking back on the square the opponent just captured on is the most common reply of all
+            if (previous != nullptr && IsCapture(previous->Type) && move.To == previous->To) {
+                return (1 << 20) - attacker;
+            }
+
+            const int victim = move.Type == MoveType::EnPassant ? Evaluation::PieceValue(PieceFlag::Pawn)
+                : Evaluation::PieceValue(board[SquareIndex(move.To)].GetType());
+
+            // Taking a piece worth at least the attacker cannot lose material, so only the rest are resolved
+            const int exchange = victim >= attacker ? 0 : Evaluation::StaticExchange(move);
+
+            return exchange >= 0 ? (1 << 18) + victim * 16 - attacker / 16 : (1 << 14) + exchange;
+        }
+
+        if (move.Type == MoveType::Promotion) {
+            return move.Promotion == PieceFlag::Queen ? 1 << 19 : Evaluation::PieceValue(move.Promotion);
+        }
+
+        // Quiet moves go by how much better the piece stands on its new square
+        return (1 << 16) + Evaluation::PieceSquare(piece, SquareIndex(move.To)) - Evaluation::PieceSquare(piece, SquareIndex(move.From));
+    }
+
+    /// <summary>
+    /// Gives every legal move of the position on the board a key, the higher the key the lower its rank. The
+    /// score takes the high bits and the place of the move in the generated list breaks ties, which makes the keys
+    /// unique, so a rank is found by counting keys rather than by sorting the moves
+    /// </summary>
+    auto GenerateKeys(std::vector<Move>& moves, std::vector<uint32_t>& keys, const Move* previous) -> void {
+        const auto& board = Board::GetBoard();
+
+        Board::GenerateMoves<Board::GenType::All>(moves);
+        keys.resize(moves.size());
+
+        for (size_t i = 0; i < moves.size(); i++) {
+            keys[i] = static_cast<uint32_t>(Score(board, moves[i], previous)) << 8U | static_cast<uint32_t>(255 - i);
+        }
+    }
+
+    /// <summary>
+    /// A range coder in the manner of LZMA: the low end of the range is kept in 64 bits so that a carry out of
+    /// the top byte can be added to the bytes already pending, of which only the first and a run of 0xFF are held
+    /// </summary>
+    class Encoder final {
+    public:
+        explicit Encoder(std::vector<uint8_t>& bytes) : m_Bytes(bytes), m_Start(bytes.size()) {}
+
+        auto Encode(const uint32_t cumulative, const uint32_t frequency) -> void {
+            const uint32_t range = m_Range >> GameCodec::ProbabilityBits;
+            m_Low += static_cast<uint64_t>(range) * cumulative;
+            m_Range = range * frequency;
+
+            while (m_Range < TopValue) {
+                m_Range <<= 8U;
+                ShiftLow();
+            }
+        }
+
+        /// <summary>
+        /// Writes only as much of the final range as the decoder needs: the value in it with the most trailing
+        /// zero bytes, which are then left out along with any other trailing zeros
+        /// </summary>
+        auto Flush() -> void {
+            m_Low = (m_Low + TopValue - 1) & ~static_cast<uint64_t>(TopValue - 1);
+            ShiftLow();
+            ShiftLow();
+
+            while (m_Bytes.size() > m_Start && m_Bytes.back() == 0) {
+                m_Bytes.pop_back();
+            }
+        }
+
+    private:
+        auto ShiftLow() -> void {
+            if (static_cast<uint32_t>(m_Low) < 0xFF000000U || (m_Low >> 32U) != 0) {
+                const auto carry = static_cast<uint8_t>(m_Low >> 32U);
+                auto pending = m_Cache;
+
+                for (; m_CacheSize > 0; m_CacheSize--) {
+                    // The first byte is always zero, the decoder starts as if it had read it
+                    if (!m_First) {
+                        m_Bytes.push_back(static_cast<uint8_t>(pending + carry));
+                    }
+
+                    m_First = false;
+                    pending = 0xFF;
+                }
+
+                m_Cache = static_cast<uint8_t>(m_Low >> 24U);
+            }
+
+            m_CacheSize++;
+            m_Low = (m_Low & 0x00FFFFFFU) << 8U;
+        }
+
+        std::vector<uint8_t>& m_Bytes;
+        size_t m_Start;
+
+        uint64_t m_Low = 0;
+        uint32_t m_Range = 0xFFFFFFFFU;
+        uint8_t m_Cache = 0;
+        uint64_t m_CacheSize = 1;
+        bool m_First = true;
+    };
+}
+
+GameCodec::Model::Model() {
+    for (int context = 0; context < Contexts; context++) {
+        const auto size = TableSize(context);
+        std::fill_n(m_Frequencies.begin() + static_cast<ptrdiff_t>(GetOffset(context)), size, static_cast<uint16_t>(Total / size));
+    }
+
+    Accumulate();
+}
+
+GameCodec::Model::Model(const std::span<const uint16_t, SymbolCount> frequencies) {
+    std::ranges::copy(frequencies, m_Frequencies.begin());
+
+    for (int context = 0; context < Contexts; context++) {
+        const auto table = std::span(m_Frequencies).subspan(GetOffset(context), TableSize(context));
+        uint32_t sum = 0;
+
+        for (const auto frequency : table) {
+            if (frequency == 0) {
+                throw std::invalid_argument("A rank has no frequency");
+            }
+
+            sum += frequency;
+        }
+
+        if (sum != Total) {
+            throw std::invalid_argument("The frequencies of a table do not add up");
+        }
+    }
+
+    Accumulate();
+}
+
+auto GameCodec::Model::Train(const std::span<const Symbol> symbols) -> Model {
+    std::array<uint64_t, SymbolCount> counts {};
+
+    for (const auto& [rank, moves] : symbols) {
+        if (moves > 1) {
+            counts[GetOffset(GetContext(moves)) + rank]++;
+        }
+    }
+
+    Model model;
+
+    for (int context = 0; context < Contexts; context++) {
+        const auto offset = GetOffset(context);
+        const auto size = TableSize(context);
+        const auto table = std::span(counts).subspan(offset, size);
+        uint64_t seen = 0;
+
+        for (const auto count : table) {
+            seen += count;
+        }
+
+        if (seen == 0) {
+            continue;
+        }
+
+        // Every rank keeps a frequency of one, the rest is shared out in proportion and what rounding leaves
+        // goes to the most frequent rank
+        const auto spare = Total - size;
+        uint32_t assigned = 0;
+
+        for (size_t rank = 0; rank < size; rank++) {
+            const auto frequency = 1 + static_cast<uint32_t>(table[rank] * spare / seen);
+            model.m_Frequencies[offset + rank] = static_cast<uint16_t>(frequency);
+            assigned += frequency;
+        }
+
+        const auto common = static_cast<size_t>(std::ranges::max_element(table) - table.begin());
+        model.m_Frequencies[offset + common] = static_cast<uint16_t>(model.m_Frequencies[offset + common] + Total - assigned);
+    }
+
+    model.Accumulate();
+    return model;
+}
+
+auto GameCodec::Model::GetContext(const int moves) -> int {
+    return std::bit_width(static_cast<unsigned>(moves - 1)) - 1;
+}
+
+auto GameCodec::Model::Accumulate() -> void {
+    for (int context = 0; context < Contexts; context++) {
+        const auto offset = GetOffset(context);
+        const auto cumulative = m_Cumulative.begin() + static_cast<ptrdiff_t>(offset + context);
+        uint32_t sum = 0;
+
+        for (size_t rank = 0; rank < TableSize(context); rank++) {
+            cumulative[static_cast<ptrdiff_t>(rank)] = sum;
+            sum += m_Frequencies[offset + rank];
+        }
+
+        cumulative[static_cast<ptrdiff_t>(TableSize(context))] = sum;
+    }
+}
+
+GameCodec::Decoder::Decoder(const Model& model, const std::span<const uint8_t> bytes, const uint32_t plies) :
+    m_Model(model), m_Bytes(bytes), m_Plies(plies) {
+    for (int i = 0; i < 4; i++) {
+        m_Code = (m_Code << 8U) | ReadByte();
+    }
+
+    m_Played.reserve(plies);
+}
+
+auto GameCodec::Decoder::Next() -> std::optional<Move> {
+    if (m_Played.size() >= m_Plies) {
+        return std::nullopt;
+    }
+
+    const auto previous = m_Played.empty() ? nullptr : &m_Played.back();
+
+    GenerateKeys(m_Moves, m_Keys, previous);
+
+    const auto count = static_cast<int>(m_Moves.size());
+    int rank = 0;
+
+    if (count > 1) {
+        const int context = Model::GetContext(count);
+        const uint32_t range = m_Range >> ProbabilityBits;
+        const uint32_t value = std::min(m_Code / range, Total - 1);
+
+        while (m_Model.GetCumulative(context, rank + 1) <= value) {
+            rank++;
+        }
+
+        const auto low = m_Model.GetCumulative(context, rank);
+        m_Code -= range * low;
+        m_Range = range * (m_Model.GetCumulative(context, rank + 1) - low);
+
+        while (m_Range < TopValue) {
+            m_Range <<= 8U;
+            m_Code = (m_Code << 8U) | ReadByte();
+        }
+    }
+
+    if (rank >= count) {
+        throw std::runtime_error("Corrupt game");
+    }
+
+    // The move of a rank holds the key that many places from the highest
+    const auto nth = m_Keys.begin() + rank;
+    std::nth_element(m_Keys.begin(), nth, m_Keys.end(), std::greater());
+
+    const auto move = m_Moves[255 - (*nth & 0xFFU)];
+    Board::MakeMove(move);
+    m_Played.push_back(move);
+    return move;
+}
+
+auto GameCodec::Decoder::Rewind() -> void {
+    while (!m_Played.empty()) {
+        Board::UnmakeMove(m_Played.back());
+        m_Played.pop_back();
+    }
+}
+
+auto GameCodec::Decoder::ReadByte() noexcept -> uint8_t {
+    return m_Position < m_Bytes.size() ? m_Bytes[m_Position++] : 0;
+}
+
+auto GameCodec::Rank(const Move& move, const Move* previous) -> Symbol {
+    thread_local std::vector<Move> moves;
+    thread_local std::vector<uint32_t> keys;
+
+    GenerateKeys(moves, keys, previous);
+
+    const auto found = std::ranges::find(moves, move);
+
+    if (found == moves.end()) {
+        throw std::invalid_argument(move.ToString() + " is not a legal move");
+    }
+
+    const auto key = keys[static_cast<size_t>(found - moves.begin())];
+    const auto rank = std::ranges::count_if(keys, [key](const uint32_t other) { return other > key; });
+
+    return { static_cast<uint8_t>(rank), static_cast<uint8_t>(moves.size()) };
+}
+
+auto GameCodec::Encode(const Model& model, const std::span<const Symbol> symbols, std::vector<uint8_t>& bytes) -> void {
+    Encoder encoder(bytes);
+
+    for (const auto& [rank, moves] : symbols) {
+        if (moves > 1) {
+            const int context = Model::GetContext(moves);
+            const auto low = model.GetCumulative(context, rank);
+            encoder.Encode(low, model.GetCumulative(context, rank + 1) - low);
+        }
+    }
+
+    encoder.Flush();
+}
\ No newline at end of file
@@ -0,0 +1,356 @@
+#include <pch.hpp>
+#include <LargePageBuffer.hpp>
+
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#ifndef _WIN32
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // The size of a huge page on x86-64 and the default one on AArch64
+    constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+    constexpr auto RoundUp(const size_t value, const size_t alignment) -> size_t {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+#ifdef _WIN32
+    /// <summary>
+    /// Large pages need the lock pages in memory privilege, which only an administrator can grant
+    /// </summary>
+    auto EnableLockMemoryPrivilege() -> bool {
+        HANDLE token = nullptr;
+
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+            return false;
+        }
+
+        TOKEN_PRIVILEGES privileges {};
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+        // AdjustTokenPrivileges succeeds without granting anything if the account lacks the privilege
+        const bool enabled = LookupPrivilegeValueW(nullptr, L"SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)
+            && AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr)
+            && GetLastError() == ERROR_SUCCESS;
+
+        CloseHandle(token);
+        return enabled;
+    }
+
+    auto GetNodes() -> std::vector<int> {
+        ULONG highest = 0;
+        std::vector<int> nodes;
+
+        if (GetNumaHighestNodeNumber(&highest)) {
+            for (ULONG node = 0; node <= highest; node++) {
+                if (GROUP_AFFINITY affinity {}; GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity) && affinity.Mask != 0) {
+                    nodes.push_back(static_cast<int>(node));
+                }
+            }
+        }
+
+        return nodes;
+    }
+
+    auto PinToNode(const int node) -> bool {
+        GROUP_AFFINITY affinity {};
+        return GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity)
+            && SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+    }
+#else
+    // The memory policy of mbind from linux/mempolicy.h, called directly so that libnuma is not needed
+    constexpr int InterleavePolicy = 3;
+
+    /// <summary>
+    /// Parses a list of the kernel such as <c>0-3,8-11</c>
+    /// </summary>
+    auto ParseList(const std::string_view text) -> std::vector<int> {
+        std::vector<int> values;
+        size_t offset = 0;
+
+        while (offset < text.size()) {
+            const auto end = std::min(text.find(',', offset), text.size());
+            const auto range = text.substr(offset, end - offset);
+            const auto dash = range.find('-');
+
+            try {
+                const int first = std::stoi(std::string(range.substr(0, dash)));
+                const int last = dash == std::string_view::npos ? first : std::stoi(std::string(range.substr(dash + 1)));
+
+                for (int value = first; value <= last; value++) {
+                    values.push_back(value);
+                }
+            }
+            catch (const std::exception&) {
+                return {};
+            }
+
+            offset = end + 1;
+        }
+
+        return values;
+    }
+
+    auto ReadLine(const std::string& path) -> std::string {
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line);
+        return line;
+    }
+
+    auto GetNodes() -> std::vector<int> {
+        return ParseList(ReadLine("/sys/devices/system/node/online"));
+    }
+
+    auto PinToNode(const int node) -> bool {
+        const auto cpus = ParseList(ReadLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+
+        if (cpus.empty()) {
+            return false;
+        }
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+
+        for (const int cpu : cpus) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+            }
+        }
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+
+    /// <summary>
+    /// Gets the system setting of transparent huge pages: always, madvise or never
+    /// </summary>
+    auto GetTransparentHugePageSetting() -> std::string {
+        const auto line = ReadLine("/sys/kernel/mm/transparent_hugepage/enabled");
+        const auto open = line.find('[');
+        const auto close = line.find(']', open);
+        return open == std::string::npos || close == std::string::npos ? "never" : line.substr(open + 1, close - open - 1);
+    }
+#endif
+}
+
+LargePageBuffer::Options LargePageBuffer::s_Options;
+
+auto LargePageBuffer::SetOptions(const Options& options) -> void {
+    s_Options = options;
+}
+
+auto LargePageBuffer::GetOptions() -> const Options& {
+    return s_Options;
+}
+
+LargePageBuffer::LargePageBuffer(const size_t bytes) : m_Size(bytes), m_RequestedNuma(s_Options.Numa) {
+#ifdef _WIN32
+    if (s_Options.LargePages) {
+        if (const size_t minimum = GetLargePageMinimum(); minimum > 0 && EnableLockMemoryPrivilege()) {
+            m_MappedSize = RoundUp(bytes, minimum);
+            m_Data = VirtualAlloc(nullptr, m_MappedSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            m_Pages = PageMode::Large;
+        }
+    }
+
+    // Falls back to normal pages when large pages are disabled, not permitted or too fragmented
+    if (m_Data == nullptr) {
+        m_MappedSize = RoundUp(bytes, 4096);
+        m_Data = VirtualAlloc(nullptr, m_MappedSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        m_Pages = PageMode::Normal;
+    }
+
+    if (m_Data == nullptr) {
+        throw std::bad_alloc();
+    }
+#else
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t alignment = s_Options.LargePages ? HugePageSize : pageSize;
+    m_MappedSize = RoundUp(bytes, alignment);
+
+    // Maps an extra huge page so that the buffer can start on a huge page boundary, the excess is unmapped again
+    const size_t reserved = m_MappedSize + alignment - pageSize;
+    void* raw = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (raw == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+
+    const auto address = reinterpret_cast<uintptr_t>(raw);
+    const auto aligned = RoundUp(address, alignment);
+
+    if (aligned > address) {
+        munmap(raw, aligned - address);
+    }
+    if (const auto end = aligned + m_MappedSize; end < address + reserved) {
+        munmap(reinterpret_cast<void*>(end), address + reserved - end);
+    }
+
+    m_Data = reinterpret_cast<void*>(aligned);
+
+    if (s_Options.LargePages) {
+        // With the setting at always every large mapping gets huge pages, at madvise only the advised ones do
+        const auto setting = GetTransparentHugePageSetting();
+        const bool advised = madvise(m_Data, m_MappedSize, MADV_HUGEPAGE) == 0;
+
+        if (setting == "always" || (setting == "madvise" && advised)) {
+            m_Pages = PageMode::Transparent;
+        }
+    }
+#endif
+
+    PlacePages(s_Options.Numa);
+}
+
+LargePageBuffer::LargePageBuffer(LargePageBuffer&& other) noexcept {
+    *this = std::move(other);
+}
+
+auto LargePageBuffer::operator=(LargePageBuffer&& other) noexcept -> LargePageBuffer& {
+    if (this != &other) {
+        Release();
+
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+        m_MappedSize = std::exchange(other.m_MappedSize, 0);
+        m_Pages = other.m_Pages;
+        m_Numa = other.m_Numa;
+        m_RequestedNuma = other.m_RequestedNuma;
+        m_Nodes = other.m_Nodes;
+    }
+
+    return *this;
+}
+
+LargePageBuffer::~LargePageBuffer() {
+    Release();
+}
+
+auto LargePageBuffer::Release() noexcept -> void {
+    if (m_Data == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    VirtualFree(m_Data, 0, MEM_RELEASE);
+#else
+    munmap(m_Data, m_MappedSize);
+#endif
+
+    m_Data = nullptr;
+}
+
+auto LargePageBuffer::PlacePages(const NumaPolicy policy) -> void {
+    const auto nodes = GetNodes();
+    m_Nodes = std::max(static_cast<int>(nodes.size()), 1);
+
+    if (policy == NumaPolicy::None || nodes.size() < 2) {
+        return;
+    }
+
+#ifndef _WIN32
+    if (policy == NumaPolicy::Interleave) {
+        std::vector<unsigned long> mask(static_cast<size_t>(nodes.back()) / 64 + 1);
+
+        for (const int node : nodes) {
+            mask[static_cast<size_t>(node) / 64] |= 1UL << (node % 64);
+        }
+
+        // The kernel ignores the last bit of the node count it is given
+        if (syscall(SYS_mbind, m_Data, m_MappedSize, InterleavePolicy, mask.data(), mask.size() * 64 + 1, 0) == 0) {
+            m_Numa = NumaPolicy::Interleave;
+        }
+
+        return;
+    }
+#endif
+
+    // Locked large pages are resident from the start, only pages yet to be faulted in can be placed
+    if (policy != NumaPolicy::FirstTouch || m_Pages == PageMode::Large) {
+        return;
+    }
+
+    // Each node faults in a contiguous share of the buffer, in whole huge pages so that no page is split
+    const size_t share = RoundUp(m_MappedSize / nodes.size(), HugePageSize);
+    std::atomic<bool> pinned = true;
+
+    {
+        std::vector<std::jthread> threads;
+
+        for (size_t i = 0; i < nodes.size(); i++) {
+            threads.emplace_back([&, i] {
+                if (!PinToNode(nodes[i])) {
+                    pinned = false;
+                }
+
+                const size_t begin = std::min(i * share, m_MappedSize);
+                const size_t end = std::min(begin + share, m_MappedSize);
+                std::memset(static_cast<uint8_t*>(m_Data) + begin, 0, end - begin);
+            });
+        }
+    }
+
+    if (pinned) {
+        m_Numa = NumaPolicy::FirstTouch;
+    }
+}
+
+auto LargePageBuffer::Describe() const -> std::string {
+    std::string description = std::to_string(m_Size / (1024 * 1024)) + " MB, ";
+
+    switch (m_Pages) {
+        case PageMode::Large:
+            description += "large pages";
+            break;
+        case PageMode::Transparent:
+            description += "transparent huge pages";
+            break;
+        default:
+            description += "normal pages";
+            break;
+    }
+
+    const auto nodes = std::to_string(m_Nodes) + (m_Nodes == 1 ? " NUMA node" : " NUMA nodes");
+
+    if (m_Numa == NumaPolicy::Interleave) {
+        description += ", interleaved over " + nodes;
+    }
+    else if (m_Numa == NumaPolicy::FirstTouch) {
+        description += ", first touched from " + nodes;
+    }
+    else if (m_RequestedNuma != NumaPolicy::None) {
+        description += ", no NUMA placement on " + nodes;
+    }
+
+    return description;
+}
+
+auto LargePageBuffer::GetName(const NumaPolicy policy) -> std::string_view {
+    switch (policy) {
+        case NumaPolicy::Interleave:
+            return "interleave";
+        case NumaPolicy::FirstTouch:
+            return "firsttouch";
+        default:
+            return "none";
+    }
+}
+
+auto LargePageBuffer::ParseNumaPolicy(const std::string_view name) -> std::optional<NumaPolicy> {
+    for (const auto policy : { NumaPolicy::None, NumaPolicy::Interleave, NumaPolicy::FirstTouch }) {
+        if (GetName(policy) == name) {
+            return policy;
+        }
+    }
+
+    return std::nullopt;
+}
\ No newline at end of file
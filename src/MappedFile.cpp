@@ -0,0 +1,90 @@
+#include <pch.hpp>
+#include <MappedFile.hpp>
+
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+    m_File = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open " + path.string());
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_File, &size) || (m_Mapping = CreateFileMappingW(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr)) == nullptr) {
+        Unmap();
+        throw std::runtime_error("Failed to map " + path.string());
+    }
+
+    m_Data = static_cast<const uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+    m_Size = static_cast<size_t>(size.QuadPart);
+#else
+    const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        throw std::runtime_error("Failed to open " + path.string());
+    }
+
+    struct stat status {};
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        m_Size = static_cast<size_t>(status.st_size);
+        void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+        m_Data = data == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(data);
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(file);
+#endif
+
+    if (m_Data == nullptr) {
+        Unmap();
+        throw std::runtime_error("Failed to map " + path.string());
+    }
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+    m_Data(std::exchange(other.m_Data, nullptr)),
+    m_Size(std::exchange(other.m_Size, 0))
+#ifdef _WIN32
+    , m_File(std::exchange(other.m_File, INVALID_HANDLE_VALUE))
+    , m_Mapping(std::exchange(other.m_Mapping, nullptr))
+#endif
+{}
+
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile& {
+    if (this != &other) {
+        Unmap();
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+#ifdef _WIN32
+        m_File = std::exchange(other.m_File, INVALID_HANDLE_VALUE);
+        m_Mapping = std::exchange(other.m_Mapping, nullptr);
+#endif
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    Unmap();
+}
+
+auto MappedFile::Unmap() noexcept -> void {
+#ifdef _WIN32
+    if (m_Data != nullptr) UnmapViewOfFile(m_Data);
+    if (m_Mapping != nullptr) CloseHandle(m_Mapping);
+    if (m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+    m_Mapping = nullptr;
+    m_File = INVALID_HANDLE_VALUE;
+#else
+    if (m_Data != nullptr) munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+}
\ No newline at end of file
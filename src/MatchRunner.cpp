@@ -0,0 +1,565 @@
+#include <pch.hpp>
+#include <MatchRunner.hpp>
+#include <Board.hpp>
+#include <Fen.hpp>
+#include <Piece.hpp>
+#include <Move.hpp>
+#include <Notation.hpp>
+#include <ChildProcess.hpp>
+#include <Trace.hpp>
+
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using GameResult = MatchRunner::GameResult;
+
+namespace {
+
+    // Engines without a clock still have to answer eventually
+    constexpr int UnlimitedMoveTimeoutMs = 60000;
+    constexpr int HandshakeTimeoutMs = 10000;
+
+    auto Split(const std::string_view text) -> std::vector<std::string> {
+        std::vector<std::string> fields;
+        std::istringstream stream { std::string(text) };
+
+        for (std::string field; stream >> field;) {
+            fields.emplace_back(std::move(field));
+        }
+
+        return fields;
+    }
+
+    auto ResultString(const GameResult result) -> std::string_view {
+        switch (result) {
+            case GameResult::WhiteWins: return "1-0";
+            case GameResult::BlackWins: return "0-1";
+            default: return "1/2-1/2";
+        }
+    }
+
+    /// <summary>
+    /// Checks if neither side has enough material left to deliver mate by any series of legal moves
+    /// </summary>
+    auto IsInsufficientMaterial() -> bool {
+        int minors = 0;
+        int bishopSquareColors = 0;
+
+        const auto& board = Board::GetBoard();
+
+        for (int square = 0; square < 64; square++) {
+            const auto piece = board[square];
+
+            if (piece.IsEmpty() || piece.Is(PieceFlag::King)) {
+                continue;
+            }
+
+            if (!piece.Is(PieceFlag::Knight) && !piece.Is(PieceFlag::Bishop)) {
+                return false;
+            }
+
+            minors++;
+
+            if (piece.Is(PieceFlag::Bishop)) {
+                bishopSquareColors |= 1 << ((square % 8 + square / 8) & 1);
+            }
+        }
+
+        // A single minor piece cannot mate, and neither can bishops that all stand on squares of one color
+        return minors <= 1 || (bishopSquareColors != 3 && std::ranges::none_of(board, [](const Piece& piece) {
+            return piece.Is(PieceFlag::Knight);
+        }));
+    }
+}
+
+/// <summary>
+/// A UCI engine running as a child process
+/// </summary>
+class MatchRunner::EngineProcess final {
+public:
+    struct Reply {
+        std::string BestMove;
+        std::string Score;
+        int Depth = 0;
+    };
+
+    explicit EngineProcess(const EngineConfig& config) : m_Config(config) {}
+
+    /// <summary>
+    /// Starts the engine and waits until it has applied its options. Throws if the engine does not respond
+    /// </summary>
+    auto Start() -> void {
+        m_Process = ChildProcess(Split(m_Config.Command));
+
+        if (!m_Process.WriteLine("uci") || !WaitFor("uciok", HandshakeTimeoutMs)) {
+            throw std::runtime_error("Engine " + m_Config.Name + " did not start as a UCI engine");
+        }
+
+        for (const auto& [name, value] : m_Config.Options) {
+            m_Process.WriteLine("setoption name " + name + " value " + value);
+        }
+
+        if (!Synchronize()) {
+            throw std::runtime_error("Engine " + m_Config.Name + " did not become ready");
+        }
+    }
+
+    auto Restart() -> void {
+        m_Process.Kill();
+        Start();
+    }
+
+    auto NewGame() -> void {
+        if (!m_Process.WriteLine("ucinewgame") || !Synchronize()) {
+            Restart();
+        }
+    }
+
+    /// <summary>
+    /// Sends the position and the search limits and waits for the best move
+    /// </summary>
+    /// <returns><c>Reply</c> The best move and the last reported score, or nothing if the engine did not answer in time</returns>
+    auto Go(const std::string& position, const std::string& limits, const int timeoutMs) -> std::optional<Reply> {
+        if (!m_Process.WriteLine(position) || !m_Process.WriteLine(limits)) {
+            return std::nullopt;
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        Reply reply;
+
+        for (std::string line;;) {
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+
+            if (remaining <= 0 || !m_Process.ReadLine(line, static_cast<int>(remaining))) {
+                return std::nullopt;
+            }
+
+            const auto fields = Split(line);
+
+            if (fields.empty()) {
+                continue;
+            }
+
+            if (fields[0] == "bestmove" && fields.size() > 1) {
+                reply.BestMove = fields[1];
+                return reply;
+            }
+
+            if (fields[0] != "info") {
+                continue;
+            }
+
+            // Only the best line counts when the engine reports several
+            if (const auto multiPv = std::ranges::find(fields, "multipv"); multiPv != fields.end()
+                && multiPv + 1 != fields.end() && multiPv[1] != "1") {
+                continue;
+            }
+
+            for (size_t i = 1; i + 1 < fields.size(); i++) {
+                if (fields[i] == "depth") {
+                    reply.Depth = std::atoi(fields[i + 1].c_str());
+                }
+                else if (fields[i] == "score" && i + 2 < fields.size()) {
+                    reply.Score = FormatScore(fields[i + 1], fields[i + 2]);
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] auto GetName() const -> const std::string& {
+        return m_Config.Name;
+    }
+
+private:
+    /// <summary>
+    /// Formats a UCI score like PGN comments usually do, e.g. <c>+0.35</c> or <c>+M3</c>
+    /// </summary>
+    static auto FormatScore(const std::string& type, const std::string& value) -> std::string {
+        const int score = std::atoi(value.c_str());
+
+        if (type == "mate") {
+            return (score > 0 ? "+M" : "-M") + std::to_string(std::abs(score));
+        }
+
+        std::ostringstream text;
+        text << std::showpos << std::fixed;
+        text.precision(2);
+        text << score / 100.0;
+        return text.str();
+    }
+
+    auto Synchronize() -> bool {
+        return m_Process.WriteLine("isready") && WaitFor("readyok", HandshakeTimeoutMs);
+    }
+
+    auto WaitFor(const std::string_view token, const int timeoutMs) -> bool {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+        for (std::string line;;) {
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+
+            if (remaining <= 0 || !m_Process.ReadLine(line, static_cast<int>(remaining))) {
+                return false;
+            }
+
+            if (line == token) {
+                return true;
+            }
+        }
+    }
+
+    const EngineConfig& m_Config;
+    ChildProcess m_Process;
+};
+
+MatchRunner::MatchRunner(Options options) :
+    m_Options(std::move(options)),
+    m_Statistics(m_Options.Elo0, m_Options.Elo1, m_Options.Alpha, m_Options.Beta) {
+    if (m_Options.Nodes == 0 && m_Options.Depth == 0 && m_Options.TimeMs == 0) {
+        throw std::invalid_argument("A match needs a node, depth or time limit");
+    }
+
+    if (m_Options.First.Command.empty() || m_Options.Second.Command.empty()) {
+        throw std::invalid_argument("A match needs two engines");
+    }
+
+    m_Options.Concurrency = std::clamp(m_Options.Concurrency, 1, std::max(m_Options.Games, 1));
+}
+
+auto MatchRunner::SetTablebaseProbe(TablebaseProbe probe) -> void {
+    m_TablebaseProbe = std::move(probe);
+}
+
+auto MatchRunner::Run() -> const MatchStatistics& {
+    LoadOpenings();
+
+    if (!m_Options.PgnPath.empty()) {
+        m_Pgn.open(m_Options.PgnPath, std::ios::app);
+
+        if (!m_Pgn) {
+            throw std::runtime_error("Failed to open " + m_Options.PgnPath);
+        }
+    }
+
+    {
+        std::vector<std::jthread> threads;
+
+        for (int i = 0; i < m_Options.Concurrency; i++) {
+            threads.emplace_back([this] { PlayGames(); });
+        }
+    }
+
+    switch (m_Statistics.GetVerdict()) {
+        case MatchStatistics::Verdict::AcceptH1:
+            std::cout << "SPRT: H1 was accepted" << std::endl;
+            break;
+        case MatchStatistics::Verdict::AcceptH0:
+            std::cout << "SPRT: H0 was accepted" << std::endl;
+            break;
+        default:
+            std::cout << "SPRT: no verdict" << std::endl;
+            break;
+    }
+
+    return m_Statistics;
+}
+
+auto MatchRunner::PlayGames() -> void {
+    if (Trace::IsEnabled()) {
+        Trace::SetThreadName("Match worker");
+    }
+
+    EngineProcess first(m_Options.First);
+    EngineProcess second(m_Options.Second);
+
+    try {
+        first.Start();
+        second.Start();
+
+        while (!m_Stop) {
+            const auto index = m_NextGame++;
+
+            if (index >= static_cast<size_t>(m_Options.Games)) {
+                break;
+            }
+
+            // Each opening is played twice so that both engines get both sides of it
+            Game game {
+                index, m_Openings[index / 2 % m_Openings.size()], index % 2 == 0,
+                {}, {}, GameResult::Draw, "", ""
+            };
+
+            first.NewGame();
+            second.NewGame();
+
+            PlayGame(game, game.FirstIsWhite ? std::array { &first, &second } : std::array { &second, &first });
+            RecordGame(game);
+        }
+    }
+    catch (const std::exception& e) {
+        std::lock_guard lock(m_ResultMutex);
+        std::cerr << e.what() << std::endl;
+        m_Stop = true;
+    }
+}
+
+auto MatchRunner::PlayGame(Game& game, const std::array<EngineProcess*, 2> engines) -> void {
+    TRACE_SCOPE_VALUE("Game", game.Index);
+
+    Board::SetState(game.Fen);
+
+    std::string position = "position fen " + game.Fen + " moves";
+    std::array clocks { m_Options.TimeMs, m_Options.TimeMs };
+
+    const auto forfeit = [&](const bool white, std::string termination, std::string reason) {
+        game.Result = white ? GameResult::BlackWins : GameResult::WhiteWins;
+        game.Termination = std::move(termination);
+        game.Reason = std::move(reason);
+    };
+
+    for (int plies = 0; !Adjudicate(game, plies); plies++) {
+        const bool white = Board::IsWhiteToMove();
+        auto& engine = *engines[white ? 0 : 1];
+        auto& clock = clocks[white ? 0 : 1];
+
+        std::ostringstream limits;
+        limits << "go";
+
+        if (m_Options.TimeMs > 0) {
+            limits << " wtime " << clocks[0] << " btime " << clocks[1]
+                << " winc " << m_Options.IncrementMs << " binc " << m_Options.IncrementMs;
+        }
+        if (m_Options.Nodes > 0) {
+            limits << " nodes " << m_Options.Nodes;
+        }
+        if (m_Options.Depth > 0) {
+            limits << " depth " << m_Options.Depth;
+        }
+
+        const int timeout = m_Options.TimeMs > 0 ? clock + m_Options.TimeMarginMs : UnlimitedMoveTimeoutMs;
+        const auto start = std::chrono::steady_clock::now();
+        const auto reply = engine.Go(plies > 0 ? position : "position fen " + game.Fen, limits.str(), timeout);
+        const auto elapsed = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+
+        if (!reply) {
+            if (m_Options.TimeMs > 0 && elapsed >= timeout) {
+                forfeit(white, "time forfeit", engine.GetName() + " loses on time");
+            }
+            else {
+                forfeit(white, "abandoned", engine.GetName() + " stopped responding");
+            }
+
+            engine.Restart();
+            return;
+        }
+
+        if (m_Options.TimeMs > 0) {
+            clock -= elapsed;
+
+            if (clock < -m_Options.TimeMarginMs) {
+                forfeit(white, "time forfeit", engine.GetName() + " loses on time");
+                return;
+            }
+
+            clock = std::max(clock, 0) + m_Options.IncrementMs;
+        }
+
+        const auto move = Board::FindMove(reply->BestMove);
+
+        if (!move) {
+            forfeit(white, "rules infraction", engine.GetName() + " plays an illegal move " + reply->BestMove);
+            return;
+        }
+
+        game.Moves.emplace_back(Notation::ToSan(*move));
+        game.Comments.emplace_back(reply->Score.empty() ? "" : reply->Score + "/" + std::to_string(reply->Depth)
+            + " " + std::to_string(elapsed) + "ms");
+
+        Board::MakeMove(*move);
+        position += ' ' + reply->BestMove;
+    }
+}
+
+auto MatchRunner::Adjudicate(Game& game, const int plies) const -> bool {
+    const auto finish = [&](const GameResult result, std::string termination, std::string reason) {
+        game.Result = result;
+        game.Termination = std::move(termination);
+        game.Reason = std::move(reason);
+        return true;
+    };
+
+    std::vector<Move> moves;
+    Board::GenerateMoves<Board::GenType::All>(moves);
+
+    if (moves.empty()) {
+        if (!Board::IsInCheck()) {
+            return finish(GameResult::Draw, "normal", "Draw by stalemate");
+        }
+
+        return Board::IsWhiteToMove()
+            ? finish(GameResult::BlackWins, "normal", "Black mates")
+            : finish(GameResult::WhiteWins, "normal", "White mates");
+    }
+
+    if (Board::GetHalfmoveClock() >= 100) {
+        return finish(GameResult::Draw, "normal", "Draw by fifty moves rule");
+    }
+
+    if (Board::IsRepetition()) {
+        return finish(GameResult::Draw, "normal", "Draw by 3-fold repetition");
+    }
+
+    if (IsInsufficientMaterial()) {
+        return finish(GameResult::Draw, "normal", "Draw by insufficient mating material");
+    }
+
+    if (m_TablebaseProbe) {
+        if (const auto result = m_TablebaseProbe()) {
+            return finish(result->Result, "adjudication", result->Reason);
+        }
+    }
+
+    if (m_Options.MaxPlies > 0 && plies >= m_Options.MaxPlies) {
+        return finish(GameResult::Draw, "adjudication", "Draw by move limit");
+    }
+
+    return false;
+}
+
+auto MatchRunner::RecordGame(const Game& game) -> void {
+    std::lock_guard lock(m_ResultMutex);
+
+    const bool firstWins = game.Result == (game.FirstIsWhite ? GameResult::WhiteWins : GameResult::BlackWins);
+    m_Statistics.AddResult(game.Result == GameResult::Draw ? 0.5 : firstWins ? 1.0 : 0.0);
+
+    if (m_Pgn.is_open()) {
+        WritePgn(game);
+    }
+
+    const auto& white = game.FirstIsWhite ? m_Options.First.Name : m_Options.Second.Name;
+    const auto& black = game.FirstIsWhite ? m_Options.Second.Name : m_Options.First.Name;
+
+    std::cout << "Finished game " << game.Index + 1 << " (" << white << " vs " << black << "): "
+        << ResultString(game.Result) << " {" << game.Reason << "}\n"
+        << "Score of " << m_Options.First.Name << " vs " << m_Options.Second.Name << ": "
+        << m_Statistics.ToString() << std::endl;
+
+    if (m_Options.StopOnVerdict && m_Statistics.GetVerdict() != MatchStatistics::Verdict::Continue) {
+        m_Stop = true;
+    }
+}
+
+auto MatchRunner::WritePgn(const Game& game) -> void {
+    TRACE_SCOPE_VALUE("WritePgn", game.Index);
+
+    const auto fields = Split(game.Fen);
+    const bool whiteStarts = fields.size() < 2 || fields[1] != "b";
+    int moveNumber = fields.size() >= 6 ? std::max(std::atoi(fields[5].c_str()), 1) : 1;
+
+    std::array<char, 16> date {};
+    const auto now = std::time(nullptr);
+    std::strftime(date.data(), date.size(), "%Y.%m.%d", std::localtime(&now));
+
+    m_Pgn << "[Event \"Match\"]\n"
+        << "[Site \"?\"]\n"
+        << "[Date \"" << date.data() << "\"]\n"
+        << "[Round \"" << game.Index + 1 << "\"]\n"
+        << "[White \"" << (game.FirstIsWhite ? m_Options.First.Name : m_Options.Second.Name) << "\"]\n"
+        << "[Black \"" << (game.FirstIsWhite ? m_Options.Second.Name : m_Options.First.Name) << "\"]\n"
+        << "[Result \"" << ResultString(game.Result) << "\"]\n";
+
+    if (game.Fen != Fen::StartPosition) {
+        m_Pgn << "[FEN \"" << game.Fen << "\"]\n"
+            << "[SetUp \"1\"]\n";
+    }
+
+    m_Pgn << "[PlyCount \"" << game.Moves.size() << "\"]\n"
+        << "[Termination \"" << game.Termination << "\"]\n\n";
+
+    // Wrap the movetext before 80 columns
+    size_t column = 0;
+    const auto write = [&](const std::string& token) {
+        if (column > 0 && column + token.size() + 1 > 79) {
+            m_Pgn << '\n';
+            column = 0;
+        }
+        else if (column > 0) {
+            m_Pgn << ' ';
+            column++;
+        }
+
+        m_Pgn << token;
+        column += token.size();
+    };
+
+    for (size_t i = 0; i < game.Moves.size(); i++) {
+        const bool whiteMove = (i % 2 == 0) == whiteStarts;
+
+        if (whiteMove) {
+            write(std::to_string(moveNumber) + ".");
+        }
+        else if (i == 0) {
+            write(std::to_string(moveNumber) + "...");
+        }
+
+        write(game.Moves[i]);
+
+        if (!game.Comments[i].empty()) {
+            write("{" + game.Comments[i] + "}");
+        }
+
+        if (!whiteMove) {
+            moveNumber++;
+        }
+    }
+
+    write("{" + game.Reason + "}");
+    write(std::string(ResultString(game.Result)));
+    m_Pgn << "\n\n" << std::flush;
+}
+
+auto MatchRunner::LoadOpenings() -> void {
+    TRACE_SCOPE("LoadOpenings");
+
+    m_Openings.clear();
+
+    if (m_Options.OpeningsPath.empty()) {
+        m_Openings.emplace_back(Fen::StartPosition);
+        return;
+    }
+
+    std::ifstream file(m_Options.OpeningsPath);
+
+    if (!file) {
+        throw std::runtime_error("Failed to open " + m_Options.OpeningsPath);
+    }
+
+    size_t number = 0;
+
+    for (std::string line; std::getline(file, line);) {
+        number++;
+
+        if (const auto first = line.find_first_not_of(" \t\r"); first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+
+        // EPD lines end in operations instead of the clocks
+        Fen::State state;
+
+        if (std::string_view operations; !Fen::Parse(line, state)) {
+            if (const auto result = Fen::ParseEpd(line, state, operations); !result) {
+                throw std::runtime_error(m_Options.OpeningsPath + ":" + std::to_string(number) + ": "
+                    + std::string(Fen::Describe(result.Code)) + " at column " + std::to_string(result.Offset + 1));
+            }
+        }
+
+        m_Openings.emplace_back(Fen::ToString(state));
+    }
+
+    if (m_Openings.empty()) {
+        throw std::runtime_error("No openings in " + m_Options.OpeningsPath);
+    }
+}
\ No newline at end of file
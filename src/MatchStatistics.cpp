@@ -0,0 +1,129 @@
+#include <pch.hpp>
+#include <MatchStatistics.hpp>
+
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    auto ScoreToElo(const double score) -> double {
+        const double clamped = std::clamp(score, 1e-6, 1.0 - 1e-6);
+        return -400.0 * std::log10(1.0 / clamped - 1.0);
+    }
+
+    auto EloToScore(const double elo) -> double {
+        return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+    }
+}
+
+MatchStatistics::MatchStatistics(const double elo0, const double elo1, const double alpha, const double beta) :
+    m_Elo0(elo0), m_Elo1(elo1), m_Alpha(alpha), m_Beta(beta) {
+    if (alpha <= 0.0 || alpha >= 1.0 || beta <= 0.0 || beta >= 1.0) {
+        throw std::invalid_argument("SPRT error probabilities must be in range (0, 1)");
+    }
+}
+
+auto MatchStatistics::AddResult(const double score) -> void {
+    if (score > 0.75) {
+        m_Wins++;
+    }
+    else if (score < 0.25) {
+        m_Losses++;
+    }
+    else {
+        m_Draws++;
+    }
+}
+
+auto MatchStatistics::GetWins() const noexcept -> int {
+    return m_Wins;
+}
+
+auto MatchStatistics::GetDraws() const noexcept -> int {
+    return m_Draws;
+}
+
+auto MatchStatistics::GetLosses() const noexcept -> int {
+    return m_Losses;
+}
+
+auto MatchStatistics::GetGames() const noexcept -> int {
+    return m_Wins + m_Draws + m_Losses;
+}
+
+auto MatchStatistics::GetScore() const -> double {
+    const int games = GetGames();
+    return games > 0 ? (m_Wins + 0.5 * m_Draws) / games : 0.5;
+}
+
+auto MatchStatistics::GetElo() const -> double {
+    return ScoreToElo(GetScore());
+}
+
+auto MatchStatistics::GetEloError() const -> double {
+    const int games = GetGames();
+
+    if (games == 0) {
+        return 0.0;
+    }
+
+    // 1.96 standard errors of the mean score cover 95% of the normal distribution
+    const double margin = 1.959964 * std::sqrt(GetVariance() / games);
+    const double score = GetScore();
+    return (ScoreToElo(score + margin) - ScoreToElo(score - margin)) / 2.0;
+}
+
+auto MatchStatistics::GetLlr() const -> double {
+    const double variance = GetVariance();
+
+    if (variance <= 0.0) {
+        return 0.0;
+    }
+
+    const double score0 = EloToScore(m_Elo0);
+    const double score1 = EloToScore(m_Elo1);
+    return (score1 - score0) * (2.0 * GetScore() - score0 - score1) * GetGames() / (2.0 * variance);
+}
+
+auto MatchStatistics::GetLowerBound() const -> double {
+    return std::log(m_Beta / (1.0 - m_Alpha));
+}
+
+auto MatchStatistics::GetUpperBound() const -> double {
+    return std::log((1.0 - m_Beta) / m_Alpha);
+}
+
+auto MatchStatistics::GetVerdict() const -> Verdict {
+    const double llr = GetLlr();
+
+    if (llr >= GetUpperBound()) {
+        return Verdict::AcceptH1;
+    }
+
+    if (llr <= GetLowerBound()) {
+        return Verdict::AcceptH0;
+    }
+
+    return Verdict::Continue;
+}
+
+auto MatchStatistics::ToString() const -> std::string {
+    std::ostringstream line;
+    line << std::fixed
+        << m_Wins << " - " << m_Losses << " - " << m_Draws
+        << " [" << std::setprecision(3) << GetScore() << "] " << GetGames()
+        << std::setprecision(1) << "  Elo: " << GetElo() << " +/- " << GetEloError()
+        << std::setprecision(2) << "  LLR: " << GetLlr() << " (" << GetLowerBound() << ", " << GetUpperBound() << ")"
+        << std::setprecision(1) << " [" << m_Elo0 << ", " << m_Elo1 << "]";
+    return line.str();
+}
+
+auto MatchStatistics::GetVariance() const -> double {
+    const int games = GetGames();
+
+    if (games == 0) {
+        return 0.0;
+    }
+
+    const double score = GetScore();
+    return (m_Wins * std::pow(1.0 - score, 2) + m_Draws * std::pow(0.5 - score, 2) + m_Losses * std::pow(score, 2)) / games;
+}
\ No newline at end of file
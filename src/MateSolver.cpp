@@ -0,0 +1,530 @@
+#include <pch.hpp>
+#include <MateSolver.hpp>
+#include <LargePageBuffer.hpp>
+#include <Trace.hpp>
+
+#include <bit>
+#include <thread>
+
+namespace {
+    /// <summary>
+    /// Proof and disproof numbers saturate here, a node with an infinite number is solved
+    /// </summary>
+    constexpr uint32_t Infinity = 100'000'000;
+
+    constexpr int MaxPly = 128;
+
+    /// <summary>
+    /// The proof number a move of the attacker starts with when it does not give check. Checks are
+    /// tried first as they leave the defender the fewest answers
+    /// </summary>
+    constexpr uint32_t QuietProof = 3;
+
+    auto Add(const uint32_t a, const uint32_t b) -> uint32_t {
+        return static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(a) + b, Infinity));
+    }
+
+    auto Clamp(const int64_t value) -> uint32_t {
+        return static_cast<uint32_t>(std::clamp<int64_t>(value, 0, Infinity));
+    }
+
+    /// <summary>
+    /// Proof numbers in negamax form, seen from the side to move. Phi is the cost of proving that the side
+    /// to move reaches its goal, delta the cost of proving that it does not. The goal of the attacker is
+    /// to mate, the goal of the defender is to avoid it
+    /// </summary>
+    struct Numbers {
+        uint32_t Phi;
+        uint32_t Delta;
+    };
+
+    constexpr Numbers Win { 0, Infinity };
+    constexpr Numbers Loss { Infinity, 0 };
+}
+
+/// <summary>
+/// The search state of a single thread and its transposition table
+/// </summary>
+class MateSolver::Worker final {
+public:
+    Worker(MateSolver& solver, const size_t megabytes) : m_Solver(solver) {
+        const size_t buckets = std::max<size_t>(megabytes * 1024 * 1024 / sizeof(Bucket), 1);
+
+        // A power of two lets the bucket index be masked out of the hash
+        m_BucketCount = std::bit_floor(buckets);
+        m_Memory = LargePageBuffer(m_BucketCount * sizeof(Bucket));
+        m_Buckets = static_cast<Bucket*>(m_Memory.Get());
+        std::uninitialized_default_construct_n(m_Buckets, m_BucketCount);
+
+        for (auto& moves : m_Moves) {
+            moves.reserve(64);
+        }
+    }
+
+    /// <summary>
+    /// Searches the position on the board of the calling thread until it is solved or the search is stopped
+    /// </summary>
+    /// <param name="rootShare"><c>int</c> Only root moves with an index of <c>rootIndex</c> modulo this are searched</param>
+    auto Prove(const bool attackerWhite, const int plies, const int rootIndex, const int rootShare) -> Numbers {
+        m_AttackerWhite = attackerWhite;
+        m_RootIndex = rootIndex;
+        m_RootShare = rootShare;
+
+        const auto numbers = Mid({ Infinity, Infinity }, plies, 0);
+        Flush();
+        return numbers;
+    }
+
+    /// <summary>
+    /// Looks up the numbers of a position with a number of plies left
+    /// </summary>
+    [[nodiscard]] auto Probe(const uint64_t hash, const int remaining) const -> std::optional<std::pair<Numbers, uint32_t>> {
+        for (const auto& entry : GetBucket(hash).Entries) {
+            if (entry.Work != 0 && entry.Hash == hash && entry.Remaining == remaining) {
+                return std::pair { Numbers { entry.Phi, entry.Delta }, entry.Work };
+            }
+        }
+
+        return std::nullopt;
+    }
+
+private:
+    /// <summary>
+    /// The numbers and search effort of a position with a number of plies left. An empty entry has no work
+    /// </summary>
+    struct Entry {
+        uint64_t Hash;
+        uint32_t Phi;
+        uint32_t Delta;
+        uint32_t Work;
+        uint16_t Remaining;
+    };
+
+    /// <summary>
+    /// The entry that took the least work to compute is replaced first
+    /// </summary>
+    struct Bucket {
+        std::array<Entry, 4> Entries;
+    };
+
+    /// <summary>
+    /// Multiple iterative deepening: expands the most proving child until the numbers of the node
+    /// exceed a threshold, so that the search only leaves a subtree when another one becomes more promising
+    /// </summary>
+    auto Mid(const Numbers threshold, const int remaining, const int ply) -> Numbers {
+        const uint64_t work = m_LocalNodes;
+        CountNode();
+
+        const bool attacker = Board::IsWhiteToMove() == m_AttackerWhite;
+
+        // A cycle never mates. The result depends on the path, so it is passed up marked as such
+        if (ply > 0 && Board::IsRepetition(ply)) {
+            m_PathDependent = true;
+            return attacker ? Loss : Win;
+        }
+
+        m_PathDependent = false;
+
+        if (attacker && remaining == 0) {
+            return Store(Loss, remaining, work);
+        }
+
+        auto& moves = m_Moves[ply];
+        Board::GenerateMoves<Board::GenType::All>(moves);
+
+        if (moves.empty()) {
+            return Store(attacker || Board::IsInCheck() ? Loss : Win, remaining, work);
+        }
+
+        // The attacker has run out of moves, the defender escaped
+        if (remaining == 0 || ply >= MaxPly - 1) {
+            return Store(attacker ? Loss : Win, remaining, work);
+        }
+
+        if (ply == 0 && m_RootShare > 1) {
+            size_t index = 0;
+            std::erase_if(moves, [&](const Move&) -> bool {
+                return static_cast<int>(index++ % m_RootShare) != m_RootIndex;
+            });
+        }
+
+        auto& children = m_Children[ply];
+        auto& dependent = m_Dependent[ply];
+        children.resize(moves.size());
+        dependent.assign(moves.size(), 0);
+
+        for (size_t i = 0; i < moves.size(); i++) {
+            Board::MakeMove(moves[i]);
+
+            if (const auto entry = Probe(Board::GetHash(), remaining - 1)) {
+                children[i] = entry->first;
+            }
+            else if (attacker && !Board::IsInCheck()) {
+                // The last move of the attacker has to be a check, a quiet move can be thrown out right away
+                children[i] = remaining == 1 ? Win : Numbers { 1, QuietProof };
+            }
+            else {
+                children[i] = { 1, 1 };
+            }
+
+            Board::UnmakeMove(moves[i]);
+        }
+
+        Numbers numbers;
+
+        while (true) {
+            numbers = { Infinity, 0 };
+            size_t best = 0;
+            uint32_t secondDelta = Infinity;
+
+            // The side to move reaches its goal through any child, and misses it only if every child does
+            for (size_t i = 0; i < children.size(); i++) {
+                if (children[i].Delta < numbers.Phi) {
+                    secondDelta = numbers.Phi;
+                    numbers.Phi = children[i].Delta;
+                    best = i;
+                }
+                else {
+                    secondDelta = std::min(secondDelta, children[i].Delta);
+                }
+
+                numbers.Delta = Add(numbers.Delta, children[i].Phi);
+            }
+
+            if (numbers.Phi >= threshold.Phi || numbers.Delta >= threshold.Delta || Stopped()) {
+                break;
+            }
+
+            const Numbers childThreshold {
+                Clamp(static_cast<int64_t>(threshold.Delta) - numbers.Delta + children[best].Phi),
+                std::min(threshold.Phi, Add(secondDelta, 1))
+            };
+
+            Board::MakeMove(moves[best]);
+            children[best] = Mid(childThreshold, remaining - 1, ply + 1);
+            dependent[best] = m_PathDependent ? 1 : 0;
+            Board::UnmakeMove(moves[best]);
+        }
+
+        // A won node holds for every path when one of the children it wins through does, a lost node only when all
+        // of its children do. Unsolved numbers are estimates that cannot solve the parent, so they do not carry
+        // the mark
+        m_PathDependent = false;
+
+        if (numbers.Phi == 0) {
+            m_PathDependent = true;
+
+            for (size_t i = 0; i < children.size(); i++) {
+                if (children[i].Delta == 0 && dependent[i] == 0) {
+                    m_PathDependent = false;
+                    break;
+                }
+            }
+        }
+        else if (numbers.Delta == 0) {
+            m_PathDependent = std::ranges::any_of(dependent, [](const uint8_t marked) { return marked != 0; });
+        }
+
+        // The root only covers the share of moves of this thread, its numbers are not those of the position.
+        // A result that relies on a repetition earlier in the path would be wrong when the node is reached
+        // another way, it is searched again rather than stored
+        return ply > 0 && !m_PathDependent ? Store(numbers, remaining, work) : numbers;
+    }
+
+    auto Store(const Numbers numbers, const int remaining, const uint64_t workBefore) -> Numbers {
+        const uint64_t hash = Board::GetHash();
+        const auto work = static_cast<uint32_t>(std::clamp<uint64_t>(m_LocalNodes - workBefore, 1, UINT32_MAX));
+        auto& entries = GetBucket(hash).Entries;
+
+        auto* slot = &entries.front();
+
+        for (auto& entry : entries) {
+            if (entry.Hash == hash && entry.Remaining == remaining) {
+                slot = &entry;
+                break;
+            }
+
+            if (entry.Work < slot->Work) {
+                slot = &entry;
+            }
+        }
+
+        *slot = { hash, numbers.Phi, numbers.Delta, work, static_cast<uint16_t>(remaining) };
+        return numbers;
+    }
+
+    [[nodiscard]] auto GetBucket(const uint64_t hash) const -> Bucket& {
+        return m_Buckets[hash & (m_BucketCount - 1)];
+    }
+
+    [[nodiscard]] auto Stopped() const -> bool {
+        return m_Solver.m_Stop.load(std::memory_order_relaxed) || m_Solver.m_Decided.load(std::memory_order_relaxed);
+    }
+
+    auto CountNode() -> void {
+        // The shared counter is only updated in batches to keep the threads off each other's cache lines
+        if ((++m_LocalNodes & 1023) == 0) {
+            Flush();
+        }
+    }
+
+    auto Flush() -> void {
+        const auto nodes = m_Solver.m_Nodes.fetch_add(m_LocalNodes - m_FlushedNodes, std::memory_order_relaxed)
+            + m_LocalNodes - m_FlushedNodes;
+        m_FlushedNodes = m_LocalNodes;
+
+        if (m_Solver.m_NodeLimit > 0 && nodes >= m_Solver.m_NodeLimit) {
+            m_Solver.m_Stop = true;
+        }
+    }
+
+    MateSolver& m_Solver;
+
+    LargePageBuffer m_Memory;
+    Bucket* m_Buckets = nullptr;
+    size_t m_BucketCount = 0;
+
+    bool m_AttackerWhite = true;
+    int m_RootIndex = 0;
+    int m_RootShare = 1;
+
+    uint64_t m_LocalNodes = 0;
+    uint64_t m_FlushedNodes = 0;
+
+    std::array<std::vector<Move>, MaxPly> m_Moves;
+    std::array<std::vector<Numbers>, MaxPly> m_Children;
+
+    /// <summary>
+    /// Whether the solved numbers of a child rely on a repetition of a position above it in the path
+    /// </summary>
+    std::array<std::vector<uint8_t>, MaxPly> m_Dependent;
+
+    /// <summary>
+    /// Set by <c>Mid</c> when the numbers it returns rely on a repetition of a position above the node
+    /// </summary>
+    bool m_PathDependent = false;
+};
+
+MateSolver::MateSolver(const size_t megabytes) : m_Megabytes(std::max<size_t>(megabytes, 1)) {}
+
+MateSolver::~MateSolver() = default;
+
+auto MateSolver::Solve(const std::string_view fen, const Board::Color attacker, const Options& options) -> Solution {
+    TRACE_SCOPE("MateSolve");
+
+    if (options.Depth < 1) {
+        throw std::invalid_argument("The depth must be at least one move");
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    Board::SetState(fen);
+
+    const bool attackerWhite = attacker == Board::Color::White;
+    const bool attackerToMove = Board::IsWhiteToMove() == attackerWhite;
+    const int threads = std::max(options.Threads, 1);
+
+    if (static_cast<int>(m_Workers.size()) != threads) {
+        m_Workers.clear();
+
+        for (int i = 0; i < threads; i++) {
+            m_Workers.emplace_back(std::make_unique<Worker>(*this, m_Megabytes / threads));
+        }
+    }
+
+    m_Nodes = 0;
+    m_NodeLimit = options.Nodes;
+    m_Stop = false;
+
+    Solution solution;
+    solution.Outcome = Result::Disproven;
+
+    std::vector<Move> moves;
+    Board::GenerateMoves<Board::GenType::All>(moves);
+
+    // The defender is already mated, which is a mate in no moves with an empty line
+    const bool mated = !attackerToMove && moves.empty() && Board::IsInCheck();
+
+    if (mated) {
+        solution.Outcome = Result::Proven;
+    }
+
+    for (int depth = options.Shortest ? 1 : options.Depth; depth <= options.Depth && !mated; depth++) {
+        // The defender moves first when it is to move, so the attacker gets the same number of moves
+        const int plies = attackerToMove ? depth * 2 - 1 : depth * 2;
+        const auto result = SolveDepth(fen, attackerWhite, plies, threads);
+
+        if (result == Result::Disproven) {
+            continue;
+        }
+
+        solution.Outcome = result;
+
+        if (result == Result::Proven) {
+            solution.MateIn = depth;
+            solution.Line = ExtractLine(fen, attackerWhite, plies);
+
+            // A proof that does not survive being replayed is not reported as one
+            if (solution.Line.empty()) {
+                solution.Outcome = Result::Unknown;
+                solution.MateIn = 0;
+            }
+        }
+
+        break;
+    }
+
+    Board::SetState(fen);
+
+    solution.Nodes = m_Nodes.load();
+    solution.Milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    return solution;
+}
+
+auto MateSolver::Stop() -> void {
+    m_Stop = true;
+}
+
+auto MateSolver::GetName(const Result result) -> std::string_view {
+    switch (result) {
+        case Result::Proven: return "proven";
+        case Result::Disproven: return "disproven";
+        default: return "unknown";
+    }
+}
+
+auto MateSolver::SolveDepth(const std::string_view fen, const bool attackerWhite, const int plies, const int threads) -> Result {
+    const bool attackerToMove = Board::IsWhiteToMove() == attackerWhite;
+    std::vector<Numbers> results(threads);
+    m_Decided = false;
+
+    {
+        std::vector<std::jthread> helpers;
+
+        const auto run = [&](const int i) -> void {
+            Board::SetState(fen);
+            results[i] = m_Workers[i]->Prove(attackerWhite, plies, i, threads);
+
+            // One share decides the whole root when the side to move reaches its goal with it, or
+            // when the defender is to move and escapes with it
+            if (results[i].Phi == 0) {
+                m_Decided = true;
+            }
+        };
+
+        for (int i = 1; i < threads; i++) {
+            helpers.emplace_back([&run, i] {
+                if (Trace::IsEnabled()) {
+                    Trace::SetThreadName("Mate solver " + std::to_string(i));
+                }
+
+                run(i);
+            });
+        }
+
+        run(0);
+    }
+
+    Board::SetState(fen);
+
+    const bool anyWin = std::ranges::any_of(results, [](const Numbers& numbers) { return numbers.Phi == 0; });
+    const bool allLost = std::ranges::all_of(results, [](const Numbers& numbers) { return numbers.Delta == 0; });
+
+    if (anyWin) {
+        return attackerToMove ? Result::Proven : Result::Disproven;
+    }
+
+    if (allLost) {
+        return attackerToMove ? Result::Disproven : Result::Proven;
+    }
+
+    return Result::Unknown;
+}
+
+auto MateSolver::ExtractLine(const std::string_view fen, const bool attackerWhite, const int plies) -> std::vector<Move> {
+    // Solving a node again is cheap once it has been proven, and it must not be cut short
+    m_Stop = false;
+    m_Decided = false;
+    m_NodeLimit = 0;
+
+    Board::SetState(fen);
+
+    std::vector<Move> line;
+    std::vector<Move> moves;
+
+    for (int remaining = plies; remaining > 0; remaining--) {
+        Board::GenerateMoves<Board::GenType::All>(moves);
+
+        if (moves.empty()) {
+            break;
+        }
+
+        const bool attacker = Board::IsWhiteToMove() == attackerWhite;
+        std::optional<Move> choice;
+        uint32_t choiceWork = 0;
+
+        for (const auto& move : moves) {
+            Board::MakeMove(move);
+
+            const auto probe = [&]() -> std::optional<std::pair<Numbers, uint32_t>> {
+                for (const auto& worker : m_Workers) {
+                    if (const auto entry = worker->Probe(Board::GetHash(), remaining - 1); entry && (entry->first.Phi == 0 || entry->first.Delta == 0)) {
+                        return entry;
+                    }
+                }
+
+                return std::nullopt;
+            };
+
+            auto entry = probe();
+
+            // A child the tables lost track of is solved again by the first thread
+            if (!entry) {
+                entry = std::pair { m_Workers.front()->Prove(attackerWhite, remaining - 1, 0, 1), 0U };
+            }
+
+            Board::UnmakeMove(move);
+
+            if (!entry) {
+                continue;
+            }
+
+            const auto [numbers, work] = *entry;
+
+            // The attacker plays a move the defender loses after, taking the quickest one to prove.
+            // The defender resists with the move whose proof took the most work
+            if (attacker && numbers.Delta == 0 && (!choice || work < choiceWork)) {
+                choice = move;
+                choiceWork = work;
+            }
+            else if (!attacker && numbers.Phi == 0 && (!choice || work > choiceWork)) {
+                choice = move;
+                choiceWork = work;
+            }
+        }
+
+        if (!choice) {
+            return {};
+        }
+
+        line.push_back(*choice);
+        Board::MakeMove(*choice);
+    }
+
+    // The line has to be legal from the start and end with the defender mated
+    Board::SetState(fen);
+
+    for (const auto& move : line) {
+        Board::GenerateMoves<Board::GenType::All>(moves);
+
+        if (std::ranges::find(moves, move) == moves.end()) {
+            return {};
+        }
+
+        Board::MakeMove(move);
+    }
+
+    Board::GenerateMoves<Board::GenType::All>(moves);
+    const bool mated = moves.empty() && Board::IsInCheck() && Board::IsWhiteToMove() != attackerWhite;
+
+    return mated ? line : std::vector<Move> {};
+}
\ No newline at end of file
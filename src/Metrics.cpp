@@ -0,0 +1,200 @@
+#include <pch.hpp>
+#include <Metrics.hpp>
+
+#include <sstream>
+
+MetricsRegistry::ThreadData::ThreadData() {
+    std::lock_guard lock(s_Mutex);
+    s_Threads.push_back(this);
+}
+
+MetricsRegistry::ThreadData::~ThreadData() {
+    std::lock_guard lock(s_Mutex);
+    Merge(*this, s_Retired);
+    std::erase(s_Threads, this);
+}
+
+auto MetricsRegistry::Snapshot() -> MetricsSnapshot {
+    std::lock_guard lock(s_Mutex);
+
+    auto snapshot = s_Retired;
+    snapshot.Enabled = true;
+
+    for (const auto* data : s_Threads) {
+        Merge(*data, snapshot);
+    }
+
+    return snapshot;
+}
+
+auto MetricsRegistry::Reset() -> void {
+    std::lock_guard lock(s_Mutex);
+
+    s_Retired = {};
+
+    for (auto* data : s_Threads) {
+        for (auto& counter : data->Counters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+
+        for (auto& histogram : data->Histograms) {
+            histogram.Count.store(0, std::memory_order_relaxed);
+            histogram.Sum.store(0, std::memory_order_relaxed);
+            histogram.Min.store(UINT64_MAX, std::memory_order_relaxed);
+            histogram.Max.store(0, std::memory_order_relaxed);
+
+            for (auto& bucket : histogram.Buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+auto MetricsRegistry::Merge(const ThreadData& data, MetricsSnapshot& snapshot) -> void {
+    for (size_t i = 0; i < data.Counters.size(); i++) {
+        snapshot.Counters[i] += data.Counters[i].load(std::memory_order_relaxed);
+    }
+
+    for (size_t i = 0; i < data.Histograms.size(); i++) {
+        const auto& source = data.Histograms[i];
+        auto& target = snapshot.Histograms[i];
+
+        const auto count = source.Count.load(std::memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+
+        const auto min = source.Min.load(std::memory_order_relaxed);
+        const auto max = source.Max.load(std::memory_order_relaxed);
+        target.Min = target.Count == 0 ? min : std::min(target.Min, min);
+        target.Max = target.Count == 0 ? max : std::max(target.Max, max);
+        target.Count += count;
+        target.Sum += source.Sum.load(std::memory_order_relaxed);
+
+        for (size_t bucket = 0; bucket < target.Buckets.size(); bucket++) {
+            target.Buckets[bucket] += source.Buckets[bucket].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+auto MetricsSnapshot::HistogramData::Percentile(const double fraction) const -> uint64_t {
+    if (Count == 0) {
+        return 0;
+    }
+
+    const auto rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(Count)));
+    uint64_t seen = 0;
+
+    for (size_t bucket = 0; bucket < Buckets.size(); bucket++) {
+        seen += Buckets[bucket];
+
+        if (seen >= std::max<uint64_t>(rank, 1)) {
+            // The upper bound of a bucket, never beyond the largest recorded value
+            return bucket == 0 ? 0 : std::min(Max, (uint64_t { 1 } << bucket) - 1);
+        }
+    }
+
+    return Max;
+}
+
+auto MetricsSnapshot::Get(const Counter counter) const -> uint64_t {
+    return Counters[static_cast<size_t>(counter)];
+}
+
+auto MetricsSnapshot::Get(const Histogram histogram) const -> const HistogramData& {
+    return Histograms[static_cast<size_t>(histogram)];
+}
+
+auto MetricsSnapshot::ToText() const -> std::string {
+    std::ostringstream text;
+
+    if (!Enabled) {
+        text << "metrics disabled, configure with -DCHESS_METRICS=ON\n";
+        return text.str();
+    }
+
+    for (size_t i = 0; i < Counters.size(); i++) {
+        text << GetName(static_cast<Counter>(i)) << ' ' << Counters[i] << '\n';
+    }
+
+    const auto probes = Get(Counter::TTProbes);
+    if (probes > 0) {
+        text << "tt_hit_rate " << static_cast<double>(Get(Counter::TTHits)) / static_cast<double>(probes) << '\n';
+    }
+
+    const auto cutoffs = Get(Counter::BetaCutoffs);
+    if (cutoffs > 0) {
+        text << "first_move_cutoff_rate " << static_cast<double>(Get(Counter::FirstMoveCutoffs)) / static_cast<double>(cutoffs) << '\n';
+    }
+
+    for (size_t i = 0; i < Histograms.size(); i++) {
+        const auto& histogram = Histograms[i];
+        text << GetName(static_cast<Histogram>(i)) << " count " << histogram.Count;
+
+        if (histogram.Count > 0) {
+            text << " mean " << static_cast<double>(histogram.Sum) / static_cast<double>(histogram.Count)
+                << " min " << histogram.Min
+                << " p50 " << histogram.Percentile(0.5)
+                << " p99 " << histogram.Percentile(0.99)
+                << " max " << histogram.Max;
+        }
+
+        text << '\n';
+    }
+
+    return text.str();
+}
+
+auto MetricsSnapshot::ToJson() const -> std::string {
+    std::ostringstream json;
+    json << "{\"enabled\":" << (Enabled ? "true" : "false") << ",\"counters\":{";
+
+    for (size_t i = 0; i < Counters.size(); i++) {
+        json << (i > 0 ? "," : "") << '"' << GetName(static_cast<Counter>(i)) << "\":" << Counters[i];
+    }
+
+    json << "},\"histograms\":{";
+
+    for (size_t i = 0; i < Histograms.size(); i++) {
+        const auto& histogram = Histograms[i];
+        json << (i > 0 ? "," : "") << '"' << GetName(static_cast<Histogram>(i)) << "\":{"
+            << "\"count\":" << histogram.Count
+            << ",\"sum\":" << histogram.Sum
+            << ",\"min\":" << histogram.Min
+            << ",\"max\":" << histogram.Max
+            << ",\"p50\":" << histogram.Percentile(0.5)
+            << ",\"p99\":" << histogram.Percentile(0.99)
+            << ",\"buckets\":[";
+
+        for (size_t bucket = 0; bucket < histogram.Buckets.size(); bucket++) {
+            json << (bucket > 0 ? "," : "") << histogram.Buckets[bucket];
+        }
+
+        json << "]}";
+    }
+
+    json << "}}";
+    return json.str();
+}
+
+auto MetricsSnapshot::GetName(const Counter counter) -> std::string_view {
+    switch (counter) {
+        case Counter::MovegenCalls: return "movegen_calls";
+        case Counter::MovesGenerated: return "moves_generated";
+        case Counter::MakeMoves: return "make_moves";
+        case Counter::UnmakeMoves: return "unmake_moves";
+        case Counter::TTProbes: return "tt_probes";
+        case Counter::TTHits: return "tt_hits";
+        case Counter::EvalCalls: return "eval_calls";
+        case Counter::BetaCutoffs: return "beta_cutoffs";
+        case Counter::FirstMoveCutoffs: return "first_move_cutoffs";
+        default: return "unknown";
+    }
+}
+
+auto MetricsSnapshot::GetName(const Histogram histogram) -> std::string_view {
+    switch (histogram) {
+        case Histogram::FrameTimeMicroseconds: return "frame_time_us";
+        default: return "unknown";
+    }
+}
\ No newline at end of file
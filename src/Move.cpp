@@ -1,2 +1,21 @@
 #include <pch.hpp>
-#include <Move.hpp>
\ No newline at end of file
+#include <Move.hpp>
+#include <Piece.hpp>
+
+auto Move::ToString() const -> std::string {
+	std::string notation {
+		static_cast<char>('a' + From.x), static_cast<char>('1' + From.y),
+		static_cast<char>('a' + To.x), static_cast<char>('1' + To.y)
+	};
+
+	if (Type == MoveType::Promotion || Type == MoveType::PromotionCapture) {
+		switch (Promotion) {
+			case PieceFlag::Knight: notation += 'n'; break;
+			case PieceFlag::Bishop: notation += 'b'; break;
+			case PieceFlag::Rook: notation += 'r'; break;
+			default: notation += 'q'; break;
+		}
+	}
+
+	return notation;
+}
\ No newline at end of file
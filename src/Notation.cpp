@@ -0,0 +1,174 @@
+#include <pch.hpp>
+#include <Notation.hpp>
+#include <Board.hpp>
+#include <Piece.hpp>
+#include <Move.hpp>
+
+using MoveType = Move::MoveType;
+
+namespace {
+    auto PieceLetter(const PieceFlag type) -> char {
+        if ((type & PieceFlag::Knight) == PieceFlag::Knight) return 'N';
+        if ((type & PieceFlag::Bishop) == PieceFlag::Bishop) return 'B';
+        if ((type & PieceFlag::Rook) == PieceFlag::Rook) return 'R';
+        if ((type & PieceFlag::Queen) == PieceFlag::Queen) return 'Q';
+        if ((type & PieceFlag::King) == PieceFlag::King) return 'K';
+        return '\0';
+    }
+
+    auto SquareName(const Position& square) -> std::string {
+        return { static_cast<char>('a' + square.x), static_cast<char>('1' + square.y) };
+    }
+
+    auto PieceFromLetter(const char letter) -> PieceFlag {
+        switch (letter) {
+            case 'N': return PieceFlag::Knight;
+            case 'B': return PieceFlag::Bishop;
+            case 'R': return PieceFlag::Rook;
+            case 'Q': return PieceFlag::Queen;
+            case 'K': return PieceFlag::King;
+            default: return PieceFlag::None;
+        }
+    }
+}
+
+auto Notation::ToSan(const Move& move) -> std::string {
+    std::vector<Move> moves;
+    Board::GenerateMoves<Board::GenType::All>(moves);
+
+    const auto type = Board::GetPiece(move.From).GetType();
+    const auto letter = PieceLetter(type);
+    const bool capture = move.Type == MoveType::Capture || move.Type == MoveType::PromotionCapture || move.Type == MoveType::EnPassant;
+
+    std::string san;
+
+    if (move.Type == MoveType::Castle) {
+        san = move.To.x > move.From.x ? "O-O" : "O-O-O";
+    }
+    else if (letter == '\0') {
+        // Pawn captures always name the file they come from
+        if (capture) {
+            san += static_cast<char>('a' + move.From.x);
+            san += 'x';
+        }
+
+        san += SquareName(move.To);
+
+        if (move.Type == MoveType::Promotion || move.Type == MoveType::PromotionCapture) {
+            san += '=';
+            san += PieceLetter(move.Promotion != PieceFlag::None ? move.Promotion : PieceFlag::Queen);
+        }
+    }
+    else {
+        san += letter;
+
+        // Name the file, the rank or both when another piece of the same kind can reach the square
+        bool ambiguous = false, sameFile = false, sameRank = false;
+
+        for (const auto& other : moves) {
+            if (other.To != move.To || other.From == move.From || Board::GetPiece(other.From).GetType() != type) {
+                continue;
+            }
+
+            ambiguous = true;
+            sameFile |= other.From.x == move.From.x;
+            sameRank |= other.From.y == move.From.y;
+        }
+
+        if (ambiguous) {
+            if (!sameFile) {
+                san += static_cast<char>('a' + move.From.x);
+            }
+            else if (!sameRank) {
+                san += static_cast<char>('1' + move.From.y);
+            }
+            else {
+                san += SquareName(move.From);
+            }
+        }
+
+        if (capture) {
+            san += 'x';
+        }
+
+        san += SquareName(move.To);
+    }
+
+    Board::MakeMove(move);
+
+    if (Board::IsInCheck()) {
+        Board::GenerateMoves<Board::GenType::Evasions>(moves);
+        san += moves.empty() ? '#' : '+';
+    }
+
+    Board::UnmakeMove(move);
+    return san;
+}
+
+auto Notation::FromSan(std::string_view san) -> std::optional<Move> {
+    while (!san.empty() && std::string_view("+#!?").find(san.back()) != std::string_view::npos) {
+        san.remove_suffix(1);
+    }
+
+    // Reused between calls, replaying a game parses every one of its moves
+    thread_local std::vector<Move> moves;
+    moves.clear();
+    Board::GenerateMoves<Board::GenType::All>(moves);
+
+    const auto unique = [&](auto&& matches) -> std::optional<Move> {
+        std::optional<Move> found;
+
+        for (const auto& move : moves) {
+            if (matches(move)) {
+                if (found) {
+                    return std::nullopt;
+                }
+                found = move;
+            }
+        }
+
+        return found;
+    };
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        const int file = san.size() == 3 ? 6 : 2;
+        return unique([&](const Move& move) { return move.Type == MoveType::Castle && move.To.x == file; });
+    }
+
+    auto piece = PieceFlag::Pawn;
+    if (!san.empty() && PieceFromLetter(san.front()) != PieceFlag::None) {
+        piece = PieceFromLetter(san.front());
+        san.remove_prefix(1);
+    }
+
+    auto promotion = PieceFlag::None;
+    if (piece == PieceFlag::Pawn && !san.empty() && PieceFromLetter(san.back()) != PieceFlag::None) {
+        promotion = PieceFromLetter(san.back());
+        san.remove_suffix(san.size() >= 2 && san[san.size() - 2] == '=' ? 2 : 1);
+    }
+
+    if (san.size() < 2 || san[san.size() - 2] < 'a' || san[san.size() - 2] > 'h' || san.back() < '1' || san.back() > '8') {
+        return std::nullopt;
+    }
+
+    const Position to { san[san.size() - 2] - 'a', san.back() - '1' };
+    san.remove_suffix(2);
+
+    // What is left names the file or rank the piece comes from, and the capture
+    int fromFile = -1, fromRank = -1;
+
+    for (const char c : san) {
+        if (c >= 'a' && c <= 'h') fromFile = c - 'a';
+        else if (c >= '1' && c <= '8') fromRank = c - '1';
+        else if (c != 'x' && c != ':' && c != '-') return std::nullopt;
+    }
+
+    return unique([&](const Move& move) {
+        const bool promotes = move.Type == MoveType::Promotion || move.Type == MoveType::PromotionCapture;
+
+        return move.To == to && move.Type != MoveType::Castle
+            && Board::GetPiece(move.From).Is(piece)
+            && (fromFile < 0 || move.From.x == fromFile) && (fromRank < 0 || move.From.y == fromRank)
+            && (promotes ? move.Promotion == promotion : promotion == PieceFlag::None);
+    });
+}
\ No newline at end of file
@@ -0,0 +1,609 @@
+#include <pch.hpp>
+#include <PatternIndex.hpp>
+#include <Board.hpp>
+
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CHESS_PATTERN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CHESS_PATTERN_SSE2
+#endif
+
+static_assert(std::endian::native == std::endian::little, "The index is read in place as little-endian");
+
+namespace {
+    using Kind = PatternIndex::Kind;
+
+    /// <summary>
+    /// A block starts with the number of positions in it and the union of each kind over them, followed by the
+    /// bitboards of every kind, the flags, the plies and the games of its positions, each padded to the block size
+    /// </summary>
+    constexpr size_t BlockHeaderSize = 128;
+    constexpr size_t PiecesOffset = BlockHeaderSize;
+    constexpr size_t FlagsOffset = PiecesOffset + Kind::KindCount * PatternIndex::BlockSize * sizeof(Bitboard);
+    constexpr size_t PliesOffset = FlagsOffset + PatternIndex::BlockSize;
+    constexpr size_t GamesOffset = PliesOffset + PatternIndex::BlockSize * sizeof(uint16_t);
+    constexpr size_t BlockBytes = GamesOffset + PatternIndex::BlockSize * sizeof(uint32_t);
+
+    static_assert(BlockBytes % 32 == 0 && PatternIndex::HeaderSize % 32 == 0, "Bitboard arrays are aligned for vector loads");
+
+    /// <summary>
+    /// The blocks a search thread takes at a time
+    /// </summary>
+    constexpr uint64_t ChunkBlocks = 8;
+
+    /// <summary>
+    /// One bitboard of several positions, a position per lane
+    /// </summary>
+#if defined(CHESS_PATTERN_AVX2)
+    struct Lanes {
+        static constexpr size_t Count = 4;
+        static constexpr std::string_view Name = "AVX2";
+
+        __m256i Value;
+
+        static auto Load(const Bitboard* source) -> Lanes {
+            return { _mm256_load_si256(reinterpret_cast<const __m256i*>(source)) };
+        }
+
+        static auto Broadcast(const Bitboard value) -> Lanes {
+            return { _mm256_set1_epi64x(static_cast<long long>(value)) };
+        }
+
+        [[nodiscard]] auto ZeroMask() const -> unsigned {
+            return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(Value, _mm256_setzero_si256()))));
+        }
+
+        [[nodiscard]] auto AndNot(const Lanes other) const -> Lanes {
+            return { _mm256_andnot_si256(Value, other.Value) };
+        }
+
+        friend auto operator&(const Lanes a, const Lanes b) -> Lanes { return { _mm256_and_si256(a.Value, b.Value) }; }
+        friend auto operator|(const Lanes a, const Lanes b) -> Lanes { return { _mm256_or_si256(a.Value, b.Value) }; }
+    };
+#elif defined(CHESS_PATTERN_SSE2)
+    struct Lanes {
+        static constexpr size_t Count = 2;
+        static constexpr std::string_view Name = "SSE2";
+
+        __m128i Value;
+
+        static auto Load(const Bitboard* source) -> Lanes {
+            return { _mm_load_si128(reinterpret_cast<const __m128i*>(source)) };
+        }
+
+        static auto Broadcast(const Bitboard value) -> Lanes {
+            return { _mm_set1_epi64x(static_cast<long long>(value)) };
+        }
+
+        /// <summary>
+        /// SSE2 compares 32-bit halves, a lane is zero when both of its halves are
+        /// </summary>
+        [[nodiscard]] auto ZeroMask() const -> unsigned {
+            const auto halves = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(Value, _mm_setzero_si128()))));
+            return ((halves & 3U) == 3U ? 1U : 0U) | ((halves & 12U) == 12U ? 2U : 0U);
+        }
+
+        [[nodiscard]] auto AndNot(const Lanes other) const -> Lanes {
+            return { _mm_andnot_si128(Value, other.Value) };
+        }
+
+        friend auto operator&(const Lanes a, const Lanes b) -> Lanes { return { _mm_and_si128(a.Value, b.Value) }; }
+        friend auto operator|(const Lanes a, const Lanes b) -> Lanes { return { _mm_or_si128(a.Value, b.Value) }; }
+    };
+#else
+    struct Lanes {
+        static constexpr size_t Count = 1;
+        static constexpr std::string_view Name = "scalar";
+
+        Bitboard Value;
+
+        static auto Load(const Bitboard* source) -> Lanes {
+            return { *source };
+        }
+
+        static auto Broadcast(const Bitboard value) -> Lanes {
+            return { value };
+        }
+
+        [[nodiscard]] auto ZeroMask() const -> unsigned {
+            return Value == 0 ? 1U : 0U;
+        }
+
+        [[nodiscard]] auto AndNot(const Lanes other) const -> Lanes {
+            return { ~Value & other.Value };
+        }
+
+        friend auto operator&(const Lanes a, const Lanes b) -> Lanes { return { a.Value & b.Value }; }
+        friend auto operator|(const Lanes a, const Lanes b) -> Lanes { return { a.Value | b.Value }; }
+    };
+#endif
+
+    static_assert(PatternIndex::BlockSize % Lanes::Count == 0);
+
+    /// <summary>
+    /// The mask test of one piece kind, the kinds a query says nothing about are not tested
+    /// </summary>
+    struct MaskTest {
+        int Kind;
+        Lanes Required;
+        Lanes Forbidden;
+    };
+
+    auto KindFromLetter(const char letter) -> int {
+        constexpr std::string_view Letters = "PNBRQKpnbrqk";
+        const auto kind = Letters.find(letter);
+        return kind == std::string_view::npos ? -1 : static_cast<int>(kind);
+    }
+
+    /// <summary>
+    /// Parses squares written one after another, as in <c>c6e6</c>
+    /// </summary>
+    auto ParseSquares(const std::string_view text, const std::string_view term) -> Bitboard {
+        if (text.empty() || text.size() % 2 != 0) {
+            throw std::invalid_argument("Expected squares in " + std::string(term));
+        }
+
+        Bitboard squares = 0;
+
+        for (size_t i = 0; i < text.size(); i += 2) {
+            if (text[i] < 'a' || text[i] > 'h' || text[i + 1] < '1' || text[i + 1] > '8') {
+                throw std::invalid_argument("Invalid square in " + std::string(term));
+            }
+
+            squares |= Bitboard { 1 } << ((text[i + 1] - '1') * 8 + (text[i] - 'a'));
+        }
+
+        return squares;
+    }
+
+    auto Read64(const uint8_t* bytes) -> uint64_t {
+        uint64_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+}
+
+auto PatternIndex::Query::Compile(const std::string_view text) -> Query {
+    Query query;
+    size_t i = 0;
+
+    while (i < text.size()) {
+        if (text[i] == ' ' || text[i] == ',') {
+            i++;
+            continue;
+        }
+
+        const auto end = std::min(text.find_first_of(" ,", i), text.size());
+        const auto term = text.substr(i, end - i);
+        i = end;
+
+        if (term == "w" || term == "b") {
+            query.FlagMask |= PositionBatch::WhiteToMove;
+            query.FlagValues = term == "w" ? PositionBatch::WhiteToMove : 0;
+            continue;
+        }
+
+        auto rest = term;
+        const bool negated = rest.front() == '!';
+
+        if (negated) {
+            rest.remove_prefix(1);
+        }
+
+        if (!rest.empty() && rest.front() == '.') {
+            if (negated) {
+                throw std::invalid_argument("An empty square cannot be negated in " + std::string(term));
+            }
+
+            const auto squares = ParseSquares(rest.substr(1), term);
+
+            for (auto& forbidden : query.Forbidden) {
+                forbidden |= squares;
+            }
+
+            continue;
+        }
+
+        const auto kind = rest.empty() ? -1 : KindFromLetter(rest.front());
+
+        if (kind < 0) {
+            throw std::invalid_argument("Expected a piece in " + std::string(term));
+        }
+
+        rest.remove_prefix(1);
+
+        if (rest.empty()) {
+            if (negated) {
+                query.MaxCount[kind] = 0;
+            }
+            else {
+                query.MinCount[kind] = std::max<uint8_t>(query.MinCount[kind], 1);
+            }
+
+            continue;
+        }
+
+        if (rest.front() == '=' || rest.front() == '<' || rest.front() == '>') {
+            const auto operation = rest.substr(0, rest.size() > 1 && rest[1] == '=' && rest.front() != '=' ? 2 : 1);
+            rest.remove_prefix(operation.size());
+
+            int count = 0;
+            const auto [last, error] = std::from_chars(rest.data(), rest.data() + rest.size(), count);
+
+            if (negated || error != std::errc() || last != rest.data() + rest.size() || count < (operation == "<" ? 1 : 0) || count > 64) {
+                throw std::invalid_argument("Invalid count in " + std::string(term));
+            }
+
+            auto& min = query.MinCount[kind];
+            auto& max = query.MaxCount[kind];
+            const auto bound = static_cast<uint8_t>(count);
+
+            if (operation == "=" || operation == ">=") min = std::max(min, bound);
+            if (operation == "=" || operation == "<=") max = std::min(max, bound);
+            if (operation == ">") min = std::max<uint8_t>(min, bound + 1);
+            if (operation == "<") max = std::min<uint8_t>(max, bound - 1);
+
+            continue;
+        }
+
+        (negated ? query.Forbidden : query.Required)[kind] |= ParseSquares(rest, term);
+    }
+
+    // The squares a kind must occupy count towards its minimum, and a kind that must be absent is forbidden
+    // everywhere, which leaves counting to the queries that need it
+    for (int kind = 0; kind < Kind::KindCount; kind++) {
+        query.MinCount[kind] = std::max(query.MinCount[kind], static_cast<uint8_t>(std::popcount(query.Required[kind])));
+
+        if (query.MaxCount[kind] == 0) {
+            query.Forbidden[kind] = ~Bitboard { 0 };
+        }
+    }
+
+    return query;
+}
+
+auto PatternIndex::Query::Matches(const std::span<const Bitboard, Kind::KindCount> pieces, const uint8_t flags) const noexcept -> bool {
+    if ((flags & FlagMask) != FlagValues) {
+        return false;
+    }
+
+    for (int kind = 0; kind < Kind::KindCount; kind++) {
+        const auto count = std::popcount(pieces[kind]);
+
+        if ((pieces[kind] & Required[kind]) != Required[kind] || (pieces[kind] & Forbidden[kind]) != 0
+            || count < MinCount[kind] || count > MaxCount[kind]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// <summary>
+/// Appends the blocks the replaying threads fill to the index file
+/// </summary>
+class PatternIndex::BlockWriter final {
+public:
+    explicit BlockWriter(std::filesystem::path path) :
+        m_Path(std::move(path)), m_Temporary(m_Path.string() + ".tmp"), m_Stream(m_Temporary, std::ios::binary | std::ios::trunc) {
+        if (!m_Stream) {
+            throw std::runtime_error("Failed to create " + m_Temporary.string());
+        }
+
+        const std::array<char, HeaderSize> header {};
+        m_Stream.write(header.data(), header.size());
+    }
+
+    BlockWriter(const BlockWriter&) = delete;
+    auto operator=(const BlockWriter&) -> BlockWriter& = delete;
+
+    ~BlockWriter() {
+        if (!m_Finished) {
+            m_Stream.close();
+
+            std::error_code error;
+            std::filesystem::remove(m_Temporary, error);
+        }
+    }
+
+    /// <summary>
+    /// Lays out the positions of a batch as a block and appends it
+    /// </summary>
+    auto Write(const PositionBatch& batch, const std::span<const uint16_t> plies, const std::span<const uint32_t> games) -> void {
+        const auto count = batch.GetSize();
+
+        if (count == 0) {
+            return;
+        }
+
+        std::vector<uint8_t> block(BlockBytes, 0);
+        std::memcpy(block.data(), &count, sizeof(uint32_t));
+
+        for (int kind = 0; kind < Kind::KindCount; kind++) {
+            const auto pieces = batch.GetPieces(static_cast<Kind>(kind));
+            Bitboard all = 0;
+
+            for (const auto squares : pieces) {
+                all |= squares;
+            }
+
+            std::memcpy(block.data() + 8 + kind * sizeof(Bitboard), &all, sizeof(all));
+            std::memcpy(block.data() + PiecesOffset + kind * BlockSize * sizeof(Bitboard), pieces.data(), count * sizeof(Bitboard));
+        }
+
+        std::memcpy(block.data() + FlagsOffset, batch.GetFlags().data(), count);
+        std::memcpy(block.data() + PliesOffset, plies.data(), count * sizeof(uint16_t));
+        std::memcpy(block.data() + GamesOffset, games.data(), count * sizeof(uint32_t));
+
+        std::lock_guard lock(m_Mutex);
+        m_Stream.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(block.size()));
+        m_Blocks++;
+        m_Positions += count;
+
+        if (!m_Stream) {
+            throw std::runtime_error("Failed to write " + m_Temporary.string());
+        }
+    }
+
+    auto Finish(const uint64_t games) -> void {
+        std::array<char, HeaderSize> header {};
+        constexpr auto blockSize = static_cast<uint32_t>(BlockSize);
+
+        std::memcpy(header.data(), Magic.data(), Magic.size());
+        std::memcpy(header.data() + 4, &Version, sizeof(Version));
+        std::memcpy(header.data() + 8, &blockSize, sizeof(blockSize));
+        std::memcpy(header.data() + 16, &m_Blocks, sizeof(m_Blocks));
+        std::memcpy(header.data() + 24, &m_Positions, sizeof(m_Positions));
+        std::memcpy(header.data() + 32, &games, sizeof(games));
+
+        m_Stream.seekp(0);
+        m_Stream.write(header.data(), header.size());
+        m_Stream.close();
+
+        if (!m_Stream) {
+            throw std::runtime_error("Failed to write " + m_Temporary.string());
+        }
+
+        std::filesystem::rename(m_Temporary, m_Path);
+        m_Finished = true;
+    }
+
+private:
+    std::filesystem::path m_Path;
+    std::filesystem::path m_Temporary;
+    std::ofstream m_Stream;
+    std::mutex m_Mutex;
+    uint64_t m_Blocks = 0;
+    uint64_t m_Positions = 0;
+    bool m_Finished = false;
+};
+
+PatternIndex::PatternIndex(const std::filesystem::path& path) : m_File(path) {
+    const auto bytes = m_File.GetBytes();
+
+    if (bytes.size() < HeaderSize || !std::equal(Magic.begin(), Magic.end(), bytes.begin())) {
+        throw std::runtime_error(path.string() + " is not a pattern index");
+    }
+
+    uint32_t version, blockSize;
+    std::memcpy(&version, bytes.data() + 4, sizeof(version));
+    std::memcpy(&blockSize, bytes.data() + 8, sizeof(blockSize));
+
+    if (version != Version || blockSize != BlockSize) {
+        throw std::runtime_error(path.string() + ": unsupported pattern index version");
+    }
+
+    m_BlockCount = Read64(bytes.data() + 16);
+    m_Positions = Read64(bytes.data() + 24);
+    m_Games = Read64(bytes.data() + 32);
+
+    if (bytes.size() != HeaderSize + m_BlockCount * BlockBytes) {
+        throw std::runtime_error(path.string() + ": truncated pattern index");
+    }
+
+    m_Blocks = bytes.data() + HeaderSize;
+}
+
+auto PatternIndex::Search(const Query& query, int threads, const size_t limit) const -> SearchResult {
+    threads = threads > 0 ? threads : static_cast<int>(std::max(std::thread::hardware_concurrency(), 1U));
+    threads = static_cast<int>(std::max<uint64_t>(std::min<uint64_t>(static_cast<uint64_t>(threads), (m_BlockCount + ChunkBlocks - 1) / ChunkBlocks), 1));
+
+    SearchResult result;
+    std::mutex mutex;
+    std::atomic<uint64_t> next = 0;
+
+    // Every thread keeps the lowest matches it finds, trimming them down to the limit as they grow
+    const auto trim = [limit](std::vector<Match>& matches) {
+        if (matches.size() > limit) {
+            std::ranges::nth_element(matches, matches.begin() + static_cast<ptrdiff_t>(limit));
+            matches.resize(limit);
+        }
+    };
+
+    const auto work = [&] {
+        SearchResult local;
+
+        for (auto begin = next.fetch_add(ChunkBlocks); begin < m_BlockCount; begin = next.fetch_add(ChunkBlocks)) {
+            SearchBlocks(query, begin, std::min(begin + ChunkBlocks, m_BlockCount), local);
+
+            if (local.Matches.size() > std::max<size_t>(limit * 2, BlockSize)) {
+                trim(local.Matches);
+            }
+        }
+
+        trim(local.Matches);
+
+        std::lock_guard lock(mutex);
+        result.Matches.insert(result.Matches.end(), local.Matches.begin(), local.Matches.end());
+        result.Total += local.Total;
+        result.BlocksScanned += local.BlocksScanned;
+        result.BlocksSkipped += local.BlocksSkipped;
+    };
+
+    if (threads == 1) {
+        work();
+    }
+    else {
+        std::vector<std::jthread> workers;
+
+        for (int thread = 0; thread < threads; thread++) {
+            workers.emplace_back(work);
+        }
+    }
+
+    trim(result.Matches);
+    std::ranges::sort(result.Matches);
+    return result;
+}
+
+auto PatternIndex::SearchBlocks(const Query& query, const uint64_t begin, const uint64_t end, SearchResult& result) const -> void {
+    std::array<MaskTest, Kind::KindCount> tests {};
+    int testCount = 0;
+
+    // The kinds whose counts the masks do not already settle, checked for the positions that pass the masks
+    std::array<int, Kind::KindCount> counted {};
+    int countedCount = 0;
+
+    for (int kind = 0; kind < Kind::KindCount; kind++) {
+        if (query.Required[kind] != 0 || query.Forbidden[kind] != 0) {
+            tests[testCount++] = { kind, Lanes::Broadcast(query.Required[kind]), Lanes::Broadcast(query.Forbidden[kind]) };
+        }
+
+        if ((query.MinCount[kind] > std::popcount(query.Required[kind]) || query.MaxCount[kind] < 64) && query.MaxCount[kind] != 0) {
+            counted[countedCount++] = kind;
+        }
+    }
+
+    for (auto index = begin; index < end; index++) {
+        const auto block = m_Blocks + index * BlockBytes;
+
+        uint32_t count;
+        std::memcpy(&count, block, sizeof(count));
+
+        // The union of a kind over the block holds every square any of its positions has the kind on
+        bool possible = true;
+
+        for (int kind = 0; kind < Kind::KindCount && possible; kind++) {
+            const auto all = Read64(block + 8 + kind * sizeof(Bitboard));
+            possible = (all & query.Required[kind]) == query.Required[kind] && std::popcount(all) >= query.MinCount[kind];
+        }
+
+        if (!possible) {
+            result.BlocksSkipped++;
+            continue;
+        }
+
+        result.BlocksScanned++;
+
+        const auto pieces = reinterpret_cast<const Bitboard*>(block + PiecesOffset);
+        const auto flags = block + FlagsOffset;
+        const auto plies = reinterpret_cast<const uint16_t*>(block + PliesOffset);
+        const auto games = reinterpret_cast<const uint32_t*>(block + GamesOffset);
+
+        for (size_t group = 0; group < count; group += Lanes::Count) {
+            Lanes violations = Lanes::Broadcast(0);
+
+            for (int test = 0; test < testCount; test++) {
+                const auto squares = Lanes::Load(pieces + tests[test].Kind * BlockSize + group);
+                violations = violations | (squares & tests[test].Forbidden) | squares.AndNot(tests[test].Required);
+            }
+
+            auto passed = violations.ZeroMask();
+
+            while (passed != 0) {
+                const auto position = group + static_cast<size_t>(std::countr_zero(passed));
+                passed &= passed - 1;
+
+                if (position >= count) {
+                    break;
+                }
+
+                if ((flags[position] & query.FlagMask) != query.FlagValues) {
+                    continue;
+                }
+
+                bool inRange = true;
+
+                for (int i = 0; i < countedCount && inRange; i++) {
+                    const auto count = std::popcount(pieces[counted[i] * BlockSize + position]);
+                    inRange = count >= query.MinCount[counted[i]] && count <= query.MaxCount[counted[i]];
+                }
+
+                if (!inRange) {
+                    continue;
+                }
+
+                result.Matches.push_back({ games[position], plies[position] });
+                result.Total++;
+            }
+        }
+    }
+}
+
+auto PatternIndex::Build(const std::span<const std::filesystem::path> pgns, const std::filesystem::path& path, const int threads) -> PgnReader::ReplayReport {
+    class Collector final : public PgnReader::Visitor {
+    public:
+        Collector(BlockWriter& writer, const uint64_t firstGame) : m_Writer(writer), m_FirstGame(firstGame) {
+            m_Batch.Reserve(BlockSize);
+        }
+
+        auto Visit(const uint64_t game, const int ply, const PgnReader::Game&, const Move*) -> void override {
+            m_Batch.Add(Board::GetState());
+            m_Plies.push_back(static_cast<uint16_t>(std::min(ply, 0xFFFF)));
+            m_Games.push_back(static_cast<uint32_t>(m_FirstGame + game));
+
+            if (m_Batch.GetSize() == BlockSize) {
+                Finish();
+            }
+        }
+
+        auto Finish() -> void override {
+            m_Writer.Write(m_Batch, m_Plies, m_Games);
+            m_Batch.Clear();
+            m_Plies.clear();
+            m_Games.clear();
+        }
+
+    private:
+        BlockWriter& m_Writer;
+        uint64_t m_FirstGame;
+        PositionBatch m_Batch;
+        std::vector<uint16_t> m_Plies;
+        std::vector<uint32_t> m_Games;
+    };
+
+    BlockWriter writer(path);
+    PgnReader::ReplayReport total;
+
+    for (const auto& pgn : pgns) {
+        std::ifstream stream(pgn);
+
+        if (!stream) {
+            throw std::runtime_error("Failed to open " + pgn.string());
+        }
+
+        const auto firstGame = total.Games;
+        const auto report = PgnReader::Replay(stream, threads, [&] { return std::make_unique<Collector>(writer, firstGame); });
+
+        total.Games += report.Games;
+        total.Positions += report.Positions;
+        total.Errors += report.Errors;
+    }
+
+    writer.Finish(total.Games);
+    return total;
+}
+
+auto PatternIndex::GetInstructionSet() -> std::string_view {
+    return Lanes::Name;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include <pch.hpp>
+#include <PerftCache.hpp>
+
+#include <bit>
+
+PerftCache::PerftCache(const size_t megabytes) {
+    const size_t buckets = megabytes * 1024 * 1024 / sizeof(Bucket);
+
+    if (buckets == 0) {
+        throw std::invalid_argument("Perft cache needs at least one megabyte");
+    }
+
+    // A power of two lets the bucket index be masked out of the hash
+    m_BucketCount = std::bit_floor(buckets);
+    m_Memory = LargePageBuffer(m_BucketCount * sizeof(Bucket));
+    m_Buckets = static_cast<Bucket*>(m_Memory.Get());
+
+    // The buffer is already zeroed, so every bucket starts out empty
+    std::uninitialized_default_construct_n(m_Buckets, m_BucketCount);
+}
+
+auto PerftCache::Probe(const uint64_t hash, const int depth) -> std::optional<uint64_t> {
+    m_Probes++;
+
+    for (const auto& entry : GetBucket(hash, depth).Entries) {
+        if (entry.Hash == hash && entry.Depth == static_cast<uint64_t>(depth)) {
+            m_Hits++;
+            return entry.Nodes;
+        }
+    }
+
+    return std::nullopt;
+}
+
+auto PerftCache::Store(const uint64_t hash, const int depth, const uint64_t nodes) -> void {
+    auto& [deepest, recent] = GetBucket(hash, depth).Entries;
+    auto& entry = depth >= static_cast<int>(deepest.Depth) ? deepest : recent;
+
+    entry.Hash = hash;
+    entry.Nodes = nodes;
+    entry.Depth = static_cast<uint64_t>(depth);
+}
+
+auto PerftCache::Clear() -> void {
+    std::fill_n(m_Buckets, m_BucketCount, Bucket {});
+    m_Probes = 0;
+    m_Hits = 0;
+}
+
+auto PerftCache::GetProbes() const noexcept -> uint64_t {
+    return m_Probes;
+}
+
+auto PerftCache::GetHits() const noexcept -> uint64_t {
+    return m_Hits;
+}
+
+auto PerftCache::GetHitRate() const noexcept -> double {
+    return m_Probes > 0 ? static_cast<double>(m_Hits) / static_cast<double>(m_Probes) : 0.0;
+}
+
+auto PerftCache::GetSize() const noexcept -> size_t {
+    return m_BucketCount * sizeof(Bucket);
+}
+
+auto PerftCache::GetMemory() const noexcept -> const LargePageBuffer& {
+    return m_Memory;
+}
+
+auto PerftCache::GetBucket(const uint64_t hash, const int depth) -> Bucket& {
+    // Mixing in the depth spreads the subtrees of one position over different buckets
+    const uint64_t key = hash ^ (static_cast<uint64_t>(depth) * 0x9E3779B97F4A7C15ULL);
+    return m_Buckets[key & (m_BucketCount - 1)];
+}
\ No newline at end of file
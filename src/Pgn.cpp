@@ -0,0 +1,309 @@
+#include <pch.hpp>
+#include <Pgn.hpp>
+#include <Board.hpp>
+#include <Fen.hpp>
+#include <Move.hpp>
+#include <Notation.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+namespace {
+    /// <summary>
+    /// The result of a game that has none, or is still in progress
+    /// </summary>
+    constexpr std::string_view Unfinished = "*";
+
+    auto IsResult(const std::string_view token) -> bool {
+        return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == Unfinished;
+    }
+
+    /// <summary>
+    /// Skips a brace comment, the text must start at its opening brace
+    /// </summary>
+    auto SkipComment(const std::string_view text, size_t i) -> size_t {
+        const auto end = text.find('}', i);
+        return end == std::string_view::npos ? text.size() : end + 1;
+    }
+}
+
+auto PgnReader::Game::GetTag(const std::string_view name) const -> std::string_view {
+    const auto tag = std::ranges::find(Tags, name, [](const auto& pair) -> std::string_view { return pair.first; });
+    return tag != Tags.end() ? std::string_view(tag->second) : std::string_view();
+}
+
+auto PgnReader::Next(Game& game) -> bool {
+    std::string text;
+
+    if (!NextText(text)) {
+        return false;
+    }
+
+    Parse(text, game);
+    return true;
+}
+
+auto PgnReader::NextText(std::string& text) -> bool {
+    text.clear();
+
+    if (!m_Pending.empty()) {
+        text = std::move(m_Pending);
+        text += '\n';
+        m_Pending.clear();
+    }
+
+    // A game ends where the tags of the next one start after its moves
+    bool moves = false;
+    std::string line;
+
+    while (std::getline(m_Stream, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if (line.starts_with('[') && moves) {
+            m_Pending = std::move(line);
+            return true;
+        }
+
+        moves |= !line.empty() && !line.starts_with('[') && !line.starts_with('%');
+        text += line;
+        text += '\n';
+    }
+
+    return text.find_first_not_of(" \t\n") != std::string::npos;
+}
+
+auto PgnReader::Parse(const std::string_view text, Game& game) -> void {
+    game.Tags.clear();
+    game.Moves.clear();
+
+    std::string_view terminator;
+    size_t i = 0;
+
+    while (i < text.size()) {
+        const char c = text[i];
+
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            i++;
+        }
+        else if (c == '[') {
+            // [Name "Value"], with backslash escapes in the value
+            const auto nameEnd = text.find_first_of(" \t\"]", i + 1);
+            const auto quote = text.find('"', i);
+            std::string name(text.substr(i + 1, nameEnd - i - 1)), value;
+
+            i = quote == std::string_view::npos ? text.size() : quote + 1;
+
+            for (; i < text.size() && text[i] != '"' && text[i] != '\n'; i++) {
+                if (text[i] == '\\' && i + 1 < text.size()) {
+                    i++;
+                }
+                value += text[i];
+            }
+
+            const auto close = text.find(']', i);
+            i = close == std::string_view::npos ? text.size() : close + 1;
+            game.Tags.emplace_back(std::move(name), std::move(value));
+        }
+        else if (c == '{') {
+            i = SkipComment(text, i);
+        }
+        else if (c == ';' || (c == '%' && (i == 0 || text[i - 1] == '\n'))) {
+            const auto end = text.find('\n', i);
+            i = end == std::string_view::npos ? text.size() : end + 1;
+        }
+        else if (c == '(') {
+            // Variations nest and may hold comments with parentheses in them
+            int depth = 0;
+
+            while (i < text.size()) {
+                if (text[i] == '{') {
+                    i = SkipComment(text, i);
+                    continue;
+                }
+
+                depth += text[i] == '(' ? 1 : text[i] == ')' ? -1 : 0;
+                i++;
+
+                if (depth == 0) {
+                    break;
+                }
+            }
+        }
+        else if (c == ')') {
+            i++;
+        }
+        else {
+            const auto end = std::min(text.find_first_of(" \t\r\n{}();[", i), text.size());
+            auto token = text.substr(i, end - i);
+            i = end;
+
+            if (IsResult(token)) {
+                terminator = token;
+                break;
+            }
+
+            // Move numbers, possibly written together with the move as in 12.e4 or 12...e5
+            const auto number = token.find_first_not_of("0123456789");
+            if (number != 0 && number != std::string_view::npos && token[number] == '.') {
+                token.remove_prefix(number);
+            }
+            token.remove_prefix(std::min(token.find_first_not_of('.'), token.size()));
+
+            if (!token.empty() && token.front() != '$' && (token.find_first_not_of("0123456789") != std::string_view::npos)) {
+                game.Moves.emplace_back(token);
+            }
+        }
+    }
+
+    // The tag takes precedence over the terminator, and a game with neither is unfinished
+    const auto tag = game.GetTag("Result");
+    const auto result = IsResult(tag) ? tag : !terminator.empty() ? terminator : Unfinished;
+
+    game.Result.assign(result.data(), result.size());
+}
+
+auto PgnReader::Replay(std::istream& stream, int threads, const std::function<std::unique_ptr<Visitor>()>& makeVisitor) -> ReplayReport {
+    threads = threads > 0 ? threads : static_cast<int>(std::max(std::thread::hardware_concurrency(), 1U));
+
+    // Games are handed to the workers in batches to keep the queue out of the way
+    constexpr size_t BatchGames = 256;
+
+    struct Batch {
+        uint64_t First = 0;
+        std::vector<std::string> Texts;
+    };
+
+    std::mutex mutex;
+    std::condition_variable ready, space;
+    std::deque<Batch> queue;
+    bool done = false;
+    std::exception_ptr failure;
+
+    std::atomic<uint64_t> games = 0, positions = 0, errors = 0;
+
+    const auto work = [&] {
+        try {
+            const auto visitor = makeVisitor();
+            Game game;
+
+            while (true) {
+                Batch batch;
+
+                {
+                    std::unique_lock lock(mutex);
+                    ready.wait(lock, [&] { return !queue.empty() || done; });
+
+                    if (queue.empty()) {
+                        break;
+                    }
+
+                    batch = std::move(queue.front());
+                    queue.pop_front();
+                }
+
+                space.notify_one();
+
+                for (size_t i = 0; i < batch.Texts.size(); i++) {
+                    Parse(batch.Texts[i], game);
+                    games++;
+
+                    Fen::State state;
+                    const auto fen = game.GetTag("FEN");
+
+                    if (!Fen::Parse(fen.empty() ? Fen::StartPosition : fen, state)) {
+                        errors++;
+                        continue;
+                    }
+
+                    Board::SetState(state);
+                    int ply = 0;
+
+                    for (const auto& san : game.Moves) {
+                        const auto move = Notation::FromSan(san);
+
+                        if (!move) {
+                            errors++;
+                            break;
+                        }
+
+                        visitor->Visit(batch.First + i, ply++, game, &*move);
+                        Board::MakeMove(*move);
+                    }
+
+                    if (ply == static_cast<int>(game.Moves.size())) {
+                        visitor->Visit(batch.First + i, ply++, game, nullptr);
+                    }
+
+                    positions += static_cast<uint64_t>(ply);
+                }
+            }
+
+            visitor->Finish();
+        }
+        catch (...) {
+            std::lock_guard lock(mutex);
+            failure = failure ? failure : std::current_exception();
+            done = true;
+            space.notify_all();
+        }
+    };
+
+    {
+        std::vector<std::jthread> workers;
+
+        for (int i = 0; i < threads; i++) {
+            workers.emplace_back(work);
+        }
+
+        PgnReader reader(stream);
+        Batch batch;
+        uint64_t read = 0;
+        std::string text;
+
+        const auto push = [&] {
+            std::unique_lock lock(mutex);
+            space.wait(lock, [&] { return queue.size() < static_cast<size_t>(threads) * 2 || failure; });
+
+            if (failure) {
+                return false;
+            }
+
+            queue.push_back(std::move(batch));
+            batch = { read, {} };
+            ready.notify_one();
+            return true;
+        };
+
+        bool reading = true;
+
+        while (reading && reader.NextText(text)) {
+            batch.Texts.push_back(std::move(text));
+            read++;
+
+            if (batch.Texts.size() == BatchGames) {
+                reading = push();
+            }
+        }
+
+        if (reading && !batch.Texts.empty()) {
+            push();
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            done = true;
+        }
+
+        ready.notify_all();
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    return { games, positions, errors };
+}
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include <pch.hpp>
+#include <PieceAtlas.hpp>
+
+#include <bit>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::endian::native == std::endian::little, "The bundle is read in place as little-endian");
+
+namespace {
+    constexpr size_t HeaderSize = 32;
+    constexpr size_t LevelEntrySize = 16;
+    constexpr size_t TileEntrySize = 16;
+    constexpr size_t LevelAlignment = 16;
+
+    auto Read32(const std::span<const uint8_t> bytes, const size_t offset) -> uint32_t {
+        uint32_t value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(value));
+        return value;
+    }
+
+    auto Read64(const std::span<const uint8_t> bytes, const size_t offset) -> uint64_t {
+        uint64_t value;
+        std::memcpy(&value, bytes.data() + offset, sizeof(value));
+        return value;
+    }
+
+    template<typename T>
+    auto Write(std::vector<uint8_t>& bytes, const size_t offset, const T value) -> void {
+        std::memcpy(bytes.data() + offset, &value, sizeof(T));
+    }
+
+    auto AlignUp(const size_t value) -> size_t {
+        return (value + LevelAlignment - 1) & ~(LevelAlignment - 1);
+    }
+}
+
+PieceAtlas::PieceAtlas(const std::filesystem::path& path) {
+#ifdef _WIN32
+    m_File = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open " + path.string());
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_File, &size) || (m_Mapping = CreateFileMappingW(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr)) == nullptr) {
+        Unmap();
+        throw std::runtime_error("Failed to map " + path.string());
+    }
+
+    m_Data = static_cast<const uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+    m_Size = static_cast<size_t>(size.QuadPart);
+#else
+    const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        throw std::runtime_error("Failed to open " + path.string());
+    }
+
+    struct stat status {};
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        m_Size = static_cast<size_t>(status.st_size);
+        void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+        m_Data = data == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(data);
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(file);
+#endif
+
+    if (m_Data == nullptr) {
+        Unmap();
+        throw std::runtime_error("Failed to map " + path.string());
+    }
+
+    try {
+        Parse({ m_Data, m_Size });
+    }
+    catch (const std::runtime_error& e) {
+        Unmap();
+        throw std::runtime_error(path.string() + ": " + e.what());
+    }
+}
+
+PieceAtlas::~PieceAtlas() {
+    Unmap();
+}
+
+auto PieceAtlas::GetLevels() const noexcept -> std::span<const Level> {
+    return m_Levels;
+}
+
+auto PieceAtlas::GetTiles() const noexcept -> std::span<const TileRect> {
+    return m_Tiles;
+}
+
+auto PieceAtlas::GetTileSize() const noexcept -> uint32_t {
+    return m_TileSize;
+}
+
+auto PieceAtlas::Serialize(const uint32_t tileSize, const std::span<const TileRect> tiles, const std::span<const Image> levels) -> std::vector<uint8_t> {
+    if (levels.empty()) {
+        throw std::invalid_argument("An atlas needs at least one level");
+    }
+
+    auto offset = AlignUp(HeaderSize + LevelEntrySize * levels.size() + TileEntrySize * tiles.size());
+
+    std::vector<uint64_t> offsets;
+    for (const auto& level : levels) {
+        if (level.Pixels.size() != static_cast<size_t>(level.Width) * level.Height * BytesPerPixel) {
+            throw std::invalid_argument("A level has the wrong number of bytes");
+        }
+
+        offsets.push_back(offset);
+        offset = AlignUp(offset + level.Pixels.size());
+    }
+
+    // Padding stays zero so the output only depends on the input
+    std::vector<uint8_t> bytes(offset, 0);
+
+    std::memcpy(bytes.data(), Magic.data(), Magic.size());
+    Write(bytes, 4, Version);
+    Write(bytes, 8, FormatRgba8);
+    Write(bytes, 12, levels.front().Width);
+    Write(bytes, 16, levels.front().Height);
+    Write(bytes, 20, static_cast<uint32_t>(levels.size()));
+    Write(bytes, 24, static_cast<uint32_t>(tiles.size()));
+    Write(bytes, 28, tileSize);
+
+    auto entry = HeaderSize;
+    for (size_t i = 0; i < levels.size(); i++, entry += LevelEntrySize) {
+        Write(bytes, entry, offsets[i]);
+        Write(bytes, entry + 8, levels[i].Width);
+        Write(bytes, entry + 12, levels[i].Height);
+        std::memcpy(bytes.data() + offsets[i], levels[i].Pixels.data(), levels[i].Pixels.size());
+    }
+
+    for (const auto& tile : tiles) {
+        Write(bytes, entry, tile.U0);
+        Write(bytes, entry + 4, tile.V0);
+        Write(bytes, entry + 8, tile.U1);
+        Write(bytes, entry + 12, tile.V1);
+        entry += TileEntrySize;
+    }
+
+    return bytes;
+}
+
+auto PieceAtlas::Parse(const std::span<const uint8_t> bytes) -> void {
+    if (bytes.size() < HeaderSize || std::memcmp(bytes.data(), Magic.data(), Magic.size()) != 0) {
+        throw std::runtime_error("Not a piece atlas");
+    }
+
+    if (Read32(bytes, 4) != Version || Read32(bytes, 8) != FormatRgba8) {
+        throw std::runtime_error("Unsupported atlas version or format");
+    }
+
+    const auto levelCount = Read32(bytes, 20);
+    const auto tileCount = Read32(bytes, 24);
+    m_TileSize = Read32(bytes, 28);
+
+    if (levelCount == 0 || levelCount > 32 || HeaderSize + LevelEntrySize * levelCount + TileEntrySize * tileCount > bytes.size()) {
+        throw std::runtime_error("Truncated atlas tables");
+    }
+
+    auto entry = HeaderSize;
+    for (uint32_t i = 0; i < levelCount; i++, entry += LevelEntrySize) {
+        const auto offset = Read64(bytes, entry);
+        const auto width = Read32(bytes, entry + 8);
+        const auto height = Read32(bytes, entry + 12);
+        const auto size = static_cast<uint64_t>(width) * height * BytesPerPixel;
+
+        if (offset % LevelAlignment != 0 || offset > bytes.size() || size > bytes.size() - offset) {
+            throw std::runtime_error("Atlas level " + std::to_string(i) + " lies outside the file");
+        }
+
+        m_Levels.push_back({ width, height, bytes.subspan(offset, size) });
+    }
+
+    for (uint32_t i = 0; i < tileCount; i++, entry += TileEntrySize) {
+        TileRect tile;
+        std::memcpy(&tile, bytes.data() + entry, sizeof(tile));
+        m_Tiles.push_back(tile);
+    }
+}
+
+auto PieceAtlas::Unmap() noexcept -> void {
+#ifdef _WIN32
+    if (m_Data != nullptr) UnmapViewOfFile(m_Data);
+    if (m_Mapping != nullptr) CloseHandle(m_Mapping);
+    if (m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+    m_Mapping = nullptr;
+    m_File = INVALID_HANDLE_VALUE;
+#else
+    if (m_Data != nullptr) munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+}
\ No newline at end of file
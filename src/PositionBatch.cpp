@@ -0,0 +1,579 @@
+#include <pch.hpp>
+#include <PositionBatch.hpp>
+#include <Evaluation.hpp>
+#include <Piece.hpp>
+
+#include <bit>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CHESS_BATCH_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CHESS_BATCH_SSE2
+#endif
+
+namespace {
+    /// <summary>
+    /// The arrays are padded for the widest lane group
+    /// </summary>
+    constexpr size_t Padding = 4;
+
+    /// <summary>
+    /// The positions a thread analyzes at a time
+    /// </summary>
+    constexpr size_t ChunkSize = 256;
+
+    constexpr Bitboard NotAFile = 0xFEFEFEFEFEFEFEFEULL;
+    constexpr Bitboard NotHFile = 0x7F7F7F7F7F7F7F7FULL;
+    constexpr Bitboard NotABFile = 0xFCFCFCFCFCFCFCFCULL;
+    constexpr Bitboard NotGHFile = 0x3F3F3F3F3F3F3F3FULL;
+
+    constexpr int RookRays = 0;
+    constexpr int BishopRays = 4;
+
+    /// <summary>
+    /// One bitboard of several positions, a position per lane
+    /// </summary>
+#if defined(CHESS_BATCH_AVX2)
+    struct Lanes {
+        static constexpr size_t Count = 4;
+        static constexpr std::string_view Name = "AVX2";
+
+        __m256i Value;
+
+        static auto Load(const Bitboard* source) -> Lanes {
+            return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source)) };
+        }
+
+        static auto Broadcast(const Bitboard value) -> Lanes {
+            return { _mm256_set1_epi64x(static_cast<long long>(value)) };
+        }
+
+        auto Store(Bitboard* destination) const -> void {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), Value);
+        }
+
+        template<int Bits>
+        [[nodiscard]] auto ShiftLeft() const -> Lanes {
+            return { _mm256_slli_epi64(Value, Bits) };
+        }
+
+        template<int Bits>
+        [[nodiscard]] auto ShiftRight() const -> Lanes {
+            return { _mm256_srli_epi64(Value, Bits) };
+        }
+
+        /// <summary>
+        /// Gets <c>~this & other</c>
+        /// </summary>
+        [[nodiscard]] auto AndNot(const Lanes other) const -> Lanes {
+            return { _mm256_andnot_si256(Value, other.Value) };
+        }
+
+        friend auto operator&(const Lanes a, const Lanes b) -> Lanes { return { _mm256_and_si256(a.Value, b.Value) }; }
+        friend auto operator|(const Lanes a, const Lanes b) -> Lanes { return { _mm256_or_si256(a.Value, b.Value) }; }
+    };
+#elif defined(CHESS_BATCH_SSE2)
+    struct Lanes {
+        static constexpr size_t Count = 2;
+        static constexpr std::string_view Name = "SSE2";
+
+        __m128i Value;
+
+        static auto Load(const Bitboard* source) -> Lanes {
+            return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)) };
+        }
+
+        static auto Broadcast(const Bitboard value) -> Lanes {
+            return { _mm_set1_epi64x(static_cast<long long>(value)) };
+        }
+
+        auto Store(Bitboard* destination) const -> void {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), Value);
+        }
+
+        template<int Bits>
+        [[nodiscard]] auto ShiftLeft() const -> Lanes {
+            return { _mm_slli_epi64(Value, Bits) };
+        }
+
+        template<int Bits>
+        [[nodiscard]] auto ShiftRight() const -> Lanes {
+            return { _mm_srli_epi64(Value, Bits) };
+        }
+
+        /// <summary>
+        /// Gets <c>~this & other</c>
+        /// </summary>
+        [[nodiscard]] auto AndNot(const Lanes other) const -> Lanes {
+            return { _mm_andnot_si128(Value, other.Value) };
+        }
+
+        friend auto operator&(const Lanes a, const Lanes b) -> Lanes { return { _mm_and_si128(a.Value, b.Value) }; }
+        friend auto operator|(const Lanes a, const Lanes b) -> Lanes { return { _mm_or_si128(a.Value, b.Value) }; }
+    };
+#else
+    struct Lanes {
+        static constexpr size_t Count = 1;
+        static constexpr std::string_view Name = "scalar";
+
+        Bitboard Value;
+
+        static auto Load(const Bitboard* source) -> Lanes {
+            return { *source };
+        }
+
+        static auto Broadcast(const Bitboard value) -> Lanes {
+            return { value };
+        }
+
+        auto Store(Bitboard* destination) const -> void {
+            *destination = Value;
+        }
+
+        template<int Bits>
+        [[nodiscard]] auto ShiftLeft() const -> Lanes {
+            return { Value << Bits };
+        }
+
+        template<int Bits>
+        [[nodiscard]] auto ShiftRight() const -> Lanes {
+            return { Value >> Bits };
+        }
+
+        /// <summary>
+        /// Gets <c>~this & other</c>
+        /// </summary>
+        [[nodiscard]] auto AndNot(const Lanes other) const -> Lanes {
+            return { ~Value & other.Value };
+        }
+
+        friend auto operator&(const Lanes a, const Lanes b) -> Lanes { return { a.Value & b.Value }; }
+        friend auto operator|(const Lanes a, const Lanes b) -> Lanes { return { a.Value | b.Value }; }
+    };
+#endif
+
+    static_assert(Padding % Lanes::Count == 0 && ChunkSize % Padding == 0);
+
+    /// <summary>
+    /// Moves every square a step in a direction, positive steps towards h8
+    /// </summary>
+    template<int Step>
+    auto Shift(const Lanes squares) -> Lanes {
+        if constexpr (Step > 0) {
+            return squares.ShiftLeft<Step>();
+        }
+        else {
+            return squares.ShiftRight<-Step>();
+        }
+    }
+
+    /// <summary>
+    /// Gets the squares a step in a direction can land on without wrapping around the board
+    /// </summary>
+    constexpr auto Landing(const int step) -> Bitboard {
+        switch ((step % 8 + 8) % 8) {
+            case 1: return NotAFile;
+            case 7: return NotHFile;
+            default: return ~Bitboard { 0 };
+        }
+    }
+
+    /// <summary>
+    /// Gets the squares attacked by sliders in one direction with a Kogge-Stone fill, which doubles the
+    /// distance of the slide in each of its three steps
+    /// </summary>
+    template<int Step>
+    auto Slide(Lanes sliders, Lanes empty) -> Lanes {
+        const auto landing = Lanes::Broadcast(Landing(Step));
+
+        empty = empty & landing;
+        sliders = sliders | (empty & Shift<Step>(sliders));
+        empty = empty & Shift<Step>(empty);
+        sliders = sliders | (empty & Shift<2 * Step>(sliders));
+        empty = empty & Shift<2 * Step>(empty);
+        sliders = sliders | (empty & Shift<4 * Step>(sliders));
+
+        return Shift<Step>(sliders) & landing;
+    }
+
+    /// <summary>
+    /// Gets the squares one step away from the pieces in a direction
+    /// </summary>
+    template<int Step>
+    auto Adjacent(const Lanes pieces) -> Lanes {
+        return Shift<Step>(pieces) & Lanes::Broadcast(Landing(Step));
+    }
+
+    /// <summary>
+    /// Gets the squares the knights attack, each of the eight jumps a shift and a mask
+    /// </summary>
+    auto KnightFill(const Lanes knights) -> Lanes {
+        const auto notA = Lanes::Broadcast(NotAFile);
+        const auto notH = Lanes::Broadcast(NotHFile);
+        const auto notAB = Lanes::Broadcast(NotABFile);
+        const auto notGH = Lanes::Broadcast(NotGHFile);
+
+        return (Shift<17>(knights) & notA) | (Shift<15>(knights) & notH)
+            | (Shift<10>(knights) & notAB) | (Shift<6>(knights) & notGH)
+            | (Shift<-15>(knights) & notA) | (Shift<-17>(knights) & notH)
+            | (Shift<-6>(knights) & notAB) | (Shift<-10>(knights) & notGH);
+    }
+
+    auto Select(const Lanes mask, const Lanes whenSet, const Lanes whenClear) -> Lanes {
+        return (mask & whenSet) | mask.AndNot(whenClear);
+    }
+
+    /// <summary>
+    /// Gets the squares the side not to move attacks in a group of positions. The king of the side to move is
+    /// left out of the occupancy, so that it cannot step back along the line of a slider that checks it
+    /// </summary>
+    auto AttackMaps(const std::array<const Bitboard*, PositionBatch::KindCount>& pieces, const Lanes whiteToMove) -> Lanes {
+        using Kind = PositionBatch::Kind;
+
+        const auto load = [&](const Kind kind) { return Lanes::Load(pieces[kind]); };
+        const auto them = [&](const Kind white, const Kind black) { return Select(whiteToMove, load(black), load(white)); };
+
+        auto occupied = load(Kind::WhitePawn);
+        for (int kind = Kind::WhiteKnight; kind < Kind::KindCount; kind++) {
+            occupied = occupied | load(static_cast<Kind>(kind));
+        }
+
+        const auto ourKing = Select(whiteToMove, load(Kind::WhiteKing), load(Kind::BlackKing));
+        const auto empty = occupied.AndNot(Lanes::Broadcast(~Bitboard { 0 })) | ourKing;
+
+        const auto whitePawns = load(Kind::WhitePawn);
+        const auto blackPawns = load(Kind::BlackPawn);
+        const auto pawns = Select(whiteToMove,
+            Adjacent<-7>(blackPawns) | Adjacent<-9>(blackPawns),
+            Adjacent<7>(whitePawns) | Adjacent<9>(whitePawns));
+
+        const auto king = them(Kind::WhiteKing, Kind::BlackKing);
+        const auto kings = Adjacent<1>(king) | Adjacent<-1>(king) | Adjacent<8>(king) | Adjacent<-8>(king)
+            | Adjacent<7>(king) | Adjacent<9>(king) | Adjacent<-7>(king) | Adjacent<-9>(king);
+
+        const auto queens = them(Kind::WhiteQueen, Kind::BlackQueen);
+        const auto straight = them(Kind::WhiteRook, Kind::BlackRook) | queens;
+        const auto diagonal = them(Kind::WhiteBishop, Kind::BlackBishop) | queens;
+
+        return pawns | kings | KnightFill(them(Kind::WhiteKnight, Kind::BlackKnight))
+            | Slide<1>(straight, empty) | Slide<-1>(straight, empty) | Slide<8>(straight, empty) | Slide<-8>(straight, empty)
+            | Slide<9>(diagonal, empty) | Slide<-9>(diagonal, empty) | Slide<7>(diagonal, empty) | Slide<-7>(diagonal, empty);
+    }
+
+    auto SliderAttacks(const int square, const Bitboard occupied, const int firstDirection) -> Bitboard {
+        Bitboard attacks = 0;
+
+        for (int direction = firstDirection; direction < firstDirection + 4; direction++) {
+            auto ray = Rays[direction][square];
+
+            if (const auto blockers = ray & occupied) {
+                ray &= ~Rays[direction][NearestSquare(direction, blockers)];
+            }
+
+            attacks |= ray;
+        }
+
+        return attacks;
+    }
+
+    /// <summary>
+    /// The pieces of a position seen from the side to move
+    /// </summary>
+    struct Sides {
+        std::array<Bitboard, 6> Us;
+        std::array<Bitboard, 6> Them;
+        Bitboard Own;
+        Bitboard Enemy;
+        bool White;
+    };
+
+    /// <summary>
+    /// Gets the pieces of the side not to move that attack a square
+    /// </summary>
+    auto Attackers(const Sides& sides, const int square, const Bitboard occupied) -> Bitboard {
+        const auto& them = sides.Them;
+
+        return (PawnAttacks[sides.White ? 0 : 1][square] & them[0])
+            | (KnightAttacks[square] & them[1])
+            | (KingAttacks[square] & them[5])
+            | (SliderAttacks(square, occupied, BishopRays) & (them[2] | them[4]))
+            | (SliderAttacks(square, occupied, RookRays) & (them[3] | them[4]));
+    }
+
+    /// <summary>
+    /// Counts the legal moves of a position from the squares the other side attacks
+    /// </summary>
+    auto CountMoves(const Sides& sides, const uint8_t flags, const int enPassant, const Bitboard attacked, const Bitboard checkers) -> int {
+        const auto& us = sides.Us;
+        const auto& them = sides.Them;
+        const auto occupied = sides.Own | sides.Enemy;
+        const int king = std::countr_zero(us[5]);
+
+        int count = std::popcount(KingAttacks[king] & ~sides.Own & ~attacked);
+
+        if (std::popcount(checkers) > 1) {
+            return count;
+        }
+
+        // In check only capturing the checker or blocking its line is allowed
+        auto targets = ~sides.Own;
+        if (checkers) {
+            targets &= checkers | SquaresBetween[king][std::countr_zero(checkers)];
+        }
+
+        // A pinned piece stays on the line through its king and the pinner
+        Bitboard pinned = 0;
+        std::array<std::pair<int, Bitboard>, 8> pins {};
+        int pinCount = 0;
+
+        for (int direction = 0; direction < static_cast<int>(RayDirections.size()); direction++) {
+            const auto ray = Rays[direction][king] & occupied;
+
+            if (!ray) {
+                continue;
+            }
+
+            const int first = NearestSquare(direction, ray);
+            const auto beyond = ray & ~(Bitboard { 1 } << first);
+
+            if (!(sides.Own & Bitboard { 1 } << first) || !beyond) {
+                continue;
+            }
+
+            const int second = NearestSquare(direction, beyond);
+            const auto pinners = direction < BishopRays ? them[3] | them[4] : them[2] | them[4];
+
+            if (pinners & Bitboard { 1 } << second) {
+                pinned |= Bitboard { 1 } << first;
+                pins[pinCount++] = { first, LineThrough[king][second] };
+            }
+        }
+
+        const auto allowed = [&](const int square) -> Bitboard {
+            if (!(pinned & Bitboard { 1 } << square)) {
+                return ~Bitboard { 0 };
+            }
+
+            for (int i = 0; i < pinCount; i++) {
+                if (pins[i].first == square) {
+                    return pins[i].second;
+                }
+            }
+
+            return 0;
+        };
+
+        for (auto knights = us[1] & ~pinned; knights; knights &= knights - 1) {
+            count += std::popcount(KnightAttacks[std::countr_zero(knights)] & targets);
+        }
+
+        for (int kind = 2; kind <= 4; kind++) {
+            for (auto pieces = us[kind]; pieces; pieces &= pieces - 1) {
+                const int square = std::countr_zero(pieces);
+                Bitboard attacks = 0;
+
+                if (kind != 3) attacks |= SliderAttacks(square, occupied, BishopRays);
+                if (kind != 2) attacks |= SliderAttacks(square, occupied, RookRays);
+
+                count += std::popcount(attacks & targets & allowed(square));
+            }
+        }
+
+        const int forward = sides.White ? 8 : -8;
+        const int startRank = sides.White ? 1 : 6;
+        const int lastRank = sides.White ? 7 : 0;
+
+        for (auto pawns = us[0]; pawns; pawns &= pawns - 1) {
+            const int square = std::countr_zero(pawns);
+            Bitboard moves = PawnAttacks[sides.White ? 0 : 1][square] & sides.Enemy;
+
+            if (const int one = square + forward; !(occupied & Bitboard { 1 } << one)) {
+                moves |= Bitboard { 1 } << one;
+
+                if (const int two = one + forward; square / 8 == startRank && !(occupied & Bitboard { 1 } << two)) {
+                    moves |= Bitboard { 1 } << two;
+                }
+            }
+
+            moves &= targets & allowed(square);
+
+            // Each promotion is four moves
+            const auto promotions = moves & (Bitboard { 0xFF } << (lastRank * 8));
+            count += std::popcount(moves & ~promotions) + 4 * std::popcount(promotions);
+
+            if (enPassant >= 0 && PawnAttacks[sides.White ? 0 : 1][square] & Bitboard { 1 } << enPassant) {
+                // Taking en passant clears two squares of a rank at once, so the king is checked from scratch
+                const int captured = enPassant - forward;
+                auto after = sides;
+                after.Them[0] &= ~(Bitboard { 1 } << captured);
+
+                const auto occupiedAfter = (occupied & ~(Bitboard { 1 } << square) & ~(Bitboard { 1 } << captured)) | Bitboard { 1 } << enPassant;
+                count += Attackers(after, king, occupiedAfter) ? 0 : 1;
+            }
+        }
+
+        if (checkers) {
+            return count;
+        }
+
+        const int backRank = sides.White ? 0 : 56;
+        const bool kingSide = flags & (sides.White ? PositionBatch::WhiteKingSide : PositionBatch::BlackKingSide);
+        const bool queenSide = flags & (sides.White ? PositionBatch::WhiteQueenSide : PositionBatch::BlackQueenSide);
+
+        if (king == backRank + 4) {
+            const auto rank = [&](const Bitboard squares) { return squares << backRank; };
+
+            if (kingSide && us[3] & rank(0x80) && !(occupied & rank(0x60)) && !(attacked & rank(0x60))) {
+                count++;
+            }
+
+            if (queenSide && us[3] & rank(0x01) && !(occupied & rank(0x0E)) && !(attacked & rank(0x0C))) {
+                count++;
+            }
+        }
+
+        return count;
+    }
+}
+
+auto PositionBatch::Add(const Fen::State& state) -> void {
+    if (m_Size % Padding == 0) {
+        for (auto& pieces : m_Pieces) {
+            pieces.resize(m_Size + Padding);
+        }
+
+        m_Flags.resize(m_Size + Padding);
+        m_EnPassant.resize(m_Size + Padding, -1);
+    }
+
+    for (int square = 0; square < 64; square++) {
+        const auto piece = state.Squares[square];
+
+        if (piece == PieceFlag::None) {
+            continue;
+        }
+
+        const auto type = piece & ~(PieceFlag::White | PieceFlag::Black);
+        const int kind = type == PieceFlag::Pawn ? 0
+            : type == PieceFlag::Knight ? 1
+            : type == PieceFlag::Bishop ? 2
+            : type == PieceFlag::Rook ? 3
+            : type == PieceFlag::Queen ? 4
+            : 5;
+
+        m_Pieces[kind + ((piece & PieceFlag::White) == PieceFlag::White ? 0 : 6)][m_Size] |= Bitboard { 1 } << square;
+    }
+
+    m_Flags[m_Size] = static_cast<uint8_t>((state.WhiteToMove ? WhiteToMove : 0)
+        | (state.WhiteCanCastleKingSide ? WhiteKingSide : 0)
+        | (state.WhiteCanCastleQueenSide ? WhiteQueenSide : 0)
+        | (state.BlackCanCastleKingSide ? BlackKingSide : 0)
+        | (state.BlackCanCastleQueenSide ? BlackQueenSide : 0));
+    m_EnPassant[m_Size] = static_cast<int8_t>(state.EnPassantSquare);
+    m_Size++;
+}
+
+auto PositionBatch::Add(const std::string_view fen) -> Fen::Result {
+    Fen::State state;
+    const auto result = Fen::Parse(fen, state);
+
+    if (result) {
+        Add(state);
+    }
+
+    return result;
+}
+
+auto PositionBatch::Clear() -> void {
+    for (auto& pieces : m_Pieces) {
+        pieces.clear();
+    }
+
+    m_Flags.clear();
+    m_EnPassant.clear();
+    m_Size = 0;
+}
+
+auto PositionBatch::Reserve(const size_t positions) -> void {
+    const auto padded = (positions + Padding - 1) / Padding * Padding;
+
+    for (auto& pieces : m_Pieces) {
+        pieces.reserve(padded);
+    }
+
+    m_Flags.reserve(padded);
+    m_EnPassant.reserve(padded);
+}
+
+auto PositionBatch::Analyze(Results& results, const int threads) const -> void {
+    results.MoveCounts.resize(m_Size);
+    results.InCheck.resize(m_Size);
+    results.Scores.resize(m_Size);
+
+    if (threads <= 1 || m_Size <= ChunkSize) {
+        AnalyzeRange(0, m_Size, results);
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    std::vector<std::jthread> workers;
+
+    for (int thread = 0; thread < threads; thread++) {
+        workers.emplace_back([&] {
+            for (auto begin = next.fetch_add(ChunkSize); begin < m_Size; begin = next.fetch_add(ChunkSize)) {
+                AnalyzeRange(begin, std::min(begin + ChunkSize, m_Size), results);
+            }
+        });
+    }
+}
+
+auto PositionBatch::GetInstructionSet() -> std::string_view {
+    return Lanes::Name;
+}
+
+auto PositionBatch::AnalyzeRange(const size_t begin, const size_t end, Results& results) const -> void {
+    std::array<Bitboard, Lanes::Count> attacked {};
+    std::array<Bitboard, Lanes::Count> whiteToMove {};
+    std::array<const Bitboard*, KindCount> pieces {};
+
+    for (auto group = begin; group < end; group += Lanes::Count) {
+        for (size_t lane = 0; lane < Lanes::Count; lane++) {
+            whiteToMove[lane] = m_Flags[group + lane] & WhiteToMove ? ~Bitboard { 0 } : 0;
+        }
+
+        for (int kind = 0; kind < KindCount; kind++) {
+            pieces[kind] = m_Pieces[kind].data() + group;
+        }
+
+        AttackMaps(pieces, Lanes::Load(whiteToMove.data())).Store(attacked.data());
+
+        for (size_t lane = 0; lane < Lanes::Count && group + lane < end; lane++) {
+            const auto index = group + lane;
+            const bool white = m_Flags[index] & WhiteToMove;
+
+            Sides sides {};
+            sides.White = white;
+
+            std::array<Bitboard, KindCount> position {};
+            for (int kind = 0; kind < KindCount; kind++) {
+                position[kind] = m_Pieces[kind][index];
+            }
+
+            for (int type = 0; type < 6; type++) {
+                sides.Us[type] = position[type + (white ? 0 : 6)];
+                sides.Them[type] = position[type + (white ? 6 : 0)];
+                sides.Own |= sides.Us[type];
+                sides.Enemy |= sides.Them[type];
+            }
+
+            const auto checkers = Attackers(sides, std::countr_zero(sides.Us[5]), sides.Own | sides.Enemy);
+
+            results.InCheck[index] = checkers ? 1 : 0;
+            results.MoveCounts[index] = static_cast<uint8_t>(CountMoves(sides, m_Flags[index], m_EnPassant[index], attacked[lane], checkers));
+            results.Scores[index] = static_cast<int16_t>(Evaluation::Evaluate(position, white));
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,686 @@
+#include <pch.hpp>
+#include <PositionIndex.hpp>
+#include <MappedFile.hpp>
+#include <Bitboard.hpp>
+#include <Board.hpp>
+#include <Move.hpp>
+#include <Piece.hpp>
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <queue>
+#include <unordered_set>
+
+static_assert(std::endian::native == std::endian::little, "Runs are read in place as little-endian");
+
+namespace {
+    /// <summary>
+    /// A position in a run. The moves of an entry run from its first move to the first move of the next entry
+    /// </summary>
+    struct Entry {
+        uint64_t Key;
+        uint32_t Count;
+        uint32_t WhiteWins;
+        uint32_t Draws;
+        uint32_t BlackWins;
+        uint64_t FirstMove;
+    };
+
+    struct MoveRecord {
+        PositionIndex::MoveCode Move;
+        uint16_t Reserved;
+        uint32_t Count;
+    };
+
+    static_assert(sizeof(Entry) == 32 && sizeof(MoveRecord) == 8);
+
+    /// <summary>
+    /// The counts of a run are 32 bits and stop at the largest value rather than wrap
+    /// </summary>
+    auto Saturate(const uint64_t count) -> uint32_t {
+        return static_cast<uint32_t>(std::min<uint64_t>(count, std::numeric_limits<uint32_t>::max()));
+    }
+
+    /// <summary>
+    /// Adds up the counts of equal moves, which must be next to each other
+    /// </summary>
+    auto CombineMoves(std::vector<PositionIndex::MoveCount>& moves) -> void {
+        size_t size = 0;
+
+        for (size_t i = 0; i < moves.size(); i++) {
+            if (size > 0 && moves[size - 1].Move == moves[i].Move) {
+                moves[size - 1].Count += moves[i].Count;
+            }
+            else {
+                moves[size++] = moves[i];
+            }
+        }
+
+        moves.resize(size);
+    }
+
+    auto BySequence(const std::filesystem::path& path) -> uint64_t {
+        try {
+            return std::stoull(path.stem().string());
+        }
+        catch (const std::exception&) {
+            return 0;
+        }
+    }
+}
+
+/// <summary>
+/// An immutable run of entries sorted by key, mapped from its file
+/// </summary>
+class PositionIndex::Run final {
+public:
+    explicit Run(std::filesystem::path path) : m_Path(std::move(path)), m_File(m_Path) {
+        const auto bytes = m_File.GetBytes();
+
+        if (bytes.size() < HeaderSize || !std::equal(Magic.begin(), Magic.end(), bytes.begin())) {
+            throw std::runtime_error(m_Path.string() + " is not a position index run");
+        }
+
+        uint32_t version;
+        uint64_t entries, moves;
+        std::memcpy(&version, bytes.data() + 4, sizeof(version));
+        std::memcpy(&Level, bytes.data() + 8, sizeof(Level));
+        std::memcpy(&entries, bytes.data() + 16, sizeof(entries));
+        std::memcpy(&moves, bytes.data() + 24, sizeof(moves));
+
+        if (version != Version) {
+            throw std::runtime_error(m_Path.string() + ": unsupported position index version");
+        }
+
+        if (bytes.size() != HeaderSize + entries * sizeof(Entry) + moves * sizeof(MoveRecord)) {
+            throw std::runtime_error(m_Path.string() + ": truncated position index run");
+        }
+
+        m_Entries = { reinterpret_cast<const Entry*>(bytes.data() + HeaderSize), entries };
+        m_Moves = { reinterpret_cast<const MoveRecord*>(m_Entries.data() + entries), moves };
+    }
+
+    [[nodiscard]] auto GetPath() const noexcept -> const std::filesystem::path& {
+        return m_Path;
+    }
+
+    [[nodiscard]] auto GetEntries() const noexcept -> std::span<const Entry> {
+        return m_Entries;
+    }
+
+    [[nodiscard]] auto GetMoves(const size_t entry) const noexcept -> std::span<const MoveRecord> {
+        const auto end = entry + 1 < m_Entries.size() ? m_Entries[entry + 1].FirstMove : m_Moves.size();
+        return m_Moves.subspan(m_Entries[entry].FirstMove, end - m_Entries[entry].FirstMove);
+    }
+
+    /// <summary>
+    /// Finds the entry of a key. Zobrist keys are uniform, so interpolating between the keys at the ends of the
+    /// range lands a few entries from the key and a lookup touches two or three pages of the run
+    /// </summary>
+    /// <returns><c>size_t</c> The index of the entry, the number of entries if the key is not in the run</returns>
+    [[nodiscard]] auto Find(const uint64_t key) const noexcept -> size_t {
+        size_t low = 0, high = m_Entries.size();
+
+        for (int step = 0; step < 8 && high - low > 16; step++) {
+            const auto lowKey = m_Entries[low].Key, highKey = m_Entries[high - 1].Key;
+
+            if (key < lowKey || key > highKey) {
+                return m_Entries.size();
+            }
+
+            const auto fraction = static_cast<double>(key - lowKey) / static_cast<double>(highKey - lowKey);
+            const auto guess = low + std::min(static_cast<size_t>(fraction * static_cast<double>(high - 1 - low)), high - 1 - low);
+
+            if (m_Entries[guess].Key == key) {
+                return guess;
+            }
+
+            if (m_Entries[guess].Key < key) {
+                low = guess + 1;
+            }
+            else {
+                high = guess;
+            }
+        }
+
+        const auto entry = std::lower_bound(m_Entries.begin() + static_cast<ptrdiff_t>(low), m_Entries.begin() + static_cast<ptrdiff_t>(high), key,
+            [](const Entry& e, const uint64_t k) { return e.Key < k; });
+
+        return entry != m_Entries.end() && entry->Key == key ? static_cast<size_t>(entry - m_Entries.begin()) : m_Entries.size();
+    }
+
+    uint32_t Level = 0;
+
+    /// <summary>
+    /// Set while the run is being merged, so a concurrent merge does not take it too. Guarded by the index
+    /// </summary>
+    bool Merging = false;
+
+private:
+    std::filesystem::path m_Path;
+    MappedFile m_File;
+    std::span<const Entry> m_Entries;
+    std::span<const MoveRecord> m_Moves;
+};
+
+/// <summary>
+/// Writes a run in key order. The moves go to a side file that is appended after the entries at the end, and
+/// the run only takes its name once it is complete
+/// </summary>
+class PositionIndex::RunWriter final {
+public:
+    RunWriter(std::filesystem::path path, const uint32_t level) :
+        m_Path(std::move(path)), m_Level(level),
+        m_Temporary(m_Path.string() + ".tmp"), m_MovesPath(m_Path.string() + ".moves.tmp"),
+        m_Stream(m_Temporary, std::ios::binary | std::ios::trunc), m_MovesStream(m_MovesPath, std::ios::binary | std::ios::trunc) {
+        if (!m_Stream || !m_MovesStream) {
+            throw std::runtime_error("Failed to create " + m_Temporary.string());
+        }
+
+        const std::array<char, HeaderSize> header {};
+        m_Stream.write(header.data(), header.size());
+    }
+
+    RunWriter(const RunWriter&) = delete;
+    auto operator=(const RunWriter&) -> RunWriter& = delete;
+
+    ~RunWriter() {
+        if (!m_Finished) {
+            m_Stream.close();
+            m_MovesStream.close();
+
+            std::error_code error;
+            std::filesystem::remove(m_Temporary, error);
+            std::filesystem::remove(m_MovesPath, error);
+        }
+    }
+
+    /// <summary>
+    /// Appends an entry, keys must come in increasing order
+    /// </summary>
+    /// <param name="moves"><c>span</c> The moves played from the position, without the zero move</param>
+    auto Add(const uint64_t key, const Stats& stats, const std::span<const MoveCount> moves) -> void {
+        const Entry entry { key, Saturate(stats.Count), Saturate(stats.WhiteWins), Saturate(stats.Draws), Saturate(stats.BlackWins), m_Moves };
+        m_Stream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+
+        for (const auto& move : moves) {
+            const MoveRecord record { move.Move, 0, Saturate(move.Count) };
+            m_MovesStream.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+
+        m_Entries++;
+        m_Moves += moves.size();
+    }
+
+    auto Finish() -> void {
+        m_MovesStream.close();
+
+        if (std::ifstream moves(m_MovesPath, std::ios::binary); m_Moves > 0) {
+            m_Stream << moves.rdbuf();
+        }
+
+        std::array<char, HeaderSize> header {};
+        std::memcpy(header.data(), Magic.data(), Magic.size());
+        std::memcpy(header.data() + 4, &Version, sizeof(Version));
+        std::memcpy(header.data() + 8, &m_Level, sizeof(m_Level));
+        std::memcpy(header.data() + 16, &m_Entries, sizeof(m_Entries));
+        std::memcpy(header.data() + 24, &m_Moves, sizeof(m_Moves));
+
+        m_Stream.seekp(0);
+        m_Stream.write(header.data(), header.size());
+        m_Stream.close();
+
+        if (!m_Stream || m_MovesStream.fail()) {
+            throw std::runtime_error("Failed to write " + m_Temporary.string());
+        }
+
+        std::filesystem::remove(m_MovesPath);
+        std::filesystem::rename(m_Temporary, m_Path);
+        m_Finished = true;
+    }
+
+private:
+    std::filesystem::path m_Path;
+    uint32_t m_Level;
+    std::filesystem::path m_Temporary;
+    std::filesystem::path m_MovesPath;
+    std::ofstream m_Stream;
+    std::ofstream m_MovesStream;
+    uint64_t m_Entries = 0;
+    uint64_t m_Moves = 0;
+    bool m_Finished = false;
+};
+
+auto PositionIndex::Writer::Add(const uint64_t key, const Outcome outcome, const MoveCode move) -> void {
+    if (m_Buffer.empty()) {
+        m_Buffer.reserve(m_Index.m_Options.BufferPositions);
+    }
+
+    m_Buffer.push_back({ key, move, outcome });
+
+    if (m_Buffer.size() >= m_Index.m_Options.BufferPositions) {
+        Flush();
+    }
+}
+
+auto PositionIndex::Writer::Flush() -> void {
+    if (m_Buffer.empty()) {
+        return;
+    }
+
+    // Sorting the log of occurrences brings the occurrences of a position and of each of its moves together
+    std::ranges::sort(m_Buffer, [](const Occurrence& a, const Occurrence& b) {
+        return a.Key != b.Key ? a.Key < b.Key : a.Move < b.Move;
+    });
+
+    const auto path = m_Index.NextPath(0);
+
+    {
+        RunWriter run(path, 0);
+        std::vector<MoveCount> moves;
+
+        for (size_t begin = 0; begin < m_Buffer.size();) {
+            const auto key = m_Buffer[begin].Key;
+            Stats stats;
+            moves.clear();
+
+            size_t end = begin;
+            for (; end < m_Buffer.size() && m_Buffer[end].Key == key; end++) {
+                const auto& occurrence = m_Buffer[end];
+                stats.Count++;
+                stats.WhiteWins += occurrence.Result == Outcome::WhiteWins;
+                stats.Draws += occurrence.Result == Outcome::Draw;
+                stats.BlackWins += occurrence.Result == Outcome::BlackWins;
+
+                if (occurrence.Move != 0) {
+                    moves.push_back({ occurrence.Move, 1 });
+                }
+            }
+
+            CombineMoves(moves);
+            run.Add(key, stats, moves);
+            begin = end;
+        }
+
+        run.Finish();
+    }
+
+    m_Buffer.clear();
+    m_Index.AddRun(path);
+}
+
+PositionIndex::PositionIndex(std::filesystem::path directory, const Options options) :
+    m_Directory(std::move(directory)), m_Options(options) {
+    m_Options.BufferPositions = std::max<size_t>(m_Options.BufferPositions, 1);
+    m_Options.MergeFanIn = std::max<size_t>(m_Options.MergeFanIn, 2);
+
+    std::filesystem::create_directories(m_Directory);
+    uint64_t sequence = 0;
+    std::vector<std::filesystem::path> files;
+
+    for (const auto& file : std::filesystem::directory_iterator(m_Directory)) {
+        if (!file.is_regular_file()) {
+            continue;
+        }
+
+        if (file.path().extension() == Extension) {
+            files.push_back(file.path());
+            sequence = std::max(sequence, BySequence(file.path()));
+        }
+        else if (file.path().extension() == ".tmp") {
+            std::filesystem::remove(file.path());
+        }
+    }
+
+    m_Sequence = sequence + 1;
+
+    const auto manifest = m_Directory / ManifestName;
+
+    // An index written before there was a manifest takes all of its runs
+    if (!std::filesystem::exists(manifest)) {
+        for (const auto& file : files) {
+            m_Runs.push_back(std::make_shared<Run>(file));
+        }
+
+        WriteManifest(m_Runs);
+        return;
+    }
+
+    std::ifstream stream(manifest);
+    std::unordered_set<std::string> names;
+
+    for (std::string name; std::getline(stream, name);) {
+        if (!name.empty()) {
+            names.insert(name);
+        }
+    }
+
+    for (const auto& file : files) {
+        if (names.erase(file.filename().string()) > 0) {
+            m_Runs.push_back(std::make_shared<Run>(file));
+        }
+        else {
+            std::filesystem::remove(file);
+        }
+    }
+
+    if (!names.empty()) {
+        throw std::runtime_error((m_Directory / *names.begin()).string() + ": run in the manifest is missing");
+    }
+}
+
+PositionIndex::~PositionIndex() = default;
+
+auto PositionIndex::Find(const uint64_t key) const -> std::optional<Stats> {
+    Stats stats;
+
+    for (const auto& run : Snapshot()) {
+        const auto entry = run->Find(key);
+
+        if (entry == run->GetEntries().size()) {
+            continue;
+        }
+
+        const auto& found = run->GetEntries()[entry];
+        stats.Count += found.Count;
+        stats.WhiteWins += found.WhiteWins;
+        stats.Draws += found.Draws;
+        stats.BlackWins += found.BlackWins;
+
+        for (const auto& move : run->GetMoves(entry)) {
+            stats.Moves.push_back({ move.Move, move.Count });
+        }
+    }
+
+    if (stats.Count == 0) {
+        return std::nullopt;
+    }
+
+    std::ranges::sort(stats.Moves, {}, &MoveCount::Move);
+    CombineMoves(stats.Moves);
+    std::ranges::stable_sort(stats.Moves, std::greater {}, &MoveCount::Count);
+
+    return stats;
+}
+
+auto PositionIndex::Ingest(std::istream& pgn, const int threads) -> PgnReader::ReplayReport {
+    class Adder final : public PgnReader::Visitor {
+    public:
+        explicit Adder(PositionIndex& index) : m_Writer(index) {}
+
+        auto Visit(uint64_t, int, const PgnReader::Game& record, const Move* next) -> void override {
+            if (record.Result != m_Result) {
+                m_Result = record.Result;
+                m_Outcome = GetOutcome(m_Result);
+            }
+
+            m_Writer.Add(Board::GetHash(), m_Outcome, next != nullptr ? EncodeMove(*next) : 0);
+        }
+
+        auto Finish() -> void override {
+            m_Writer.Flush();
+        }
+
+    private:
+        Writer m_Writer;
+        std::string m_Result;
+        Outcome m_Outcome = Outcome::Unknown;
+    };
+
+    return PgnReader::Replay(pgn, threads, [this] { return std::make_unique<Adder>(*this); });
+}
+
+auto PositionIndex::Compact() -> void {
+    std::vector<std::shared_ptr<Run>> runs;
+    uint32_t level = 0;
+
+    {
+        std::lock_guard lock(m_Mutex);
+
+        for (const auto& run : m_Runs) {
+            if (!run->Merging) {
+                run->Merging = true;
+                runs.push_back(run);
+                level = std::max(level, run->Level);
+            }
+        }
+
+        if (runs.size() < 2) {
+            for (const auto& run : runs) {
+                run->Merging = false;
+            }
+
+            return;
+        }
+    }
+
+    Merge(runs, level + 1);
+}
+
+auto PositionIndex::GetRunCount() const -> size_t {
+    std::lock_guard lock(m_Mutex);
+    return m_Runs.size();
+}
+
+auto PositionIndex::GetEntryCount() const -> uint64_t {
+    uint64_t entries = 0;
+
+    for (const auto& run : Snapshot()) {
+        entries += run->GetEntries().size();
+    }
+
+    return entries;
+}
+
+auto PositionIndex::GetKeys(const size_t run) const -> std::vector<uint64_t> {
+    const auto runs = Snapshot();
+    std::vector<uint64_t> keys;
+
+    if (run < runs.size()) {
+        keys.reserve(runs[run]->GetEntries().size());
+
+        for (const auto& entry : runs[run]->GetEntries()) {
+            keys.push_back(entry.Key);
+        }
+    }
+
+    return keys;
+}
+
+auto PositionIndex::EncodeMove(const Move& move) -> MoveCode {
+    int promotion = 0;
+
+    if (move.Type == Move::MoveType::Promotion || move.Type == Move::MoveType::PromotionCapture) {
+        switch (move.Promotion) {
+            case PieceFlag::Knight: promotion = 1; break;
+            case PieceFlag::Bishop: promotion = 2; break;
+            case PieceFlag::Rook: promotion = 3; break;
+            default: promotion = 4; break;
+        }
+    }
+
+    return static_cast<MoveCode>(SquareIndex(move.From) | SquareIndex(move.To) << 6 | promotion << 12);
+}
+
+auto PositionIndex::MoveName(const MoveCode move) -> std::string {
+    const int from = move & 63, to = move >> 6 & 63, promotion = move >> 12;
+
+    std::string name {
+        static_cast<char>('a' + from % 8), static_cast<char>('1' + from / 8),
+        static_cast<char>('a' + to % 8), static_cast<char>('1' + to / 8)
+    };
+
+    if (promotion > 0) {
+        name += "nbrq"[(promotion - 1) & 3];
+    }
+
+    return name;
+}
+
+auto PositionIndex::GetOutcome(const std::string_view result) -> Outcome {
+    if (result == "1-0") return Outcome::WhiteWins;
+    if (result == "0-1") return Outcome::BlackWins;
+    if (result == "1/2-1/2") return Outcome::Draw;
+    return Outcome::Unknown;
+}
+
+auto PositionIndex::AddRun(const std::filesystem::path& path) -> void {
+    auto run = std::make_shared<Run>(path);
+    const auto level = run->Level;
+
+    {
+        std::lock_guard lock(m_Mutex);
+        auto runs = m_Runs;
+        runs.push_back(std::move(run));
+
+        WriteManifest(runs);
+        m_Runs = std::move(runs);
+    }
+
+    MergeLevel(level);
+}
+
+auto PositionIndex::MergeLevel(const uint32_t level) -> void {
+    while (true) {
+        std::vector<std::shared_ptr<Run>> runs;
+
+        {
+            std::lock_guard lock(m_Mutex);
+
+            for (const auto& run : m_Runs) {
+                if (run->Level == level && !run->Merging && runs.size() < m_Options.MergeFanIn) {
+                    runs.push_back(run);
+                }
+            }
+
+            if (runs.size() < m_Options.MergeFanIn) {
+                return;
+            }
+
+            for (const auto& run : runs) {
+                run->Merging = true;
+            }
+        }
+
+        Merge(runs, level + 1);
+        MergeLevel(level + 1);
+    }
+}
+
+auto PositionIndex::Merge(const std::vector<std::shared_ptr<Run>>& runs, const uint32_t level) -> void {
+    const auto path = NextPath(level);
+
+    try {
+        RunWriter writer(path, level);
+
+        // A k-way merge over the runs, the heap holds the next entry of every run that has one left
+        using Cursor = std::pair<uint64_t, size_t>;
+        std::priority_queue<Cursor, std::vector<Cursor>, std::greater<>> heap;
+        std::vector<size_t> positions(runs.size(), 0);
+
+        for (size_t i = 0; i < runs.size(); i++) {
+            if (!runs[i]->GetEntries().empty()) {
+                heap.emplace(runs[i]->GetEntries().front().Key, i);
+            }
+        }
+
+        std::vector<MoveCount> moves;
+
+        while (!heap.empty()) {
+            const auto key = heap.top().first;
+            Stats stats;
+            moves.clear();
+
+            while (!heap.empty() && heap.top().first == key) {
+                const auto i = heap.top().second;
+                heap.pop();
+
+                const auto entry = positions[i]++;
+                const auto& found = runs[i]->GetEntries()[entry];
+                stats.Count += found.Count;
+                stats.WhiteWins += found.WhiteWins;
+                stats.Draws += found.Draws;
+                stats.BlackWins += found.BlackWins;
+
+                for (const auto& move : runs[i]->GetMoves(entry)) {
+                    moves.push_back({ move.Move, move.Count });
+                }
+
+                if (positions[i] < runs[i]->GetEntries().size()) {
+                    heap.emplace(runs[i]->GetEntries()[positions[i]].Key, i);
+                }
+            }
+
+            std::ranges::sort(moves, {}, &MoveCount::Move);
+            CombineMoves(moves);
+            writer.Add(key, stats, moves);
+        }
+
+        writer.Finish();
+
+        auto merged = std::make_shared<Run>(path);
+        std::lock_guard lock(m_Mutex);
+
+        auto live = m_Runs;
+        std::erase_if(live, [&](const std::shared_ptr<Run>& run) { return std::ranges::find(runs, run) != runs.end(); });
+        live.push_back(std::move(merged));
+
+        // The merge takes effect when the manifest is replaced, until then the merged run is a leftover
+        WriteManifest(live);
+        m_Runs = std::move(live);
+    }
+    catch (...) {
+        std::lock_guard lock(m_Mutex);
+        std::error_code error;
+        std::filesystem::remove(path, error);
+
+        for (const auto& run : runs) {
+            run->Merging = false;
+        }
+
+        throw;
+    }
+
+    // Lookups that still hold a merged run keep reading its mapping after the file is gone. Runs that cannot be
+    // removed now are no longer in the manifest and go when the index is next opened
+    for (const auto& run : runs) {
+        std::error_code error;
+        std::filesystem::remove(run->GetPath(), error);
+    }
+}
+
+auto PositionIndex::NextPath(const uint32_t level) -> std::filesystem::path {
+    auto name = std::to_string(m_Sequence++);
+    name.insert(0, name.size() < 10 ? 10 - name.size() : 0, '0');
+
+    return m_Directory / (name + "-L" + std::to_string(level) + std::string(Extension));
+}
+
+auto PositionIndex::WriteManifest(const std::vector<std::shared_ptr<Run>>& runs) const -> void {
+    const auto manifest = m_Directory / ManifestName;
+    const std::filesystem::path temporary = manifest.string() + ".tmp";
+
+    {
+        std::ofstream stream(temporary, std::ios::trunc);
+
+        for (const auto& run : runs) {
+            stream << run->GetPath().filename().string() << '\n';
+        }
+
+        stream.close();
+
+        if (!stream) {
+            std::error_code error;
+            std::filesystem::remove(temporary, error);
+            throw std::runtime_error("Failed to write " + temporary.string());
+        }
+    }
+
+    std::filesystem::rename(temporary, manifest);
+}
+
+auto PositionIndex::Snapshot() const -> std::vector<std::shared_ptr<Run>> {
+    std::lock_guard lock(m_Mutex);
+    return m_Runs;
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include <pch.hpp>
+#include <RecordingRenderBackend.hpp>
+
+using CommandType = RecordingRenderBackend::CommandType;
+
+auto RecordingRenderBackend::BeginFrame(const FrameConstants&) -> void {
+    if (m_InFrame) {
+        throw std::logic_error("BeginFrame called twice without EndFrame");
+    }
+
+    m_InFrame = true;
+    m_Frames++;
+    Record(CommandType::BeginFrame, 0, sizeof(FrameConstants));
+}
+
+auto RecordingRenderBackend::DrawBoard() -> void {
+    m_DrawCalls++;
+    Record(CommandType::DrawBoard, 1, 0);
+}
+
+auto RecordingRenderBackend::DrawHighlights(const std::span<const QuadInstance> instances) -> void {
+    if (instances.size() > MaxInstances) {
+        throw std::length_error("Too many highlights in a batch");
+    }
+
+    // Empty batches are skipped like a device backend would
+    if (instances.empty()) {
+        return;
+    }
+
+    m_DrawCalls++;
+    Record(CommandType::DrawHighlights, instances.size(), instances.size_bytes());
+}
+
+auto RecordingRenderBackend::DrawPieces(const std::span<const QuadInstance> instances) -> void {
+    if (instances.size() > MaxInstances) {
+        throw std::length_error("Too many pieces in a batch");
+    }
+
+    m_Pieces.assign(instances.begin(), instances.end());
+
+    if (instances.empty()) {
+        return;
+    }
+
+    m_DrawCalls++;
+    Record(CommandType::DrawPieces, instances.size(), instances.size_bytes());
+}
+
+auto RecordingRenderBackend::EndFrame() -> void {
+    if (!m_InFrame) {
+        throw std::logic_error("EndFrame called without BeginFrame");
+    }
+
+    m_InFrame = false;
+    Record(CommandType::EndFrame, 0, 0);
+}
+
+auto RecordingRenderBackend::GetCommands() const noexcept -> const std::vector<Command>& {
+    return m_Commands;
+}
+
+auto RecordingRenderBackend::GetPieces() const noexcept -> const std::vector<QuadInstance>& {
+    return m_Pieces;
+}
+
+auto RecordingRenderBackend::GetFrames() const noexcept -> size_t {
+    return m_Frames;
+}
+
+auto RecordingRenderBackend::GetDrawCalls() const noexcept -> size_t {
+    return m_DrawCalls;
+}
+
+auto RecordingRenderBackend::GetUploadBytes() const noexcept -> size_t {
+    return m_UploadBytes;
+}
+
+auto RecordingRenderBackend::Reset() -> void {
+    m_Commands.clear();
+    m_Pieces.clear();
+    m_Frames = 0;
+    m_DrawCalls = 0;
+    m_UploadBytes = 0;
+    m_InFrame = false;
+}
+
+auto RecordingRenderBackend::Record(const CommandType type, const size_t instances, const size_t uploadBytes) -> void {
+    m_UploadBytes += uploadBytes;
+    m_Commands.push_back({ type, instances, uploadBytes });
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include <pch.hpp>
+#include <RenderBackend.hpp>
+
+namespace {
+    /// <summary>
+    /// Highlights lie over the board and under the pieces
+    /// </summary>
+    constexpr float HighlightDepth = 0.005F;
+}
+
+auto RenderBackend::DrawFrame(const FrameConstants& constants, const std::span<const Move> moves, const std::span<const PieceSprite> pieces) -> void {
+    if (pieces.size() > MaxInstances) {
+        throw std::length_error("Too many pieces in a frame");
+    }
+
+    std::array<QuadInstance, MaxInstances> highlights;
+    std::array<QuadInstance, MaxInstances> sprites;
+    const auto highlightCount = std::min(moves.size(), MaxInstances);
+
+    for (size_t i = 0; i < highlightCount; i++) {
+        highlights[i] = { static_cast<float>(moves[i].To.x), static_cast<float>(moves[i].To.y), HighlightDepth, 0 };
+    }
+
+    for (size_t i = 0; i < pieces.size(); i++) {
+        sprites[i] = { pieces[i].X, pieces[i].Y, pieces[i].Z, PieceTextureIndex(pieces[i].Type) };
+    }
+
+    BeginFrame(constants);
+    DrawBoard();
+    DrawHighlights({ highlights.data(), highlightCount });
+    DrawPieces({ sprites.data(), pieces.size() });
+    EndFrame();
+}
\ No newline at end of file
@@ -0,0 +1,1066 @@
+#include <pch.hpp>
+#include <Search.hpp>
+#include <Board.hpp>
+#include <Piece.hpp>
+#include <Evaluation.hpp>
+#include <Metrics.hpp>
+#include <TranspositionTable.hpp>
+#include <Trace.hpp>
+
+#include <bit>
+#include <cmath>
+#include <thread>
+
+using Bound = TranspositionTable::Bound;
+using MoveType = Move::MoveType;
+
+namespace {
+    // Mate scores are stored relative to the node so that they stay valid when reached through another path
+    auto ToTableScore(const int score, const int ply) -> int {
+        if (score >= Search::MateBound) {
+            return score + ply;
+        }
+        if (score <= -Search::MateBound) {
+            return score - ply;
+        }
+        return score;
+    }
+
+    auto FromTableScore(const int score, const int ply) -> int {
+        if (score >= Search::MateBound) {
+            return score - ply;
+        }
+        if (score <= -Search::MateBound) {
+            return score + ply;
+        }
+        return score;
+    }
+
+    /// <summary>
+    /// History scores are pulled towards zero as they grow, so they stay within this bound
+    /// </summary>
+    constexpr int MaxHistory = 16384;
+
+    constexpr auto HistoryBonus(const int depth) -> int {
+        return std::min(32 * depth * depth, 2048);
+    }
+
+    /// <summary>
+    /// Applies a bonus or malus to a history score with gravity, a score near the bound barely moves further
+    /// </summary>
+    auto UpdateHistory(int16_t& entry, const int bonus) -> void {
+        entry = static_cast<int16_t>(entry + bonus - entry * std::abs(bonus) / MaxHistory);
+    }
+
+    /// <summary>
+    /// Indexes the twelve kinds of pieces, white pawn to queen and then black
+    /// </summary>
+    auto PieceIndex(const Piece piece) -> int {
+        const auto type = piece.GetType() & ~(PieceFlag::White | PieceFlag::Black);
+        return std::countr_zero(static_cast<uint8_t>(type)) + (piece.Is(PieceFlag::White) ? 0 : 6);
+    }
+
+    auto SquareOf(const Position& position) -> int {
+        return position.y * 8 + position.x;
+    }
+
+    auto IsQuiet(const Move& move) -> bool {
+        return move.Type == MoveType::Normal || move.Type == MoveType::Castle;
+    }
+
+    /// <summary>
+    /// Checks if the side to move has a piece other than pawns and the king. Without one, zugzwang is
+    /// common enough that passing the turn proves nothing
+    /// </summary>
+    auto HasNonPawnMaterial() -> bool {
+        const auto& board = Board::GetBoard();
+
+        for (auto pieces = Board::GetOccupancy(Board::IsWhiteToMove()); pieces; pieces &= pieces - 1) {
+            const auto piece = board[std::countr_zero(pieces)];
+
+            if (!piece.Is(PieceFlag::Pawn) && !piece.Is(PieceFlag::King)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+/// <summary>
+/// The search state of a single thread
+/// </summary>
+class Search::Worker final {
+public:
+    Worker(Search& search, const int id) :
+        m_Search(search), m_Id(id), m_Parameters(search.m_Parameters),
+        m_ContinuationHistory(std::make_unique<ContinuationTable>()) {
+        for (auto& moves : m_MoveLists) {
+            moves.reserve(64);
+        }
+
+        for (auto& moves : m_QuietLists) {
+            moves.reserve(64);
+        }
+
+        const double base = m_Parameters.ReductionBase / 100.0;
+        const double divisor = std::max(m_Parameters.ReductionDivisor, 1) / 100.0;
+
+        for (int depth = 1; depth < static_cast<int>(m_Reductions.size()); depth++) {
+            for (int move = 1; move < static_cast<int>(m_Reductions[depth].size()); move++) {
+                m_Reductions[depth][move] = std::max(static_cast<int>(base + std::log(depth) * std::log(move) / divisor), 0);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Deepens the search one iteration at a time until the search is stopped
+    /// </summary>
+    /// <param name="report"><c>ReportCallback</c> Called after each finished iteration, only given to the main thread</param>
+    auto Iterate(const ReportCallback* report) -> void {
+        std::vector<Move> rootMoves;
+        Board::GenerateMoves<Board::GenType::All>(rootMoves);
+
+        // Every thread searches all lines, so the helpers fill the table for each of them
+        const size_t lineCount = std::min(static_cast<size_t>(m_Search.m_MultiPv), rootMoves.size());
+
+        // Helpers start one ply deeper every other thread so that the threads do not move in lockstep
+        for (int depth = 1 + (m_Id & 1); depth < MaxPly; depth++) {
+            TRACE_SCOPE_VALUE("Iteration", depth);
+
+            m_SelectiveDepth = 0;
+            m_Excluded.clear();
+            m_Lines.clear();
+
+            for (size_t line = 0; line < lineCount; line++) {
+                const int score = Negamax(-Infinity, Infinity, depth, 0);
+
+                if (Stopped() || m_Pv[0].empty()) {
+                    break;
+                }
+
+                m_Lines.push_back({ score, m_Pv[0] });
+                m_Excluded.push_back(m_Pv[0].front());
+            }
+
+            // An unfinished iteration is thrown away as a whole, the lines of the last one stand
+            if (Stopped()) {
+                break;
+            }
+
+            // A later line can come out better than an earlier one when the table changed in between
+            std::ranges::stable_sort(m_Lines, std::greater {}, &Line::Score);
+
+            m_CompletedDepth = depth;
+            m_BestScore = m_Lines.front().Score;
+            m_BestPv = m_Lines.front().Pv;
+
+            if (m_Id != 0) {
+                continue;
+            }
+
+            if (report && *report) {
+                for (size_t line = 0; line < m_Lines.size(); line++) {
+                    (*report)({
+                        depth, m_SelectiveDepth, m_Lines[line].Score, m_Search.GetNodes(), m_Search.GetElapsed(),
+                        m_Search.m_Table.GetHashfull(), m_Lines[line].Pv, static_cast<int>(line) + 1
+                    });
+                }
+            }
+
+            if (m_Search.m_Limits.Depth > 0 && depth >= m_Search.m_Limits.Depth) {
+                break;
+            }
+
+            // Another iteration would most likely not finish in time
+            if (m_Search.m_SoftTime > 0 && m_Search.GetElapsed() >= m_Search.m_SoftTime / 2) {
+                break;
+            }
+        }
+    }
+
+    [[nodiscard]] auto GetNodes() const -> uint64_t {
+        return m_Nodes.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto GetBestPv() const -> const std::vector<Move>& {
+        return m_BestPv;
+    }
+
+private:
+    /// <summary>
+    /// Searches a node with the selective toolkit: reverse futility and null move pruning before the moves,
+    /// futility and late move pruning of quiet moves, late move reductions and check extensions
+    /// </summary>
+    /// <param name="allowNull"><c>bool</c> False right after a null move and in verification searches</param>
+    auto Negamax(int alpha, const int beta, const int depth, const int ply, const bool allowNull = true) -> int {
+        const bool pvNode = beta - alpha > 1;
+        m_Pv[ply].clear();
+
+        if (depth <= 0) {
+            return Quiescence(alpha, beta, ply);
+        }
+
+        CountNode();
+
+        if (ply > 0 && Stopped()) {
+            return 0;
+        }
+
+        // Drawn cycles are cut off instead of being searched again and again
+        if (ply > 0 && Board::IsRepetition(ply)) {
+            return 0;
+        }
+
+        // The fifty moves rule does not apply when the move that reached the hundredth ply gave mate
+        if (ply > 0 && Board::GetHalfmoveClock() >= 100) {
+            if (auto& evasions = m_MoveLists[ply]; Board::IsInCheck()) {
+                Board::GenerateMoves<Board::GenType::Evasions>(evasions);
+
+                if (evasions.empty()) {
+                    return -MateScore + ply;
+                }
+            }
+
+            return 0;
+        }
+
+        if (ply >= MaxPly - 1) {
+            return Evaluation::Evaluate();
+        }
+
+        const auto hash = Board::GetHash();
+        uint16_t tableMove = 0;
+
+        if (const auto entry = m_Search.m_Table.Probe(hash)) {
+            tableMove = entry->Move;
+            const int score = FromTableScore(entry->Score, ply);
+
+            if (!pvNode && entry->Depth >= depth
+                && (entry->Type == Bound::Exact
+                    || (entry->Type == Bound::Lower && score >= beta)
+                    || (entry->Type == Bound::Upper && score <= alpha))) {
+                return score;
+            }
+        }
+
+        const bool inCheck = Board::IsInCheck();
+        const int staticEval = inCheck ? -Infinity : Evaluation::Evaluate();
+        const bool mateWindow = std::abs(beta) >= MateBound;
+
+        // So far ahead that even losing the margin for every remaining ply keeps the score above beta
+        if (!pvNode && !inCheck && !mateWindow && depth <= m_Parameters.ReverseFutilityDepth
+            && staticEval - m_Parameters.ReverseFutilityMargin * depth >= beta) {
+            return staticEval;
+        }
+
+        // If passing the turn still fails high, a real move almost certainly does as well
+        if (!pvNode && !inCheck && !mateWindow && allowNull && m_Parameters.NullMovePruning
+            && depth >= m_Parameters.NullMoveDepth && staticEval >= beta && HasNonPawnMaterial()) {
+            const int reduction = m_Parameters.NullMoveReduction + depth / std::max(m_Parameters.NullMoveDivisor, 1);
+
+            m_Stack[ply] = { -1, 0 };
+            Board::MakeNullMove();
+            int score = -Negamax(-beta, -beta + 1, depth - 1 - reduction, ply + 1, false);
+            Board::UnmakeNullMove();
+
+            if (Stopped()) {
+                return 0;
+            }
+
+            if (score >= beta) {
+                // A mate found after passing the turn is not a proven mate
+                score = std::min(score, MateBound - 1);
+
+                if (depth < m_Parameters.NullMoveVerifyDepth) {
+                    return score;
+                }
+
+                // Deep cutoffs are confirmed without null moves, which catches zugzwang the material test misses
+                const int verified = Negamax(beta - 1, beta, depth - reduction, ply, false);
+                m_Pv[ply].clear();
+
+                if (Stopped()) {
+                    return 0;
+                }
+
+                if (verified >= beta) {
+                    return score;
+                }
+            }
+        }
+
+        MovePicker picker(*this, ply, tableMove);
+        auto& tried = m_TriedQuiets[ply];
+        tried.clear();
+
+        const int originalAlpha = alpha;
+        int best = -Infinity;
+        uint16_t bestMove = 0;
+        int searched = 0;
+
+        while (const auto next = picker.Next()) {
+            const auto& move = *next;
+
+            // The first moves of the lines found before are left out at the root
+            if (ply == 0 && std::ranges::find(m_Excluded, move) != m_Excluded.end()) {
+                continue;
+            }
+
+            const bool quiet = IsQuiet(move);
+            int score;
+
+            m_Stack[ply] = { PieceIndex(Board::GetPiece(move.From)), SquareOf(move.To) };
+            Board::MakeMove(move);
+
+            const bool givesCheck = Board::IsInCheck();
+
+            // Once a move has saved the node from being mated, late and hopeless quiet moves are not searched
+            if (!pvNode && !inCheck && quiet && !givesCheck && best > -MateBound) {
+                const bool lateMove = depth <= m_Parameters.LateMovePruningDepth
+                    && searched >= m_Parameters.LateMovePruningBase + depth * depth;
+                const bool futile = depth <= m_Parameters.FutilityDepth
+                    && staticEval + m_Parameters.FutilityBase + m_Parameters.FutilityMargin * depth <= alpha;
+
+                if (lateMove || futile) {
+                    Board::UnmakeMove(move);
+                    searched++;
+                    continue;
+                }
+            }
+
+            const int newDepth = depth - 1 + (givesCheck && m_Parameters.CheckExtensions ? 1 : 0);
+
+            // The first move is expected to be the best, the rest only need to be proven worse
+            if (searched++ == 0) {
+                score = -Negamax(-beta, -alpha, newDepth, ply + 1);
+            }
+            else {
+                int reduction = 0;
+
+                // Quiet moves late in the ordering are searched shallower and only searched again if they surprise
+                if (depth >= 3 && quiet && !inCheck && !givesCheck) {
+                    const auto& row = m_Reductions[std::min<size_t>(depth, m_Reductions.size() - 1)];
+                    reduction = row[std::min<size_t>(searched, row.size() - 1)] - (pvNode ? 1 : 0);
+                    reduction = std::clamp(reduction, 0, newDepth - 1);
+                }
+
+                score = -Negamax(-alpha - 1, -alpha, newDepth - reduction, ply + 1);
+
+                if (reduction > 0 && score > alpha) {
+                    score = -Negamax(-alpha - 1, -alpha, newDepth, ply + 1);
+                }
+
+                if (score > alpha && score < beta) {
+                    score = -Negamax(-beta, -alpha, newDepth, ply + 1);
+                }
+            }
+
+            Board::UnmakeMove(move);
+
+            if (Stopped()) {
+                return 0;
+            }
+
+            if (quiet) {
+                tried.push_back(move);
+            }
+
+            if (score <= best) {
+                continue;
+            }
+
+            best = score;
+
+            if (score > alpha) {
+                alpha = score;
+                bestMove = TranspositionTable::PackMove(move);
+
+                m_Pv[ply].clear();
+                m_Pv[ply].emplace_back(move);
+                m_Pv[ply].insert(m_Pv[ply].end(), m_Pv[ply + 1].begin(), m_Pv[ply + 1].end());
+
+                if (alpha >= beta) {
+                    Metrics::Increment(Counter::BetaCutoffs);
+
+                    if (searched == 1) {
+                        Metrics::Increment(Counter::FirstMoveCutoffs);
+                    }
+
+                    if (quiet) {
+                        UpdateQuietStatistics(move, depth, ply);
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        // Every move is generated by the time the picker runs dry, so no move at all means mate or stalemate
+        if (picker.GetCount() == 0) {
+            return inCheck ? -MateScore + ply : 0;
+        }
+
+        // The root result of a later line only holds for part of the moves, it would mislead the next iteration
+        if (ply > 0 || m_Excluded.empty()) {
+            const auto bound = best >= beta ? Bound::Lower : best > originalAlpha ? Bound::Exact : Bound::Upper;
+            m_Search.m_Table.Store(hash, {
+                bestMove, static_cast<int16_t>(ToTableScore(best, ply)), static_cast<uint8_t>(depth), bound
+            });
+        }
+
+        return best;
+    }
+
+    /// <summary>
+    /// Searches captures until the position is quiet, or every evasion while in check
+    /// </summary>
+    auto Quiescence(int alpha, const int beta, const int ply) -> int {
+        CountNode();
+        m_SelectiveDepth = std::max(m_SelectiveDepth, ply);
+
+        if (Stopped()) {
+            return 0;
+        }
+
+        const bool inCheck = Board::IsInCheck();
+
+        if (ply >= MaxPly - 1) {
+            return inCheck ? 0 : Evaluation::Evaluate();
+        }
+
+        int best = -Infinity;
+
+        // Standing pat is only possible when not forced to answer a check
+        if (!inCheck) {
+            best = Evaluation::Evaluate();
+
+            if (best >= beta) {
+                return best;
+            }
+
+            alpha = std::max(alpha, best);
+        }
+
+        auto& moves = m_MoveLists[ply];
+
+        if (inCheck) {
+            Board::GenerateMoves<Board::GenType::Evasions>(moves);
+
+            if (moves.empty()) {
+                return -MateScore + ply;
+            }
+        }
+        else {
+            Board::GenerateMoves<Board::GenType::Captures>(moves);
+        }
+
+        OrderMoves(moves, 0);
+
+        for (const auto& move : moves) {
+            Board::MakeMove(move);
+            const int score = -Quiescence(-beta, -alpha, ply + 1);
+            Board::UnmakeMove(move);
+
+            if (Stopped()) {
+                return 0;
+            }
+
+            if (score > best) {
+                best = score;
+                alpha = std::max(alpha, score);
+
+                if (alpha >= beta) {
+                    break;
+                }
+            }
+        }
+
+        return best;
+    }
+
+    /// <summary>
+    /// Rewards a quiet move that caused a cutoff and punishes the quiet moves tried before it
+    /// </summary>
+    auto UpdateQuietStatistics(const Move& move, const int depth, const int ply) -> void {
+        const int bonus = HistoryBonus(depth);
+        const auto packed = TranspositionTable::PackMove(move);
+
+        for (const auto& tried : m_TriedQuiets[ply]) {
+            UpdateQuietHistory(tried, TranspositionTable::IsSameMove(packed, tried) ? bonus : -bonus, ply);
+        }
+
+        auto& killers = m_Killers[ply];
+        if (killers[0] != packed) {
+            killers[1] = killers[0];
+            killers[0] = packed;
+        }
+
+        if (ply > 0 && m_Stack[ply - 1].Piece >= 0) {
+            m_CounterMoves[m_Stack[ply - 1].Piece][m_Stack[ply - 1].To] = packed;
+        }
+    }
+
+    auto UpdateQuietHistory(const Move& move, const int bonus, const int ply) -> void {
+        const int piece = PieceIndex(Board::GetPiece(move.From));
+        const int to = SquareOf(move.To);
+
+        UpdateHistory(m_History[Board::IsWhiteToMove() ? 0 : 1][SquareOf(move.From)][to], bonus);
+
+        // The moves one and two plies back, the opponent's last move and our own move before it
+        for (const int back : { 1, 2 }) {
+            if (ply >= back && m_Stack[ply - back].Piece >= 0) {
+                UpdateHistory((*m_ContinuationHistory)[m_Stack[ply - back].Piece][m_Stack[ply - back].To][piece][to], bonus);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Scores a quiet move by the butterfly history and the continuation histories of the last two plies
+    /// </summary>
+    [[nodiscard]] auto QuietScore(const Move& move, const int ply) const -> int {
+        const int piece = PieceIndex(Board::GetPiece(move.From));
+        const int to = SquareOf(move.To);
+        int score = m_History[Board::IsWhiteToMove() ? 0 : 1][SquareOf(move.From)][to];
+
+        for (const int back : { 1, 2 }) {
+            if (ply >= back && m_Stack[ply - back].Piece >= 0) {
+                score += (*m_ContinuationHistory)[m_Stack[ply - back].Piece][m_Stack[ply - back].To][piece][to];
+            }
+        }
+
+        return score;
+    }
+
+    /// <summary>
+    /// Hands out the moves of a node in stages, so that no work is spent on the moves after a cutoff:
+    /// the table move, captures that do not lose material by most valuable victim, the killers, the counter
+    /// move, the other quiet moves by history, and last the captures that lose material
+    /// </summary>
+    class MovePicker final {
+    public:
+        MovePicker(Worker& worker, const int ply, const uint16_t tableMove) :
+            m_Worker(worker), m_Ply(ply), m_TableMove(tableMove), m_Killers(worker.m_Killers[ply]),
+            m_Captures(worker.m_MoveLists[ply]), m_Quiets(worker.m_QuietLists[ply]),
+            m_CaptureScores(worker.m_CaptureScores[ply]), m_QuietScores(worker.m_QuietScores[ply]) {
+            const auto& previous = ply > 0 ? worker.m_Stack[ply - 1] : StackEntry { -1, 0 };
+            m_CounterMove = previous.Piece >= 0 ? worker.m_CounterMoves[previous.Piece][previous.To] : 0;
+        }
+
+        /// <summary>
+        /// Gets the next move to search, or nothing when every move has been handed out
+        /// </summary>
+        auto Next() -> std::optional<Move> {
+            const auto move = NextMove();
+            m_Count += move ? 1 : 0;
+            return move;
+        }
+
+        /// <summary>
+        /// Gets the number of moves handed out so far
+        /// </summary>
+        [[nodiscard]] auto GetCount() const -> int {
+            return m_Count;
+        }
+
+    private:
+        enum class Stage : uint8_t {
+            TableMove,
+            GoodCaptures,
+            Killers,
+            CounterMove,
+            Quiets,
+            BadCaptures,
+            Done
+        };
+
+        auto NextMove() -> std::optional<Move> {
+            while (true) {
+                switch (m_Stage) {
+                    case Stage::TableMove: {
+                        m_Stage = Stage::GoodCaptures;
+                        Board::GenerateMoves<Board::GenType::Captures>(m_Captures);
+                        ScoreCaptures();
+
+                        if (m_TableMove == 0) {
+                            break;
+                        }
+
+                        if (const auto move = Find(m_Captures, m_TableMove)) {
+                            return move;
+                        }
+
+                        // The quiet moves are only generated this early to verify a quiet table move
+                        GenerateQuiets();
+
+                        if (const auto move = Find(m_Quiets, m_TableMove)) {
+                            return move;
+                        }
+
+                        break;
+                    }
+
+                    case Stage::GoodCaptures: {
+                        while (m_Current < m_Captures.size()) {
+                            PickBest(m_Captures, m_CaptureScores, m_Current);
+                            const auto move = m_Captures[m_Current++];
+
+                            if (TranspositionTable::IsSameMove(m_TableMove, move)) {
+                                continue;
+                            }
+
+                            // Losing captures are kept at the front of the list for the last stage
+                            if (Evaluation::StaticExchange(move) < 0) {
+                                std::swap(m_Captures[m_BadEnd++], m_Captures[m_Current - 1]);
+                                continue;
+                            }
+
+                            return move;
+                        }
+
+                        m_Stage = Stage::Killers;
+                        GenerateQuiets();
+                        break;
+                    }
+
+                    case Stage::Killers: {
+                        while (m_Killer < m_Killers.size()) {
+                            const auto killer = m_Killers[m_Killer++];
+
+                            if (killer == m_TableMove) {
+                                continue;
+                            }
+
+                            if (const auto move = Find(m_Quiets, killer)) {
+                                return move;
+                            }
+                        }
+
+                        m_Stage = Stage::CounterMove;
+                        break;
+                    }
+
+                    case Stage::CounterMove: {
+                        m_Stage = Stage::Quiets;
+                        ScoreQuiets();
+                        m_Current = 0;
+
+                        if (m_CounterMove == m_TableMove || IsKiller(m_CounterMove)) {
+                            m_CounterMove = 0;
+                            break;
+                        }
+
+                        if (const auto move = Find(m_Quiets, m_CounterMove)) {
+                            return move;
+                        }
+
+                        break;
+                    }
+
+                    case Stage::Quiets: {
+                        while (m_Current < m_Quiets.size()) {
+                            PickBest(m_Quiets, m_QuietScores, m_Current);
+                            const auto move = m_Quiets[m_Current++];
+
+                            if (TranspositionTable::IsSameMove(m_TableMove, move)
+                                || TranspositionTable::IsSameMove(m_CounterMove, move)
+                                || IsKiller(TranspositionTable::PackMove(move))) {
+                                continue;
+                            }
+
+                            return move;
+                        }
+
+                        m_Stage = Stage::BadCaptures;
+                        m_Current = 0;
+                        break;
+                    }
+
+                    case Stage::BadCaptures: {
+                        if (m_Current < m_BadEnd) {
+                            return m_Captures[m_Current++];
+                        }
+
+                        m_Stage = Stage::Done;
+                        break;
+                    }
+
+                    case Stage::Done: {
+                        return std::nullopt;
+                    }
+                }
+            }
+        }
+
+        auto GenerateQuiets() -> void {
+            if (!m_QuietsGenerated) {
+                Board::GenerateMoves<Board::GenType::Quiets>(m_Quiets);
+                m_QuietsGenerated = true;
+            }
+        }
+
+        /// <summary>
+        /// Scores captures by most valuable victim and least valuable attacker
+        /// </summary>
+        auto ScoreCaptures() -> void {
+            m_CaptureScores.resize(m_Captures.size());
+
+            for (size_t i = 0; i < m_Captures.size(); i++) {
+                const auto& move = m_Captures[i];
+                const auto victim = move.Type == MoveType::EnPassant ? PieceFlag::Pawn : Board::GetPiece(move.To).GetType();
+                int score = Evaluation::PieceValue(victim) * 16 - Evaluation::PieceValue(Board::GetPiece(move.From).GetType()) / 16;
+
+                if (move.Type == MoveType::PromotionCapture) {
+                    score += Evaluation::PieceValue(move.Promotion) * 16;
+                }
+
+                m_CaptureScores[i] = score;
+            }
+        }
+
+        /// <summary>
+        /// Scores quiet moves by history, with quiet promotions to a queen before all of them
+        /// </summary>
+        auto ScoreQuiets() -> void {
+            m_QuietScores.resize(m_Quiets.size());
+
+            for (size_t i = 0; i < m_Quiets.size(); i++) {
+                const auto& move = m_Quiets[i];
+                m_QuietScores[i] = move.Type == MoveType::Promotion
+                    ? (1 << 20) + Evaluation::PieceValue(move.Promotion)
+                    : m_Worker.QuietScore(move, m_Ply);
+            }
+        }
+
+        /// <summary>
+        /// Moves the best scored move from the start index on to the start index
+        /// </summary>
+        static auto PickBest(std::vector<Move>& moves, std::vector<int>& scores, const size_t start) -> void {
+            size_t best = start;
+
+            for (size_t i = start + 1; i < moves.size(); i++) {
+                if (scores[i] > scores[best]) {
+                    best = i;
+                }
+            }
+
+            std::swap(moves[start], moves[best]);
+            std::swap(scores[start], scores[best]);
+        }
+
+        static auto Find(const std::vector<Move>& moves, const uint16_t packed) -> std::optional<Move> {
+            const auto move = std::ranges::find_if(moves, [packed](const Move& m) -> bool {
+                return TranspositionTable::IsSameMove(packed, m);
+            });
+
+            return move != moves.end() ? std::optional(*move) : std::nullopt;
+        }
+
+        [[nodiscard]] auto IsKiller(const uint16_t packed) const -> bool {
+            return packed != 0 && std::ranges::find(m_Killers, packed) != m_Killers.end();
+        }
+
+        Worker& m_Worker;
+        int m_Ply;
+        Stage m_Stage = Stage::TableMove;
+        int m_Count = 0;
+
+        uint16_t m_TableMove;
+        uint16_t m_CounterMove;
+        std::array<uint16_t, 2> m_Killers;
+        size_t m_Killer = 0;
+
+        std::vector<Move>& m_Captures;
+        std::vector<Move>& m_Quiets;
+        std::vector<int>& m_CaptureScores;
+        std::vector<int>& m_QuietScores;
+        bool m_QuietsGenerated = false;
+
+        size_t m_Current = 0;
+        size_t m_BadEnd = 0;
+    };
+
+    /// <summary>
+    /// Sorts the table move first, then captures by most valuable victim and least valuable attacker, then promotions
+    /// </summary>
+    auto OrderMoves(std::vector<Move>& moves, const uint16_t tableMove) -> void {
+        m_Scores.resize(moves.size());
+
+        for (size_t i = 0; i < moves.size(); i++) {
+            const auto& move = moves[i];
+            int score = 0;
+
+            if (TranspositionTable::IsSameMove(tableMove, move)) {
+                score = 1 << 20;
+            }
+            else if (move.Type == MoveType::Capture || move.Type == MoveType::PromotionCapture) {
+                score = (1 << 16) + Evaluation::PieceValue(Board::GetPiece(move.To).GetType()) * 16
+                    - Evaluation::PieceValue(Board::GetPiece(move.From).GetType()) / 16;
+            }
+            else if (move.Type == MoveType::EnPassant) {
+                score = (1 << 16) + Evaluation::PieceValue(PieceFlag::Pawn) * 15;
+            }
+            else if (move.Type == MoveType::Promotion) {
+                score = (1 << 15) + Evaluation::PieceValue(move.Promotion);
+            }
+
+            m_Scores[i] = score;
+        }
+
+        // Insertion sort is stable and fast for the short lists of chess moves
+        for (size_t i = 1; i < moves.size(); i++) {
+            const auto move = moves[i];
+            const auto score = m_Scores[i];
+            size_t j = i;
+
+            for (; j > 0 && m_Scores[j - 1] < score; j--) {
+                moves[j] = moves[j - 1];
+                m_Scores[j] = m_Scores[j - 1];
+            }
+
+            moves[j] = move;
+            m_Scores[j] = score;
+        }
+    }
+
+    auto CountNode() -> void {
+        // Only this thread writes the counter, other threads merely read it
+        const auto nodes = m_Nodes.load(std::memory_order_relaxed) + 1;
+        m_Nodes.store(nodes, std::memory_order_relaxed);
+
+        if (m_Id == 0 && (nodes & 255) == 0) {
+            m_Search.CheckLimits();
+        }
+    }
+
+    /// <summary>
+    /// The main thread always finishes the first iteration so that there is a move to play
+    /// </summary>
+    [[nodiscard]] auto Stopped() const -> bool {
+        return (m_Id != 0 || m_CompletedDepth > 0) && m_Search.m_Stop.load(std::memory_order_relaxed);
+    }
+
+    Search& m_Search;
+    int m_Id;
+    Search::Parameters m_Parameters;
+
+    /// <summary>
+    /// Late move reductions indexed by depth and move number
+    /// </summary>
+    std::array<std::array<int, 64>, 64> m_Reductions {};
+
+    std::atomic<uint64_t> m_Nodes = 0;
+    int m_SelectiveDepth = 0;
+    int m_CompletedDepth = 0;
+    int m_BestScore = 0;
+    std::vector<Move> m_BestPv;
+
+    struct Line {
+        int Score;
+        std::vector<Move> Pv;
+    };
+
+    /// <summary>
+    /// The lines of the current iteration, and the root moves they start with
+    /// </summary>
+    std::vector<Line> m_Lines;
+    std::vector<Move> m_Excluded;
+
+    std::array<std::vector<Move>, MaxPly + 1> m_Pv;
+    std::array<std::vector<Move>, MaxPly> m_MoveLists;
+    std::vector<int> m_Scores;
+
+    /// <summary>
+    /// The buffers of the move picker at each ply, the captures are kept in <c>m_MoveLists</c>
+    /// </summary>
+    std::array<std::vector<Move>, MaxPly> m_QuietLists;
+    std::array<std::vector<int>, MaxPly> m_CaptureScores;
+    std::array<std::vector<int>, MaxPly> m_QuietScores;
+    std::array<std::vector<Move>, MaxPly> m_TriedQuiets;
+
+    /// <summary>
+    /// The piece that moved at each ply of the current line and where it went, a piece of -1 for a null move
+    /// </summary>
+    struct StackEntry {
+        int Piece;
+        int To;
+    };
+
+    std::array<StackEntry, MaxPly> m_Stack {};
+
+    /// <summary>
+    /// Quiet moves that caused cutoffs at the same ply of sibling nodes
+    /// </summary>
+    std::array<std::array<uint16_t, 2>, MaxPly> m_Killers {};
+
+    /// <summary>
+    /// Butterfly history indexed by side, from and to square
+    /// </summary>
+    std::array<std::array<std::array<int16_t, 64>, 64>, 2> m_History {};
+
+    /// <summary>
+    /// The quiet move that last refuted each piece arriving on each square
+    /// </summary>
+    std::array<std::array<uint16_t, 64>, 12> m_CounterMoves {};
+
+    /// <summary>
+    /// History of quiet moves indexed by the piece and target square of an earlier move and of the move itself
+    /// </summary>
+    using ContinuationTable = std::array<std::array<std::array<std::array<int16_t, 64>, 12>, 64>, 12>;
+    std::unique_ptr<ContinuationTable> m_ContinuationHistory;
+};
+
+Search::Search(TranspositionTable& table) noexcept : m_Table(table) {}
+
+Search::~Search() = default;
+
+auto Search::SetThreads(const int threads) -> void {
+    m_Threads = std::max(threads, 1);
+}
+
+auto Search::SetMultiPv(const int lines) -> void {
+    m_MultiPv = std::max(lines, 1);
+}
+
+auto Search::SetParameters(const Parameters& parameters) -> void {
+    m_Parameters = parameters;
+}
+
+auto Search::GetParameters() const -> const Parameters& {
+    return m_Parameters;
+}
+
+auto Search::Run(const std::string_view fen, const std::vector<std::string>& moves, const Limits& limits, const ReportCallback& report) -> std::optional<Move> {
+    m_Fen = fen;
+    m_Moves = moves;
+    m_Limits = limits;
+    m_Start = std::chrono::steady_clock::now();
+
+    if (Trace::IsEnabled()) {
+        Trace::SetThreadName("Search");
+    }
+    TRACE_SCOPE("Search");
+
+    if (!SetupBoard()) {
+        throw std::invalid_argument("The position contains an illegal move");
+    }
+
+    std::vector<Move> rootMoves;
+    Board::GenerateMoves<Board::GenType::All>(rootMoves);
+
+    if (rootMoves.empty()) {
+        return std::nullopt;
+    }
+
+    AllocateTime(Board::IsWhiteToMove());
+    m_Table.NewSearch();
+
+    m_Workers.clear();
+    for (int i = 0; i < m_Threads; i++) {
+        m_Workers.emplace_back(std::make_unique<Worker>(*this, i));
+    }
+
+    {
+        std::vector<std::jthread> helpers;
+
+        for (int i = 1; i < m_Threads; i++) {
+            helpers.emplace_back([this, i] {
+                if (Trace::IsEnabled()) {
+                    Trace::SetThreadName("Search helper " + std::to_string(i));
+                }
+                TRACE_SCOPE_VALUE("Helper", i);
+
+                SetupBoard();
+                m_Workers[i]->Iterate(nullptr);
+            });
+        }
+
+        m_Workers.front()->Iterate(&report);
+
+        // An infinite search only ends when it is told to
+        while (m_Limits.Infinite && !m_Stop.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        m_Stop = true;
+    }
+
+    const auto& pv = m_Workers.front()->GetBestPv();
+    return pv.empty() ? rootMoves.front() : pv.front();
+}
+
+auto Search::Stop() -> void {
+    m_Stop = true;
+}
+
+auto Search::Reset() -> void {
+    m_Stop = false;
+}
+
+auto Search::SetupBoard() const -> bool {
+    Board::SetState(m_Fen);
+
+    for (const auto& notation : m_Moves) {
+        const auto move = Board::FindMove(notation);
+
+        if (!move) {
+            return false;
+        }
+
+        Board::MakeMove(*move);
+    }
+
+    return true;
+}
+
+auto Search::AllocateTime(const bool whiteToMove) -> void {
+    m_SoftTime = 0;
+    m_HardTime = 0;
+
+    if (m_Limits.Infinite) {
+        return;
+    }
+
+    if (m_Limits.MoveTime > 0) {
+        m_SoftTime = m_HardTime = m_Limits.MoveTime;
+        return;
+    }
+
+    const int time = whiteToMove ? m_Limits.WhiteTime : m_Limits.BlackTime;
+    const int increment = whiteToMove ? m_Limits.WhiteIncrement : m_Limits.BlackIncrement;
+
+    if (time <= 0) {
+        return;
+    }
+
+    // Keep a little time in reserve for the communication with the GUI
+    const int64_t available = std::max(time - 50, 1);
+    const int movesToGo = m_Limits.MovesToGo > 0 ? std::min(m_Limits.MovesToGo, 40) : 30;
+
+    m_SoftTime = std::min<int64_t>(available / movesToGo + increment * 3 / 4, available);
+    m_HardTime = std::min<int64_t>(m_SoftTime * 4, available / 2 + 1);
+    m_SoftTime = std::min(m_SoftTime, m_HardTime);
+}
+
+auto Search::CheckLimits() -> bool {
+    if ((m_Limits.Nodes > 0 && GetNodes() >= m_Limits.Nodes)
+        || (m_HardTime > 0 && GetElapsed() >= m_HardTime)) {
+        m_Stop = true;
+    }
+
+    return m_Stop;
+}
+
+auto Search::GetNodes() const -> uint64_t {
+    uint64_t nodes = 0;
+
+    for (const auto& worker : m_Workers) {
+        nodes += worker->GetNodes();
+    }
+
+    return nodes;
+}
+
+auto Search::GetElapsed() const -> int64_t {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_Start).count();
+}
\ No newline at end of file
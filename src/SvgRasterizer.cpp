@@ -0,0 +1,807 @@
+#include <pch.hpp>
+#include <SvgRasterizer.hpp>
+
+#include <charconv>
+#include <numbers>
+
+namespace {
+    /// <summary>
+    /// The largest distance in document units a flattened curve may stray from the true curve
+    /// </summary>
+    constexpr double FlatnessTolerance = 0.01;
+
+    /// <summary>
+    /// Samples per pixel along each axis
+    /// </summary>
+    constexpr int SampleGrid = 4;
+
+    auto IsSpace(const char c) -> bool {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    auto Trim(std::string_view text) -> std::string_view {
+        while (!text.empty() && IsSpace(text.front())) text.remove_prefix(1);
+        while (!text.empty() && IsSpace(text.back())) text.remove_suffix(1);
+        return text;
+    }
+
+    auto ParseDouble(std::string_view text) -> double {
+        text = Trim(text);
+
+        // Units are ignored, the artwork only ever uses user units or pixels
+        double value = 0.0;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+
+        if (error != std::errc()) {
+            throw std::runtime_error("Invalid number '" + std::string(text) + "'");
+        }
+
+        return value;
+    }
+
+    /// <summary>
+    /// Reads the numbers of path data and transform lists, which may be separated by
+    /// whitespace, a comma or nothing at all, as in <c>0.5-1.5</c> or <c>.5.5</c>
+    /// </summary>
+    class NumberReader final {
+    public:
+        explicit NumberReader(const std::string_view text) : m_Text(text) {}
+
+        auto SkipSeparators() -> void {
+            while (m_Offset < m_Text.size() && (IsSpace(m_Text[m_Offset]) || m_Text[m_Offset] == ',')) {
+                m_Offset++;
+            }
+        }
+
+        auto AtEnd() -> bool {
+            SkipSeparators();
+            return m_Offset >= m_Text.size();
+        }
+
+        auto Peek() -> char {
+            SkipSeparators();
+            return m_Offset < m_Text.size() ? m_Text[m_Offset] : '\0';
+        }
+
+        auto NextIsNumber() -> bool {
+            const auto c = Peek();
+            return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.';
+        }
+
+        auto ReadCommand() -> char {
+            SkipSeparators();
+            return m_Text[m_Offset++];
+        }
+
+        auto ReadNumber() -> double {
+            SkipSeparators();
+            const auto start = m_Offset;
+
+            if (m_Offset < m_Text.size() && (m_Text[m_Offset] == '-' || m_Text[m_Offset] == '+')) m_Offset++;
+
+            bool seenDot = false;
+            while (m_Offset < m_Text.size()) {
+                const auto c = m_Text[m_Offset];
+                if (c >= '0' && c <= '9') {
+                    m_Offset++;
+                }
+                else if (c == '.' && !seenDot) {
+                    seenDot = true;
+                    m_Offset++;
+                }
+                else if ((c == 'e' || c == 'E') && m_Offset + 1 < m_Text.size()) {
+                    m_Offset++;
+                    if (m_Text[m_Offset] == '-' || m_Text[m_Offset] == '+') m_Offset++;
+                    while (m_Offset < m_Text.size() && m_Text[m_Offset] >= '0' && m_Text[m_Offset] <= '9') m_Offset++;
+                    break;
+                }
+                else {
+                    break;
+                }
+            }
+
+            auto number = m_Text.substr(start, m_Offset - start);
+            if (!number.empty() && number.front() == '+') number.remove_prefix(1);
+
+            if (number.empty() || number == "-" || number == ".") {
+                throw std::runtime_error("Expected a number in '" + std::string(m_Text) + "'");
+            }
+
+            return ParseDouble(number);
+        }
+
+        /// <summary>
+        /// Reads an arc flag, a single digit that needs no separator after it
+        /// </summary>
+        auto ReadFlag() -> bool {
+            SkipSeparators();
+
+            if (m_Offset >= m_Text.size() || (m_Text[m_Offset] != '0' && m_Text[m_Offset] != '1')) {
+                throw std::runtime_error("Expected an arc flag in '" + std::string(m_Text) + "'");
+            }
+
+            return m_Text[m_Offset++] == '1';
+        }
+
+    private:
+        std::string_view m_Text;
+        size_t m_Offset = 0;
+    };
+
+    /// <summary>
+    /// Splits <c>name:value;name:value</c> declarations
+    /// </summary>
+    template<typename Callback>
+    auto ForEachDeclaration(std::string_view declarations, Callback&& callback) -> void {
+        while (!declarations.empty()) {
+            const auto end = declarations.find(';');
+            const auto declaration = declarations.substr(0, end);
+            declarations = end == std::string_view::npos ? std::string_view() : declarations.substr(end + 1);
+
+            const auto colon = declaration.find(':');
+            if (colon == std::string_view::npos) continue;
+
+            callback(Trim(declaration.substr(0, colon)), Trim(declaration.substr(colon + 1)));
+        }
+    }
+
+    /// <summary>
+    /// Splits the whitespace separated names of a <c>class</c> attribute
+    /// </summary>
+    template<typename Callback>
+    auto ForEachClass(std::string_view classes, Callback&& callback) -> void {
+        while (!(classes = Trim(classes)).empty()) {
+            size_t end = 0;
+            while (end < classes.size() && !IsSpace(classes[end])) end++;
+            callback(classes.substr(0, end));
+            classes.remove_prefix(end);
+        }
+    }
+
+    /// <summary>
+    /// Reads the attributes of a start tag
+    /// </summary>
+    auto ParseAttributes(std::string_view tag) -> std::unordered_map<std::string_view, std::string_view> {
+        std::unordered_map<std::string_view, std::string_view> attributes;
+
+        size_t i = 0;
+        while (i < tag.size()) {
+            while (i < tag.size() && IsSpace(tag[i])) i++;
+
+            const auto nameStart = i;
+            while (i < tag.size() && tag[i] != '=' && !IsSpace(tag[i])) i++;
+            const auto name = tag.substr(nameStart, i - nameStart);
+
+            while (i < tag.size() && IsSpace(tag[i])) i++;
+            if (i >= tag.size() || tag[i] != '=') continue;
+            i++;
+            while (i < tag.size() && IsSpace(tag[i])) i++;
+
+            if (i >= tag.size() || (tag[i] != '"' && tag[i] != '\'')) {
+                throw std::runtime_error("Unquoted attribute '" + std::string(name) + "'");
+            }
+
+            const auto quote = tag[i++];
+            const auto end = tag.find(quote, i);
+            if (end == std::string_view::npos) {
+                throw std::runtime_error("Unterminated attribute '" + std::string(name) + "'");
+            }
+
+            attributes[name] = tag.substr(i, end - i);
+            i = end + 1;
+        }
+
+        return attributes;
+    }
+}
+
+auto SvgRasterizer::Transform::Apply(const Point& p) const -> Point {
+    return { A * p.X + C * p.Y + E, B * p.X + D * p.Y + F };
+}
+
+auto SvgRasterizer::Transform::Multiply(const Transform& rhs) const -> Transform {
+    return {
+        A * rhs.A + C * rhs.B,
+        B * rhs.A + D * rhs.B,
+        A * rhs.C + C * rhs.D,
+        B * rhs.C + D * rhs.D,
+        A * rhs.E + C * rhs.F + E,
+        B * rhs.E + D * rhs.F + F
+    };
+}
+
+SvgRasterizer::SvgRasterizer(const std::string_view document) {
+    // The style of every open element, the root style holds the SVG defaults
+    std::vector<Style> styles { Style {} };
+
+    size_t offset = 0;
+    while ((offset = document.find('<', offset)) != std::string_view::npos) {
+        const auto rest = document.substr(offset);
+
+        if (rest.starts_with("<!--")) {
+            const auto end = document.find("-->", offset);
+            if (end == std::string_view::npos) throw std::runtime_error("Unterminated comment");
+            offset = end + 3;
+            continue;
+        }
+
+        const auto end = document.find('>', offset);
+        if (end == std::string_view::npos) throw std::runtime_error("Unterminated tag");
+
+        auto tag = document.substr(offset + 1, end - offset - 1);
+        offset = end + 1;
+
+        // Declarations, doctypes and processing instructions carry nothing to draw
+        if (tag.starts_with('?') || tag.starts_with('!')) continue;
+
+        if (tag.starts_with('/')) {
+            if (styles.size() > 1) styles.pop_back();
+            continue;
+        }
+
+        const bool selfClosing = tag.ends_with('/');
+        if (selfClosing) tag.remove_suffix(1);
+
+        size_t nameEnd = 0;
+        while (nameEnd < tag.size() && !IsSpace(tag[nameEnd])) nameEnd++;
+        const auto name = tag.substr(0, nameEnd);
+        const auto attributes = ParseAttributes(tag.substr(nameEnd));
+
+        const auto attribute = [&](const std::string_view key) -> std::string_view {
+            const auto it = attributes.find(key);
+            return it == attributes.end() ? std::string_view() : it->second;
+        };
+
+        if (name == "style") {
+            if (!selfClosing) {
+                const auto close = document.find("</style>", offset);
+                if (close == std::string_view::npos) throw std::runtime_error("Unterminated style sheet");
+                ParseStyleSheet(document.substr(offset, close - offset));
+                offset = close + 8;
+            }
+            continue;
+        }
+
+        // Presentation attributes are overridden by class rules, which are overridden by the style attribute
+        Style style = styles.back();
+        for (const auto& [key, value] : attributes) {
+            if (key != "style" && key != "transform" && key != "class") {
+                ApplyProperty(style, key, value);
+            }
+        }
+
+        ForEachClass(attribute("class"), [&](const std::string_view className) {
+            if (const auto it = m_Classes.find(className); it != m_Classes.end()) {
+                ApplyDeclarations(style, it->second);
+            }
+        });
+
+        ApplyDeclarations(style, attribute("style"));
+
+        if (const auto transform = attribute("transform"); !transform.empty()) {
+            style.Matrix = style.Matrix.Multiply(ParseTransform(transform));
+        }
+
+        if (name == "svg") {
+            if (const auto viewBox = attribute("viewBox"); !viewBox.empty()) {
+                NumberReader reader(viewBox);
+                m_ViewX = reader.ReadNumber();
+                m_ViewY = reader.ReadNumber();
+                m_ViewWidth = reader.ReadNumber();
+                m_ViewHeight = reader.ReadNumber();
+            }
+            else {
+                m_ViewWidth = ParseDouble(attribute("width"));
+                m_ViewHeight = ParseDouble(attribute("height"));
+            }
+        }
+        else if (name == "path") {
+            AddPath(attribute("d"), style);
+        }
+        else if (name == "circle") {
+            AddCircle(ParseDouble(attribute("cx")), ParseDouble(attribute("cy")), ParseDouble(attribute("r")), style);
+        }
+
+        if (!selfClosing) {
+            styles.push_back(style);
+        }
+    }
+
+    if (m_ViewWidth <= 0.0 || m_ViewHeight <= 0.0) {
+        throw std::runtime_error("The document has no size");
+    }
+}
+
+auto SvgRasterizer::ParseStyleSheet(std::string_view css) -> void {
+    while (true) {
+        const auto open = css.find('{');
+        const auto close = css.find('}');
+        if (open == std::string_view::npos || close == std::string_view::npos || close < open) break;
+
+        const auto selector = Trim(css.substr(0, open));
+        const auto declarations = css.substr(open + 1, close - open - 1);
+        css.remove_prefix(close + 1);
+
+        // Only class selectors are supported
+        if (selector.starts_with('.')) {
+            m_Classes[selector.substr(1)] = declarations;
+        }
+    }
+}
+
+auto SvgRasterizer::ApplyProperty(Style& style, const std::string_view name, const std::string_view value) const -> void {
+    if (name == "fill") {
+        style.Fill = ParsePaint(value);
+    }
+    else if (name == "stroke") {
+        style.Stroke = ParsePaint(value);
+    }
+    else if (name == "stroke-width") {
+        style.StrokeWidth = ParseDouble(value);
+    }
+    else if (name == "stroke-linecap") {
+        style.Cap = value == "round" ? LineCap::Round : value == "square" ? LineCap::Square : LineCap::Butt;
+    }
+    else if (name == "fill-rule") {
+        style.EvenOdd = value == "evenodd";
+    }
+    else if (name == "opacity") {
+        style.Opacity = static_cast<float>(ParseDouble(value));
+    }
+    else if (name == "fill-opacity") {
+        style.FillOpacity = static_cast<float>(ParseDouble(value));
+    }
+    else if (name == "stroke-opacity") {
+        style.StrokeOpacity = static_cast<float>(ParseDouble(value));
+    }
+}
+
+auto SvgRasterizer::ApplyDeclarations(Style& style, const std::string_view declarations) const -> void {
+    ForEachDeclaration(declarations, [&](const std::string_view name, const std::string_view value) {
+        ApplyProperty(style, name, value);
+    });
+}
+
+auto SvgRasterizer::ParsePaint(std::string_view value) -> Paint {
+    value = Trim(value);
+
+    if (value == "none") return Paint { true };
+    if (value == "black") return Paint { false, 0.0F, 0.0F, 0.0F };
+    if (value == "white") return Paint { false, 1.0F, 1.0F, 1.0F };
+
+    if (!value.starts_with('#') || (value.size() != 4 && value.size() != 7)) {
+        throw std::runtime_error("Unsupported paint '" + std::string(value) + "'");
+    }
+
+    const auto hex = [&](const size_t index) {
+        const auto c = value[index];
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        throw std::runtime_error("Unsupported paint '" + std::string(value) + "'");
+    };
+
+    const auto channel = [&](const int index) {
+        const int byte = value.size() == 4 ? hex(1 + index) * 17 : hex(1 + index * 2) * 16 + hex(2 + index * 2);
+        return static_cast<float>(byte) / 255.0F;
+    };
+
+    return Paint { false, channel(0), channel(1), channel(2) };
+}
+
+auto SvgRasterizer::ParseTransform(std::string_view value) -> Transform {
+    Transform result;
+
+    while (true) {
+        const auto open = value.find('(');
+        const auto close = value.find(')');
+        if (open == std::string_view::npos || close == std::string_view::npos) break;
+
+        const auto function = Trim(value.substr(0, open));
+        NumberReader reader(value.substr(open + 1, close - open - 1));
+        value.remove_prefix(close + 1);
+        while (!value.empty() && (IsSpace(value.front()) || value.front() == ',')) value.remove_prefix(1);
+
+        std::vector<double> args;
+        while (!reader.AtEnd()) args.push_back(reader.ReadNumber());
+
+        Transform local;
+        if (function == "matrix" && args.size() == 6) {
+            local = { args[0], args[1], args[2], args[3], args[4], args[5] };
+        }
+        else if (function == "translate" && !args.empty()) {
+            local.E = args[0];
+            local.F = args.size() > 1 ? args[1] : 0.0;
+        }
+        else if (function == "scale" && !args.empty()) {
+            local.A = args[0];
+            local.D = args.size() > 1 ? args[1] : args[0];
+        }
+        else if (function == "rotate" && !args.empty()) {
+            const auto angle = args[0] * std::numbers::pi / 180.0;
+            const Transform rotation { std::cos(angle), std::sin(angle), -std::sin(angle), std::cos(angle), 0.0, 0.0 };
+
+            if (args.size() == 3) {
+                const Transform to { 1.0, 0.0, 0.0, 1.0, args[1], args[2] };
+                const Transform back { 1.0, 0.0, 0.0, 1.0, -args[1], -args[2] };
+                local = to.Multiply(rotation).Multiply(back);
+            }
+            else {
+                local = rotation;
+            }
+        }
+        else {
+            throw std::runtime_error("Unsupported transform '" + std::string(function) + "'");
+        }
+
+        result = result.Multiply(local);
+    }
+
+    return result;
+}
+
+auto SvgRasterizer::AddPath(const std::string_view data, const Style& style) -> void {
+    Shape shape { {}, style };
+    NumberReader reader(data);
+
+    Point current { 0.0, 0.0 };
+    Point start { 0.0, 0.0 };
+    Point lastControl { 0.0, 0.0 };
+    char command = '\0';
+    char previous = '\0';
+
+    const auto point = [&](const bool relative) -> Point {
+        const auto x = reader.ReadNumber();
+        const auto y = reader.ReadNumber();
+        return relative ? Point { current.X + x, current.Y + y } : Point { x, y };
+    };
+
+    const auto subpath = [&]() -> std::vector<Point>& {
+        if (shape.Subpaths.empty() || shape.Subpaths.back().Closed) {
+            shape.Subpaths.push_back({ { current }, false });
+        }
+        return shape.Subpaths.back().Points;
+    };
+
+    while (!reader.AtEnd()) {
+        // Repeated arguments continue the previous command, a repeated move continues as a line
+        if (!reader.NextIsNumber()) {
+            command = reader.ReadCommand();
+        }
+        else if (command == 'M') {
+            command = 'L';
+        }
+        else if (command == 'm') {
+            command = 'l';
+        }
+        else if (command == '\0') {
+            throw std::runtime_error("Path data starts without a command");
+        }
+
+        const bool relative = command >= 'a' && command <= 'z';
+        const char upper = static_cast<char>(relative ? command - 'a' + 'A' : command);
+
+        switch (upper) {
+            case 'M':
+                current = point(relative);
+                start = current;
+                shape.Subpaths.push_back({ { current }, false });
+                break;
+            case 'L':
+                current = point(relative);
+                subpath().push_back(current);
+                break;
+            case 'H':
+                current.X = reader.ReadNumber() + (relative ? current.X : 0.0);
+                subpath().push_back(current);
+                break;
+            case 'V':
+                current.Y = reader.ReadNumber() + (relative ? current.Y : 0.0);
+                subpath().push_back(current);
+                break;
+            case 'C':
+            case 'S': {
+                Point control1;
+                if (upper == 'S') {
+                    // The first control point mirrors the second one of a preceding curve
+                    const bool afterCurve = previous == 'C' || previous == 'S';
+                    control1 = afterCurve ? Point { 2.0 * current.X - lastControl.X, 2.0 * current.Y - lastControl.Y } : current;
+                }
+                else {
+                    control1 = point(relative);
+                }
+
+                const auto control2 = point(relative);
+                const auto end = point(relative);
+                auto& points = subpath();
+                FlattenCubic(points, current, control1, control2, end, 0);
+                points.push_back(end);
+                lastControl = control2;
+                current = end;
+                break;
+            }
+            case 'A': {
+                const auto rx = reader.ReadNumber();
+                const auto ry = reader.ReadNumber();
+                const auto rotation = reader.ReadNumber();
+                const auto largeArc = reader.ReadFlag();
+                const auto sweep = reader.ReadFlag();
+                const auto end = point(relative);
+                FlattenArc(subpath(), current, rx, ry, rotation, largeArc, sweep, end);
+                current = end;
+                break;
+            }
+            case 'Z':
+                if (!shape.Subpaths.empty() && !shape.Subpaths.back().Closed) {
+                    shape.Subpaths.back().Closed = true;
+                }
+                current = start;
+                break;
+            default:
+                throw std::runtime_error(std::string("Unsupported path command '") + command + "'");
+        }
+
+        previous = upper;
+    }
+
+    m_Shapes.push_back(std::move(shape));
+}
+
+auto SvgRasterizer::AddCircle(const double cx, const double cy, const double r, const Style& style) -> void {
+    Shape shape { {}, style };
+    Subpath circle { {}, true };
+
+    // Enough segments to stay within the tolerance: r (1 - cos(pi / n)) <= tolerance
+    const auto segments = std::max(16, static_cast<int>(std::ceil(std::numbers::pi / std::acos(1.0 - std::min(1.0, FlatnessTolerance / r)))));
+
+    for (int i = 0; i < segments; i++) {
+        const auto angle = 2.0 * std::numbers::pi * i / segments;
+        circle.Points.push_back({ cx + r * std::cos(angle), cy + r * std::sin(angle) });
+    }
+
+    shape.Subpaths.push_back(std::move(circle));
+    m_Shapes.push_back(std::move(shape));
+}
+
+auto SvgRasterizer::FlattenCubic(std::vector<Point>& points, const Point p0, const Point p1, const Point p2, const Point p3, const int depth) -> void {
+    // The control points' distance from the chord bounds the distance of the curve from it
+    const auto dx = p3.X - p0.X;
+    const auto dy = p3.Y - p0.Y;
+    const auto d1 = std::abs((p1.X - p3.X) * dy - (p1.Y - p3.Y) * dx);
+    const auto d2 = std::abs((p2.X - p3.X) * dy - (p2.Y - p3.Y) * dx);
+    const auto chord = dx * dx + dy * dy;
+
+    const bool flat = chord > 0.0
+        ? (d1 + d2) * (d1 + d2) <= FlatnessTolerance * FlatnessTolerance * chord
+        : std::hypot(p1.X - p0.X, p1.Y - p0.Y) + std::hypot(p2.X - p0.X, p2.Y - p0.Y) <= FlatnessTolerance;
+
+    if (flat || depth >= 16) {
+        return;
+    }
+
+    const auto mid = [](const Point& a, const Point& b) { return Point { (a.X + b.X) * 0.5, (a.Y + b.Y) * 0.5 }; };
+
+    const auto p01 = mid(p0, p1), p12 = mid(p1, p2), p23 = mid(p2, p3);
+    const auto p012 = mid(p01, p12), p123 = mid(p12, p23);
+    const auto split = mid(p012, p123);
+
+    FlattenCubic(points, p0, p01, p012, split, depth + 1);
+    points.push_back(split);
+    FlattenCubic(points, split, p123, p23, p3, depth + 1);
+}
+
+auto SvgRasterizer::FlattenArc(std::vector<Point>& points, const Point from, double rx, double ry, const double rotation,
+    const bool largeArc, const bool sweep, const Point to) -> void {
+    rx = std::abs(rx);
+    ry = std::abs(ry);
+
+    if (rx == 0.0 || ry == 0.0 || (from.X == to.X && from.Y == to.Y)) {
+        points.push_back(to);
+        return;
+    }
+
+    // Conversion from endpoint to center parameterization, SVG 1.1 appendix F.6.5
+    const auto phi = rotation * std::numbers::pi / 180.0;
+    const auto cosPhi = std::cos(phi);
+    const auto sinPhi = std::sin(phi);
+
+    const auto hx = (from.X - to.X) * 0.5;
+    const auto hy = (from.Y - to.Y) * 0.5;
+    const auto x1 = cosPhi * hx + sinPhi * hy;
+    const auto y1 = -sinPhi * hx + cosPhi * hy;
+
+    // Radii too small to reach the endpoint are scaled up, F.6.6
+    const auto lambda = (x1 * x1) / (rx * rx) + (y1 * y1) / (ry * ry);
+    if (lambda > 1.0) {
+        rx *= std::sqrt(lambda);
+        ry *= std::sqrt(lambda);
+    }
+
+    const auto numerator = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1;
+    const auto denominator = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+    auto factor = std::sqrt(std::max(0.0, numerator / denominator));
+    if (largeArc == sweep) factor = -factor;
+
+    const auto cx1 = factor * rx * y1 / ry;
+    const auto cy1 = -factor * ry * x1 / rx;
+    const auto cx = cosPhi * cx1 - sinPhi * cy1 + (from.X + to.X) * 0.5;
+    const auto cy = sinPhi * cx1 + cosPhi * cy1 + (from.Y + to.Y) * 0.5;
+
+    const auto angle = [](const double ux, const double uy, const double vx, const double vy) {
+        return std::atan2(ux * vy - uy * vx, ux * vx + uy * vy);
+    };
+
+    const auto theta = angle(1.0, 0.0, (x1 - cx1) / rx, (y1 - cy1) / ry);
+    auto delta = angle((x1 - cx1) / rx, (y1 - cy1) / ry, (-x1 - cx1) / rx, (-y1 - cy1) / ry);
+
+    if (!sweep && delta > 0.0) delta -= 2.0 * std::numbers::pi;
+    if (sweep && delta < 0.0) delta += 2.0 * std::numbers::pi;
+
+    const auto radius = std::max(rx, ry);
+    const auto step = 2.0 * std::acos(1.0 - std::min(1.0, FlatnessTolerance / radius));
+    const auto segments = std::max(4, static_cast<int>(std::ceil(std::abs(delta) / step)));
+
+    for (int i = 1; i < segments; i++) {
+        const auto t = theta + delta * i / segments;
+        const auto ex = rx * std::cos(t);
+        const auto ey = ry * std::sin(t);
+        points.push_back({ cosPhi * ex - sinPhi * ey + cx, sinPhi * ex + cosPhi * ey + cy });
+    }
+
+    points.push_back(to);
+}
+
+auto SvgRasterizer::Render(const uint32_t size, std::vector<float>& rgba) const -> void {
+    rgba.assign(static_cast<size_t>(size) * size * 4, 0.0F);
+
+    // The view box is scaled uniformly and centered
+    const auto scale = std::min(size / m_ViewWidth, size / m_ViewHeight);
+    const Transform view {
+        scale, 0.0, 0.0, scale,
+        (size - m_ViewWidth * scale) * 0.5 - m_ViewX * scale,
+        (size - m_ViewHeight * scale) * 0.5 - m_ViewY * scale
+    };
+
+    const auto samples = static_cast<int>(size) * SampleGrid;
+    constexpr auto samplesPerPixel = SampleGrid * SampleGrid;
+
+    // The number of covered samples of every pixel, and the samples a stroke has already covered
+    std::vector<uint8_t> coverage(static_cast<size_t>(size) * size);
+    std::vector<uint8_t> strokeMask(static_cast<size_t>(samples) * samples);
+
+    const auto composite = [&](const Paint& paint, const float opacity) {
+        for (size_t i = 0; i < coverage.size(); i++) {
+            if (coverage[i] == 0) continue;
+
+            const auto alpha = opacity * static_cast<float>(coverage[i]) / samplesPerPixel;
+            auto* pixel = &rgba[i * 4];
+            pixel[0] = paint.R * alpha + pixel[0] * (1.0F - alpha);
+            pixel[1] = paint.G * alpha + pixel[1] * (1.0F - alpha);
+            pixel[2] = paint.B * alpha + pixel[2] * (1.0F - alpha);
+            pixel[3] = alpha + pixel[3] * (1.0F - alpha);
+        }
+    };
+
+    std::vector<std::pair<double, int>> crossings;
+
+    for (const auto& shape : m_Shapes) {
+        const auto& style = shape.Paint;
+        const auto matrix = view.Multiply(style.Matrix);
+
+        std::vector<Subpath> outline;
+        for (const auto& subpath : shape.Subpaths) {
+            Subpath transformed { {}, subpath.Closed };
+            for (const auto& p : subpath.Points) transformed.Points.push_back(matrix.Apply(p));
+            outline.push_back(std::move(transformed));
+        }
+
+        if (!style.Fill.None) {
+            std::ranges::fill(coverage, 0);
+
+            // Every subpath is implicitly closed for filling
+            for (int row = 0; row < samples; row++) {
+                const auto y = (row + 0.5) / SampleGrid;
+                crossings.clear();
+
+                for (const auto& subpath : outline) {
+                    const auto& points = subpath.Points;
+                    for (size_t i = 0; i < points.size(); i++) {
+                        const auto& a = points[i];
+                        const auto& b = points[(i + 1) % points.size()];
+
+                        if ((a.Y <= y) == (b.Y <= y)) continue;
+
+                        const auto x = a.X + (y - a.Y) * (b.X - a.X) / (b.Y - a.Y);
+                        crossings.emplace_back(x, b.Y > a.Y ? 1 : -1);
+                    }
+                }
+
+                std::ranges::sort(crossings);
+
+                int winding = 0;
+                for (size_t i = 0; i + 1 < crossings.size(); i++) {
+                    winding += crossings[i].second;
+
+                    const bool inside = style.EvenOdd ? (winding & 1) != 0 : winding != 0;
+                    if (!inside) continue;
+
+                    // Samples sit at the centers of a grid within each pixel
+                    const auto first = std::max(0, static_cast<int>(std::ceil(crossings[i].first * SampleGrid - 0.5)));
+                    const auto last = std::min(samples, static_cast<int>(std::ceil(crossings[i + 1].first * SampleGrid - 0.5)));
+
+                    for (int column = first; column < last; column++) {
+                        coverage[static_cast<size_t>(row / SampleGrid) * size + column / SampleGrid]++;
+                    }
+                }
+            }
+
+            composite(style.Fill, style.Opacity * style.FillOpacity);
+        }
+
+        if (!style.Stroke.None && style.StrokeWidth > 0.0) {
+            std::ranges::fill(coverage, 0);
+
+            // Stroke widths scale with the transform, which only ever scales uniformly here
+            const auto halfWidth = style.StrokeWidth * std::sqrt(std::abs(matrix.A * matrix.D - matrix.B * matrix.C)) * 0.5;
+            const auto extension = style.Cap == LineCap::Square ? halfWidth : 0.0;
+
+            // Covers the samples within half the width of the segments. Segments are capsules,
+            // so joins come out round; open ends are cut square unless the cap is round
+            for (const auto& subpath : outline) {
+                const auto& points = subpath.Points;
+                if (points.size() < 2) continue;
+
+                const auto count = subpath.Closed ? points.size() : points.size() - 1;
+                for (size_t i = 0; i < count; i++) {
+                    auto a = points[i];
+                    auto b = points[(i + 1) % points.size()];
+
+                    const auto dx = b.X - a.X;
+                    const auto dy = b.Y - a.Y;
+                    const auto length = std::hypot(dx, dy);
+                    if (length == 0.0) continue;
+
+                    const bool cutStart = !subpath.Closed && i == 0 && style.Cap != LineCap::Round;
+                    const bool cutEnd = !subpath.Closed && i + 1 == count && style.Cap != LineCap::Round;
+
+                    if (cutStart) a = { a.X - dx / length * extension, a.Y - dy / length * extension };
+                    if (cutEnd) b = { b.X + dx / length * extension, b.Y + dy / length * extension };
+
+                    const auto ex = b.X - a.X;
+                    const auto ey = b.Y - a.Y;
+                    const auto lengthSquared = ex * ex + ey * ey;
+
+                    const auto minX = std::max(0, static_cast<int>(std::floor((std::min(a.X, b.X) - halfWidth) * SampleGrid)));
+                    const auto maxX = std::min(samples - 1, static_cast<int>(std::ceil((std::max(a.X, b.X) + halfWidth) * SampleGrid)));
+                    const auto minY = std::max(0, static_cast<int>(std::floor((std::min(a.Y, b.Y) - halfWidth) * SampleGrid)));
+                    const auto maxY = std::min(samples - 1, static_cast<int>(std::ceil((std::max(a.Y, b.Y) + halfWidth) * SampleGrid)));
+
+                    for (int row = minY; row <= maxY; row++) {
+                        const auto y = (row + 0.5) / SampleGrid;
+                        for (int column = minX; column <= maxX; column++) {
+                            auto& covered = strokeMask[static_cast<size_t>(row) * samples + column];
+                            if (covered) continue;
+
+                            const auto x = (column + 0.5) / SampleGrid;
+                            const auto t = ((x - a.X) * ex + (y - a.Y) * ey) / lengthSquared;
+
+                            if ((cutStart && t < 0.0) || (cutEnd && t > 1.0)) continue;
+
+                            const auto clamped = std::clamp(t, 0.0, 1.0);
+                            const auto px = x - (a.X + clamped * ex);
+                            const auto py = y - (a.Y + clamped * ey);
+
+                            if (px * px + py * py <= halfWidth * halfWidth) {
+                                covered = 1;
+                                coverage[static_cast<size_t>(row / SampleGrid) * size + column / SampleGrid]++;
+                            }
+                        }
+                    }
+                }
+            }
+
+            std::ranges::fill(strokeMask, 0);
+            composite(style.Stroke, style.Opacity * style.StrokeOpacity);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include <pch.hpp>
+#include <Trace.hpp>
+
+#include <iomanip>
+#include <ostream>
+
+namespace {
+    /// <summary>
+    /// The most spans kept of finished threads, the oldest threads are dropped first
+    /// </summary>
+    constexpr size_t MaxRetiredSpans = Trace::BufferSize * 16;
+
+    auto WriteString(std::ostream& stream, const std::string_view text) -> void {
+        stream << '"';
+
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                stream << '\\' << c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20) {
+                stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+            }
+            else {
+                stream << c;
+            }
+        }
+
+        stream << '"';
+    }
+
+    // Trace events are timed in microseconds, written with nanosecond precision
+    auto WriteMicroseconds(std::ostream& stream, const int64_t nanoseconds) -> void {
+        stream << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000;
+    }
+}
+
+Trace::ThreadBuffer::ThreadBuffer() {
+    std::lock_guard lock(s_Mutex);
+    Id = s_NextId++;
+    s_Threads.push_back(this);
+}
+
+Trace::ThreadBuffer::~ThreadBuffer() {
+    std::lock_guard lock(s_Mutex);
+    std::erase(s_Threads, this);
+
+    std::vector<Span> spans;
+    Collect(*this, spans);
+
+    if (spans.empty()) {
+        return;
+    }
+
+    s_Retired.emplace_back(Id, std::move(Name), std::move(spans));
+
+    size_t total = 0;
+    for (const auto& [id, name, retired] : s_Retired) {
+        total += retired.size();
+    }
+
+    while (total > MaxRetiredSpans) {
+        total -= std::get<2>(s_Retired.front()).size();
+        s_Retired.erase(s_Retired.begin());
+    }
+}
+
+auto Trace::SetEnabled(const bool enabled) -> void {
+    s_Enabled.store(enabled, std::memory_order_relaxed);
+}
+
+auto Trace::SetThreadName(const std::string_view name) -> void {
+    auto& buffer = s_Local;
+    std::lock_guard lock(s_Mutex);
+    buffer.Name = name;
+}
+
+auto Trace::Record(const char* name, const int64_t start, const int64_t end, const int64_t value) noexcept -> void {
+    auto& buffer = s_Local;
+
+    // The slots are only allocated once the thread records its first span
+    if (!buffer.Slots) [[unlikely]] {
+        std::lock_guard lock(s_Mutex);
+        buffer.Slots.reset(new (std::nothrow) Slot[BufferSize]());
+
+        if (!buffer.Slots) {
+            return;
+        }
+    }
+
+    const auto head = buffer.Head.load(std::memory_order_relaxed);
+    auto& slot = buffer.Slots[head & (BufferSize - 1)];
+
+    // Orders the publication of the previous span before the slot is overwritten, see Collect
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.Name.store(name, std::memory_order_relaxed);
+    slot.Start.store(start, std::memory_order_relaxed);
+    slot.Duration.store(end - start, std::memory_order_relaxed);
+    slot.Value.store(value, std::memory_order_relaxed);
+
+    buffer.Head.store(head + 1, std::memory_order_release);
+}
+
+auto Trace::Collect(const ThreadBuffer& buffer, std::vector<Span>& spans) -> void {
+    if (!buffer.Slots) {
+        return;
+    }
+
+    const auto head = buffer.Head.load(std::memory_order_acquire);
+    const auto begin = std::max(buffer.Tail.load(std::memory_order_relaxed), head - std::min<uint64_t>(head, BufferSize));
+    const auto offset = spans.size();
+
+    for (auto index = begin; index < head; index++) {
+        const auto& slot = buffer.Slots[index & (BufferSize - 1)];
+        spans.push_back({
+            slot.Name.load(std::memory_order_relaxed),
+            slot.Start.load(std::memory_order_relaxed),
+            slot.Duration.load(std::memory_order_relaxed),
+            slot.Value.load(std::memory_order_relaxed)
+        });
+    }
+
+    // The owner may have moved on while the slots were read. The span it writes at index i overwrites
+    // index i - BufferSize, so every span at or below the current write index minus the buffer size is suspect
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const auto written = buffer.Head.load(std::memory_order_relaxed);
+
+    if (written >= BufferSize && written - BufferSize >= begin) {
+        const auto torn = std::min<uint64_t>(written - BufferSize - begin + 1, head - begin);
+        spans.erase(spans.begin() + static_cast<ptrdiff_t>(offset), spans.begin() + static_cast<ptrdiff_t>(offset + torn));
+    }
+}
+
+auto Trace::Export(std::ostream& stream) -> void {
+    std::lock_guard lock(s_Mutex);
+
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+
+    for (const auto& [id, name, spans] : s_Retired) {
+        WriteEvents(stream, id, name, spans, first);
+    }
+
+    std::vector<Span> spans;
+
+    for (const auto* buffer : s_Threads) {
+        spans.clear();
+        Collect(*buffer, spans);
+        WriteEvents(stream, buffer->Id, buffer->Name, spans, first);
+    }
+
+    stream << "\n]}\n";
+}
+
+auto Trace::WriteEvents(std::ostream& stream, const uint32_t thread, const std::string_view name, const std::vector<Span>& spans, bool& first) -> void {
+    const auto separator = [&] {
+        stream << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    if (!name.empty()) {
+        separator();
+        stream << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << thread << R"(,"args":{"name":)";
+        WriteString(stream, name);
+        stream << "}}";
+    }
+
+    for (const auto& span : spans) {
+        separator();
+        stream << R"({"name":)";
+        WriteString(stream, span.Name);
+        stream << R"(,"cat":"chess","ph":"X","pid":1,"tid":)" << thread << R"(,"ts":)";
+        WriteMicroseconds(stream, span.Start);
+        stream << R"(,"dur":)";
+        WriteMicroseconds(stream, span.Duration);
+
+        if (span.Value != NoValue) {
+            stream << R"(,"args":{"value":)" << span.Value << '}';
+        }
+
+        stream << '}';
+    }
+}
+
+auto Trace::Clear() -> void {
+    std::lock_guard lock(s_Mutex);
+    s_Retired.clear();
+
+    // Only the owner moves the write index, the spans below the read index are skipped instead
+    for (auto* buffer : s_Threads) {
+        buffer->Tail.store(buffer->Head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
\ No newline at end of file
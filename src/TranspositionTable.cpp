@@ -0,0 +1,158 @@
+#include <pch.hpp>
+#include <TranspositionTable.hpp>
+#include <Metrics.hpp>
+#include <Move.hpp>
+#include <Piece.hpp>
+
+#include <bit>
+
+namespace {
+    constexpr std::array PromotionCodes { PieceFlag::None, PieceFlag::Knight, PieceFlag::Bishop, PieceFlag::Rook, PieceFlag::Queen };
+}
+
+TranspositionTable::TranspositionTable(const size_t megabytes) {
+    Resize(megabytes);
+}
+
+auto TranspositionTable::Resize(const size_t megabytes) -> void {
+    const size_t clusters = megabytes * 1024 * 1024 / sizeof(Cluster);
+
+    if (clusters == 0) {
+        throw std::invalid_argument("Transposition table needs at least one megabyte");
+    }
+
+    m_ClusterCount = std::bit_floor(clusters);
+
+    // The old table is released first so that both never need to fit in memory at once
+    m_Memory = {};
+    m_Memory = LargePageBuffer(m_ClusterCount * sizeof(Cluster));
+    m_Clusters = static_cast<Cluster*>(m_Memory.Get());
+
+    // The buffer is already zeroed, so every slot starts out empty
+    std::uninitialized_default_construct_n(m_Clusters, m_ClusterCount);
+    m_Generation = 0;
+}
+
+auto TranspositionTable::GetMemory() const noexcept -> const LargePageBuffer& {
+    return m_Memory;
+}
+
+auto TranspositionTable::Clear() -> void {
+    for (size_t i = 0; i < m_ClusterCount; i++) {
+        for (auto& slot : m_Clusters[i].Slots) {
+            slot.Key.store(0, std::memory_order_relaxed);
+            slot.Data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    m_Generation = 0;
+}
+
+auto TranspositionTable::NewSearch() -> void {
+    // The generation has six bits next to the bound
+    m_Generation = (m_Generation + 1) & 63;
+}
+
+auto TranspositionTable::Probe(const uint64_t hash) const -> std::optional<Entry> {
+    Metrics::Increment(Counter::TTProbes);
+
+    for (const auto& slot : GetCluster(hash).Slots) {
+        const auto data = slot.Data.load(std::memory_order_relaxed);
+
+        if ((slot.Key.load(std::memory_order_relaxed) ^ data) == hash && data != 0) {
+            Metrics::Increment(Counter::TTHits);
+            return Unpack(data);
+        }
+    }
+
+    return std::nullopt;
+}
+
+auto TranspositionTable::Store(const uint64_t hash, const Entry& entry) -> void {
+    auto& cluster = GetCluster(hash);
+    Slot* replace = &cluster.Slots[0];
+    int worst = std::numeric_limits<int>::max();
+
+    for (auto& slot : cluster.Slots) {
+        const auto data = slot.Data.load(std::memory_order_relaxed);
+
+        if ((slot.Key.load(std::memory_order_relaxed) ^ data) == hash || data == 0) {
+            replace = &slot;
+            break;
+        }
+
+        // Entries of old searches are worth less than shallow entries of the current one
+        const int age = (m_Generation - GetGeneration(data)) & 63;
+        const int value = Unpack(data).Depth - 8 * age;
+
+        if (value < worst) {
+            worst = value;
+            replace = &slot;
+        }
+    }
+
+    auto stored = entry;
+
+    // Keep the known best move if the new result has none
+    if (stored.Move == 0) {
+        const auto data = replace->Data.load(std::memory_order_relaxed);
+        if ((replace->Key.load(std::memory_order_relaxed) ^ data) == hash) {
+            stored.Move = Unpack(data).Move;
+        }
+    }
+
+    const auto data = Pack(stored, m_Generation);
+    replace->Key.store(hash ^ data, std::memory_order_relaxed);
+    replace->Data.store(data, std::memory_order_relaxed);
+}
+
+auto TranspositionTable::GetHashfull() const -> int {
+    const size_t sample = std::min<size_t>(m_ClusterCount, 250);
+    int used = 0;
+
+    for (size_t i = 0; i < sample; i++) {
+        for (const auto& slot : m_Clusters[i].Slots) {
+            const auto data = slot.Data.load(std::memory_order_relaxed);
+            used += data != 0 && GetGeneration(data) == m_Generation;
+        }
+    }
+
+    return static_cast<int>(used * 1000 / (sample * 4));
+}
+
+auto TranspositionTable::PackMove(const Move& move) -> uint16_t {
+    const auto promotion = std::ranges::find(PromotionCodes, move.Promotion) - PromotionCodes.begin();
+    const auto from = move.From.y * 8 + move.From.x;
+    const auto to = move.To.y * 8 + move.To.x;
+    return static_cast<uint16_t>(from | to << 6 | (promotion % PromotionCodes.size()) << 12);
+}
+
+auto TranspositionTable::IsSameMove(const uint16_t packed, const Move& move) -> bool {
+    return packed != 0 && packed == PackMove(move);
+}
+
+auto TranspositionTable::Pack(const Entry& entry, const uint8_t generation) -> uint64_t {
+    // Layout from the lowest bit: move 16, score 16, depth 8, bound 2, generation 6
+    return static_cast<uint64_t>(entry.Move)
+        | static_cast<uint64_t>(static_cast<uint16_t>(entry.Score)) << 16
+        | static_cast<uint64_t>(entry.Depth) << 32
+        | static_cast<uint64_t>(entry.Type) << 40
+        | static_cast<uint64_t>(generation) << 42;
+}
+
+auto TranspositionTable::Unpack(const uint64_t data) -> Entry {
+    return {
+        static_cast<uint16_t>(data),
+        static_cast<int16_t>(static_cast<uint16_t>(data >> 16)),
+        static_cast<uint8_t>(data >> 32),
+        static_cast<Bound>((data >> 40) & 3)
+    };
+}
+
+auto TranspositionTable::GetGeneration(const uint64_t data) -> uint8_t {
+    return static_cast<uint8_t>((data >> 42) & 63);
+}
+
+auto TranspositionTable::GetCluster(const uint64_t hash) const -> Cluster& {
+    return m_Clusters[hash & (m_ClusterCount - 1)];
+}
\ No newline at end of file
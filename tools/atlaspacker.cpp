@@ -0,0 +1,265 @@
+#include <pch.hpp>
+#include <PieceAtlas.hpp>
+#include <RenderBackend.hpp>
+#include <SvgRasterizer.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+    constexpr std::string_view Usage =
+        "Usage:\n"
+        "  atlaspacker --svg <directory> --output <file> [--size <pixels>] [--verify]\n"
+        "\n"
+        "Rasterizes the piece SVGs into a mipmapped atlas. The size of a sprite is a power of two,\n"
+        "256 by default. --verify renders the atlas and compares it byte for byte with the file, and for\n"
+        "the sizes it knows with the checksum of the artwork in the repository.\n";
+
+    /// <summary>
+    /// The piece artwork in the order of <c>RenderBackend::PieceTextureIndex</c>
+    /// </summary>
+    constexpr std::array<std::string_view, RenderBackend::PieceTextureCount> PieceFiles {
+        "wPawn.svg", "wRook.svg", "wKnight.svg", "wBishop.svg", "wKing.svg", "wQueen.svg",
+        "bPawn.svg", "bRook.svg", "bKnight.svg", "bBishop.svg", "bKing.svg", "bQueen.svg"
+    };
+
+    /// <summary>
+    /// The sprites are laid out in rows of one color each, split in two rows per color
+    /// </summary>
+    constexpr uint32_t Columns = 4;
+    constexpr uint32_t Rows = RenderBackend::PieceTextureCount / Columns;
+
+    /// <summary>
+    /// The checksums of the atlas of the artwork in ChessPiecesSVG by sprite size. They pin what the rasterizer
+    /// draws, so a change to it or to the artwork has to update them on purpose
+    /// </summary>
+    constexpr std::array<std::pair<uint32_t, uint64_t>, 3> GoldenChecksums { {
+        { 32, 0x2D025F3D7D74D45CULL },
+        { 64, 0x552C04882242C066ULL },
+        { 256, 0x64EC608E8D2F336CULL }
+    } };
+
+    auto ReadFile(const std::filesystem::path& path) -> std::string {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    /// <summary>
+    /// Halves a premultiplied image with a box filter. Sprites are a power of two in size,
+    /// so a filtered pixel never mixes two sprites
+    /// </summary>
+    auto Downsample(const std::vector<float>& source, const uint32_t width, const uint32_t height) -> std::vector<float> {
+        const auto halfWidth = width / 2;
+        const auto halfHeight = height / 2;
+        std::vector<float> result(static_cast<size_t>(halfWidth) * halfHeight * 4);
+
+        for (uint32_t y = 0; y < halfHeight; y++) {
+            for (uint32_t x = 0; x < halfWidth; x++) {
+                for (uint32_t c = 0; c < 4; c++) {
+                    const auto at = [&](const uint32_t sx, const uint32_t sy) {
+                        return source[(static_cast<size_t>(sy) * width + sx) * 4 + c];
+                    };
+
+                    result[(static_cast<size_t>(y) * halfWidth + x) * 4 + c] =
+                        (at(2 * x, 2 * y) + at(2 * x + 1, 2 * y) + at(2 * x, 2 * y + 1) + at(2 * x + 1, 2 * y + 1)) * 0.25F;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    /// <summary>
+    /// Converts premultiplied floats to 8-bit straight alpha, as the blend state expects
+    /// </summary>
+    auto Quantize(const std::vector<float>& source, const uint32_t width, const uint32_t height) -> PieceAtlas::Image {
+        PieceAtlas::Image image { width, height, std::vector<uint8_t>(source.size()) };
+
+        const auto toByte = [](const float value) {
+            return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0F, 1.0F) * 255.0F));
+        };
+
+        for (size_t i = 0; i < source.size(); i += 4) {
+            const auto alpha = source[i + 3];
+            image.Pixels[i + 3] = toByte(alpha);
+
+            if (image.Pixels[i + 3] == 0) {
+                continue;
+            }
+
+            for (size_t c = 0; c < 3; c++) {
+                image.Pixels[i + c] = toByte(source[i + c] / alpha);
+            }
+        }
+
+        return image;
+    }
+
+    auto Pack(const std::filesystem::path& directory, const uint32_t tileSize) -> std::vector<uint8_t> {
+        const auto width = tileSize * Columns;
+        const auto height = tileSize * Rows;
+        std::vector<float> atlas(static_cast<size_t>(width) * height * 4);
+        std::vector<PieceAtlas::TileRect> tiles;
+
+        std::vector<float> sprite;
+        for (uint32_t index = 0; index < PieceFiles.size(); index++) {
+            const auto path = directory / PieceFiles[index];
+
+            try {
+                SvgRasterizer(ReadFile(path)).Render(tileSize, sprite);
+            }
+            catch (const std::runtime_error& e) {
+                throw std::runtime_error(path.string() + ": " + e.what());
+            }
+
+            const auto left = index % Columns * tileSize;
+            const auto top = index / Columns * tileSize;
+
+            for (uint32_t y = 0; y < tileSize; y++) {
+                std::copy_n(&sprite[static_cast<size_t>(y) * tileSize * 4], tileSize * 4,
+                    &atlas[(static_cast<size_t>(top + y) * width + left) * 4]);
+            }
+
+            tiles.push_back({
+                static_cast<float>(left) / static_cast<float>(width),
+                static_cast<float>(top) / static_cast<float>(height),
+                static_cast<float>(left + tileSize) / static_cast<float>(width),
+                static_cast<float>(top + tileSize) / static_cast<float>(height)
+            });
+        }
+
+        // The chain ends when a sprite is a single pixel
+        std::vector<PieceAtlas::Image> levels;
+        auto levelWidth = width;
+        auto levelHeight = height;
+
+        while (true) {
+            levels.push_back(Quantize(atlas, levelWidth, levelHeight));
+
+            if (levelWidth == Columns) {
+                break;
+            }
+
+            atlas = Downsample(atlas, levelWidth, levelHeight);
+            levelWidth /= 2;
+            levelHeight /= 2;
+        }
+
+        return PieceAtlas::Serialize(tileSize, tiles, levels);
+    }
+
+    /// <summary>
+    /// FNV-1a, printed so a bundle can be compared at a glance
+    /// </summary>
+    auto Checksum(const std::span<const uint8_t> bytes) -> uint64_t {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        for (const auto byte : bytes) {
+            hash = (hash ^ byte) * 0x100000001B3ULL;
+        }
+        return hash;
+    }
+}
+
+auto main(int argc, char** argv) -> int {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    std::filesystem::path directory;
+    std::filesystem::path output;
+    uint32_t tileSize = 256;
+    bool verify = false;
+
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const auto& arg = args[i];
+            const auto value = [&]() -> const std::string& {
+                if (i + 1 >= args.size()) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return args[++i];
+            };
+
+            if (arg == "--svg") {
+                directory = value();
+            }
+            else if (arg == "--output") {
+                output = value();
+            }
+            else if (arg == "--size") {
+                tileSize = static_cast<uint32_t>(std::stoul(value()));
+            }
+            else if (arg == "--verify") {
+                verify = true;
+            }
+            else {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+        }
+
+        if (directory.empty() || output.empty()) {
+            throw std::invalid_argument("--svg and --output are required");
+        }
+
+        if (!std::has_single_bit(tileSize) || tileSize < 4 || tileSize > 4096) {
+            throw std::invalid_argument("--size must be a power of two between 4 and 4096");
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+
+    try {
+        const auto bytes = Pack(directory, tileSize);
+
+        if (verify) {
+            const auto expected = ReadFile(output);
+            const auto mismatch = std::ranges::mismatch(bytes, expected,
+                [](const uint8_t a, const char b) { return a == static_cast<uint8_t>(b); });
+
+            if (bytes.size() != expected.size() || mismatch.in1 != bytes.end()) {
+                std::cerr << output.string() << " differs from the rendered atlas at byte "
+                    << std::distance(bytes.begin(), mismatch.in1) << " (" << expected.size()
+                    << " bytes, expected " << bytes.size() << ")" << std::endl;
+                return 1;
+            }
+
+            const auto golden = std::ranges::find(GoldenChecksums, tileSize, &std::pair<uint32_t, uint64_t>::first);
+
+            if (golden != GoldenChecksums.end() && Checksum(bytes) != golden->second) {
+                std::cerr << "The rendered atlas has checksum " << std::hex << Checksum(bytes) << ", the artwork in the repository renders to "
+                    << golden->second << std::dec << " at size " << tileSize << std::endl;
+                return 1;
+            }
+        }
+        else {
+            if (output.has_parent_path()) {
+                std::filesystem::create_directories(output.parent_path());
+            }
+
+            std::ofstream file(output, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+            if (!file) {
+                throw std::runtime_error("Failed to write " + output.string());
+            }
+        }
+
+        std::cout << output.string() << ": " << bytes.size() << " bytes, "
+            << tileSize * Columns << "x" << tileSize * Rows << ", checksum "
+            << std::hex << Checksum(bytes) << std::dec << (verify ? ", verified" : "") << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include <pch.hpp>
+#include <Board.hpp>
+#include <Evaluation.hpp>
+#include <Fen.hpp>
+#include <Move.hpp>
+#include <PositionBatch.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace {
+    constexpr std::string_view Usage =
+        "Usage:\n"
+        "  batcheval [--file <fen file>] [--positions <n>] [--threads <n>] [--repeat <n>] [--verify]\n"
+        "\n"
+        "Without a file the positions are sampled from random games. The batch is timed against setting up\n"
+        "the board for every position, and --verify compares the two results position by position\n";
+
+    /// <summary>
+    /// Random games from these start with checks, pins, castling and en passant soon
+    /// </summary>
+    const std::vector<std::string_view> Seeds {
+        Fen::StartPosition,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+    };
+
+    /// <summary>
+    /// Plays random games from the seeds and keeps every position, restarting when a game ends
+    /// </summary>
+    auto SamplePositions(const size_t count) -> std::vector<Fen::State> {
+        std::mt19937_64 random(2024);
+        std::vector<Fen::State> positions;
+        std::vector<Move> moves;
+
+        while (positions.size() < count) {
+            Board::SetState(Seeds[positions.size() % Seeds.size()]);
+
+            for (int ply = 0; ply < 200 && positions.size() < count; ply++) {
+                positions.push_back(Board::GetState());
+
+                moves.clear();
+                Board::GenerateMoves<Board::GenType::All>(moves);
+
+                if (moves.empty()) {
+                    break;
+                }
+
+                Board::MakeMove(moves[random() % moves.size()]);
+            }
+        }
+
+        return positions;
+    }
+
+    auto LoadPositions(const std::string& path) -> std::vector<Fen::State> {
+        std::ifstream file(path);
+
+        if (!file) {
+            throw std::runtime_error("Failed to open " + path);
+        }
+
+        std::vector<Fen::State> positions;
+        std::string line;
+
+        while (std::getline(file, line)) {
+            if (Fen::State state; !line.empty() && Fen::Parse(line, state)) {
+                positions.push_back(state);
+            }
+        }
+
+        return positions;
+    }
+
+    auto PrintRate(const std::string_view name, const size_t positions, const double seconds) -> void {
+        std::cout << name << ": " << static_cast<double>(positions) / std::max(seconds, 1e-9) / 1e6 << " M positions/s, "
+            << seconds * 1e9 / static_cast<double>(std::max<size_t>(positions, 1)) << " ns each" << std::endl;
+    }
+}
+
+auto main(int argc, char** argv) -> int {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    std::string path;
+    size_t count = 1'000'000;
+    int threads = 1;
+    int repeat = 5;
+    bool verify = false;
+
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const auto& arg = args[i];
+            const auto value = [&]() -> const std::string& {
+                if (i + 1 >= args.size()) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return args[++i];
+            };
+
+            if (arg == "--file") {
+                path = value();
+            }
+            else if (arg == "--positions") {
+                count = std::stoull(value());
+            }
+            else if (arg == "--threads") {
+                threads = std::stoi(value());
+            }
+            else if (arg == "--repeat") {
+                repeat = std::max(std::stoi(value()), 1);
+            }
+            else if (arg == "--verify") {
+                verify = true;
+            }
+            else {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+
+    try {
+        const auto positions = path.empty() ? SamplePositions(count) : LoadPositions(path);
+
+        PositionBatch batch;
+        batch.Reserve(positions.size());
+
+        for (const auto& position : positions) {
+            batch.Add(position);
+        }
+
+        std::cout << "Positions: " << batch.GetSize() << ", lanes: " << PositionBatch::GetInstructionSet()
+            << ", threads: " << threads << std::endl;
+
+        // The best of several runs, the first one also faults the result arrays in
+        PositionBatch::Results results;
+        double batchSeconds = std::numeric_limits<double>::max();
+
+        for (int run = 0; run < repeat; run++) {
+            const auto start = std::chrono::steady_clock::now();
+            batch.Analyze(results, threads);
+            batchSeconds = std::min(batchSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        PrintRate("Batch", batch.GetSize(), batchSeconds);
+
+        std::vector<Move> moves;
+        uint64_t checksum = 0;
+        size_t mismatches = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < positions.size(); i++) {
+            Board::SetState(positions[i]);
+
+            moves.clear();
+            Board::GenerateMoves<Board::GenType::All>(moves);
+            const bool inCheck = Board::IsInCheck();
+            const int score = Evaluation::Evaluate();
+
+            checksum += moves.size() + (inCheck ? 1 : 0) + static_cast<uint64_t>(score);
+
+            if (verify && (moves.size() != results.MoveCounts[i] || inCheck != (results.InCheck[i] != 0) || score != results.Scores[i])) {
+                if (mismatches++ < 10) {
+                    std::cout << Fen::ToString(positions[i]) << ": " << moves.size() << " moves, check " << inCheck << ", score " << score
+                        << " on the board, " << +results.MoveCounts[i] << ", " << +results.InCheck[i] << ", " << results.Scores[i] << " in the batch\n";
+                }
+            }
+        }
+
+        PrintRate("Board", positions.size(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        std::cout << "Checksum: " << checksum << std::endl;
+
+        if (verify) {
+            std::cout << "Mismatches: " << mismatches << std::endl;
+            return mismatches == 0 ? 0 : 1;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
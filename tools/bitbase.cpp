@@ -0,0 +1,207 @@
+#include <pch.hpp>
+#include <Bitbase.hpp>
+#include <BitbaseGenerator.hpp>
+#include <Board.hpp>
+#include <Move.hpp>
+#include <Fen.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    constexpr std::string_view Usage =
+        "Usage:\n"
+        "  bitbase generate <material>... [--output <directory>] [--threads <n>]\n"
+        "  bitbase probe <fen> [--output <directory>]\n"
+        "  bitbase verify <material>... [--output <directory>]\n"
+        "\n"
+        "Materials are named like KQvKR, with pawns on one side only. The tables a material converts into\n"
+        "are generated with it, tables already in the directory are reused\n";
+
+    auto WriteTable(const Bitbase& table, const std::filesystem::path& directory) -> void {
+        const auto path = directory / (table.GetMaterial().GetName() + std::string(Bitbase::Extension));
+        const auto bytes = table.GetBytes();
+
+        std::ofstream stream(path, std::ios::binary);
+        stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+        if (!stream) {
+            throw std::runtime_error("Failed to write " + path.string());
+        }
+    }
+
+    /// <summary>
+    /// Checks every position of a table against its moves: a win has a move to a loss, a loss has every move
+    /// to a win, and a draw has neither
+    /// </summary>
+    /// <returns><c>uint64_t</c> The number of positions with a wrong value</returns>
+    auto Verify(const Bitbase& table, const BitbaseSet& tables) -> uint64_t {
+        const auto& material = table.GetMaterial();
+        const auto strongEnd = 2 + static_cast<int>(material.Strong.size());
+
+        uint64_t errors = 0;
+        std::vector<Move> moves;
+
+        for (uint64_t index = 0; index < material.GetEntries(); index++) {
+            const auto value = table.Get(index);
+
+            if (value == Bitbase::Value::Illegal) {
+                continue;
+            }
+
+            const auto squares = Bitbase::Decode(material, index);
+            Fen::State state;
+            state.WhiteToMove = squares.WhiteToMove;
+
+            for (int piece = 0; piece < material.GetPieceCount(); piece++) {
+                const auto type = piece < 2 ? PieceFlag::King : piece < strongEnd ? material.Strong[piece - 2] : material.Weak[piece - strongEnd];
+                state.Squares[squares.Pieces[piece]] = type | (piece == 0 || (piece >= 2 && piece < strongEnd) ? PieceFlag::White : PieceFlag::Black);
+            }
+
+            Board::SetState(state);
+
+            // The value of the position as probed must be the one stored at its entry
+            auto expected = Board::IsInCheck() ? Bitbase::Value::Loss : Bitbase::Value::Draw;
+            bool allWins = true;
+
+            moves.clear();
+            Board::GenerateMoves<Board::GenType::All>(moves);
+
+            for (const auto& move : moves) {
+                Board::MakeMove(move);
+                const auto successor = tables.Probe();
+                Board::UnmakeMove(move);
+
+                if (successor == Bitbase::Value::Loss) {
+                    expected = Bitbase::Value::Win;
+                    allWins = false;
+                    break;
+                }
+
+                allWins &= successor == Bitbase::Value::Win;
+            }
+
+            if (!moves.empty() && expected != Bitbase::Value::Win) {
+                expected = allWins ? Bitbase::Value::Loss : Bitbase::Value::Draw;
+            }
+
+            if (value != expected || tables.Probe() != value) {
+                if (errors++ < 10) {
+                    std::cout << Board::GetFen() << ": " << Bitbase::GetName(value) << ", expected " << Bitbase::GetName(expected) << '\n';
+                }
+            }
+        }
+
+        return errors;
+    }
+}
+
+auto main(int argc, char** argv) -> int {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    std::string command;
+    std::vector<std::string> operands;
+    std::filesystem::path directory = ".";
+    int threads = 0;
+
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const auto& arg = args[i];
+            const auto value = [&]() -> const std::string& {
+                if (i + 1 >= args.size()) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return args[++i];
+            };
+
+            if (arg == "--output") {
+                directory = value();
+            }
+            else if (arg == "--threads") {
+                threads = std::stoi(value());
+            }
+            else if (arg.starts_with("--")) {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+            else if (command.empty()) {
+                command = arg;
+            }
+            else {
+                operands.push_back(arg);
+            }
+        }
+
+        if ((command != "generate" && command != "probe" && command != "verify") || operands.empty()) {
+            throw std::invalid_argument("Expected a command and its operands");
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+
+    try {
+        BitbaseSet tables;
+
+        if (std::filesystem::is_directory(directory)) {
+            tables.Load(directory);
+        }
+
+        if (command == "probe") {
+            Board::SetState(operands.front());
+            const auto value = tables.Probe();
+
+            std::cout << (value ? Bitbase::GetName(*value) : "not in the tables") << std::endl;
+            return value ? 0 : 2;
+        }
+
+        if (command == "verify") {
+            uint64_t errors = 0;
+
+            for (const auto& name : operands) {
+                const auto table = tables.Find(Bitbase::Material::Parse(name));
+
+                if (table == nullptr) {
+                    throw std::runtime_error("There is no " + name + " table in " + directory.string());
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                const auto tableErrors = Verify(*table, tables);
+                const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                std::cout << table->GetMaterial().GetName() << ": " << tableErrors << " errors (" << seconds << " s)" << std::endl;
+                errors += tableErrors;
+            }
+
+            return errors == 0 ? 0 : 1;
+        }
+
+        std::filesystem::create_directories(directory);
+
+        BitbaseGenerator generator(tables, threads, [&](const BitbaseGenerator::Report& report) {
+            const auto legal = report.Wins + report.Draws + report.Losses;
+            const auto percent = [&](const uint64_t count) { return 100.0 * static_cast<double>(count) / static_cast<double>(std::max<uint64_t>(legal, 1)); };
+
+            std::cout << report.Material << ": " << report.Entries << " entries, " << legal << " legal, "
+                << percent(report.Wins) << "% wins, " << percent(report.Draws) << "% draws, " << percent(report.Losses) << "% losses, "
+                << report.Iterations << " iterations, " << report.Milliseconds << " ms" << std::endl;
+
+            WriteTable(*tables.Find(Bitbase::Material::Parse(report.Material)), directory);
+        });
+
+        for (const auto& name : operands) {
+            generator.Generate(Bitbase::Material::Parse(name));
+        }
+    }
+    catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,320 @@
+#include <pch.hpp>
+#include <Board.hpp>
+#include <Fen.hpp>
+#include <MateSolver.hpp>
+#include <Move.hpp>
+#include <Notation.hpp>
+#include <RecordingRenderBackend.hpp>
+#include <Search.hpp>
+#include <TranspositionTable.hpp>
+
+#include <functional>
+#include <iostream>
+
+namespace {
+    constexpr std::string_view Usage =
+        "Usage:\n"
+        "  check [<name>...]\n"
+        "\n"
+        "Runs the named checks of the core library, all of them by default, and fails if any does not hold\n";
+
+    struct Check {
+        std::string_view Name;
+        std::function<void()> Run;
+    };
+
+    auto Expect(const bool condition, const std::string& description) -> void {
+        if (!condition) {
+            throw std::runtime_error(description);
+        }
+    }
+
+    /// <summary>
+    /// Plays moves in SAN from the start position
+    /// </summary>
+    auto Play(const std::initializer_list<std::string_view> moves) -> void {
+        Board::SetState();
+
+        for (const auto san : moves) {
+            const auto move = Notation::FromSan(san);
+            Expect(move.has_value(), std::string(san) + " is not legal in " + Board::GetFen());
+            Board::MakeMove(*move);
+        }
+    }
+
+    auto HashOf(const std::string_view fen) -> uint64_t {
+        Board::SetState(fen);
+        return Board::GetHash();
+    }
+
+    /// <summary>
+    /// A double push whose pawn cannot be taken en passant leaves the same position as any other move to the
+    /// square, so the knights shuffling back to it repeat the position after 1.e4
+    /// </summary>
+    auto CheckRepetition() -> void {
+        Play({ "e4", "Nf6", "Nf3", "Ng8", "Ng1", "Nf6", "Nf3", "Ng8" });
+        Expect(!Board::IsRepetition(), "Twofold repetition counted as threefold");
+
+        Play({ "e4", "Nf6", "Nf3", "Ng8", "Ng1", "Nf6", "Nf3", "Ng8", "Ng1" });
+        Expect(Board::IsRepetition(), "Threefold repetition of the position after a double push missed");
+
+        // With a pawn that can capture en passant the position after the double push is a different one
+        Play({ "e4", "Nf6", "e5", "d5", "Nf3", "Ng8", "Ng1", "Nf6", "Nf3", "Ng8", "Ng1", "Nf6" });
+        Expect(!Board::IsRepetition(), "Position with an en passant capture repeated by one without it");
+    }
+
+    /// <summary>
+    /// A null move passes the turn without a capture or pawn move, so it counts towards the fifty moves but no
+    /// position before it can repeat, and a mate on the hundredth ply is still a mate
+    /// </summary>
+    auto CheckFiftyMoves() -> void {
+        Play({ "e4", "Nf6", "Nf3", "Ng8", "Ng1", "Nf6", "Nf3", "Ng8", "Ng1" });
+        Board::MakeNullMove();
+        Expect(!Board::IsRepetition(1), "Position before a null move repeated");
+        Expect(Board::GetHalfmoveClock() == 9, "Null move restarted the fifty moves count");
+        Board::UnmakeNullMove();
+        Expect(Board::IsRepetition() && Board::GetHalfmoveClock() == 8, "Null move not taken back");
+
+        TranspositionTable table(1);
+        Search search(table);
+        int score = 0;
+
+        Search::Limits limits;
+        limits.Depth = 2;
+
+        search.Reset();
+        const auto move = search.Run("7k/8/6K1/8/8/8/8/R7 w - - 99 80", {}, limits, [&score](const Search::Report& report) {
+            score = report.Score;
+        });
+
+        Expect(move && move->ToString() == "a1a8" && score == Search::MateScore - 1, "Mate on the hundredth ply scored as a draw");
+    }
+
+    auto CheckEnPassantKey() -> void {
+        Expect(HashOf("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1")
+            == HashOf("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1"), "En passant square without a capture hashed");
+
+        Expect(HashOf("rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2")
+            != HashOf("rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2"), "En passant square with a capture not hashed");
+
+        // The only pawn that could capture is pinned to its king
+        Expect(HashOf("8/8/8/K2pP2r/8/8/8/7k w - d6 0 1") == HashOf("8/8/8/K2pP2r/8/8/8/7k w - - 0 1"),
+            "En passant square with only a pinned capture hashed");
+
+        Play({ "d4", "d5", "c4", "e6" });
+        const auto queensGambit = Board::GetHash();
+        Play({ "c4", "d5", "d4", "e6" });
+        Expect(Board::GetHash() == queensGambit, "Transposition through a double push hashed apart");
+    }
+
+    /// <summary>
+    /// Records that are written back exactly as they were read
+    /// </summary>
+    constexpr std::array<std::string_view, 5> RoundTrips {
+        Fen::StartPosition,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w Kq - 0 1",
+        "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2",
+        "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",
+        "4k3/8/8/8/8/8/8/4r1K1 w - - 99 120" // The side to move may be in check
+    };
+
+    /// <summary>
+    /// One malformed or impossible record per error code
+    /// </summary>
+    const std::vector<std::pair<std::string_view, Fen::Error>> FenErrors {
+        { "4k3/8/8/8/8/8/8/4K3", Fen::Error::MissingField },
+        { "4k3/8/8/8/8/8/8/4X2K w - - 0 1", Fen::Error::InvalidPiece },
+        { "4k4/8/8/8/8/8/8/4K3 w - - 0 1", Fen::Error::RankTooLong },
+        { "4k2/8/8/8/8/8/8/4K3 w - - 0 1", Fen::Error::RankTooShort },
+        { "4k3/8/8/8/8/8/4K3 w - - 0 1", Fen::Error::WrongRankCount },
+        { "4k2p/8/8/8/8/8/8/4K3 w - - 0 1", Fen::Error::PawnOnBackRank },
+        { "4k3/8/8/8/8/8/8/4K2K w - - 0 1", Fen::Error::WrongKingCount },
+        { "4k3/8/8/8/8/8/8/4K3 x - - 0 1", Fen::Error::InvalidSideToMove },
+        { "4k3/8/8/8/8/8/8/4R1K1 w - - 0 1", Fen::Error::OpponentInCheck },
+        { "r3k2r/8/8/8/8/8/8/R3K2R w QK - 0 1", Fen::Error::InvalidCastlingRights },
+        { "4k3/8/8/8/8/8/8/4K3 w K - 0 1", Fen::Error::CastlingWithoutKingOrRook },
+        { "4k3/8/8/8/8/8/8/4K3 w - e6 0 1", Fen::Error::InvalidEnPassantSquare },
+        { "4k3/8/8/8/8/8/8/4K3 w - - x 1", Fen::Error::InvalidHalfmoveClock },
+        { "4k3/8/8/8/8/8/8/4K3 w - - 0 0", Fen::Error::InvalidFullmoveNumber },
+        { "4k3/8/8/8/8/8/8/4K3 w - - 0 1 1", Fen::Error::TrailingCharacters }
+    };
+
+    auto CheckFen() -> void {
+        Fen::State state;
+
+        for (const auto fen : RoundTrips) {
+            Expect(static_cast<bool>(Fen::Parse(fen, state)), std::string(fen) + " rejected");
+            Expect(Fen::ToString(state) == fen, std::string(fen) + " written as " + Fen::ToString(state));
+        }
+
+        // The clocks may be left out
+        Expect(Fen::Parse("4k3/8/8/8/8/8/8/4K3 b - -", state) && Fen::ToString(state) == "4k3/8/8/8/8/8/8/4K3 b - - 0 1",
+            "Record without clocks not completed");
+
+        for (auto code = static_cast<int>(Fen::Error::MissingField); code <= static_cast<int>(Fen::Error::TrailingCharacters); code++) {
+            Expect(std::ranges::find(FenErrors, static_cast<Fen::Error>(code), &std::pair<std::string_view, Fen::Error>::second) != FenErrors.end(),
+                "No record for error code " + std::to_string(code));
+        }
+
+        for (const auto& [fen, error] : FenErrors) {
+            const auto result = Fen::Parse(fen, state);
+            Expect(result.Code == error, std::string(fen) + " parsed as " + std::string(Fen::Describe(result.Code))
+                + " instead of " + std::string(Fen::Describe(error)));
+        }
+
+        bool thrown = false;
+
+        try {
+            Board::SetState("4k3/8/8/8/8/8/8/4R1K1 w - - 0 1");
+        }
+        catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+
+        Expect(thrown, "Board set to a position whose king can be captured");
+    }
+
+    struct PerftCase {
+        std::string_view Fen;
+        std::vector<uint64_t> Nodes; // The leaf counts from depth 1 on
+    };
+
+    /// <summary>
+    /// The well known perft positions: the start position, Kiwipete and positions 3 to 5 with their mirror, which
+    /// between them cover castling, en passant, promotions, pins and checks
+    /// </summary>
+    const std::vector<PerftCase> PerftCases {
+        { Fen::StartPosition, { 20, 400, 8902, 197281, 4865609 } },
+        { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", { 48, 2039, 97862, 4085603 } },
+        { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", { 14, 191, 2812, 43238, 674624 } },
+        { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", { 6, 264, 9467, 422333 } },
+        { "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", { 6, 264, 9467, 422333 } },
+        { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", { 44, 1486, 62379, 2103487 } }
+    };
+
+    auto CheckPerft() -> void {
+        for (const auto& [fen, nodes] : PerftCases) {
+            Board::SetState(fen);
+
+            for (size_t depth = 1; depth <= nodes.size(); depth++) {
+                const auto counted = Board::Perft(static_cast<int>(depth));
+                Expect(counted == nodes[depth - 1], "Perft " + std::to_string(depth) + " of " + std::string(fen) + " counted "
+                    + std::to_string(counted) + " instead of " + std::to_string(nodes[depth - 1]));
+            }
+
+            Expect(Board::GetFen() == fen, "Perft did not restore " + std::string(fen));
+        }
+    }
+
+    /// <summary>
+    /// A defender that is already mated is a proven mate in no moves, and a search shorter than a move is refused
+    /// </summary>
+    auto CheckMateSolver() -> void {
+        constexpr std::string_view foolsMate = "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3";
+        MateSolver solver(1);
+
+        const auto mated = solver.Solve(foolsMate, Board::Color::Black, {});
+        Expect(mated.Outcome == MateSolver::Result::Proven && mated.MateIn == 0 && mated.Line.empty(), "Mated defender not proven in 0");
+
+        const auto lost = solver.Solve(foolsMate, Board::Color::White, {});
+        Expect(lost.Outcome == MateSolver::Result::Disproven, "Mated attacker not disproven");
+
+        bool refused = false;
+
+        try {
+            solver.Solve(Fen::StartPosition, Board::Color::White, { .Depth = 0 });
+        }
+        catch (const std::invalid_argument&) {
+            refused = true;
+        }
+
+        Expect(refused, "Depth of zero accepted");
+    }
+
+    /// <summary>
+    /// A frame of the start position with the moves of the e2 pawn shown draws the board, the highlights and the
+    /// pieces with one draw each, and uploads the constants and one instance per highlight and piece
+    /// </summary>
+    auto CheckRenderFrame() -> void {
+        using CommandType = RecordingRenderBackend::CommandType;
+
+        Board::SetState();
+
+        std::vector<PieceSprite> pieces;
+        const auto& board = Board::GetBoard();
+
+        for (size_t square = 0; square < board.size(); square++) {
+            if (!board[square].IsEmpty()) {
+                pieces.push_back({ board[square].GetType(), static_cast<float>(square % 8), static_cast<float>(square / 8), 0.01F });
+            }
+        }
+
+        std::vector<Move> moves;
+        const Position pawn { 4, 1 };
+        Board::CalculateLegalMoves(pawn, Board::GetPiece(pawn), moves);
+
+        RecordingRenderBackend backend;
+        backend.DrawFrame({}, moves, pieces);
+
+        const std::vector<std::pair<CommandType, size_t>> expected {
+            { CommandType::BeginFrame, 0 }, { CommandType::DrawBoard, 1 }, { CommandType::DrawHighlights, 2 },
+            { CommandType::DrawPieces, 32 }, { CommandType::EndFrame, 0 }
+        };
+
+        const auto& commands = backend.GetCommands();
+        Expect(commands.size() == expected.size(), "Frame submitted " + std::to_string(commands.size()) + " commands");
+
+        for (size_t i = 0; i < expected.size(); i++) {
+            Expect(commands[i].Type == expected[i].first && commands[i].Instances == expected[i].second,
+                "Command " + std::to_string(i) + " of the frame is not the expected draw");
+        }
+
+        Expect(backend.GetFrames() == 1 && backend.GetDrawCalls() == 3, "Frame took more than one draw per batch");
+        Expect(backend.GetUploadBytes() == sizeof(FrameConstants) + (2 + 32) * sizeof(QuadInstance),
+            "Frame uploaded " + std::to_string(backend.GetUploadBytes()) + " bytes");
+
+        for (size_t i = 0; i < pieces.size(); i++) {
+            Expect(backend.GetPieces()[i].Texture == RenderBackend::PieceTextureIndex(pieces[i].Type), "Piece drawn with the wrong sprite");
+        }
+    }
+
+    const std::vector<Check> Checks {
+        { "fen", CheckFen },
+        { "perft", CheckPerft },
+        { "repetition", CheckRepetition },
+        { "fiftymoves", CheckFiftyMoves },
+        { "enpassant", CheckEnPassantKey },
+        { "matesolver", CheckMateSolver },
+        { "render", CheckRenderFrame }
+    };
+}
+
+auto main(int argc, char** argv) -> int {
+    const std::vector<std::string_view> names(argv + 1, argv + argc);
+
+    for (const auto name : names) {
+        if (std::ranges::find(Checks, name, &Check::Name) == Checks.end()) {
+            std::cerr << "Unknown check " << name << '\n' << Usage;
+            return 1;
+        }
+    }
+
+    int failures = 0;
+
+    for (const auto& [name, run] : Checks) {
+        if (!names.empty() && std::ranges::find(names, name) == names.end()) {
+            continue;
+        }
+
+        try {
+            run();
+            std::cout << name << ": ok" << std::endl;
+        }
+        catch (const std::exception& e) {
+            std::cout << name << ": FAILED: " << e.what() << std::endl;
+            failures++;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
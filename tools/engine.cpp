@@ -0,0 +1,455 @@
+#include <pch.hpp>
+#include <Board.hpp>
+#include <Fen.hpp>
+#include <LargePageBuffer.hpp>
+#include <Metrics.hpp>
+#include <Piece.hpp>
+#include <Search.hpp>
+#include <Trace.hpp>
+#include <TranspositionTable.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace {
+    auto FormatScore(const int score) -> std::string {
+        if (std::abs(score) < Search::MateBound) {
+            return "cp " + std::to_string(score);
+        }
+
+        // Mate in moves rather than plies, negative when getting mated
+        const int plies = Search::MateScore - std::abs(score);
+        return "mate " + std::to_string(score > 0 ? (plies + 1) / 2 : -(plies / 2));
+    }
+
+    auto PrintReport(const Search::Report& report) -> void {
+        std::ostringstream line;
+        line << "info depth " << report.Depth
+            << " seldepth " << report.SelectiveDepth
+            << " multipv " << report.MultiPv
+            << " score " << FormatScore(report.Score)
+            << " nodes " << report.Nodes
+            << " nps " << report.Nodes * 1000 / std::max<int64_t>(report.Milliseconds, 1)
+            << " hashfull " << report.Hashfull
+            << " time " << report.Milliseconds
+            << " pv";
+
+        for (const auto& move : report.Pv) {
+            line << ' ' << move.ToString();
+        }
+
+        std::cout << line.str() << std::endl;
+    }
+
+    struct ParameterOption {
+        std::string_view Name;
+        int Search::Parameters::* Value;
+        int Min;
+        int Max;
+    };
+
+    /// <summary>
+    /// The selective search parameters exposed as spin options, so that a match can compare settings
+    /// </summary>
+    constexpr std::array ParameterOptions {
+        ParameterOption { "NullMoveDepth", &Search::Parameters::NullMoveDepth, 1, 20 },
+        ParameterOption { "NullMoveReduction", &Search::Parameters::NullMoveReduction, 1, 10 },
+        ParameterOption { "NullMoveDivisor", &Search::Parameters::NullMoveDivisor, 1, 20 },
+        ParameterOption { "NullMoveVerifyDepth", &Search::Parameters::NullMoveVerifyDepth, 1, 128 },
+        ParameterOption { "ReductionBase", &Search::Parameters::ReductionBase, -200, 300 },
+        ParameterOption { "ReductionDivisor", &Search::Parameters::ReductionDivisor, 50, 1000 },
+        ParameterOption { "ReverseFutilityDepth", &Search::Parameters::ReverseFutilityDepth, 0, 20 },
+        ParameterOption { "ReverseFutilityMargin", &Search::Parameters::ReverseFutilityMargin, 0, 1000 },
+        ParameterOption { "FutilityDepth", &Search::Parameters::FutilityDepth, 0, 20 },
+        ParameterOption { "FutilityBase", &Search::Parameters::FutilityBase, 0, 1000 },
+        ParameterOption { "FutilityMargin", &Search::Parameters::FutilityMargin, 0, 1000 },
+        ParameterOption { "LateMovePruningDepth", &Search::Parameters::LateMovePruningDepth, 0, 20 },
+        ParameterOption { "LateMovePruningBase", &Search::Parameters::LateMovePruningBase, 0, 100 }
+    };
+
+    /// <summary>
+    /// Openings, middlegames and endgames searched by <c>bench</c>. Changing the list changes the signature
+    /// </summary>
+    const std::vector<std::string_view> BenchPositions {
+        Fen::StartPosition,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+        "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+        "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+        "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+        "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+        "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+        "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+        "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+        "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+        "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+        "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+        "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+        "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+        "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+        "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+        "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+        "2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+        "8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+        "7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1",
+        "8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+        "8/1p3pp1/7p/5P1P/2k3P1/8/2K2P2/8 w - - 0 1",
+        "8/pp2r1k1/2p1p3/3pP2p/1P1P1P1P/P5KR/8/8 w - - 0 1",
+        "8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+        "5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+        "6k1/6p1/P6p/r1N5/5p2/7P/1b3PP1/4R1K1 w - - 0 1",
+        "1r3k2/4q3/2Pp3b/3Bp3/2Q2p2/1p1P2P1/1P2KP2/3N4 w - - 0 1",
+        "6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1",
+        "8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 1",
+        "5rk1/q6p/2p3bR/1pPp1rP1/1P1Pp3/P3B1Q1/1K3P2/R7 w - - 93 90",
+        "4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21",
+        "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+        "3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40",
+        "4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+        "8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+        "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+        "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+        "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+        "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+        "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+        "6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1",
+        "r2r1n2/pp2bk2/2p1p2p/3q4/3PN1QP/2P3R1/P4PP1/5RK1 w - - 0 1",
+        "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/8/8/8/8/6k1/6p1/6K1 w - - 0 1",
+        "7k/7P/6K1/8/3B4/8/8/8 b - - 0 1"
+    };
+
+    constexpr int BenchDepth = 6;
+
+    /// <summary>
+    /// The tokens of the go command followed by a number. Mate searches are not supported, their value is skipped
+    /// </summary>
+    constexpr std::array<std::string_view, 9> ValueTokens {
+        "depth", "nodes", "movetime", "wtime", "btime", "winc", "binc", "movestogo", "mate"
+    };
+
+    /// <summary>
+    /// Searches every bench position to a fixed depth on a single thread with a cleared table. The total node count
+    /// is a signature of the search and the move generator, any change in their behavior changes it
+    /// </summary>
+    /// <returns><c>uint64_t</c> The total number of nodes searched</returns>
+    auto Bench(const int depth) -> uint64_t {
+        TranspositionTable table(16);
+        Search search(table);
+
+        Search::Limits limits;
+        limits.Depth = depth;
+
+        uint64_t total = 0;
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < BenchPositions.size(); i++) {
+            table.Clear();
+
+            uint64_t nodes = 0;
+            search.Reset();
+            search.Run(BenchPositions[i], {}, limits, [&nodes](const Search::Report& report) {
+                nodes = report.Nodes;
+            });
+
+            std::cerr << "Position " << i + 1 << "/" << BenchPositions.size() << ": " << nodes << " nodes" << std::endl;
+            total += nodes;
+        }
+
+        const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "Total time (ms) : " << milliseconds << '\n'
+            << "Nodes searched  : " << total << '\n'
+            << "Nodes/second    : " << total * 1000 / static_cast<uint64_t>(std::max<int64_t>(milliseconds, 1)) << std::endl;
+
+        return total;
+    }
+
+    /// <summary>
+    /// The UCI front end. Searches run on a thread of their own so that the input is read while searching
+    /// </summary>
+    class Engine final {
+    public:
+        Engine() : m_Table(16), m_Search(m_Table) {}
+
+        ~Engine() {
+            StopSearch();
+        }
+
+        auto Loop() -> void {
+            for (std::string line; std::getline(std::cin, line);) {
+                std::istringstream stream(line);
+                std::string command;
+                stream >> command;
+
+                if (command == "uci") {
+                    std::cout << "id name Chess\n"
+                        << "id author JoniHelen\n"
+                        << "option name Hash type spin default 16 min 1 max 65536\n"
+                        << "option name Threads type spin default 1 min 1 max 256\n"
+                        << "option name MultiPV type spin default 1 min 1 max 256\n"
+                        << "option name LargePages type check default true\n"
+                        << "option name NumaPolicy type combo default none var none var interleave var firsttouch\n";
+                    PrintParameterOptions();
+                    std::cout << "uciok" << std::endl;
+                    PrintTableMemory();
+                }
+                else if (command == "isready") {
+                    std::cout << "readyok" << std::endl;
+                }
+                else if (command == "setoption") {
+                    SetOption(stream);
+                }
+                else if (command == "ucinewgame") {
+                    StopSearch();
+                    m_Table.Clear();
+                }
+                else if (command == "position") {
+                    StopSearch();
+                    SetPosition(stream);
+                }
+                else if (command == "go") {
+                    StopSearch();
+                    Go(stream);
+                }
+                else if (command == "stop") {
+                    StopSearch();
+                }
+                else if (command == "metrics") {
+                    // Not part of UCI: metrics [json|reset] dumps the counters of every search thread
+                    std::string format;
+                    stream >> format;
+
+                    if (format == "reset") {
+                        Metrics::Reset();
+                    }
+                    else {
+                        const auto snapshot = Metrics::Snapshot();
+                        std::cout << (format == "json" ? snapshot.ToJson() + "\n" : snapshot.ToText()) << std::flush;
+                    }
+                }
+                else if (command == "bench") {
+                    // Not part of UCI: bench [depth] searches the bench positions for a speed number and a signature
+                    StopSearch();
+
+                    int depth = BenchDepth;
+                    stream >> depth;
+                    Bench(std::max(depth, 1));
+                }
+                else if (command == "trace") {
+                    // Not part of UCI: trace on|off|clear|save <file> records the spans of the searches
+                    std::string action, path;
+                    stream >> action >> path;
+
+                    if (action == "on" || action == "off") {
+                        Trace::SetEnabled(action == "on");
+                    }
+                    else if (action == "clear") {
+                        Trace::Clear();
+                    }
+                    else if (action == "save" && !path.empty()) {
+                        if (std::ofstream file(path); file) {
+                            Trace::Export(file);
+                        }
+                        else {
+                            std::cout << "info string failed to open " << path << std::endl;
+                        }
+                    }
+                }
+                else if (command == "quit") {
+                    break;
+                }
+            }
+        }
+
+    private:
+        auto SetOption(std::istringstream& stream) -> void {
+            std::string token, name, value;
+
+            // setoption name <name> value <value>
+            stream >> token >> name >> token >> value;
+
+            StopSearch();
+
+            auto options = LargePageBuffer::GetOptions();
+
+            if (name == "Hash") {
+                m_Table.Resize(std::max(std::stoul(value), 1UL));
+                PrintTableMemory();
+            }
+            else if (name == "Threads") {
+                m_Search.SetThreads(std::stoi(value));
+            }
+            else if (name == "MultiPV") {
+                m_Search.SetMultiPv(std::stoi(value));
+            }
+            else if (name == "LargePages") {
+                options.LargePages = value == "true";
+                ReallocateTable(options);
+            }
+            else if (name == "NumaPolicy") {
+                if (const auto policy = LargePageBuffer::ParseNumaPolicy(value)) {
+                    options.Numa = *policy;
+                    ReallocateTable(options);
+                }
+            }
+            else {
+                SetParameter(name, value);
+            }
+        }
+
+        auto PrintParameterOptions() const -> void {
+            const Search::Parameters defaults;
+
+            std::cout << "option name NullMovePruning type check default " << (defaults.NullMovePruning ? "true" : "false") << '\n'
+                << "option name CheckExtensions type check default " << (defaults.CheckExtensions ? "true" : "false") << '\n';
+
+            for (const auto& option : ParameterOptions) {
+                std::cout << "option name " << option.Name << " type spin default " << defaults.*option.Value
+                    << " min " << option.Min << " max " << option.Max << '\n';
+            }
+        }
+
+        auto SetParameter(const std::string& name, const std::string& value) -> void {
+            auto parameters = m_Search.GetParameters();
+
+            if (name == "NullMovePruning") {
+                parameters.NullMovePruning = value == "true";
+            }
+            else if (name == "CheckExtensions") {
+                parameters.CheckExtensions = value == "true";
+            }
+            else {
+                const auto option = std::ranges::find(ParameterOptions, name, &ParameterOption::Name);
+
+                if (option == ParameterOptions.end()) {
+                    return;
+                }
+
+                parameters.*option->Value = std::clamp(std::stoi(value), option->Min, option->Max);
+            }
+
+            m_Search.SetParameters(parameters);
+        }
+
+        /// <summary>
+        /// Allocates the table again at the same size so that new memory options take effect
+        /// </summary>
+        auto ReallocateTable(const LargePageBuffer::Options& options) -> void {
+            LargePageBuffer::SetOptions(options);
+            m_Table.Resize(std::max<size_t>(m_Table.GetMemory().GetSize() / (1024 * 1024), 1));
+            PrintTableMemory();
+        }
+
+        auto PrintTableMemory() const -> void {
+            std::cout << "info string Hash " << m_Table.GetMemory().Describe() << std::endl;
+        }
+
+        auto SetPosition(std::istringstream& stream) -> void {
+            std::string token;
+            stream >> token;
+
+            if (token == "startpos") {
+                m_Fen = Fen::StartPosition;
+                stream >> token;
+            }
+            else if (token == "fen") {
+                m_Fen.clear();
+
+                while (stream >> token && token != "moves") {
+                    m_Fen += m_Fen.empty() ? token : ' ' + token;
+                }
+            }
+
+            m_Moves.clear();
+
+            if (token == "moves") {
+                for (std::string move; stream >> move;) {
+                    m_Moves.emplace_back(move);
+                }
+            }
+        }
+
+        auto Go(std::istringstream& stream) -> void {
+            Search::Limits limits;
+
+            for (std::string token; stream >> token;) {
+                if (token == "infinite") {
+                    limits.Infinite = true;
+                    continue;
+                }
+
+                // Pondering and restricting the root moves are not supported: ponder, searchmoves and the moves after
+                // it are skipped, and the search runs on all moves as if the move was played
+                if (token == "ponder" || token == "searchmoves" || std::ranges::find(ValueTokens, token) == ValueTokens.end()) {
+                    continue;
+                }
+
+                int64_t value = 0;
+
+                if (!(stream >> value)) {
+                    break;
+                }
+
+                if (token == "depth") limits.Depth = static_cast<int>(value);
+                else if (token == "nodes") limits.Nodes = static_cast<uint64_t>(value);
+                else if (token == "movetime") limits.MoveTime = static_cast<int>(value);
+                else if (token == "wtime") limits.WhiteTime = static_cast<int>(value);
+                else if (token == "btime") limits.BlackTime = static_cast<int>(value);
+                else if (token == "winc") limits.WhiteIncrement = static_cast<int>(value);
+                else if (token == "binc") limits.BlackIncrement = static_cast<int>(value);
+                else if (token == "movestogo") limits.MovesToGo = static_cast<int>(value);
+            }
+
+            m_Search.Reset();
+            m_Thread = std::thread([this, limits] {
+                try {
+                    const auto move = m_Search.Run(m_Fen, m_Moves, limits, PrintReport);
+                    std::cout << "bestmove " << (move ? move->ToString() : "0000") << std::endl;
+                }
+                catch (const std::exception& e) {
+                    std::cout << "info string " << e.what() << '\n' << "bestmove 0000" << std::endl;
+                }
+            });
+        }
+
+        auto StopSearch() -> void {
+            if (m_Thread.joinable()) {
+                m_Search.Stop();
+                m_Thread.join();
+            }
+        }
+
+        TranspositionTable m_Table;
+        Search m_Search;
+        std::thread m_Thread;
+
+        std::string m_Fen { Fen::StartPosition };
+        std::vector<std::string> m_Moves;
+    };
+}
+
+auto main(int argc, char** argv) -> int {
+    // engine bench [depth] runs the bench and exits, for build scripts
+    if (argc >= 2 && std::string_view(argv[1]) == "bench") {
+        try {
+            Bench(argc >= 3 ? std::max(std::stoi(argv[2]), 1) : BenchDepth);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    Engine engine;
+    engine.Loop();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include <pch.hpp>
+#include <Board.hpp>
+#include <Fen.hpp>
+#include <Piece.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+
+namespace {
+    constexpr std::string_view Usage =
+        "Usage:\n"
+        "  fenbench [--iterations <n>] [--file <fen or epd file>]\n";
+
+    // Counts every allocation of the process, so the parse and write loops can prove they make none
+    std::atomic<uint64_t> s_Allocations = 0;
+
+    const std::vector<std::string> DefaultPositions {
+        std::string(Fen::StartPosition),
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"
+    };
+
+    struct Measurement {
+        double Seconds;
+        uint64_t Allocations;
+    };
+
+    template<typename Function>
+    auto Measure(const size_t iterations, Function&& function) -> Measurement {
+        const auto allocations = s_Allocations.load();
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < iterations; i++) {
+            function(i);
+        }
+
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return { seconds, s_Allocations.load() - allocations };
+    }
+
+    auto PrintMeasurement(const std::string_view name, const size_t iterations, const Measurement& measurement) -> void {
+        const double perSecond = measurement.Seconds > 0.0 ? static_cast<double>(iterations) / measurement.Seconds : 0.0;
+        std::cout << name << ": " << perSecond / 1e6 << " M/s, "
+            << measurement.Seconds * 1e9 / static_cast<double>(iterations) << " ns each, "
+            << measurement.Allocations << " allocations" << std::endl;
+    }
+}
+
+auto operator new(const size_t size) -> void* {
+    s_Allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+auto operator delete(void* pointer) noexcept -> void {
+    std::free(pointer);
+}
+
+auto operator delete(void* pointer, size_t) noexcept -> void {
+    std::free(pointer);
+}
+
+auto main(int argc, char** argv) -> int {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    size_t iterations = 2'000'000;
+    std::vector<std::string> positions;
+
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const auto& arg = args[i];
+            const auto value = [&]() -> const std::string& {
+                if (i + 1 >= args.size()) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return args[++i];
+            };
+
+            if (arg == "--iterations") {
+                iterations = std::stoull(value());
+            }
+            else if (arg == "--file") {
+                std::ifstream file(value());
+
+                if (!file) {
+                    throw std::invalid_argument("Failed to open " + args[i]);
+                }
+
+                for (std::string line; std::getline(file, line);) {
+                    if (!line.empty() && line.front() != '#') {
+                        positions.emplace_back(std::move(line));
+                    }
+                }
+            }
+            else {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+
+    if (positions.empty()) {
+        positions = DefaultPositions;
+    }
+
+    // Every record must parse, and writing it back must give a record that parses to the same state
+    std::vector<Fen::State> states(positions.size());
+
+    for (size_t i = 0; i < positions.size(); i++) {
+        std::string_view operations;
+
+        if (const auto result = Fen::Parse(positions[i], states[i]); !result
+            && !Fen::ParseEpd(positions[i], states[i], operations)) {
+            std::cerr << positions[i] << ": " << Fen::Describe(result.Code) << " at column " << result.Offset + 1 << std::endl;
+            return 1;
+        }
+
+        Fen::State written;
+
+        if (!Fen::Parse(Fen::ToString(states[i]), written) || Fen::ToString(written) != Fen::ToString(states[i])) {
+            std::cerr << positions[i] << ": does not survive a round trip" << std::endl;
+            return 1;
+        }
+    }
+
+    Fen::State state;
+    std::array<char, Fen::MaxLength> buffer {};
+    size_t checksum = 0;
+
+    const auto parse = Measure(iterations, [&](const size_t i) {
+        checksum += static_cast<size_t>(Fen::Parse(positions[i % positions.size()], state).Code);
+    });
+
+    const auto write = Measure(iterations, [&](const size_t i) {
+        checksum += Fen::Write(states[i % states.size()], buffer);
+    });
+
+    const auto setState = Measure(iterations / 10, [&](const size_t i) {
+        Board::SetState(states[i % states.size()]);
+        checksum += Board::GetHash() & 1;
+    });
+
+    std::cout << "Positions: " << positions.size() << ", checksum " << checksum << '\n';
+    PrintMeasurement("Parse", iterations, parse);
+    PrintMeasurement("Write", iterations, write);
+    PrintMeasurement("Board::SetState", iterations / 10, setState);
+
+    return parse.Allocations == 0 && write.Allocations == 0 && setState.Allocations == 0 ? 0 : 1;
+}
\ No newline at end of file
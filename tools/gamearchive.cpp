@@ -0,0 +1,144 @@
+#include <pch.hpp>
+#include <GameArchive.hpp>
+#include <Board.hpp>
+#include <Notation.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+namespace {
+    constexpr std::string_view Usage =
+        "Usage:\n"
+        "  gamearchive build <pgn>... [--archive <file>] [--threads <n>]\n"
+        "  gamearchive decode [--archive <file>] [--threads <n>]\n"
+        "  gamearchive show <game> [--archive <file>]\n";
+
+    constexpr std::array<std::string_view, 4> Results { "1-0", "1/2-1/2", "0-1", "*" };
+}
+
+auto main(int argc, char** argv) -> int {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    std::string command;
+    std::vector<std::string> operands;
+    std::filesystem::path path = std::string("games") + std::string(GameArchive::Extension);
+    int threads = 0;
+
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const auto& arg = args[i];
+            const auto value = [&]() -> const std::string& {
+                if (i + 1 >= args.size()) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return args[++i];
+            };
+
+            if (arg == "--archive") {
+                path = value();
+            }
+            else if (arg == "--threads") {
+                threads = std::stoi(value());
+            }
+            else if (arg.starts_with("--")) {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+            else if (command.empty()) {
+                command = arg;
+            }
+            else {
+                operands.push_back(arg);
+            }
+        }
+
+        const bool valid = (command == "build" && !operands.empty()) || (command == "decode" && operands.empty())
+            || (command == "show" && operands.size() == 1);
+
+        if (!valid) {
+            throw std::invalid_argument("Expected a command and its operands");
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+
+    try {
+        if (command == "build") {
+            const std::vector<std::filesystem::path> pgns(operands.begin(), operands.end());
+
+            const auto start = std::chrono::steady_clock::now();
+            const auto report = GameArchive::Build(pgns, path, threads);
+            const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            const GameArchive archive(path);
+            const auto moves = static_cast<double>(std::max<uint64_t>(archive.GetMoveCount(), 1));
+
+            std::cout << path.string() << ": " << archive.GetGameCount() << " of " << report.Games << " games, " << archive.GetMoveCount()
+                << " moves, " << report.Errors << " errors, " << seconds << " s\n"
+                << "moves " << archive.GetMoveBytes() << " bytes (" << static_cast<double>(archive.GetMoveBytes()) / moves << " per move), file "
+                << std::filesystem::file_size(path) << " bytes (" << static_cast<double>(std::filesystem::file_size(path)) / moves << " per move)"
+                << std::endl;
+            return 0;
+        }
+
+        const GameArchive archive(path);
+
+        if (command == "show") {
+            const auto record = archive.GetRecord(std::stoull(operands.front()));
+
+            Board::SetState(record.Fen.empty() ? Fen::StartPosition : record.Fen);
+
+            // The moves are decoded first, since writing one in SAN needs the position before it
+            GameCodec::Decoder decoder(archive.GetModel(), record.Moves, record.Plies);
+            while (decoder.Next()) {}
+
+            const std::vector<Move> moves(decoder.GetMoves().begin(), decoder.GetMoves().end());
+            decoder.Rewind();
+
+            if (!record.Fen.empty()) {
+                std::cout << "[FEN \"" << record.Fen << "\"]\n\n";
+            }
+
+            for (size_t ply = 0; ply < moves.size(); ply++) {
+                if (Board::IsWhiteToMove() || ply == 0) {
+                    std::cout << (ply == 0 ? "" : " ") << Board::GetFullmoveNumber() << (Board::IsWhiteToMove() ? "." : "...");
+                }
+
+                std::cout << ' ' << Notation::ToSan(moves[ply]);
+                Board::MakeMove(moves[ply]);
+            }
+
+            std::cout << (moves.empty() ? "" : " ") << Results[static_cast<size_t>(record.Result)] << std::endl;
+            return 0;
+        }
+
+        // The hashes of the final positions make a checksum that only agrees when every game decodes the same
+        std::atomic<uint64_t> checksum = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        archive.Replay(threads, [&](uint64_t, const GameArchive::Record&, std::span<const Move>) {
+            checksum.fetch_xor(Board::GetHash(), std::memory_order_relaxed);
+        });
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const auto games = static_cast<double>(archive.GetGameCount());
+        const auto moves = static_cast<double>(archive.GetMoveCount());
+
+        std::cout << archive.GetGameCount() << " games, " << archive.GetMoveCount() << " moves in " << seconds << " s: "
+            << games / seconds * 60.0 / 1e6 << "M games/min, " << moves / seconds / 1e6 << "M moves/s, "
+            << static_cast<double>(archive.GetMoveBytes()) / std::max(moves, 1.0) << " bytes per move, checksum "
+            << std::hex << checksum.load() << std::endl;
+    }
+    catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include <pch.hpp>
+#include <Bitbase.hpp>
+#include <Board.hpp>
+#include <MatchRunner.hpp>
+#include <Trace.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace {
+    constexpr std::string_view Usage =
+        "Usage:\n"
+        "  match --engine cmd=<path> [name=<name>] [option.<name>=<value>]...\n"
+        "        --engine cmd=<path> [name=<name>] [option.<name>=<value>]...\n"
+        "        (--nodes <n> | --depth <n> | --tc <seconds>[+<increment>])\n"
+        "        [--games <n>] [--concurrency <n>] [--openings <file>] [--pgn <file>]\n"
+        "        [--sprt <elo0> <elo1> <alpha> <beta>] [--maxplies <n>]\n"
+        "        [--trace <file>] [--bitbases <directory>]\n";
+
+    auto ParseEngine(const std::vector<std::string>& args, size_t& i) -> MatchRunner::EngineConfig {
+        MatchRunner::EngineConfig config;
+
+        for (; i + 1 < args.size() && !args[i + 1].starts_with("--"); i++) {
+            const auto& arg = args[i + 1];
+            const auto separator = arg.find('=');
+
+            if (separator == std::string::npos) {
+                throw std::invalid_argument("Engine settings are of the form key=value: " + arg);
+            }
+
+            const auto key = arg.substr(0, separator);
+            const auto value = arg.substr(separator + 1);
+
+            if (key == "cmd") {
+                config.Command = value;
+            }
+            else if (key == "name") {
+                config.Name = value;
+            }
+            else if (key.starts_with("option.")) {
+                config.Options.emplace_back(key.substr(7), value);
+            }
+            else {
+                throw std::invalid_argument("Unknown engine setting " + key);
+            }
+        }
+
+        if (config.Name.empty()) {
+            config.Name = config.Command.substr(config.Command.find_last_of('/') + 1);
+        }
+
+        return config;
+    }
+}
+
+auto main(int argc, char** argv) -> int {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    MatchRunner::Options options;
+    options.Concurrency = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1U));
+    int engines = 0;
+    std::string tracePath;
+    std::string bitbasePath;
+
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const auto& arg = args[i];
+            const auto value = [&]() -> const std::string& {
+                if (i + 1 >= args.size()) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return args[++i];
+            };
+
+            if (arg == "--engine") {
+                (engines++ == 0 ? options.First : options.Second) = ParseEngine(args, i);
+            }
+            else if (arg == "--nodes") {
+                options.Nodes = std::stoull(value());
+            }
+            else if (arg == "--depth") {
+                options.Depth = std::stoi(value());
+            }
+            else if (arg == "--tc") {
+                const auto& control = value();
+                const auto plus = control.find('+');
+                options.TimeMs = static_cast<int>(std::stod(control.substr(0, plus)) * 1000.0);
+                options.IncrementMs = plus != std::string::npos ? static_cast<int>(std::stod(control.substr(plus + 1)) * 1000.0) : 0;
+            }
+            else if (arg == "--games") {
+                options.Games = std::stoi(value());
+            }
+            else if (arg == "--concurrency") {
+                options.Concurrency = std::stoi(value());
+            }
+            else if (arg == "--openings") {
+                options.OpeningsPath = value();
+            }
+            else if (arg == "--pgn") {
+                options.PgnPath = value();
+            }
+            else if (arg == "--maxplies") {
+                options.MaxPlies = std::stoi(value());
+            }
+            else if (arg == "--sprt") {
+                options.Elo0 = std::stod(value());
+                options.Elo1 = std::stod(value());
+                options.Alpha = std::stod(value());
+                options.Beta = std::stod(value());
+            }
+            else if (arg == "--trace") {
+                tracePath = value();
+            }
+            else if (arg == "--bitbases") {
+                bitbasePath = value();
+            }
+            else {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+        }
+
+        if (engines != 2) {
+            throw std::invalid_argument("A match needs exactly two engines");
+        }
+
+        // Two builds of the same engine would otherwise share a name
+        if (options.First.Name == options.Second.Name) {
+            options.First.Name += "-1";
+            options.Second.Name += "-2";
+        }
+
+        if (!tracePath.empty()) {
+            Trace::SetEnabled(true);
+        }
+
+        MatchRunner runner(std::move(options));
+        BitbaseSet bitbases;
+
+        if (!bitbasePath.empty()) {
+            std::cout << "Loaded " << bitbases.Load(bitbasePath) << " bitbases" << std::endl;
+
+            runner.SetTablebaseProbe([&bitbases]() -> std::optional<MatchRunner::Adjudication> {
+                const auto value = bitbases.Probe();
+
+                if (!value) {
+                    return std::nullopt;
+                }
+
+                if (*value == Bitbase::Value::Draw) {
+                    return MatchRunner::Adjudication { MatchRunner::GameResult::Draw, "Bitbase draw" };
+                }
+
+                const bool whiteWins = (*value == Bitbase::Value::Win) == Board::IsWhiteToMove();
+                return whiteWins
+                    ? MatchRunner::Adjudication { MatchRunner::GameResult::WhiteWins, "Bitbase win for White" }
+                    : MatchRunner::Adjudication { MatchRunner::GameResult::BlackWins, "Bitbase win for Black" };
+            });
+        }
+
+        runner.Run();
+
+        if (!tracePath.empty()) {
+            Trace::SetEnabled(false);
+            std::ofstream stream(tracePath);
+            Trace::Export(stream);
+        }
+    }
+    catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include <pch.hpp>
+#include <Board.hpp>
+#include <MateSolver.hpp>
+
+#include <iostream>
+
+namespace {
+    constexpr std::string_view Usage =
+        "Usage:\n"
+        "  matesolver [--fen <fen>] [--side <white|black>] [--depth <moves>] [--nodes <n>]\n"
+        "             [--hash <megabytes>] [--threads <n>] [--any-length]\n"
+        "\n"
+        "Without a position the built-in puzzle suite is solved and checked against the known results.\n"
+        "The side to move gives mate unless another side is given\n";
+
+    struct Puzzle {
+        std::string_view Fen;
+        Board::Color Attacker;
+        int Depth;
+
+        /// <summary>
+        /// The length of the shortest mate, zero if there is no mate within the depth
+        /// </summary>
+        int MateIn;
+    };
+
+    /// <summary>
+    /// Mates of different lengths for either side, with the attacker or the defender to move, and positions
+    /// without a mate that have to be disproven. Changing the list changes the totals
+    /// </summary>
+    constexpr std::array Suite {
+        Puzzle { "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1", Board::Color::White, 3, 1 },
+        Puzzle { "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4", Board::Color::White, 3, 1 },
+        Puzzle { "rnbqkbnr/pppp1ppp/8/4p3/6P1/5P2/PPPPP2P/RNBQKBNR b KQkq - 0 2", Board::Color::Black, 3, 1 },
+        Puzzle { "k7/8/1K6/8/8/8/8/6R1 b - - 0 1", Board::Color::White, 3, 1 },
+        Puzzle { "kbK5/pp6/1P6/8/8/8/8/R7 w - - 0 1", Board::Color::White, 4, 2 },
+        Puzzle { "r2qkbnr/ppp2ppp/2np4/4N3/2B1P1b1/2N5/PPPP1PPP/R1BbK2R w KQkq - 0 6", Board::Color::White, 4, 2 },
+        Puzzle { "r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 1", Board::Color::White, 4, 2 },
+        Puzzle { "r1b2k1r/ppp1bppp/8/1B1Q4/5q2/2P5/PPP2PPP/R3R1K1 w - - 1 1", Board::Color::White, 4, 2 },
+        Puzzle { "5rk1/1p1q2bp/p2pN1p1/2pP2Bn/2P3P1/1P6/P4QKP/5R2 w - - 1 1", Board::Color::White, 4, 2 },
+        Puzzle { "2r3k1/p4p2/3Rp2p/1p2P1pK/8/1P4P1/P3Q2P/1q6 b - - 0 1", Board::Color::Black, 5, 3 },
+        Puzzle { "r1bqr3/ppp1B1kp/1b4p1/n2B4/3PQ1P1/2P5/P4P2/RN4K1 w - - 1 1", Board::Color::White, 5, 4 },
+        Puzzle { "8/8/8/3k4/8/8/8/4K1Q1 w - - 0 1", Board::Color::White, 10, 8 },
+        Puzzle { Fen::StartPosition, Board::Color::White, 2, 0 },
+        Puzzle { "r4rk1/ppp2ppp/8/8/2q5/2N5/PPP1QPPP/R3R1K1 w - - 0 1", Board::Color::White, 3, 0 },
+        Puzzle { "rnbqkbnr/pppp1ppp/8/4p3/8/5P2/PPPPP1PP/RNBQKBNR w KQkq - 0 2", Board::Color::Black, 1, 0 }
+    };
+
+    auto FormatLine(const std::vector<Move>& line) -> std::string {
+        std::string text;
+
+        for (const auto& move : line) {
+            if (!text.empty()) {
+                text += ' ';
+            }
+
+            text += move.ToString();
+        }
+
+        return text;
+    }
+
+    auto Print(const MateSolver::Solution& solution) -> void {
+        std::cout << MateSolver::GetName(solution.Outcome);
+
+        if (solution.Outcome == MateSolver::Result::Proven && solution.MateIn == 0) {
+            std::cout << ", already mate";
+        }
+        else if (solution.Outcome == MateSolver::Result::Proven) {
+            std::cout << ", mate in " << solution.MateIn << ": " << FormatLine(solution.Line);
+        }
+
+        std::cout << " (" << solution.Nodes << " nodes, " << solution.Milliseconds << " ms)" << std::endl;
+    }
+}
+
+auto main(int argc, char** argv) -> int {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    std::string fen;
+    std::optional<Board::Color> side;
+    std::optional<int> depth;
+    size_t hashMegabytes = 64;
+    MateSolver::Options options;
+
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const auto& arg = args[i];
+            const auto value = [&]() -> const std::string& {
+                if (i + 1 >= args.size()) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return args[++i];
+            };
+
+            if (arg == "--fen") {
+                fen = value();
+            }
+            else if (arg == "--side") {
+                const auto& name = value();
+
+                if (name != "white" && name != "black") {
+                    throw std::invalid_argument("The side is white or black, not " + name);
+                }
+
+                side = name == "white" ? Board::Color::White : Board::Color::Black;
+            }
+            else if (arg == "--depth") {
+                depth = std::stoi(value());
+
+                if (*depth < 1) {
+                    throw std::invalid_argument("The depth must be at least one move");
+                }
+            }
+            else if (arg == "--nodes") {
+                options.Nodes = std::stoull(value());
+            }
+            else if (arg == "--hash") {
+                hashMegabytes = std::stoul(value());
+            }
+            else if (arg == "--threads") {
+                options.Threads = std::stoi(value());
+            }
+            else if (arg == "--any-length") {
+                options.Shortest = false;
+            }
+            else {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+        }
+
+        if (!fen.empty()) {
+            Board::SetState(fen);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+
+    MateSolver solver(hashMegabytes);
+
+    if (!fen.empty()) {
+        options.Depth = depth.value_or(options.Depth);
+        const auto toMove = Board::IsWhiteToMove() ? Board::Color::White : Board::Color::Black;
+
+        const auto solution = solver.Solve(fen, side.value_or(toMove), options);
+        Print(solution);
+        return solution.Outcome == MateSolver::Result::Unknown ? 2 : 0;
+    }
+
+    uint64_t nodes = 0;
+    int64_t milliseconds = 0;
+    int failures = 0;
+
+    for (size_t i = 0; i < Suite.size(); i++) {
+        const auto& puzzle = Suite[i];
+        options.Depth = depth.value_or(puzzle.Depth);
+
+        const auto solution = solver.Solve(puzzle.Fen, puzzle.Attacker, options);
+        nodes += solution.Nodes;
+        milliseconds += solution.Milliseconds;
+
+        // A deeper search than the puzzle was made for still has to find the same shortest mate
+        const bool solved = puzzle.MateIn > 0
+            ? solution.Outcome == MateSolver::Result::Proven && (!options.Shortest || solution.MateIn == puzzle.MateIn)
+            : solution.Outcome == MateSolver::Result::Disproven || (depth > puzzle.Depth && solution.Outcome == MateSolver::Result::Proven);
+
+        failures += solved ? 0 : 1;
+
+        std::cout << "Puzzle " << i + 1 << "/" << Suite.size() << (solved ? "" : " FAILED") << ": ";
+        Print(solution);
+    }
+
+    std::cout << "Solved          : " << Suite.size() - failures << "/" << Suite.size() << '\n'
+        << "Total time (ms) : " << milliseconds << '\n'
+        << "Nodes searched  : " << nodes << '\n'
+        << "Nodes/second    : " << nodes * 1000 / std::max<int64_t>(milliseconds, 1) << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
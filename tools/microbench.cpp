@@ -0,0 +1,476 @@
+#include <pch.hpp>
+#include <Board.hpp>
+#include <Evaluation.hpp>
+#include <Fen.hpp>
+#include <Move.hpp>
+#include <Piece.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <numeric>
+
+using Color = Board::Color;
+using GenType = Board::GenType;
+
+namespace {
+    constexpr std::string_view Usage =
+        "Usage:\n"
+        "  microbench [--samples <n>] [--sample-time <milliseconds>] [--filter <text>] [--json]\n";
+
+    // Counts every allocation of the process, reported per operation
+    std::atomic<uint64_t> s_Allocations = 0;
+
+    // Results are folded into the sink so that the measured calls cannot be optimized away
+    volatile uint64_t s_Sink = 0;
+
+    /// <summary>
+    /// Openings, middlegames and endgames, with checks, pins, en passant and promotions among them
+    /// </summary>
+    const std::vector<std::string_view> Corpus {
+        Fen::StartPosition,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+        "r2q1rk1/pp2bppp/2n1pn2/2bp4/3P4/2N1PN2/PPQ1BPPP/R1B2RK1 w - - 0 10",
+        "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+        "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+        "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1"
+    };
+
+    /// <summary>
+    /// A position of the corpus with the inputs of the benchmarks prepared up front
+    /// </summary>
+    struct Entry {
+        Fen::State State;
+        bool White;
+        std::vector<Move> Moves;
+        std::vector<Move> Captures;
+        // The squares of the pieces of the side to move, indexed by the bit index of the type flag
+        std::array<std::vector<Position>, 6> Pieces;
+    };
+
+    using AttackFunction = auto (*)(Position, bool, std::vector<Position>&) -> void;
+    using MoveFunction = auto (*)(Position, std::vector<Move>&) -> void;
+
+    struct PieceFunctions {
+        std::string_view Name;
+        int Type;
+        std::array<AttackFunction, 2> Attacks;
+        std::array<MoveFunction, 2> Moves;
+    };
+
+    const std::array<PieceFunctions, 6> Pieces { {
+        { "Pawn", 0,
+            { &Board::CalculatePawnAttacks<Color::White>, &Board::CalculatePawnAttacks<Color::Black> },
+            { &Board::CalculatePawnMoves<Color::White, GenType::All>, &Board::CalculatePawnMoves<Color::Black, GenType::All> } },
+        { "Rook", 1,
+            { &Board::CalculateRookAttacks<Color::White>, &Board::CalculateRookAttacks<Color::Black> },
+            { &Board::CalculateRookMoves<Color::White, GenType::All>, &Board::CalculateRookMoves<Color::Black, GenType::All> } },
+        { "Knight", 2,
+            { &Board::CalculateKnightAttacks<Color::White>, &Board::CalculateKnightAttacks<Color::Black> },
+            { &Board::CalculateKnightMoves<Color::White, GenType::All>, &Board::CalculateKnightMoves<Color::Black, GenType::All> } },
+        { "Bishop", 3,
+            { &Board::CalculateBishopAttacks<Color::White>, &Board::CalculateBishopAttacks<Color::Black> },
+            { &Board::CalculateBishopMoves<Color::White, GenType::All>, &Board::CalculateBishopMoves<Color::Black, GenType::All> } },
+        { "King", 4,
+            { &Board::CalculateKingAttacks<Color::White>, &Board::CalculateKingAttacks<Color::Black> },
+            { &Board::CalculateKingMoves<Color::White, GenType::All>, &Board::CalculateKingMoves<Color::Black, GenType::All> } },
+        { "Queen", 5,
+            { &Board::CalculateQueenAttacks<Color::White>, &Board::CalculateQueenAttacks<Color::Black> },
+            { &Board::CalculateQueenMoves<Color::White, GenType::All>, &Board::CalculateQueenMoves<Color::Black, GenType::All> } }
+    } };
+
+    /// <summary>
+    /// Runs an operation <c>repeat</c> times on the position of an entry, which is set up on the board beforehand
+    /// </summary>
+    /// <returns><c>uint64_t</c> The number of operations that were run</returns>
+    using BenchmarkFunction = std::function<uint64_t(const Entry& entry, size_t repeat)>;
+
+    struct Benchmark {
+        std::string Name;
+        BenchmarkFunction Function;
+    };
+
+    struct Result {
+        std::string Name;
+        uint64_t Operations;
+        double Allocations;
+        std::vector<double> Samples;
+        double Median;
+        double Mean;
+        double Deviation;
+        double Min;
+    };
+
+    /// <summary>
+    /// Calls a function with the side to move as a compile time constant
+    /// </summary>
+    template<typename Function>
+    auto Dispatch(const bool white, Function&& function) -> void {
+        if (white) {
+            function(std::integral_constant<Color, Color::White> {});
+        }
+        else {
+            function(std::integral_constant<Color, Color::Black> {});
+        }
+    }
+
+    auto LoadCorpus() -> std::vector<Entry> {
+        std::vector<Entry> entries;
+
+        for (const auto fen : Corpus) {
+            Entry entry {};
+
+            if (const auto result = Fen::Parse(fen, entry.State); !result) {
+                throw std::runtime_error(std::string(fen) + ": " + std::string(Fen::Describe(result.Code)));
+            }
+
+            Board::SetState(entry.State);
+            entry.White = Board::IsWhiteToMove();
+            Board::GenerateMoves<GenType::All>(entry.Moves);
+            Board::GenerateMoves<GenType::Captures>(entry.Captures);
+
+            for (auto pieces = Board::GetOccupancy(entry.White); pieces;) {
+                const auto pos = PopSquare(pieces);
+                const auto type = Board::GetPiece(pos).GetType() & ~(PieceFlag::White | PieceFlag::Black);
+                entry.Pieces[std::countr_zero(static_cast<uint8_t>(type))].push_back(pos);
+            }
+
+            entries.emplace_back(std::move(entry));
+        }
+
+        return entries;
+    }
+
+    auto CreateBenchmarks() -> std::vector<Benchmark> {
+        std::vector<Benchmark> benchmarks;
+
+        // The outputs are reused so that only the allocations of the primitives themselves are counted
+        static std::vector<Position> attacks;
+        static std::vector<Move> moves;
+        attacks.reserve(64);
+        moves.reserve(256);
+
+        for (const auto& piece : Pieces) {
+            benchmarks.push_back({ "Board::Calculate" + std::string(piece.Name) + "Attacks", [&piece](const Entry& entry, const size_t repeat) {
+                const auto function = piece.Attacks[entry.White ? 0 : 1];
+
+                for (size_t i = 0; i < repeat; i++) {
+                    for (const auto& pos : entry.Pieces[piece.Type]) {
+                        attacks.clear();
+                        function(pos, false, attacks);
+                        s_Sink = s_Sink + attacks.size();
+                    }
+                }
+
+                return repeat * entry.Pieces[piece.Type].size();
+            } });
+        }
+
+        for (const auto& piece : Pieces) {
+            benchmarks.push_back({ "Board::Calculate" + std::string(piece.Name) + "Moves", [&piece](const Entry& entry, const size_t repeat) {
+                const auto function = piece.Moves[entry.White ? 0 : 1];
+
+                for (size_t i = 0; i < repeat; i++) {
+                    for (const auto& pos : entry.Pieces[piece.Type]) {
+                        moves.clear();
+                        function(pos, moves);
+                        s_Sink = s_Sink + moves.size();
+                    }
+                }
+
+                return repeat * entry.Pieces[piece.Type].size();
+            } });
+        }
+
+        benchmarks.push_back({ "Board::UpdateCheckState", [](const Entry& entry, const size_t repeat) {
+            Dispatch(entry.White, [&](auto us) {
+                for (size_t i = 0; i < repeat; i++) {
+                    Board::UpdateCheckState<us()>();
+                }
+            });
+
+            return static_cast<uint64_t>(repeat);
+        } });
+
+        benchmarks.push_back({ "Board::CheckForPins", [](const Entry& entry, const size_t repeat) {
+            uint64_t operations = 0;
+
+            Dispatch(entry.White, [&](auto us) {
+                for (size_t i = 0; i < repeat; i++) {
+                    for (const auto& squares : entry.Pieces) {
+                        for (const auto& pos : squares) {
+                            Bitboard free = 0;
+                            s_Sink = s_Sink + Board::CheckForPins<us()>(pos, free) + free;
+                            operations++;
+                        }
+                    }
+                }
+            });
+
+            return operations;
+        } });
+
+        benchmarks.push_back({ "Board::GetKingPosition", [](const Entry& entry, const size_t repeat) {
+            for (size_t i = 0; i < repeat; i++) {
+                s_Sink = s_Sink + static_cast<uint64_t>(Board::GetKingPosition(entry.White).x);
+            }
+
+            return static_cast<uint64_t>(repeat);
+        } });
+
+        benchmarks.push_back({ "Board::GenerateMoves", [](const Entry&, const size_t repeat) {
+            for (size_t i = 0; i < repeat; i++) {
+                Board::GenerateMoves<GenType::All>(moves);
+                s_Sink = s_Sink + moves.size();
+            }
+
+            return static_cast<uint64_t>(repeat);
+        } });
+
+        // A move and taking it back count as one operation
+        benchmarks.push_back({ "Board::MakeMove", [](const Entry& entry, const size_t repeat) {
+            for (size_t i = 0; i < repeat; i++) {
+                for (const auto& move : entry.Moves) {
+                    Board::MakeMove(move);
+                    Board::UnmakeMove(move);
+                }
+            }
+
+            s_Sink = s_Sink + Board::GetHash();
+            return repeat * entry.Moves.size();
+        } });
+
+        benchmarks.push_back({ "Board::SetState", [](const Entry& entry, const size_t repeat) {
+            for (size_t i = 0; i < repeat; i++) {
+                Board::SetState(entry.State);
+                s_Sink = s_Sink + Board::GetHash();
+            }
+
+            return static_cast<uint64_t>(repeat);
+        } });
+
+        benchmarks.push_back({ "Board::ComputeHash", [](const Entry&, const size_t repeat) {
+            for (size_t i = 0; i < repeat; i++) {
+                s_Sink = s_Sink + Board::ComputeHash();
+            }
+
+            return static_cast<uint64_t>(repeat);
+        } });
+
+        benchmarks.push_back({ "Evaluation::StaticExchange", [](const Entry& entry, const size_t repeat) {
+            for (size_t i = 0; i < repeat; i++) {
+                for (const auto& move : entry.Captures) {
+                    s_Sink = s_Sink + static_cast<uint64_t>(Evaluation::StaticExchange(move));
+                }
+            }
+
+            return repeat * entry.Captures.size();
+        } });
+
+        benchmarks.push_back({ "Evaluation::Evaluate", [](const Entry&, const size_t repeat) {
+            for (size_t i = 0; i < repeat; i++) {
+                s_Sink = s_Sink + static_cast<uint64_t>(Evaluation::Evaluate());
+            }
+
+            return static_cast<uint64_t>(repeat);
+        } });
+
+        return benchmarks;
+    }
+
+    struct Sample {
+        int64_t Nanoseconds;
+        uint64_t Operations;
+        uint64_t Allocations;
+    };
+
+    /// <summary>
+    /// Runs a benchmark over every position of the corpus. Setting up the board is not timed
+    /// </summary>
+    auto RunPass(const Benchmark& benchmark, const std::vector<Entry>& entries, const size_t repeat) -> Sample {
+        Sample sample {};
+
+        for (const auto& entry : entries) {
+            Board::SetState(entry.State);
+            Dispatch(entry.White, [](auto us) { Board::UpdateCheckState<us()>(); });
+
+            const auto allocations = s_Allocations.load(std::memory_order_relaxed);
+            const auto start = std::chrono::steady_clock::now();
+            sample.Operations += benchmark.Function(entry, repeat);
+            sample.Nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            sample.Allocations += s_Allocations.load(std::memory_order_relaxed) - allocations;
+        }
+
+        return sample;
+    }
+
+    auto Run(const Benchmark& benchmark, const std::vector<Entry>& entries, const size_t samples, const int64_t sampleNanoseconds) -> Result {
+        // Doubles the repetitions until a pass takes long enough to time reliably, which also warms the caches
+        size_t repeat = 1;
+        while (RunPass(benchmark, entries, repeat).Nanoseconds < sampleNanoseconds && repeat < (size_t { 1 } << 30)) {
+            repeat *= 2;
+        }
+
+        Result result { benchmark.Name, 0, 0.0, {}, 0.0, 0.0, 0.0, 0.0 };
+        uint64_t allocations = 0;
+        uint64_t operations = 0;
+
+        for (size_t i = 0; i < samples; i++) {
+            const auto sample = RunPass(benchmark, entries, repeat);
+            result.Samples.push_back(sample.Operations > 0 ? static_cast<double>(sample.Nanoseconds) / static_cast<double>(sample.Operations) : 0.0);
+            result.Operations = sample.Operations;
+            operations += sample.Operations;
+            allocations += sample.Allocations;
+        }
+
+        auto sorted = result.Samples;
+        std::ranges::sort(sorted);
+
+        const auto count = static_cast<double>(sorted.size());
+        result.Median = sorted.size() % 2 == 1 ? sorted[sorted.size() / 2] : (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2.0;
+        result.Mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / count;
+        result.Min = sorted.front();
+
+        double squares = 0.0;
+        for (const auto value : sorted) {
+            squares += (value - result.Mean) * (value - result.Mean);
+        }
+
+        result.Deviation = sorted.size() > 1 ? std::sqrt(squares / (count - 1.0)) : 0.0;
+        result.Allocations = operations > 0 ? static_cast<double>(allocations) / static_cast<double>(operations) : 0.0;
+
+        return result;
+    }
+
+    auto PrintText(const std::vector<Result>& results) -> void {
+        std::cout << std::left << std::setw(36) << "Benchmark" << std::right
+            << std::setw(12) << "ops/pass" << std::setw(12) << "median ns" << std::setw(12) << "mean ns"
+            << std::setw(10) << "stddev" << std::setw(12) << "min ns" << std::setw(12) << "allocs/op" << '\n'
+            << std::fixed;
+
+        for (const auto& result : results) {
+            std::cout << std::left << std::setw(36) << result.Name << std::right
+                << std::setw(12) << result.Operations
+                << std::setprecision(2) << std::setw(12) << result.Median << std::setw(12) << result.Mean
+                << std::setw(10) << result.Deviation << std::setw(12) << result.Min
+                << std::setprecision(3) << std::setw(12) << result.Allocations << '\n';
+        }
+
+        std::cout << std::flush;
+    }
+
+    auto PrintJson(const std::vector<Result>& results, const size_t positions) -> void {
+        std::cout << "{\"positions\":" << positions << ",\"benchmarks\":[" << std::setprecision(4) << std::fixed;
+
+        for (size_t i = 0; i < results.size(); i++) {
+            const auto& result = results[i];
+            std::cout << (i == 0 ? "\n" : ",\n")
+                << "{\"name\":\"" << result.Name << "\",\"operations\":" << result.Operations
+                << ",\"median_ns\":" << result.Median << ",\"mean_ns\":" << result.Mean
+                << ",\"stddev_ns\":" << result.Deviation << ",\"min_ns\":" << result.Min
+                << ",\"allocations_per_op\":" << result.Allocations << ",\"samples_ns\":[";
+
+            for (size_t sample = 0; sample < result.Samples.size(); sample++) {
+                std::cout << (sample == 0 ? "" : ",") << result.Samples[sample];
+            }
+
+            std::cout << "]}";
+        }
+
+        std::cout << "\n]}" << std::endl;
+    }
+}
+
+auto operator new(const size_t size) -> void* {
+    s_Allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+auto operator delete(void* pointer) noexcept -> void {
+    std::free(pointer);
+}
+
+auto operator delete(void* pointer, size_t) noexcept -> void {
+    std::free(pointer);
+}
+
+auto main(int argc, char** argv) -> int {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    size_t samples = 15;
+    int64_t sampleMilliseconds = 20;
+    std::string filter;
+    bool json = false;
+
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const auto& arg = args[i];
+            const auto value = [&]() -> const std::string& {
+                if (i + 1 >= args.size()) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return args[++i];
+            };
+
+            if (arg == "--samples") {
+                samples = std::max<size_t>(std::stoull(value()), 1);
+            }
+            else if (arg == "--sample-time") {
+                sampleMilliseconds = std::max<int64_t>(std::stoll(value()), 1);
+            }
+            else if (arg == "--filter") {
+                filter = value();
+            }
+            else if (arg == "--json") {
+                json = true;
+            }
+            else {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+
+    try {
+        const auto entries = LoadCorpus();
+        std::vector<Result> results;
+
+        for (const auto& benchmark : CreateBenchmarks()) {
+            if (benchmark.Name.find(filter) != std::string::npos) {
+                results.push_back(Run(benchmark, entries, samples, sampleMilliseconds * 1'000'000));
+            }
+        }
+
+        if (json) {
+            PrintJson(results, entries.size());
+        }
+        else {
+            PrintText(results);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include <pch.hpp>
+#include <PatternIndex.hpp>
+
+#include <chrono>
+#include <iostream>
+
+namespace {
+    constexpr std::string_view Usage =
+        "Usage:\n"
+        "  patternsearch build <pgn>... [--index <file>] [--threads <n>]\n"
+        "  patternsearch search <query> [--index <file>] [--threads <n>] [--limit <n>]\n"
+        "\n"
+        "Queries are terms separated by spaces or commas, pieces written as in FEN:\n"
+        "  Nd5       a white knight on d5        pc6e6     black pawns on c6 and e6\n"
+        "  !Bg2      no white bishop on g2       .e4       an empty square\n"
+        "  Q=0 p>=6  the number of a piece       !q        no black queen\n"
+        "  w b       the side to move\n"
+        "e.g. \"Nd5 pc6e6 Q=0 q=0\"\n";
+}
+
+auto main(int argc, char** argv) -> int {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    std::string command;
+    std::vector<std::string> operands;
+    std::filesystem::path path = std::string("positions") + std::string(PatternIndex::Extension);
+    int threads = 0;
+    size_t limit = 20;
+
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const auto& arg = args[i];
+            const auto value = [&]() -> const std::string& {
+                if (i + 1 >= args.size()) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return args[++i];
+            };
+
+            if (arg == "--index") {
+                path = value();
+            }
+            else if (arg == "--threads") {
+                threads = std::stoi(value());
+            }
+            else if (arg == "--limit") {
+                limit = std::stoull(value());
+            }
+            else if (arg.starts_with("--")) {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+            else if (command.empty()) {
+                command = arg;
+            }
+            else {
+                operands.push_back(arg);
+            }
+        }
+
+        if ((command != "build" && command != "search") || operands.empty() || (command == "search" && operands.size() > 1)) {
+            throw std::invalid_argument("Expected a command and its operands");
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+
+    try {
+        if (command == "build") {
+            const std::vector<std::filesystem::path> pgns(operands.begin(), operands.end());
+
+            const auto start = std::chrono::steady_clock::now();
+            const auto report = PatternIndex::Build(pgns, path, threads);
+            const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::cout << path.string() << ": " << report.Games << " games, " << report.Positions << " positions, "
+                << report.Errors << " errors, " << seconds << " s" << std::endl;
+            return 0;
+        }
+
+        const auto query = PatternIndex::Query::Compile(operands.front());
+        const PatternIndex index(path);
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto result = index.Search(query, threads, limit);
+        const auto milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        for (const auto& [game, ply] : result.Matches) {
+            std::cout << "game " << game << " ply " << ply << '\n';
+        }
+
+        std::cout << result.Total << " of " << index.GetPositionCount() << " positions match, " << result.BlocksScanned << " blocks scanned, "
+            << result.BlocksSkipped << " skipped, " << milliseconds << " ms (" << PatternIndex::GetInstructionSet() << ")" << std::endl;
+    }
+    catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
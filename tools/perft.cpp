@@ -0,0 +1,148 @@
+#include <pch.hpp>
+#include <Board.hpp>
+#include <Fen.hpp>
+#include <Piece.hpp>
+#include <DistributedPerft.hpp>
+#include <LargePageBuffer.hpp>
+#include <Metrics.hpp>
+#include <PerftCache.hpp>
+
+#include <chrono>
+#include <iostream>
+
+namespace {
+    constexpr std::string_view Usage =
+        "Usage:\n"
+        "  perft <depth> [--hash <megabytes>] [--numa <none|interleave|firsttouch>] [--no-large-pages]\n"
+        "              [--fen <fen>] [--metrics]\n"
+        "  perft <depth> --workers <n> [--split <plies>] [--checkpoint <file>]\n"
+        "                [--attempts <n>] [--timeout <seconds>] [--fen <fen>]\n"
+        "  perft --worker\n";
+
+    auto PrintResult(const uint64_t nodes, const std::chrono::steady_clock::time_point start) -> void {
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Nodes: " << nodes << '\n'
+            << "Time: " << seconds << " s\n"
+            << "NPS: " << static_cast<uint64_t>(seconds > 0.0 ? static_cast<double>(nodes) / seconds : 0.0) << std::endl;
+    }
+}
+
+auto main(int argc, char** argv) -> int {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    if (!args.empty() && args.front() == "--worker") {
+        return DistributedPerft::RunWorker(std::cin, std::cout);
+    }
+
+    DistributedPerft::Options options;
+    options.Fen = Fen::StartPosition;
+    // The coordinator starts copies of this executable as workers
+    options.WorkerExecutable = "/proc/self/exe";
+    options.Workers = 0;
+
+    size_t hashMegabytes = 0;
+    bool printMetrics = false;
+    LargePageBuffer::Options memory;
+
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const auto& arg = args[i];
+            const auto value = [&]() -> const std::string& {
+                if (i + 1 >= args.size()) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return args[++i];
+            };
+
+            if (arg == "--fen") {
+                options.Fen = value();
+            }
+            else if (arg == "--workers") {
+                options.Workers = std::stoi(value());
+            }
+            else if (arg == "--split") {
+                options.SplitDepth = std::stoi(value());
+            }
+            else if (arg == "--checkpoint") {
+                options.CheckpointPath = value();
+            }
+            else if (arg == "--attempts") {
+                options.MaxAttempts = std::stoi(value());
+            }
+            else if (arg == "--hash") {
+                hashMegabytes = std::stoul(value());
+            }
+            else if (arg == "--timeout") {
+                options.JobTimeoutSeconds = std::stoi(value());
+            }
+            else if (arg == "--numa") {
+                const auto policy = LargePageBuffer::ParseNumaPolicy(value());
+
+                if (!policy) {
+                    throw std::invalid_argument("Unknown NUMA policy " + args[i]);
+                }
+
+                memory.Numa = *policy;
+            }
+            else if (arg == "--no-large-pages") {
+                memory.LargePages = false;
+            }
+            else if (arg == "--metrics") {
+                printMetrics = true;
+            }
+            else {
+                options.Depth = std::stoi(arg);
+            }
+        }
+
+        // Rejects a malformed position before any work is started
+        Board::SetState(options.Fen);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    if (options.Workers <= 0 && hashMegabytes > 0) {
+        LargePageBuffer::SetOptions(memory);
+        PerftCache cache(hashMegabytes);
+        std::cout << "Cache memory: " << cache.GetMemory().Describe() << std::endl;
+
+        Board::SetState(options.Fen);
+        const auto nodes = Board::Perft(options.Depth, cache);
+
+        std::cout << "Cache: " << cache.GetSize() / (1024 * 1024) << " MB, "
+            << cache.GetHits() << "/" << cache.GetProbes() << " hits ("
+            << cache.GetHitRate() * 100.0 << "%)\n";
+        PrintResult(nodes, start);
+        if (printMetrics) std::cout << Metrics::Snapshot().ToText();
+        return 0;
+    }
+
+    if (options.Workers <= 0) {
+        Board::SetState(options.Fen);
+        PrintResult(Board::Perft(options.Depth), start);
+        if (printMetrics) std::cout << Metrics::Snapshot().ToText();
+        return 0;
+    }
+
+    try {
+        DistributedPerft perft(options);
+        const auto nodes = perft.Run();
+
+        for (const auto& [move, count] : perft.GetDivide()) {
+            std::cout << (move.empty() ? "root" : move) << ": " << count << '\n';
+        }
+
+        std::cout << "Retried jobs: " << perft.GetRetries() << '\n';
+        PrintResult(nodes, start);
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include <pch.hpp>
+#include <Board.hpp>
+#include <Fen.hpp>
+#include <Move.hpp>
+#include <PositionIndex.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+namespace {
+    constexpr std::string_view Usage =
+        "Usage:\n"
+        "  positionindex ingest <pgn>... [--index <directory>] [--threads <n>] [--buffer <positions>]\n"
+        "  positionindex query [<fen>] [--moves <uci moves>] [--index <directory>]\n"
+        "  positionindex compact [--index <directory>]\n"
+        "  positionindex bench [--queries <n>] [--index <directory>]\n"
+        "  positionindex verify\n"
+        "\n"
+        "A query looks up the position after the moves from the FEN, the start position by default. Verify ingests\n"
+        "built-in games into a scratch index and checks what it finds\n";
+
+    /// <summary>
+    /// Two games that reach the same position by different move orders, each ending them with a double push whose
+    /// pawn cannot be taken en passant
+    /// </summary>
+    constexpr std::string_view Transpositions =
+        "[Result \"1-0\"]\n\n1. d4 d5 2. c4 e6 3. Nc3 1-0\n\n"
+        "[Result \"0-1\"]\n\n1. c4 d5 2. d4 e6 3. Nf3 0-1\n";
+
+    auto Percent(const uint64_t count, const uint64_t total) -> double {
+        return 100.0 * static_cast<double>(count) / static_cast<double>(std::max<uint64_t>(total, 1));
+    }
+
+    /// <summary>
+    /// Sets up the position after moves in coordinate notation from a FEN, the start position if it is empty
+    /// </summary>
+    auto SetPosition(const std::string& fen, const std::string& moves) -> void {
+        Board::SetState(fen.empty() ? Fen::StartPosition : fen);
+
+        std::vector<Move> legal;
+        std::istringstream stream(moves);
+
+        for (std::string name; stream >> name;) {
+            legal.clear();
+            Board::GenerateMoves<Board::GenType::All>(legal);
+
+            const auto move = std::ranges::find(legal, name, &Move::ToString);
+            if (move == legal.end()) {
+                throw std::invalid_argument(name + " is not legal in " + Board::GetFen());
+            }
+
+            Board::MakeMove(*move);
+        }
+    }
+
+    auto Query(const PositionIndex& index, const std::string& fen, const std::string& moves) -> int {
+        SetPosition(fen, moves);
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto stats = index.Find(Board::GetHash());
+        const auto microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << Board::GetFen() << " (" << microseconds << " us)\n";
+
+        if (!stats) {
+            std::cout << "Not in the index" << std::endl;
+            return 2;
+        }
+
+        std::cout << stats->Count << " occurrences, white " << Percent(stats->WhiteWins, stats->Count) << "%, draw "
+            << Percent(stats->Draws, stats->Count) << "%, black " << Percent(stats->BlackWins, stats->Count) << "%\n";
+
+        for (const auto& [move, count] : stats->Moves) {
+            std::cout << "  " << PositionIndex::MoveName(move) << ' ' << count << '\n';
+        }
+
+        std::cout << std::flush;
+        return 0;
+    }
+
+    /// <summary>
+    /// Times lookups of keys sampled from the runs, which are found, and of random keys, which are not
+    /// </summary>
+    auto Bench(const PositionIndex& index, const size_t queries) -> void {
+        std::mt19937_64 random(2024);
+        std::vector<uint64_t> keys;
+
+        for (size_t run = 0; run < index.GetRunCount(); run++) {
+            const auto runKeys = index.GetKeys(run);
+
+            for (size_t i = 0; i < queries / index.GetRunCount() + 1 && !runKeys.empty(); i++) {
+                keys.push_back(runKeys[random() % runKeys.size()]);
+            }
+        }
+
+        std::ranges::shuffle(keys, random);
+
+        const auto time = [&](const std::string_view name, const auto& key) {
+            uint64_t found = 0;
+            const auto start = std::chrono::steady_clock::now();
+
+            for (size_t i = 0; i < queries; i++) {
+                found += index.Find(key(i)).has_value() ? 1 : 0;
+            }
+
+            const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << name << ": " << seconds * 1e6 / static_cast<double>(std::max<size_t>(queries, 1)) << " us per query, "
+                << found << " of " << queries << " found" << std::endl;
+        };
+
+        std::cout << "Runs: " << index.GetRunCount() << ", entries: " << index.GetEntryCount() << std::endl;
+
+        if (!keys.empty()) {
+            time("Stored keys", [&](const size_t i) { return keys[i % keys.size()]; });
+        }
+
+        time("Random keys", [&](size_t) { return random(); });
+    }
+
+    /// <summary>
+    /// Checks that the position both games reach after 2.c4 or 2.d4 is one entry with the occurrences and the
+    /// reply of both games
+    /// </summary>
+    auto CheckTranspositions(const PositionIndex& index, const std::string_view stage) -> void {
+        SetPosition({}, "d2d4 d7d5 c2c4");
+        const auto stats = index.Find(Board::GetHash());
+
+        const bool found = stats && stats->Count == 2 && stats->WhiteWins == 1 && stats->BlackWins == 1 && stats->Moves.size() == 1
+            && PositionIndex::MoveName(stats->Moves.front().Move) == "e7e6" && stats->Moves.front().Count == 2;
+
+        if (!found) {
+            throw std::runtime_error(std::string(stage) + ": the transposed position is not one entry with both games");
+        }
+    }
+
+    auto Runs(const std::filesystem::path& directory) -> std::vector<std::filesystem::path> {
+        std::vector<std::filesystem::path> runs;
+
+        for (const auto& file : std::filesystem::directory_iterator(directory)) {
+            if (file.path().extension() == PositionIndex::Extension) {
+                runs.push_back(file.path());
+            }
+        }
+
+        return runs;
+    }
+
+    /// <summary>
+    /// Ingests the transposing games into a scratch index and checks them after ingest, compaction and reopening.
+    /// The runs a compaction replaced are then put back, as a crash before their removal would leave them, and
+    /// reopening must drop them rather than count the games twice
+    /// </summary>
+    auto Verify() -> void {
+        const auto directory = std::filesystem::temp_directory_path() / ("positionindex-verify-" + std::to_string(std::random_device()()));
+        const auto replaced = directory / "replaced";
+        std::filesystem::remove_all(directory);
+
+        try {
+            {
+                PositionIndex index(directory, { .BufferPositions = 2, .MergeFanIn = 3 });
+                std::istringstream pgn { std::string(Transpositions) };
+
+                if (const auto report = index.Ingest(pgn, 1); report.Games != 2 || report.Errors != 0) {
+                    throw std::runtime_error("The games did not replay");
+                }
+
+                CheckTranspositions(index, "Ingest");
+
+                if (index.GetRunCount() < 2) {
+                    throw std::runtime_error("Ingest: the games were not spread over runs");
+                }
+
+                std::filesystem::create_directories(replaced);
+                for (const auto& run : Runs(directory)) {
+                    std::filesystem::copy_file(run, replaced / run.filename());
+                }
+
+                index.Compact();
+                CheckTranspositions(index, "Compact");
+            }
+
+            CheckTranspositions(PositionIndex(directory), "Reopen");
+
+            for (const auto& run : Runs(replaced)) {
+                std::filesystem::copy_file(run, directory / run.filename(), std::filesystem::copy_options::overwrite_existing);
+            }
+
+            const PositionIndex recovered(directory);
+            CheckTranspositions(recovered, "Interrupted merge");
+
+            if (recovered.GetRunCount() != 1 || Runs(directory).size() != 1) {
+                throw std::runtime_error("Interrupted merge: the replaced runs were not removed");
+            }
+        }
+        catch (...) {
+            std::filesystem::remove_all(directory);
+            throw;
+        }
+
+        std::filesystem::remove_all(directory);
+        std::cout << "Verified" << std::endl;
+    }
+}
+
+auto main(int argc, char** argv) -> int {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+
+    std::string command;
+    std::vector<std::string> operands;
+    std::filesystem::path directory = "positions";
+    std::string moves;
+    PositionIndex::Options options;
+    int threads = 0;
+    size_t queries = 1'000'000;
+
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const auto& arg = args[i];
+            const auto value = [&]() -> const std::string& {
+                if (i + 1 >= args.size()) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return args[++i];
+            };
+
+            if (arg == "--index") {
+                directory = value();
+            }
+            else if (arg == "--threads") {
+                threads = std::stoi(value());
+            }
+            else if (arg == "--buffer") {
+                options.BufferPositions = std::stoull(value());
+            }
+            else if (arg == "--moves") {
+                moves = value();
+            }
+            else if (arg == "--queries") {
+                queries = std::stoull(value());
+            }
+            else if (arg.starts_with("--")) {
+                throw std::invalid_argument("Unknown argument " + arg);
+            }
+            else if (command.empty()) {
+                command = arg;
+            }
+            else {
+                operands.push_back(arg);
+            }
+        }
+
+        if (command != "ingest" && command != "query" && command != "compact" && command != "bench" && command != "verify") {
+            throw std::invalid_argument("Expected a command");
+        }
+
+        if ((command == "ingest") == operands.empty() || (command == "query" && operands.size() > 1) || (command == "verify" && !operands.empty())) {
+            throw std::invalid_argument("Wrong operands for " + command);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << '\n' << Usage;
+        return 1;
+    }
+
+    try {
+        if (command == "verify") {
+            Verify();
+            return 0;
+        }
+
+        PositionIndex index(directory, options);
+
+        if (command == "query") {
+            return Query(index, operands.empty() ? std::string() : operands.front(), moves);
+        }
+
+        if (command == "bench") {
+            Bench(index, queries);
+            return 0;
+        }
+
+        if (command == "ingest") {
+            for (const auto& path : operands) {
+                std::ifstream pgn(path);
+
+                if (!pgn) {
+                    throw std::runtime_error("Failed to open " + path);
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                const auto report = index.Ingest(pgn, threads);
+                const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                std::cout << path << ": " << report.Games << " games, " << report.Positions << " positions, " << report.Errors << " errors, "
+                    << seconds << " s (" << static_cast<double>(report.Positions) / std::max(seconds, 1e-9) / 1e6 << " M positions/s)" << std::endl;
+            }
+        }
+        else {
+            const auto start = std::chrono::steady_clock::now();
+            index.Compact();
+            std::cout << "Compacted in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+        }
+
+        std::cout << "Runs: " << index.GetRunCount() << ", entries: " << index.GetEntryCount() << std::endl;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file